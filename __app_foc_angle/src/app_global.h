@@ -27,9 +27,6 @@
 /**  Default ADC Filter Mode  1 == On */
 #define ADC_FILTER 1
 
-/**  Default QEI Filter Mode  1 == On */
-#define QEI_FILTER 1
-
 /**  Default QEI Sampling Mode  0 == Edge-Triggered, 1 == Regularly-Sampled */
 #define QEI_RS_MODE 1
 
@@ -64,6 +61,18 @@
 /** Define Minimum motor speed, below which motor stalls. WARNING: Safety critical */
 #define MIN_STALL_RPM 500
 
+/* Motor electrical parameters (in control-loop units), used for current-loop decoupling.
+ * Voltages are PWM demand voltages, currents are ADC units, and speed is in RPM. Up-scaled by 2^16
+ */
+/** Define radial inductance: Voltage per (RPM * Current) */
+#define MOTOR_L_D 2026 // ~0.031
+
+/** Define tangential inductance: Voltage per (RPM * Current) */
+#define MOTOR_L_Q 2026 // ~0.031
+
+/** Define magnet flux linkage (back-EMF constant): Voltage per RPM */
+#define MOTOR_PSI 242000 // ~3.7
+
 #define QEI_PER_REV (QEI_PER_PAIR * NUM_POLE_PAIRS) // No. Of QEI positions per Revolution
 #define HALL_PER_REV (HALL_PER_PAIR * NUM_POLE_PAIRS) // No. Of Hall positions per Revolution
 
@@ -102,6 +111,12 @@
 /** Define if Shared Memory is used to transfer PWM data from Client to Server */
 #define PWM_SHARED_MEM 0 // 0: Use c_pwm channel for pwm data transfer
 
+/** Define if one PWM Server core drives all motors (see pwm_multi_server.h) */
+#define PWM_MULTI_SERVER 0 // 0: One PWM Server core per motor
+
+/** Define if phases are centred at different times (see pwm_common.h). WARNING: Keep at 0 with leg shunts */
+#define PWM_PHASE_SHIFT 0 // 0: All phases centred on the same reference time
+
 /** Maximum Port timer value. See also PORT_TIME_TYP */
 #define PORT_TIME_MASK 0xFFFF
 
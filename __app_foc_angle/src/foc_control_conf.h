@@ -0,0 +1,25 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _FOC_CONTROL_CONF_H_
+#define _FOC_CONTROL_CONF_H_
+
+// Feature policies for FOC motor control engine (see inner_loop.h in module_foc_control)
+
+/** Define this to synchronise the angle of each motor to the master motor, at low speed */
+#define FOC_ANGLE_SYNC 1
+
+#endif // _FOC_CONTROL_CONF_H_
+// foc_control_conf.h
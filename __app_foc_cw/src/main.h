@@ -26,6 +26,8 @@
 #include "hall_server.h"
 #include "qei_server.h"
 #include "pwm_server.h"
+#include "pwm_multi_server.h"
+#include "foc_budget.h" // NB Build fails if configuration does NOT fit on MOTOR_TILE
 
 // Define where everything is
 #define INTERFACE_TILE 0
@@ -36,6 +36,9 @@
 /** Default ADC Filter Mode  1 == On */
 #define ADC_FILTER 0
 
+/** Stored ADC offsets for simulated board (Test vectors have zero offset) */
+#define ADC_BOARD_OFFSETS {{ 0 ,0 } ,{ 0 ,0 }} // [NUMBER_OF_MOTORS][MEAS_ADC_PHASES]
+
 /** Define Bits in Byte */
 #define BITS_IN_BYTE 8
 
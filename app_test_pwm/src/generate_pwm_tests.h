@@ -56,6 +56,7 @@ typedef struct GENERATE_PWM_TAG // Structure containing PWM test generation data
 	unsigned time; // timer value
 	unsigned period; // period (in ticks) between tests
 	unsigned width; // PWM width
+	int currs[NUM_PWM_PHASES]; // Modelled phase-currents (used in Dead-time compensation tests)
 	int print_on;  // Print flag
 	int print_cnt; // Print counter
 	int dbg;  // Debug flag
@@ -48,6 +48,18 @@
 /** Define value for Maximum Speed test */
 #define MAXI_PWM (PWM_WID_LIMIT - 1)
 
+/** Define phase-current band used in Dead-time compensation tests (see pwm_convert_width.h) */
+#define COMP_BAND 32
+
+/** Define magnitude of modelled phase-current in Dead-time compensation tests. NB Outside band, so full correction applied */
+#define COMP_CURR (COMP_BAND << 1)
+
+/** Define magnitude of modelled phase-current inside band. NB Partial correction applied */
+#define COMP_HALF (COMP_BAND >> 1)
+
+/** Define unit of expected Dead-time compensation (quarter of Dead-time) */
+#define COMP_QUART (PWM_DEAD_TIME >> 2)
+
 /** Define ADC Pattern - Must NOT be equivalent to a PWM pattern */
 #define ADC_PATN 0xAA // ADC Pattern - Must NOT be equivalent to a PWM pattern
 
@@ -58,6 +70,7 @@ typedef enum PWM_TEST_ETAG
   TST_NARROW,			// Test Narrow PWM Widths
   TST_EQUAL,			// Test Equal PWM Widths
   TST_ADC,				// Test ADC Trigger
+  TST_COMP,				// Test Dead-time compensation
   NUM_TEST_OPTS		// Handy Value!-)
 } PWM_TEST_ENUM;
 
@@ -69,6 +82,7 @@ typedef enum VECT_COMP_ETAG
 	LEG,				// PWM-Leg
   ADC_TRIG,		// ADC Trigger
 	DEAD,				// Dead-Time
+	COMP,				// Dead-Time compensation
   NUM_VECT_COMPS	// Handy Value!-)
 } VECT_COMP_ENUM;
 
@@ -99,6 +113,18 @@ typedef enum DEAD_PWM_ETAG
   NUM_PWM_DEADS	// Handy Value!-)
 } DEAD_PWM_ENUM;
 
+/** Enumeration of PWM Dead-Time compensation states (modelled phase-current) */
+typedef enum COMP_PWM_ETAG
+{
+  NO_COMP = 0,	// Dead-Time compensation not tested
+  POSI_CURR,		// Large positive phase-current (flowing into motor)
+  POSI_BAND,		// Small positive phase-current (inside compensation band)
+  ZERO_CURR,		// Zero phase-current
+  NEGA_BAND,		// Small negative phase-current (inside compensation band)
+  NEGA_CURR,		// Large negative phase-current (flowing out of motor)
+  NUM_PWM_COMPS	// Handy Value!-)
+} COMP_PWM_ENUM;
+
 /** Enumeration of PWM Control-states */
 typedef enum CNTRL_PWM_ETAG
 {
@@ -111,7 +137,7 @@ typedef enum CNTRL_PWM_ETAG
 // NB Enumeration of PWM Phase-states in sc_pwm/module_foc_pwm/src/pwm_common.h
 
 /** Define maximum number of states for any test vector component (used to size arrays) */
-#define MAX_COMP_STATES NUM_PWM_WIDTHS	// Edit this line
+#define MAX_COMP_STATES NUM_PWM_COMPS	// Edit this line
 
 /** Type containing string */
 typedef struct STRING_TAG // Structure containing string array
@@ -22,6 +22,7 @@
 
 #include "app_global.h"
 #include "adc_common.h"
+#include "adc_pipeline.h"
 
 #ifndef ADC_FILTER
 	#error Define. ADC_FILTER in app_global.h
@@ -31,6 +32,20 @@
 	#error Define. NUMBER_OF_MOTORS in app_global.h
 #endif // NUMBER_OF_MOTORS
 
+/** Default ADC Oversampling: 2^ADC_OVERSAMPLE_BITS conversions per trigger (0 == Off) */
+#ifndef ADC_OVERSAMPLE_BITS
+	#define ADC_OVERSAMPLE_BITS 0
+#endif // ADC_OVERSAMPLE_BITS
+
+/** Default ADC Trigger-Delay Calibration Mode  1 == On */
+#ifndef ADC_DELAY_CALIB
+	#define ADC_DELAY_CALIB 1
+#endif // ADC_DELAY_CALIB
+
+#if ((ADC_OVERSAMPLE_BITS) && (ADC_FILTER))
+	#error ADC_FILTER must be 0 when ADC_OVERSAMPLE_BITS used (Oversampling replaces filter across PWM periods)
+#endif // ((ADC_OVERSAMPLE_BITS) && (ADC_FILTER))
+
 #define NUM_ADC_TRIGGERS NUMBER_OF_MOTORS	// The number of trigger channels coming from PWM units
 
 /*	The AD7265 data-sheet refers to the following signals:-
@@ -52,6 +67,16 @@
  *		A[0] selects between Fully/Pseudo Differential. We choose A[0] = 0 for Fully Differential.
  *		A[1,2] is dependant on the motor identifier, and selects between Motor ports V1/V3/V5
  *
+ *	On a board with a Phase_C shunt for each motor, ADC_PHASE_C_MUX gives the mux input for each trigger, e.g.
+ *	#define ADC_PHASE_C_MUX { 4 ,6 } // [NUM_ADC_TRIGGERS]
+ *	After the Phase_A/B conversions, the mux is switched to this input, and Phase_C is converted on ADC_PHASE_C_PORT.
+ *
+ *	On a board with a single (DC-link) shunt for each motor, ADC_SHUNT_MUX gives the mux input for each trigger, e.g.
+ *	#define ADC_SHUNT_MUX { 1 ,3 } // [NUM_ADC_TRIGGERS]
+ *	The PWM Server then sends 2 single-shunt tokens per period (see PWM_SINGLE_SHUNT), and the shunt is converted on ADC_SHUNT_PORT
+ *	after each one. A capture requested while the previous one is pending, is queued. After the 2nd capture,
+ *	the 3 phases are rebuilt (see rebuild_shunt_frame()). NB The Motor-Control Board has NO DC-link shunt.
+ *
  *	The AD7265 returns a sample with 12 active bits of data.
  *	For our configuration (SGL/DIFF=0, A[0]=0, RANGE=0), these bit are in 2's compliment format.
  *
@@ -90,55 +115,85 @@
 
 /* ADC_TRIGGER_DELAY needs to be tuned to move the ADC trigger point into the centre of the PWM 'OFF' period.
  * This value is related to the PWM_MAX_VALUE (in module_pwm_foc) and is independent of the Reference Frequency
+ * If the Client selects a different PWM period, it sends the new trigger advance (ADC_CMD_TRIG_ADV), and the delay is rebuilt from it.
  */
 #define ADC_TRIGGER_CORR 128 // Timing correction
-#define ADC_TRIGGER_DELAY (QUART_PWM_MAX - ADC_TRIGGER_CORR) // MB~ Re-tune
-
-// Parameters for filtering raw ADC values. WARNING: ADC_FILT_RES>2 will significantly reduce the ADC amplitude
-#define ADC_FILT_RES 2 // ADC Filter scaling resolution
-#define ADC_FILT_DIV (1 << ADC_FILT_RES) // ADC Filter scaling factor
-#define ADC_FILT_HALF (ADC_FILT_DIV >> 1) // Half ADC scaling factor (used for rounding)
+#define ADC_TRIGGER_DELAY_FROM_ADV(adv) ((adv) - ADC_TRIGGER_CORR) // Trigger delay for a given trigger advance
+#define ADC_TRIGGER_DELAY ADC_TRIGGER_DELAY_FROM_ADV(QUART_PWM_MAX) // MB~ Re-tune
 
-// Parameters for filtering to obtain the mean ADC values
-#define ADC_SCALE_BITS 16 // Used to generate 2^n scaling factor
-#define ADC_SCALE_DIV (1 << ADC_SCALE_BITS) // ADC scaling factor
-#define ADC_SCALE_HALF (ADC_SCALE_DIV >> 1) // Half Scaling factor (used in rounding)
-
-#define ADC_MAX_COEF_BITS 13 // Used to generate max. filter coef divisor. coef_div = 1/2^n
-#define ADC_MAX_COEF_DIV (1 << ADC_MAX_COEF_BITS) // Max. coef divisor
+/* If ADC_DELAY_CALIB is set, ADC_TRIGGER_DELAY is only the nominal delay.
+ * Before the offsets are calibrated, the delay is swept around the nominal value, and the quietest delay is selected.
+ * See adc_delay_calib.h for more detail.
+ */
+#define ADC_SWEEP_STEP_FROM_ADV(adv) ((adv) >> ADC_SWEEP_STEP_BITS) // Time between candidate delays for a given trigger advance
+#define ADC_SWEEP_STEP ADC_SWEEP_STEP_FROM_ADV(QUART_PWM_MAX) // Time between candidate trigger delays
 
-typedef struct ADC_PHASE_TAG // Structure containing data for one phase of ADC Trigger
-{
-	ADC_TYP adc_val; // measured current ADC value
-	ADC_TYP curr_raw; // current raw ADC value
-	ADC_TYP prev_raw; // previous raw ADC value
-	ADC_TYP mean; // local mean value
-	int filt_val; // (Upscaled) filtered value
-	int coef_err; // (Upscaled) Coefficient diffusion error
-	int scale_err; // (Upscaled) Scaling diffusion error
-	int rem; // remainder for error diffusion
-} ADC_PHASE_TYP;
-
-typedef struct ADC_FILT_TAG // Structure containing data for one ADC Trigger
-{
-	int coef_div; // coef = 1/coef_div
-	int coef_bits; // coef_div = 2^coef_bits
-	int half_div; // half coef_div (used for rounding)
-} ADC_FILT_TYP;
+/* In oversampling mode, ADC_OVERSAMPLES conversions are done back-to-back, in the same PWM 'OFF' period,
+ * and averaged. This gives cleaner samples, without the phase lag of a filter across PWM periods.
+ * The conversions are centred on the trigger point, so the first conversion starts ADC_OVERSAMPLE_ADVANCE early.
+ */
+#define ADC_OVERSAMPLES (1 << ADC_OVERSAMPLE_BITS) // No. of conversions per trigger
+#define ADC_OVERSAMPLE_HALF (ADC_OVERSAMPLES >> 1) // Half No. of conversions (used for rounding)
+#define ADC_CONV_GAP 32 // Approx. time between conversions, for reading ports (in Reference Frequency Cycles) MB~ Re-tune
+#define ADC_CONV_TICKS ((ADC_TOTAL_BITS * PLATFORM_REFERENCE_MHZ + ADC_SCLK_MHZ - 1) / ADC_SCLK_MHZ + ADC_CONV_GAP) // Time for one conversion
+
+#ifdef ADC_PHASE_C_MUX
+#define ADC_PHASE_C_PORT 0 // ADC data port used to convert Phase_C
+#define ADC_MUX_GROUPS 2 // No. of mux inputs converted per trigger (Phase_A/B, then Phase_C)
+#else // ADC_PHASE_C_MUX
+#define ADC_MUX_GROUPS 1 // No. of mux inputs converted per trigger (Phase_A/B)
+#endif // else !ADC_PHASE_C_MUX
+
+#ifdef ADC_SHUNT_MUX
+#define ADC_SHUNT_PORT 0 // ADC data port used to convert single shunt
+
+#ifdef ADC_PHASE_C_MUX
+	#error ADC_SHUNT_MUX and ADC_PHASE_C_MUX can NOT both be defined
+#endif // ADC_PHASE_C_MUX
+
+#if (ADC_DELAY_CALIB)
+	#error ADC_DELAY_CALIB must be 0 when ADC_SHUNT_MUX used (PWM Server places each single-shunt trigger)
+#endif // (ADC_DELAY_CALIB)
+
+#if (ADC_OVERSAMPLE_BITS)
+	#error ADC_OVERSAMPLE_BITS must be 0 when ADC_SHUNT_MUX used (Conversions must NOT overrun the measurement window)
+#endif // (ADC_OVERSAMPLE_BITS)
+#endif // ADC_SHUNT_MUX
+
+#define ADC_OVERSAMPLE_ADVANCE (((ADC_MUX_GROUPS * ADC_OVERSAMPLES - 1) * ADC_CONV_TICKS) >> 1) // Start of 1st conversion before trigger point
+
+// NB Checks the default PWM period only. A shorter period selected at run-time is rejected by the server (see ADC_CMD_TRIG_ADV)
+#if (ADC_OVERSAMPLE_ADVANCE >= ADC_TRIGGER_DELAY)
+	#error ADC_OVERSAMPLE_BITS too large: Conversions do NOT fit in PWM 'OFF' period
+#endif // (ADC_OVERSAMPLE_ADVANCE >= ADC_TRIGGER_DELAY)
+
+/* The DC offsets are calibrated by the ADC pipeline (see adc_pipeline.h) when the ADC server starts,
+ * and calibration can be re-started by the client (ADC_CMD_CALIB_START).
+ * If a board has already been calibrated, its offsets can be stored in app_global.h, e.g.
+ * #define ADC_BOARD_OFFSETS {{ -3 ,5 } ,{ 2 ,-1 }} // [NUM_ADC_TRIGGERS][MEAS_ADC_PHASES]
+ * The stored offsets are then used from start-up, and NO calibration is done.
+ */
 
 typedef struct ADC_DATA_TAG // Structure containing data for one ADC Trigger
 {
 	ADC_PARAM_TYP params; // Structure containing ADC parameters (for Client)
-	ADC_PHASE_TYP phase_data[USED_ADC_PHASES]; // Array of structures for each phase
-	ADC_FILT_TYP filt; // Filter parameters. NB Need to have separate structure to satisfy XC rules on aliasing
+	ADC_PIPE_TYP pipe; // Structure containing chip-independent pipeline data (filter and calibration)
 	timer my_timer;	// timer
 	unsigned time_stamp; 	// time-stamp
 	char guard_off;	// Guard
 	int mux_id; // Mux input identifier
-	int filt_cnt; // Counter used in filter
+#ifdef ADC_PHASE_C_MUX
+	int mux_c_id; // Mux input identifier for Phase_C
+#endif // ADC_PHASE_C_MUX
+#ifdef ADC_SHUNT_MUX
+	int mux_shunt_id; // Mux input identifier for single shunt
+	ADC_SHUNT_TYP shunt; // Structure containing single-shunt samples, and outstanding captures (see adc_pipeline.h)
+	unsigned queue_time; // time-stamp of queued capture
+#endif // ADC_SHUNT_MUX
 	int id; // Trigger id
 } ADC_DATA_TYP;
 
+#ifdef __XC__ // NB The structure above is also sized by the host budget model (see src.dir/foc_budget_model.c)
 /*****************************************************************************/
 /** \brief Implements the AD7265 triggered ADC service
  *
@@ -163,5 +218,6 @@ void foc_adc_7265_triggered( // On request, Transmits new sampled ADC values ove
 	port out p4_mux // port to allow the selection of the analogue MUX input
 );
 /*****************************************************************************/
+#endif // __XC__
 
 #endif /* _ADC_7265_H_ */
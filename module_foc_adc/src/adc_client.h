@@ -35,4 +35,31 @@ void foc_adc_get_parameters( // Get 12-bit ADC values and convert to signed 32-b
 	streaming chanend c_adc // Channel connecting ADC to client and server
 );
 /*****************************************************************************/
+/** (Re-)Start ADC offset calibration. WARNING: PWM must be off until calibration is done
+ * \param c_adc  // channel connecting ADC client and server
+ */
+void foc_adc_start_calibration( // (Re-)Start ADC offset calibration
+	streaming chanend c_adc // Channel connecting ADC to client and server
+);
+/*****************************************************************************/
+/** Get ADC offset calibration data (e.g. to check calibration is done, or to store offsets for this board)
+ * \param adc_calib_s // Structure containing ADC offset calibration data
+ * \param c_adc  // channel connecting ADC client and server
+ */
+void foc_adc_get_calibration( // Get ADC offset calibration data
+	ADC_CALIB_TYP &adc_calib_s, // Structure containing ADC offset calibration data
+	streaming chanend c_adc // Channel connecting ADC to client and server
+);
+/*****************************************************************************/
+/** Set PWM trigger advance, after a change of PWM period. WARNING: PWM must be off until calibration is done
+ * NB If the trigger delay is calibrated (ADC_DELAY_CALIB), the calibration is restarted
+ * \param trig_adv // Time PWM trigger is sent before centre of PWM 'OFF' period (Quarter of PWM period)
+ * \param c_adc  // channel connecting ADC client and server
+ * \return 1 if accepted, 0 if ADC conversions do NOT fit in PWM 'OFF' period (previous trigger delay kept)
+ */
+int foc_adc_set_trigger_advance( // Set PWM trigger advance, after a change of PWM period
+	int trig_adv, // Time PWM trigger is sent before centre of PWM 'OFF' period
+	streaming chanend c_adc // Channel connecting ADC to client and server
+);
+/*****************************************************************************/
 #endif // _ADC_CLIENT_H_
@@ -18,6 +18,7 @@
 #define _ADC_COMMON_H_
 
 #include "use_locks.h"
+#include "app_global.h"
 
 #define ADC_UPSCALE_BITS 2 // No of bits used when upsacaling ADC values (to improve precision)
 #define ADC_UPSCALE_FACTOR (1 << ADC_UPSCALE_BITS) // Factor for upsacaling ADC values (to improve precision)
@@ -35,10 +36,35 @@ typedef enum ADC_PHASE_ETAG
 // NB H/W only returns 1st and 2nd phases, 3rd Phase can be inferred as 3 phases sum to zero
 #define USED_ADC_PHASES (NUM_ADC_PHASES - 1)
 
+/* If the board also has a Phase_C shunt connected to an ADC mux input (ADC_PHASE_C_MUX defined in app_global.h),
+ * then all 3 phases are measured, and NO phase is inferred. The client then chooses which 2 phases to trust.
+ */
+#ifdef ADC_PHASE_C_MUX
+#define MEAS_ADC_PHASES NUM_ADC_PHASES // No. of measured ADC phases
+#else // ADC_PHASE_C_MUX
+#ifdef ADC_SHUNT_MUX
+#define MEAS_ADC_PHASES NUM_ADC_PHASES // No. of measured ADC phases (Rebuilt from single-shunt samples)
+#else // ADC_SHUNT_MUX
+#define MEAS_ADC_PHASES USED_ADC_PHASES // No. of measured ADC phases
+#endif // else !ADC_SHUNT_MUX
+#endif // else !ADC_PHASE_C_MUX
+
+/* If the board has a single (DC-link) shunt (ADC_SHUNT_MUX defined in app_global.h), the PWM Server sends 2 triggers per period
+ * (see PWM_SINGLE_SHUNT in module_foc_pwm). Each trigger is a control token, that identifies the sample and the measured phase.
+ * WARNING: ADC_SHUNT_CT_BASE must match PWM_SHUNT_CT_BASE in pwm_common.h (module_foc_pwm)
+ */
+#define ADC_SHUNT_CT_BASE 0x10 // 1st single-shunt control token
+#define ADC_SHUNT_CT_LIM (ADC_SHUNT_CT_BASE + (ADC_SHUNT_SAMPS * NUM_ADC_PHASES)) // Single-shunt tokens are below this limit (see adc_pipeline.h)
+#define ADC_SHUNT_CT_SAMP(token) (((token) - ADC_SHUNT_CT_BASE) / NUM_ADC_PHASES) // Sample index of single-shunt token
+#define ADC_SHUNT_CT_PHASE(token) (((token) - ADC_SHUNT_CT_BASE) % NUM_ADC_PHASES) // Measured phase of single-shunt token
+
 /** Different ADC Commands */
 typedef enum CMD_ADC_ETAG
 {
   ADC_CMD_DATA_REQ = 0,  // Request ADC data
+	ADC_CMD_CALIB_START, // (Re-)Start ADC offset calibration. WARNING: PWM must be off
+	ADC_CMD_CALIB_REQ, // Request ADC offset calibration data
+	ADC_CMD_TRIG_ADV, // Set PWM trigger advance (after change of PWM period): Expect another parameter, and reply if accepted. WARNING: PWM must be off
 	ADC_CMD_LOOP_STOP, // Stop while-loop.
 	ADC_CMD_ACK,	// Acknowledge Command from control loop
   NUM_ADC_CMDS    // Handy Value!-)
@@ -53,4 +79,12 @@ typedef struct ADC_PARAM_TAG // Structure containing ADC parameters
 	ADC_TYP vals[NUM_ADC_PHASES]; // Array of ADC values for each phase
 } ADC_PARAM_TYP;
 
+/** Structure containing ADC offset calibration data for one motor */
+typedef struct ADC_CALIB_TAG // Structure containing ADC offset calibration data
+{
+	ADC_TYP offsets[MEAS_ADC_PHASES]; // Array of calibrated DC offsets for each measured phase (e.g. to store per board)
+	int done; // Flag set when offsets are calibrated
+	int trig_delay; // Calibrated time from PWM control token to ADC capture
+} ADC_CALIB_TYP;
+
 #endif /* _ADC_COMMON_H_ */
@@ -0,0 +1,171 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "adc_delay_calib.h"
+
+/*****************************************************************************/
+static int calc_sweep_delay( // Calculate trigger delay for one candidate
+	ADC_DELAY_CALIB_TYP * calib_p, // Pointer to structure containing data for ADC trigger delay calibration
+	int step_cnt // Candidate identifier
+) // Returns trigger delay
+{
+	int out_delay = calib_p->nom_delay + (step_cnt - ADC_SWEEP_HALF) * calib_p->step; // Candidate trigger delay
+
+
+	// NB Delay can NOT be negative
+	if (0 > out_delay)
+	{
+		out_delay = 0;
+	} // if (0 > out_delay)
+
+	return out_delay;
+} // calc_sweep_delay
+/*****************************************************************************/
+static void clear_sweep_sums( // Clear sums used to measure noise at one candidate delay
+	ADC_DELAY_CALIB_TYP * calib_p // Pointer to structure containing data for ADC trigger delay calibration
+)
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	for (phase_cnt=0; phase_cnt<ADC_SWEEP_PHASES; phase_cnt++)
+	{
+		calib_p->sums[phase_cnt] = 0;
+		calib_p->sum_sqrs[phase_cnt] = 0;
+	} // for phase_cnt
+
+	calib_p->samp_cnt = 0;
+} // clear_sweep_sums
+/*****************************************************************************/
+void init_adc_delay_calib( // (Re-)Start ADC trigger delay calibration
+	ADC_DELAY_CALIB_TYP * calib_p, // Pointer to structure containing data for ADC trigger delay calibration
+	int nom_delay, // Nominal trigger delay
+	int step // Time between candidate delays
+)
+{
+	assert(0 < step); // ERROR: Candidate delays must be different
+
+	calib_p->nom_delay = nom_delay;
+	calib_p->step = step;
+	calib_p->step_cnt = 0;
+	calib_p->done = 0;
+
+	clear_sweep_sums( calib_p );
+
+	calib_p->delay = calc_sweep_delay( calib_p ,0 ); // Start sweep at earliest delay
+} // init_adc_delay_calib
+/*****************************************************************************/
+static void select_quiet_delay( // Select centre of widest quiet plateau of candidate delays
+	ADC_DELAY_CALIB_TYP * calib_p // Pointer to structure containing data for ADC trigger delay calibration
+)
+{
+	ADC_NOISE_TYP min_noise = calib_p->noise[0]; // Minimum measured noise
+	ADC_NOISE_TYP quiet_lim; // Max. noise for a quiet candidate
+	int best_strt = 0; // First candidate of widest quiet plateau
+	int best_len = 0; // Length of widest quiet plateau
+	int run_strt = 0; // First candidate of current quiet plateau
+	int run_len = 0; // Length of current quiet plateau
+	int step_cnt; // Candidate counter
+
+
+	for (step_cnt=1; step_cnt<NUM_ADC_SWEEP_STEPS; step_cnt++)
+	{
+		if (min_noise > calib_p->noise[step_cnt])
+		{
+			min_noise = calib_p->noise[step_cnt];
+		} // if (min_noise > calib_p->noise[step_cnt])
+	} // for step_cnt
+
+	quiet_lim = min_noise + (min_noise >> ADC_SWEEP_TOL_BITS) + 1; // NB +1 handles zero noise
+
+	for (step_cnt=0; step_cnt<NUM_ADC_SWEEP_STEPS; step_cnt++)
+	{
+		if (quiet_lim >= calib_p->noise[step_cnt])
+		{
+			if (0 == run_len)
+			{
+				run_strt = step_cnt; // Start of new plateau
+			} // if (0 == run_len)
+
+			run_len++;
+
+			if (best_len < run_len)
+			{
+				best_strt = run_strt;
+				best_len = run_len;
+			} // if (best_len < run_len)
+		} // if (quiet_lim >= calib_p->noise[step_cnt])
+		else
+		{
+			run_len = 0;
+		} // else !(quiet_lim >= calib_p->noise[step_cnt])
+	} // for step_cnt
+
+	// Centre of plateau (NB Rounded, and may lie half-way between candidates)
+	calib_p->delay = (calc_sweep_delay( calib_p ,best_strt ) + calc_sweep_delay( calib_p ,(best_strt + best_len - 1) ) + 1) >> 1;
+	calib_p->done = 1;
+} // select_quiet_delay
+/*****************************************************************************/
+void update_adc_delay_calib( // Add one set of ADC samples to ADC trigger delay calibration
+	ADC_DELAY_CALIB_TYP * calib_p, // Pointer to structure containing data for ADC trigger delay calibration
+	int inp_vals[], // Array of raw ADC values, for each phase
+	int num_phases // No. of ADC phases
+)
+{
+	ADC_NOISE_TYP sum_noise = 0; // Sum of (up-scaled) phase variances
+	int phase_cnt; // ADC Phase counter
+
+
+	assert(ADC_SWEEP_PHASES >= num_phases); // ERROR: Too many ADC phases
+
+	if (calib_p->done)
+	{
+		return;
+	} // if (calib_p->done)
+
+	for (phase_cnt=0; phase_cnt<num_phases; phase_cnt++)
+	{
+		calib_p->sums[phase_cnt] += inp_vals[phase_cnt];
+		calib_p->sum_sqrs[phase_cnt] += (ADC_NOISE_TYP)inp_vals[phase_cnt] * (ADC_NOISE_TYP)inp_vals[phase_cnt];
+	} // for phase_cnt
+
+	calib_p->samp_cnt++;
+
+	// Check if enough samples measured at this candidate delay
+	if (ADC_SWEEP_SAMPS <= calib_p->samp_cnt)
+	{
+		// NB N^2.Variance = N.Sum(x^2) - Sum(x)^2
+		for (phase_cnt=0; phase_cnt<num_phases; phase_cnt++)
+		{
+			sum_noise += (calib_p->sum_sqrs[phase_cnt] << ADC_SWEEP_SAMP_BITS)
+				- (ADC_NOISE_TYP)calib_p->sums[phase_cnt] * (ADC_NOISE_TYP)calib_p->sums[phase_cnt];
+		} // for phase_cnt
+
+		calib_p->noise[calib_p->step_cnt] = sum_noise;
+
+		clear_sweep_sums( calib_p );
+		calib_p->step_cnt++;
+
+		if (NUM_ADC_SWEEP_STEPS > calib_p->step_cnt)
+		{
+			calib_p->delay = calc_sweep_delay( calib_p ,calib_p->step_cnt ); // Move to next candidate
+		} // if (NUM_ADC_SWEEP_STEPS > calib_p->step_cnt)
+		else
+		{
+			select_quiet_delay( calib_p ); // Sweep complete
+		} // else !(NUM_ADC_SWEEP_STEPS > calib_p->step_cnt)
+	} // if (ADC_SWEEP_SAMPS <= calib_p->samp_cnt)
+} // update_adc_delay_calib
+/*****************************************************************************/
+// adc_delay_calib.c
@@ -0,0 +1,100 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _ADC_DELAY_CALIB_H_
+#define _ADC_DELAY_CALIB_H_
+
+#include <assert.h>
+
+/* Calibration of the ADC trigger delay (time from PWM control token to ADC capture).
+ * The PWM sends its control token early, so the ADC must wait until the centre of the PWM 'OFF' period,
+ * where the current is free of switching ripple. Any change to the PWM resolution, dead-time or clocking moves this centre.
+ *
+ * The calibration sweeps the delay over NUM_ADC_SWEEP_STEPS candidates, spaced 'step' apart, and centred on the nominal delay.
+ * At each candidate, ADC_SWEEP_SAMPS samples are taken, and the variance of each phase is measured.
+ * Samples near a PWM edge are noisy, so the candidates with noise close to the minimum form a quiet plateau.
+ * The delay is set to the centre of the widest quiet plateau (i.e. as far as possible from the PWM edges).
+ * WARNING: The PWM must hold a constant voltage vector during the sweep (e.g. motor stopped)
+ *
+ * NB This file is independent of XMOS hardware, so can also be compiled in a host test (see src.dir)
+ */
+
+#define ADC_SWEEP_HALF 8 // No. of candidate delays either side of nominal delay
+#define NUM_ADC_SWEEP_STEPS ((ADC_SWEEP_HALF << 1) + 1) // No. of candidate delays
+#define ADC_SWEEP_STEP_BITS 3 // Step is (quarter PWM period) / 2^ADC_SWEEP_STEP_BITS. NB Sweep then spans about half a PWM period
+#define ADC_SWEEP_SAMP_BITS 6 // Used to generate No. of samples per candidate delay. sweep_samps = 2^n
+#define ADC_SWEEP_SAMPS (1 << ADC_SWEEP_SAMP_BITS) // No. of samples measured at each candidate delay
+#define ADC_SWEEP_TOL_BITS 1 // Candidate is quiet if noise <= min_noise * (1 + 1/2^ADC_SWEEP_TOL_BITS)
+#define ADC_SWEEP_PHASES 3 // Max. No. of ADC phases measured
+
+/** Type for ADC noise measurements (NB Large dynamic range) */
+typedef signed long long ADC_NOISE_TYP;
+
+/** Structure containing data for ADC trigger delay calibration */
+typedef struct ADC_DELAY_CALIB_TAG
+{
+	ADC_NOISE_TYP noise[NUM_ADC_SWEEP_STEPS]; // Measured noise for each candidate delay (Sum of phase variances, up-scaled by ADC_SWEEP_SAMPS^2)
+	ADC_NOISE_TYP sum_sqrs[ADC_SWEEP_PHASES]; // Sum of squared ADC values, for each phase
+	int sums[ADC_SWEEP_PHASES]; // Sum of ADC values, for each phase
+	int nom_delay; // Nominal trigger delay (centre of sweep)
+	int step; // Time between candidate delays
+	int step_cnt; // Current candidate delay
+	int samp_cnt; // No. of samples measured at current candidate delay
+	int delay; // Trigger delay to use for next sample (output)
+	int done; // Flag set when calibration complete (output)
+} ADC_DELAY_CALIB_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief (Re-)Start ADC trigger delay calibration
+ * \param calib_s // Reference to structure containing data for ADC trigger delay calibration
+ * \param nom_delay // Nominal trigger delay (centre of sweep)
+ * \param step // Time between candidate delays
+ */
+void init_adc_delay_calib( // (Re-)Start ADC trigger delay calibration
+	ADC_DELAY_CALIB_TYP &calib_s, // Reference to structure containing data for ADC trigger delay calibration
+	int nom_delay, // Nominal trigger delay
+	int step // Time between candidate delays
+);
+/*****************************************************************************/
+/** \brief Add one set of ADC samples (taken with current delay) to ADC trigger delay calibration
+ * \param calib_s // Reference to structure containing data for ADC trigger delay calibration
+ * \param inp_vals // Array of raw ADC values, for each phase
+ * \param num_phases // No. of ADC phases
+ */
+void update_adc_delay_calib( // Add one set of ADC samples to ADC trigger delay calibration
+	ADC_DELAY_CALIB_TYP &calib_s, // Reference to structure containing data for ADC trigger delay calibration
+	int inp_vals[], // Array of raw ADC values, for each phase
+	int num_phases // No. of ADC phases
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_adc_delay_calib( // (Re-)Start ADC trigger delay calibration
+	ADC_DELAY_CALIB_TYP * calib_p, // Pointer to structure containing data for ADC trigger delay calibration
+	int nom_delay, // Nominal trigger delay
+	int step // Time between candidate delays
+);
+/*****************************************************************************/
+void update_adc_delay_calib( // Add one set of ADC samples to ADC trigger delay calibration
+	ADC_DELAY_CALIB_TYP * calib_p, // Pointer to structure containing data for ADC trigger delay calibration
+	int inp_vals[], // Array of raw ADC values, for each phase
+	int num_phases // No. of ADC phases
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _ADC_DELAY_CALIB_H_
@@ -0,0 +1,467 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "adc_pipeline.h"
+
+/*****************************************************************************/
+static void init_adc_phase( // Initialise the pipeline data for one phase
+	ADC_PHASE_TYP * phase_data_p // Pointer to structure containing pipeline data for one phase
+)
+{
+	phase_data_p->mean = 0; // Clear local mean value
+	phase_data_p->calib_sum = 0; // Clear sum of calibration values
+	phase_data_p->adc_val = 0; // Clear measured current ADC value
+	phase_data_p->rem = 0; // Clear remainder for error diffusion
+	phase_data_p->curr_raw = 0; // Clear current raw ADC value
+	phase_data_p->prev_raw = 0; // Clear previous raw ADC value
+} // init_adc_phase
+/*****************************************************************************/
+void init_adc_pipeline( // Initialise ADC pipeline for one trigger
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int num_phases, // No. of measured phases in each raw frame
+	int filter, // Flag set if raw values are filtered
+	int sweep, // Flag set if trigger delay is calibrated
+	int nom_delay, // Nominal trigger delay
+	int sweep_step // Time between candidate trigger delays
+)
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	assert(ADC_PIPE_PHASES >= num_phases); // ERROR: Too many ADC phases
+	assert(ADC_SWEEP_PHASES >= num_phases); // ERROR: Too many ADC phases for trigger delay calibration
+
+	// Loop through measured ADC phases
+	for (phase_cnt=0; phase_cnt<num_phases; ++phase_cnt)
+	{
+		init_adc_phase( &pipe_p->phase_data[phase_cnt] );
+	} // for phase_cnt
+
+	pipe_p->num_phases = num_phases;
+	pipe_p->filter = filter;
+	pipe_p->sweep = sweep;
+	pipe_p->nom_delay = nom_delay;
+	pipe_p->sweep_step = sweep_step;
+	pipe_p->filt_cnt = 0; // Initialise filter count
+	pipe_p->calib_cnt = 0;
+	pipe_p->calib_done = 0; // Offsets NOT yet calibrated
+	pipe_p->trig_delay = nom_delay;
+	pipe_p->delay_calib.done = 1; // NO trigger delay sweep in progress
+} // init_adc_pipeline
+/*****************************************************************************/
+void start_adc_pipeline_calib( // (Re-)Start calibration of trigger delay and offsets
+	ADC_PIPE_TYP * pipe_p // Pointer to structure containing pipeline data for one ADC trigger
+)
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	// Loop through measured ADC phases
+	for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+	{
+		pipe_p->phase_data[phase_cnt].calib_sum = 0; // Clear sum of calibration values
+	} // for phase_cnt
+
+	pipe_p->calib_cnt = 0; // Clear No. of calibration samples
+	pipe_p->calib_done = 0; // Clear flag until offsets calibrated
+
+	if (pipe_p->sweep)
+	{
+		// NB Trigger delay is calibrated first, so offsets are calibrated at the selected delay
+		init_adc_delay_calib( &pipe_p->delay_calib ,pipe_p->nom_delay ,pipe_p->sweep_step );
+		pipe_p->trig_delay = pipe_p->delay_calib.delay;
+	} // if (pipe_p->sweep)
+	else
+	{
+		pipe_p->trig_delay = pipe_p->nom_delay;
+		pipe_p->delay_calib.done = 1; // NO trigger delay calibration
+	} // else !(pipe_p->sweep)
+} // start_adc_pipeline_calib
+/*****************************************************************************/
+void set_adc_pipeline_delay( // Change nominal trigger delay
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int nom_delay, // Nominal trigger delay
+	int sweep_step // Time between candidate trigger delays
+)
+{
+	assert(0 < nom_delay); // ERROR: Trigger delay must be after PWM trigger
+
+	pipe_p->nom_delay = nom_delay;
+	pipe_p->sweep_step = sweep_step;
+
+	if (pipe_p->sweep)
+	{ // NB Previously selected delay is NOT valid for new PWM period
+		start_adc_pipeline_calib( pipe_p );
+	} // if (pipe_p->sweep)
+	else
+	{
+		pipe_p->trig_delay = nom_delay;
+	} // else !(pipe_p->sweep)
+} // set_adc_pipeline_delay
+/*****************************************************************************/
+void preset_adc_pipeline_offsets( // Use stored offsets
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int offsets[] // Array of stored offsets for each measured phase
+)
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	// Loop through measured ADC phases
+	for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+	{
+		pipe_p->phase_data[phase_cnt].mean = offsets[phase_cnt]; // Use stored offset
+	} // for phase_cnt
+
+	pipe_p->calib_cnt = ADC_CALIB_SAMPS;
+	pipe_p->calib_done = 1; // Offsets already calibrated
+	pipe_p->trig_delay = pipe_p->nom_delay;
+	pipe_p->delay_calib.done = 1;
+} // preset_adc_pipeline_offsets
+/*****************************************************************************/
+static int median3_filter( // Returns median of 3 input values
+	ADC_PHASE_TYP * phase_data_p, // Pointer to structure containing pipeline data for one phase
+	int new_val  // newest (32-bit) ADC value
+)
+// This code filters out single-sample glitchs, as follows ...
+// The filter ranks 3 values [New ,Current ,Previous] in order of size, then returns the central value.
+{
+	int cur_val = phase_data_p->curr_raw; // current raw ADC value
+	int prev_val = phase_data_p->prev_raw; // previous raw ADC value
+
+
+	if (new_val < cur_val)
+	{ // N < (C,P) or P < N < C
+
+		if (cur_val < prev_val)
+		{ // N < C < P
+			return cur_val;
+		} // if (cur_val < prev_val)
+		else
+		{ // (N,P) < C
+
+			if (new_val < prev_val)
+			{ // N < P < C
+				return prev_val;
+			} // if (new_val < prev_val)
+			else
+			{ // P < N < C
+				return new_val;
+			}	// else !(new_val < prev_val)
+		}	// else !(cur_val < prev_val)
+	} // if (new_val < cur_val)
+	else
+	{ // C < (N,P) or C < N <= P
+
+		if (cur_val < prev_val)
+		{ // C < (N,P)
+
+			if (new_val < prev_val)
+			{ // C < N < P
+				return new_val;
+			} // if (new_val < prev_val)
+			else
+			{ // C < P < N
+				return prev_val;
+			}	// else !(new_val < prev_val)
+		} // if (cur_val < prev_val)
+		else
+		{ // P < C < N
+			return cur_val;
+		}	// else !(cur_val < prev_val)
+	} // else !(new_val < cur_val)
+
+} // median3_filter
+/*****************************************************************************/
+static void filter_adc_phase( // Process one raw ADC value for one phase
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	ADC_PHASE_TYP * phase_data_p, // Pointer to structure containing pipeline data for one phase
+	int inp_val // signed (32-bit) raw ADC input value
+)
+{
+	int out_val = inp_val; // (possibly filtered) output value. NB Preset to raw input value
+
+
+	// Check if filtering selected, and enough data to filter
+	if ((pipe_p->filter) && (1 < pipe_p->filt_cnt))
+	{ // Enough data so filter
+		int prev_val = phase_data_p->adc_val; // get previous filtered value
+		int corr_val; // Correction to previous value
+
+
+		// Remove single-sample spikes
+		out_val = median3_filter( phase_data_p ,inp_val ); // returns median of 3 adjacent ADC values.
+
+		// Do Low-pass filter ...
+
+		corr_val = (out_val - prev_val); // compute correction to previous filtered value
+		corr_val += phase_data_p->rem; // Add in error diffusion remainder
+
+		out_val = (corr_val + ADC_FILT_HALF) >> ADC_FILT_RES; // 1st order filter (uncalibrated value)
+		phase_data_p->rem = corr_val - (out_val << ADC_FILT_RES); // Update remainder
+		out_val += prev_val; // Add filtered difference to previous value
+	} // if ((pipe_p->filter) && (1 < pipe_p->filt_cnt))
+
+	phase_data_p->adc_val = out_val; // Update uncalibrated value
+
+	// update store of raw values
+	phase_data_p->prev_raw = phase_data_p->curr_raw;
+	phase_data_p->curr_raw = inp_val;
+} // filter_adc_phase
+/*****************************************************************************/
+static void calibrate_adc_offsets( // Accumulate ADC values, and freeze mean values when enough samples
+	ADC_PIPE_TYP * pipe_p // Pointer to structure containing pipeline data for one ADC trigger
+)
+/* With the PWM off there is NO coil current, so the mean ADC value of each phase is the DC offset.
+ * The mean is evaluated over exactly ADC_CALIB_SAMPS samples, then frozen until the next calibration.
+ */
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	// Loop through measured phases
+	for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+	{
+		pipe_p->phase_data[phase_cnt].calib_sum += pipe_p->phase_data[phase_cnt].adc_val; // Accumulate ADC value
+	} // for phase_cnt
+
+	pipe_p->calib_cnt++; // Update sample count
+
+	// Check if enough samples accumulated
+	if (ADC_CALIB_SAMPS <= pipe_p->calib_cnt)
+	{
+		// Loop through measured phases
+		for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+		{
+			pipe_p->phase_data[phase_cnt].mean = (pipe_p->phase_data[phase_cnt].calib_sum + ADC_CALIB_HALF) >> ADC_CALIB_BITS;
+		} // for phase_cnt
+
+		pipe_p->calib_done = 1; // Freeze offsets
+	} // if (ADC_CALIB_SAMPS <= pipe_p->calib_cnt)
+} // calibrate_adc_offsets
+/*****************************************************************************/
+static void sweep_trigger_delay( // Add latest ADC values to trigger delay calibration, and update trigger delay
+	ADC_PIPE_TYP * pipe_p // Pointer to structure containing pipeline data for one ADC trigger
+)
+{
+	int raw_vals[ADC_PIPE_PHASES]; // Array of raw ADC values (NB Filtered values would hide PWM ripple)
+	int phase_cnt; // ADC Phase counter
+
+
+	// Loop through measured phases
+	for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+	{
+		raw_vals[phase_cnt] = pipe_p->phase_data[phase_cnt].curr_raw;
+	} // for phase_cnt
+
+	update_adc_delay_calib( &pipe_p->delay_calib ,raw_vals ,pipe_p->num_phases );
+
+	pipe_p->trig_delay = pipe_p->delay_calib.delay; // Delay for next capture
+} // sweep_trigger_delay
+/*****************************************************************************/
+void process_adc_frame( // Process one raw ADC frame
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int raw_vals[] // Array of raw ADC values, for each measured phase
+)
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	// Loop through measured phases
+	for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+	{
+		filter_adc_phase( pipe_p ,&pipe_p->phase_data[phase_cnt] ,raw_vals[phase_cnt] );
+	} // for phase_cnt
+
+	// NB The median filter (see ADC_FILTER) needs 2 previous samples
+	if (1 >= pipe_p->filt_cnt)
+	{
+		pipe_p->filt_cnt++; // Update sample count
+	} // if (1 >= pipe_p->filt_cnt)
+
+	/* The mean values are frozen after calibration (see calibrate_adc_offsets).
+	 * So in run mode, there is NO per-sample filtering of the mean.
+	 */
+	if (0 == pipe_p->calib_done)
+	{
+		// Check if trigger delay calibrated
+		if (pipe_p->delay_calib.done)
+		{
+			calibrate_adc_offsets( pipe_p );
+		} // if (pipe_p->delay_calib.done)
+		else
+		{
+			sweep_trigger_delay( pipe_p );
+		} // else !(pipe_p->delay_calib.done)
+	} // if (0 == pipe_p->calib_done)
+} // process_adc_frame
+/*****************************************************************************/
+void rebuild_shunt_frame( // Rebuild raw ADC frame of all 3 phases, from 2 single-shunt samples
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int raw_vals[], // Array of raw ADC values, for each phase (output)
+	int shunt_vals[], // Array of raw single-shunt samples
+	int shunt_phases[] // Array of phases measured by each single-shunt sample
+)
+/* With shunt offset Z, the samples are (Z + I_first) and (Z - I_last). Each phase is rebuilt as (Z + I):
+ *		First phase:	sample_0
+ *		Last phase:		2Z - sample_1
+ *		Other phase:	3Z - (First + Last), as the 3 currents sum to zero
+ * Before the offsets are calibrated (PWM off, so NO current), Z is taken from sample_0.
+ * Afterwards, Z is the mean of the calibrated offsets (which all equal the shunt offset).
+ */
+{
+	int zero_val; // Shunt offset
+	int phase_cnt; // ADC Phase counter
+
+
+	assert(ADC_PIPE_PHASES == pipe_p->num_phases); // ERROR: Single-shunt rebuilds all 3 phases
+	assert(shunt_phases[0] != shunt_phases[1]); // ERROR: Both samples measured same phase
+
+	if (pipe_p->calib_done)
+	{
+		zero_val = 0;
+
+		// Loop through phases
+		for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; ++phase_cnt)
+		{
+			zero_val += pipe_p->phase_data[phase_cnt].mean;
+		} // for phase_cnt
+
+		zero_val /= ADC_PIPE_PHASES;
+	} // if (pipe_p->calib_done)
+	else
+	{
+		zero_val = shunt_vals[0];
+	} // else !(pipe_p->calib_done)
+
+	// Preset all phases to the phase NOT sampled
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; ++phase_cnt)
+	{
+		raw_vals[phase_cnt] = zero_val - shunt_vals[0] + shunt_vals[1];
+	} // for phase_cnt
+
+	raw_vals[shunt_phases[0]] = shunt_vals[0];
+	raw_vals[shunt_phases[1]] = (zero_val << 1) - shunt_vals[1];
+} // rebuild_shunt_frame
+/*****************************************************************************/
+void init_adc_shunt( // Initialise single-shunt sample data
+	ADC_SHUNT_TYP * shunt_p // Pointer to structure containing single-shunt sample data
+)
+{
+	int samp_cnt; // Single-shunt sample counter
+
+
+	for (samp_cnt=0; samp_cnt<ADC_SHUNT_SAMPS; ++samp_cnt)
+	{
+		shunt_p->vals[samp_cnt] = 0;
+		shunt_p->phases[samp_cnt] = samp_cnt;
+	} // for samp_cnt
+
+	shunt_p->queue_cnt = 0; // NO outstanding captures
+	shunt_p->got_first = 0; // Wait for 1st sample of a PWM period
+} // init_adc_shunt
+/*****************************************************************************/
+int request_shunt_sample( // Request capture of one single-shunt sample
+	ADC_SHUNT_TYP * shunt_p, // Pointer to structure containing single-shunt sample data
+	int samp_id, // Sample index (0 == 1st sample of PWM period)
+	int phase_id // Phase measured by sample
+) // Returns 1 if capture must be started now, 0 if queued behind pending capture
+{
+	int queue_id = shunt_p->queue_cnt; // Queue position of this capture
+
+
+	assert(ADC_SHUNT_SAMPS > samp_id); // ERROR: Unknown single-shunt sample
+
+	// Check for full queue. NB The newest request replaces the queued capture, which has NOT yet started
+	if (ADC_SHUNT_QUEUE <= queue_id)
+	{
+		queue_id = ADC_SHUNT_QUEUE - 1;
+	} // if (ADC_SHUNT_QUEUE <= queue_id)
+	else
+	{
+		shunt_p->queue_cnt++;
+	} // else !(ADC_SHUNT_QUEUE <= queue_id)
+
+	shunt_p->queue_samps[queue_id] = samp_id;
+	shunt_p->queue_phases[queue_id] = phase_id;
+
+	return (0 == queue_id);
+} // request_shunt_sample
+/*****************************************************************************/
+int store_shunt_sample( // Store value of pending single-shunt capture
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	ADC_SHUNT_TYP * shunt_p, // Pointer to structure containing single-shunt sample data
+	int raw_vals[], // Array of raw ADC values, for each phase (output)
+	int samp_val // Raw value of pending capture
+) // Returns 1 if raw frame rebuilt
+{
+	int samp_id = shunt_p->queue_samps[0]; // Sample index of pending capture
+	int queue_cnt; // Queue counter
+	int done = 0; // Flag set if raw frame rebuilt
+
+
+	assert(0 < shunt_p->queue_cnt); // ERROR: NO pending capture
+
+	shunt_p->vals[samp_id] = samp_val;
+	shunt_p->phases[samp_id] = shunt_p->queue_phases[0];
+
+	// Check for 1st sample of PWM period
+	if (0 == samp_id)
+	{
+		shunt_p->got_first = 1;
+	} // if (0 == samp_id)
+	else
+	{ // NB 2nd sample is discarded if 1st sample of same period was NOT captured
+		if (shunt_p->got_first)
+		{
+			rebuild_shunt_frame( pipe_p ,raw_vals ,shunt_p->vals ,shunt_p->phases );
+			done = 1;
+		} // if (shunt_p->got_first)
+
+		shunt_p->got_first = 0;
+	} // else !(0 == samp_id)
+
+	// Move queued capture to front of queue
+	shunt_p->queue_cnt--;
+
+	for (queue_cnt=0; queue_cnt<shunt_p->queue_cnt; ++queue_cnt)
+	{
+		shunt_p->queue_samps[queue_cnt] = shunt_p->queue_samps[queue_cnt + 1];
+		shunt_p->queue_phases[queue_cnt] = shunt_p->queue_phases[queue_cnt + 1];
+	} // for queue_cnt
+
+	return done;
+} // store_shunt_sample
+/*****************************************************************************/
+int get_adc_pipeline_vals( // Get zero-mean ADC values
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int out_vals[] // Array of zero-mean ADC values, for each measured phase
+) // Returns sum of zero-mean ADC values
+{
+	int adc_sum = 0; // Accumulator for ADC Phases
+	int phase_cnt; // ADC Phase counter
+
+
+	// Loop through measured phases
+	for (phase_cnt=0; phase_cnt<pipe_p->num_phases; ++phase_cnt)
+	{
+		// Convert phase values to zero mean
+		out_vals[phase_cnt] = pipe_p->phase_data[phase_cnt].adc_val - pipe_p->phase_data[phase_cnt].mean;
+		adc_sum += out_vals[phase_cnt];
+	} // for phase_cnt
+
+	return adc_sum;
+} // get_adc_pipeline_vals
+/*****************************************************************************/
+// adc_pipeline.c
@@ -0,0 +1,277 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _ADC_PIPELINE_H_
+#define _ADC_PIPELINE_H_
+
+#include <assert.h>
+
+#include "adc_delay_calib.h"
+
+/* Chip-independent processing of raw ADC frames (one raw value per measured phase, per PWM trigger).
+ * An ADC server is split into two parts:-
+ *		Driver: Chip-specific. Configures the ADC, waits for the trigger point, and reads one raw frame
+ *			(e.g. adc_7265.xc for the AD7265, or the host-side mock in src.dir/adc_mock_model.c)
+ *		Pipeline: This file. Filters each frame, calibrates the trigger delay and DC offsets, and returns zero-mean values
+ *
+ * A driver for a new ADC chip only has to read raw frames, feed them to process_adc_frame(),
+ * wait for pipe.trig_delay after each PWM trigger, and serve the ADC_CMD_* protocol (see adc_common.h).
+ * The ADC Client and the motor control code are then unchanged.
+ *
+ * NB This file is independent of XMOS hardware, so can also be compiled in a host test (see src.dir)
+ */
+
+#define ADC_PIPE_PHASES 3 // Max. No. of ADC phases processed
+
+// Parameters for filtering raw ADC values. WARNING: ADC_FILT_RES>2 will significantly reduce the ADC amplitude
+#define ADC_FILT_RES 2 // ADC Filter scaling resolution
+#define ADC_FILT_DIV (1 << ADC_FILT_RES) // ADC Filter scaling factor
+#define ADC_FILT_HALF (ADC_FILT_DIV >> 1) // Half ADC scaling factor (used for rounding)
+
+/* The DC offset (mean) of each ADC phase is calibrated while the PWM is off (i.e. NO coil current).
+ * ADC_CALIB_SAMPS samples are averaged, then the offsets are frozen, and used for all subsequent ADC values.
+ * If the trigger delay sweep is selected, it is done first, so the offsets are calibrated at the selected delay.
+ */
+#define ADC_CALIB_BITS 10 // Used to generate No. of calibration samples. calib_samps = 2^n
+#define ADC_CALIB_SAMPS (1 << ADC_CALIB_BITS) // No. of samples averaged to calibrate ADC offsets
+#define ADC_CALIB_HALF (ADC_CALIB_SAMPS >> 1) // Half No. of calibration samples (used in rounding)
+
+/* Single-shunt mode: The DC-link shunt is sampled twice per PWM period (see PWM_SINGLE_SHUNT in module_foc_pwm).
+ * The 1st sample is the current of the phase whose Hi-leg switched on first, the 2nd is minus the current of the last phase.
+ * rebuild_shunt_frame() converts the 2 samples into a raw frame of all 3 phases, which is then processed as usual.
+ * The 3rd phase is minus the sum of the other 2. The shunt offset is added back to each phase,
+ * so that the calibrated mean of every phase is the shunt offset, whichever phase each sample measured.
+ *
+ * The driver requests a capture for each single-shunt trigger (see request_shunt_sample()). A request made while the
+ * previous capture is still pending, is queued. Each capture keeps the sample index and phase of its own request,
+ * so a queued 1st sample of the next PWM period does NOT corrupt the frame of the current period.
+ * A frame is only rebuilt when the 2nd sample is captured after the 1st sample of the same period (see store_shunt_sample()).
+ */
+#define ADC_SHUNT_SAMPS 2 // No. of single-shunt samples per PWM period
+#define ADC_SHUNT_QUEUE 2 // Max. No. of outstanding single-shunt captures (pending plus queued)
+
+/** Structure containing pipeline data for one ADC phase */
+typedef struct ADC_PHASE_TAG
+{
+	int adc_val; // measured current ADC value (uncalibrated)
+	int curr_raw; // current raw ADC value
+	int prev_raw; // previous raw ADC value
+	int mean; // Calibrated (frozen) mean value
+	int calib_sum; // Sum of ADC values during offset calibration
+	int rem; // remainder for error diffusion
+} ADC_PHASE_TYP;
+
+/** Structure containing pipeline data for one ADC trigger */
+typedef struct ADC_PIPE_TAG
+{
+	ADC_PHASE_TYP phase_data[ADC_PIPE_PHASES]; // Array of structures for each phase
+	ADC_DELAY_CALIB_TYP delay_calib; // Structure containing data for trigger delay calibration
+	int num_phases; // No. of measured phases in each raw frame
+	int filter; // Flag set if raw values are filtered (see ADC_FILTER)
+	int sweep; // Flag set if trigger delay is calibrated (see ADC_DELAY_CALIB)
+	int nom_delay; // Nominal trigger delay
+	int sweep_step; // Time between candidate trigger delays
+	int filt_cnt; // Counter used in filter
+	int calib_cnt; // No. of samples accumulated during offset calibration
+	int calib_done; // Flag set when offsets are calibrated (frozen)
+	int trig_delay; // Time from PWM trigger to ADC capture (output)
+} ADC_PIPE_TYP;
+
+/** Structure containing single-shunt sample data for one ADC trigger */
+typedef struct ADC_SHUNT_TAG
+{
+	int vals[ADC_SHUNT_SAMPS]; // Array of raw single-shunt samples for current PWM period
+	int phases[ADC_SHUNT_SAMPS]; // Array of phases measured by each single-shunt sample
+	int queue_samps[ADC_SHUNT_QUEUE]; // Sample index of each outstanding capture (pending capture first)
+	int queue_phases[ADC_SHUNT_QUEUE]; // Measured phase of each outstanding capture
+	int queue_cnt; // No. of outstanding captures
+	int got_first; // Flag set when 1st sample of current PWM period captured
+} ADC_SHUNT_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise ADC pipeline for one trigger (NB Calibration NOT started)
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param num_phases // No. of measured phases in each raw frame
+ * \param filter // Flag set if raw values are filtered
+ * \param sweep // Flag set if trigger delay is calibrated
+ * \param nom_delay // Nominal trigger delay
+ * \param sweep_step // Time between candidate trigger delays
+ */
+void init_adc_pipeline( // Initialise ADC pipeline for one trigger
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	int num_phases, // No. of measured phases in each raw frame
+	int filter, // Flag set if raw values are filtered
+	int sweep, // Flag set if trigger delay is calibrated
+	int nom_delay, // Nominal trigger delay
+	int sweep_step // Time between candidate trigger delays
+);
+/*****************************************************************************/
+/** \brief (Re-)Start calibration of trigger delay and offsets. WARNING: PWM must be off
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ */
+void start_adc_pipeline_calib( // (Re-)Start calibration of trigger delay and offsets
+	ADC_PIPE_TYP &pipe_s // Reference to structure containing pipeline data for one ADC trigger
+);
+/*****************************************************************************/
+/** \brief Change nominal trigger delay (e.g. after change of PWM period). If the delay is swept, calibration is restarted
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param nom_delay // Nominal trigger delay
+ * \param sweep_step // Time between candidate trigger delays
+ */
+void set_adc_pipeline_delay( // Change nominal trigger delay
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	int nom_delay, // Nominal trigger delay
+	int sweep_step // Time between candidate trigger delays
+);
+/*****************************************************************************/
+/** \brief Use stored offsets (and nominal trigger delay). NO calibration is done
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param offsets // Array of stored offsets for each measured phase
+ */
+void preset_adc_pipeline_offsets( // Use stored offsets
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	int offsets[] // Array of stored offsets for each measured phase
+);
+/*****************************************************************************/
+/** \brief Process one raw ADC frame (filter, and calibrate if required)
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param raw_vals // Array of raw ADC values, for each measured phase
+ */
+void process_adc_frame( // Process one raw ADC frame
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	int raw_vals[] // Array of raw ADC values, for each measured phase
+);
+/*****************************************************************************/
+/** \brief Rebuild raw ADC frame of all 3 phases, from 2 single-shunt samples
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param raw_vals // Array of raw ADC values, for each phase (output)
+ * \param shunt_vals // Array of raw single-shunt samples
+ * \param shunt_phases // Array of phases measured by each single-shunt sample
+ */
+void rebuild_shunt_frame( // Rebuild raw ADC frame of all 3 phases, from 2 single-shunt samples
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	int raw_vals[], // Array of raw ADC values, for each phase (output)
+	int shunt_vals[], // Array of raw single-shunt samples
+	int shunt_phases[] // Array of phases measured by each single-shunt sample
+);
+/*****************************************************************************/
+/** \brief Initialise single-shunt sample data (NO outstanding captures)
+ * \param shunt_s // Reference to structure containing single-shunt sample data
+ */
+void init_adc_shunt( // Initialise single-shunt sample data
+	ADC_SHUNT_TYP &shunt_s // Reference to structure containing single-shunt sample data
+);
+/*****************************************************************************/
+/** \brief Request capture of one single-shunt sample
+ * \param shunt_s // Reference to structure containing single-shunt sample data
+ * \param samp_id // Sample index (0 == 1st sample of PWM period)
+ * \param phase_id // Phase measured by sample
+ * \return 1 if capture must be started now, 0 if queued behind pending capture
+ */
+int request_shunt_sample( // Request capture of one single-shunt sample
+	ADC_SHUNT_TYP &shunt_s, // Reference to structure containing single-shunt sample data
+	int samp_id, // Sample index (0 == 1st sample of PWM period)
+	int phase_id // Phase measured by sample
+);
+/*****************************************************************************/
+/** \brief Store value of pending single-shunt capture, and rebuild raw frame when both samples of a PWM period captured
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param shunt_s // Reference to structure containing single-shunt sample data
+ * \param raw_vals // Array of raw ADC values, for each phase (output)
+ * \param samp_val // Raw value of pending capture
+ * \return 1 if raw frame rebuilt
+ */
+int store_shunt_sample( // Store value of pending single-shunt capture
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	ADC_SHUNT_TYP &shunt_s, // Reference to structure containing single-shunt sample data
+	int raw_vals[], // Array of raw ADC values, for each phase (output)
+	int samp_val // Raw value of pending capture
+);
+/*****************************************************************************/
+/** \brief Get zero-mean ADC values for each measured phase
+ * \param pipe_s // Reference to structure containing pipeline data for one ADC trigger
+ * \param out_vals // Array of zero-mean ADC values, for each measured phase (output)
+ * \return Sum of zero-mean ADC values
+ */
+int get_adc_pipeline_vals( // Get zero-mean ADC values
+	ADC_PIPE_TYP &pipe_s, // Reference to structure containing pipeline data for one ADC trigger
+	int out_vals[] // Array of zero-mean ADC values, for each measured phase
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_adc_pipeline( // Initialise ADC pipeline for one trigger
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int num_phases, // No. of measured phases in each raw frame
+	int filter, // Flag set if raw values are filtered
+	int sweep, // Flag set if trigger delay is calibrated
+	int nom_delay, // Nominal trigger delay
+	int sweep_step // Time between candidate trigger delays
+);
+/*****************************************************************************/
+void start_adc_pipeline_calib( // (Re-)Start calibration of trigger delay and offsets
+	ADC_PIPE_TYP * pipe_p // Pointer to structure containing pipeline data for one ADC trigger
+);
+/*****************************************************************************/
+void set_adc_pipeline_delay( // Change nominal trigger delay
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int nom_delay, // Nominal trigger delay
+	int sweep_step // Time between candidate trigger delays
+);
+/*****************************************************************************/
+void preset_adc_pipeline_offsets( // Use stored offsets
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int offsets[] // Array of stored offsets for each measured phase
+);
+/*****************************************************************************/
+void process_adc_frame( // Process one raw ADC frame
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int raw_vals[] // Array of raw ADC values, for each measured phase
+);
+/*****************************************************************************/
+void rebuild_shunt_frame( // Rebuild raw ADC frame of all 3 phases, from 2 single-shunt samples
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int raw_vals[], // Array of raw ADC values, for each phase (output)
+	int shunt_vals[], // Array of raw single-shunt samples
+	int shunt_phases[] // Array of phases measured by each single-shunt sample
+);
+/*****************************************************************************/
+void init_adc_shunt( // Initialise single-shunt sample data
+	ADC_SHUNT_TYP * shunt_p // Pointer to structure containing single-shunt sample data
+);
+/*****************************************************************************/
+int request_shunt_sample( // Request capture of one single-shunt sample
+	ADC_SHUNT_TYP * shunt_p, // Pointer to structure containing single-shunt sample data
+	int samp_id, // Sample index (0 == 1st sample of PWM period)
+	int phase_id // Phase measured by sample
+);
+/*****************************************************************************/
+int store_shunt_sample( // Store value of pending single-shunt capture
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	ADC_SHUNT_TYP * shunt_p, // Pointer to structure containing single-shunt sample data
+	int raw_vals[], // Array of raw ADC values, for each phase (output)
+	int samp_val // Raw value of pending capture
+);
+/*****************************************************************************/
+int get_adc_pipeline_vals( // Get zero-mean ADC values
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data for one ADC trigger
+	int out_vals[] // Array of zero-mean ADC values, for each measured phase
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _ADC_PIPELINE_H_
@@ -0,0 +1,129 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _FOC_BUDGET_H_
+#define _FOC_BUDGET_H_
+
+/* Resource budget for the MOTOR_TILE, as a function of the number of motors (num_mots).
+ * The counts follow the composition in main.xc:-
+ *	One motor-control engine (run_motor) and one PWM server per motor, plus one each of QEI, Hall and ADC servers.
+ *	If PWM_MULTI_SERVER is set, one PWM server drives all motors (see pwm_multi_server.h)
+ * NB This file contains preprocessor definitions only, so it can also be included by the host-side model (see src.dir/foc_budget_model.c)
+ *
+ * Thread, channel-end and clock-block counts are exact. RAM values are estimates:
+ *	Structure sizes are those of the server/engine data structures (see BUDGET_*_BYTES), stack and code values are allowances.
+ *	Check against the memory report generated by 'xcc -report'.
+ */
+
+#ifndef PWM_MULTI_SERVER
+	#define PWM_MULTI_SERVER 0 // Default: One PWM Server core per motor
+#endif // PWM_MULTI_SERVER
+
+// XS1-L tile resources
+#define BUDGET_TILE_THREADS 8 // No. of logical cores per tile
+#define BUDGET_TILE_CHANENDS 32 // No. of channel-ends per tile
+#define BUDGET_TILE_CLK_BLKS 5 // No. of configurable clock blocks per tile (XS1_CLKBLK_1 .. XS1_CLKBLK_5)
+#define BUDGET_TILE_RAM (64 * 1024) // Bytes of RAM per tile
+
+// RAM allowances
+#define BUDGET_CODE_RAM (40 * 1024) // Allowance for code and constant tables (e.g. Sine table) on MOTOR_TILE
+#define BUDGET_LOOP_STACK 1024 // Stack allowance for one motor-control thread (deep call tree)
+#define BUDGET_SERV_STACK 512 // Stack allowance for one server thread
+
+/* Structure sizes (bytes). The host model checks each against sizeof() for the __app_foc_demo configuration,
+ * and fails if they differ (make -f budget.mak check, in src.dir). It then prints the measured sizes, to copy here.
+ * MOTOR_DATA_TYP is XC-only, so it is checked on the target instead (see init_motor() in inner_loop.xc)
+ */
+#define BUDGET_MOTOR_DATA_BYTES 976 // MOTOR_DATA_TYP
+#define BUDGET_PWM_ARRAY_BYTES 252 // PWM_ARRAY_TYP (Double-buffered)
+#define BUDGET_PWM_SERV_BYTES 16 // PWM_SERV_TYP
+#define BUDGET_PWM_COMMS_BYTES 48 // PWM_COMMS_TYP
+#define BUDGET_PWM_SCHED_BYTES 520 // PWM_SCHED_TYP
+#define BUDGET_QEI_DATA_BYTES 236 // QEI_DATA_TYP
+#define BUDGET_HALL_DATA_BYTES 180 // HALL_DATA_TYP (incl. edge ring)
+#define BUDGET_ADC_DATA_BYTES 360 // ADC_DATA_TYP
+
+#define BUDGET_PWM_MOTOR_BYTES (BUDGET_PWM_ARRAY_BYTES + BUDGET_PWM_SERV_BYTES + BUDGET_PWM_COMMS_BYTES) // PWM data per motor
+
+// Motor-control engine (run_motor): c_pwm, c_hall, c_qei, c_adc_cntrl, c_wd, c_speed ends per motor, plus both c_commands ends
+#define BUDGET_CONTROL_THREADS(num_mots) (num_mots)
+#define BUDGET_CONTROL_CHANENDS(num_mots) (6 * (num_mots) + 2)
+#define BUDGET_CONTROL_CLK_BLKS(num_mots) 0
+#define BUDGET_CONTROL_RAM(num_mots) ((num_mots) * (BUDGET_MOTOR_DATA_BYTES + BUDGET_LOOP_STACK))
+
+// PWM servers: c_pwm, c_pwm2adc_trig ends per motor. All PWM servers share one clock block
+#define BUDGET_PWM_THREADS(num_mots) ((PWM_MULTI_SERVER) ? 1 : (num_mots))
+#define BUDGET_PWM_CHANENDS(num_mots) (2 * (num_mots))
+#define BUDGET_PWM_CLK_BLKS(num_mots) 1
+#define BUDGET_PWM_RAM(num_mots) ((PWM_MULTI_SERVER) \
+	? ((num_mots) * (BUDGET_PWM_MOTOR_BYTES + BUDGET_PWM_SCHED_BYTES) + BUDGET_SERV_STACK) /* Multi-motor Server: plus schedule */ \
+	: ((num_mots) * (BUDGET_PWM_MOTOR_BYTES + BUDGET_SERV_STACK)))
+
+// QEI server: c_qei end, and one clock block, per motor
+#define BUDGET_QEI_THREADS(num_mots) 1
+#define BUDGET_QEI_CHANENDS(num_mots) (num_mots)
+#define BUDGET_QEI_CLK_BLKS(num_mots) (num_mots)
+#define BUDGET_QEI_RAM(num_mots) ((num_mots) * BUDGET_QEI_DATA_BYTES + BUDGET_SERV_STACK)
+
+// Hall server: c_hall end per motor
+#define BUDGET_HALL_THREADS(num_mots) 1
+#define BUDGET_HALL_CHANENDS(num_mots) (num_mots)
+#define BUDGET_HALL_CLK_BLKS(num_mots) 0
+#define BUDGET_HALL_RAM(num_mots) ((num_mots) * BUDGET_HALL_DATA_BYTES + BUDGET_SERV_STACK)
+
+// ADC server: c_adc_cntrl, c_pwm2adc_trig ends per motor (one ADC trigger per motor)
+#define BUDGET_ADC_THREADS(num_mots) 1
+#define BUDGET_ADC_CHANENDS(num_mots) (2 * (num_mots))
+#define BUDGET_ADC_CLK_BLKS(num_mots) 1
+#define BUDGET_ADC_RAM(num_mots) ((num_mots) * BUDGET_ADC_DATA_BYTES + BUDGET_SERV_STACK)
+
+// xscope: One channel-end per tile, when enabled
+#define BUDGET_XSCOPE_CHANENDS(use_xscope) ((use_xscope) ? 1 : 0)
+
+// Totals for MOTOR_TILE
+#define BUDGET_TOTAL_THREADS(num_mots) (BUDGET_CONTROL_THREADS(num_mots) + BUDGET_PWM_THREADS(num_mots) \
+	+ BUDGET_QEI_THREADS(num_mots) + BUDGET_HALL_THREADS(num_mots) + BUDGET_ADC_THREADS(num_mots))
+
+#define BUDGET_TOTAL_CHANENDS(num_mots ,use_xscope) (BUDGET_CONTROL_CHANENDS(num_mots) + BUDGET_PWM_CHANENDS(num_mots) \
+	+ BUDGET_QEI_CHANENDS(num_mots) + BUDGET_HALL_CHANENDS(num_mots) + BUDGET_ADC_CHANENDS(num_mots) \
+	+ BUDGET_XSCOPE_CHANENDS(use_xscope))
+
+#define BUDGET_TOTAL_CLK_BLKS(num_mots) (BUDGET_CONTROL_CLK_BLKS(num_mots) + BUDGET_PWM_CLK_BLKS(num_mots) \
+	+ BUDGET_QEI_CLK_BLKS(num_mots) + BUDGET_HALL_CLK_BLKS(num_mots) + BUDGET_ADC_CLK_BLKS(num_mots))
+
+#define BUDGET_TOTAL_RAM(num_mots) (BUDGET_CODE_RAM + BUDGET_CONTROL_RAM(num_mots) + BUDGET_PWM_RAM(num_mots) \
+	+ BUDGET_QEI_RAM(num_mots) + BUDGET_HALL_RAM(num_mots) + BUDGET_ADC_RAM(num_mots))
+
+// Build-time checks (NB Only made when the application configuration is known)
+#ifdef NUMBER_OF_MOTORS
+#if (BUDGET_TOTAL_THREADS(NUMBER_OF_MOTORS) > BUDGET_TILE_THREADS)
+	#error NUMBER_OF_MOTORS needs more threads than MOTOR_TILE has (see foc_budget.h)
+#endif // (BUDGET_TOTAL_THREADS(NUMBER_OF_MOTORS) > BUDGET_TILE_THREADS)
+
+#if (BUDGET_TOTAL_CHANENDS(NUMBER_OF_MOTORS ,USE_XSCOPE) > BUDGET_TILE_CHANENDS)
+	#error NUMBER_OF_MOTORS needs more channel-ends than MOTOR_TILE has (see foc_budget.h)
+#endif // (BUDGET_TOTAL_CHANENDS(NUMBER_OF_MOTORS ,USE_XSCOPE) > BUDGET_TILE_CHANENDS)
+
+#if (BUDGET_TOTAL_CLK_BLKS(NUMBER_OF_MOTORS) > BUDGET_TILE_CLK_BLKS)
+	#error NUMBER_OF_MOTORS needs more clock blocks than MOTOR_TILE has (see foc_budget.h)
+#endif // (BUDGET_TOTAL_CLK_BLKS(NUMBER_OF_MOTORS) > BUDGET_TILE_CLK_BLKS)
+
+#if (BUDGET_TOTAL_RAM(NUMBER_OF_MOTORS) > BUDGET_TILE_RAM)
+	#error NUMBER_OF_MOTORS needs more RAM than MOTOR_TILE has (see foc_budget.h)
+#endif // (BUDGET_TOTAL_RAM(NUMBER_OF_MOTORS) > BUDGET_TILE_RAM)
+#endif // NUMBER_OF_MOTORS
+
+#endif // _FOC_BUDGET_H_
+// foc_budget.h
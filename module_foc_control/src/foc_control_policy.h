@@ -0,0 +1,69 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _FOC_CONTROL_POLICY_H_
+#define _FOC_CONTROL_POLICY_H_
+
+#include "app_global.h"
+
+#ifdef __foc_control_conf_h_exists__
+#include "foc_control_conf.h" // Optional application-specific feature policies
+#endif // __foc_control_conf_h_exists__
+
+/* Feature policies. Each feature is selected at compile-time, so a disabled feature is compiled out completely.
+ * The defaults below may be over-ridden in the application file foc_control_conf.h
+ */
+#ifndef FOC_XSCOPE
+#define FOC_XSCOPE USE_XSCOPE // Send (decimated) xscope probes from the control loop
+#endif // FOC_XSCOPE
+
+#if ((FOC_XSCOPE) && !(USE_XSCOPE))
+	#error FOC_XSCOPE requires USE_XSCOPE in app_global.h
+#endif // ((FOC_XSCOPE) && !(USE_XSCOPE))
+
+#ifndef FOC_FIELD_WEAK
+#define FOC_FIELD_WEAK 1 // MTPA and voltage-feedback field-weakening. If 0, target Id is zero
+#endif // FOC_FIELD_WEAK
+
+#ifndef FOC_ANGLE_SYNC
+#define FOC_ANGLE_SYNC 0 // At low speed, correct velocity so angle of this motor tracks angle of master motor
+#endif // FOC_ANGLE_SYNC
+
+#ifndef FOC_HALL_ONLY
+#define FOC_HALL_ONLY 0 // FOC angle and velocity interpolated from Hall edges (for motors without an encoder). QEI data is NOT used
+#endif // FOC_HALL_ONLY
+
+#if ((FOC_HALL_ONLY) && (FOC_ANGLE_SYNC))
+	#error FOC_ANGLE_SYNC requires QEI data, so can NOT be used with FOC_HALL_ONLY
+#endif // ((FOC_HALL_ONLY) && (FOC_ANGLE_SYNC))
+
+#ifndef FOC_SENSOR_FUSION
+#define FOC_SENSOR_FUSION 0 // FOC angle and velocity from QEI/Hall fusion observer, instead of filtered QEI data (see sensor_fusion.h)
+#endif // FOC_SENSOR_FUSION
+
+#if ((FOC_HALL_ONLY) && (FOC_SENSOR_FUSION))
+	#error FOC_SENSOR_FUSION requires QEI data, so can NOT be used with FOC_HALL_ONLY
+#endif // ((FOC_HALL_ONLY) && (FOC_SENSOR_FUSION))
+
+#ifndef FOC_DEAD_COMP
+#define FOC_DEAD_COMP 0 // Correct PWM widths for dead-time distortion, using sign of estimated phase currents. NB Enable once sign checked on hardware
+#endif // FOC_DEAD_COMP
+
+#ifndef FOC_GAMMA_SWEEP
+#define FOC_GAMMA_SWEEP 0 // Tuning only: IQ/ID Open-loop, Gamma swept through electrical cycle
+#endif // FOC_GAMMA_SWEEP
+
+#endif // _FOC_CONTROL_POLICY_H_
+// foc_control_policy.h
@@ -0,0 +1,46 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include <print.h>
+
+#include "foc_errors.h"
+
+// Error messages, indexed by error type. NB Constant table, so only one copy is held (in ROM-able memory) for all motors
+static const char * const err_strs[NUM_ERR_TYPS] = {
+	"Over-Current Detected", // OVERCURRENT_ERR
+	"Under-Voltage Detected", // UNDERVOLTAGE_ERR
+	"Motor Stalled Persistently", // STALLED_ERR
+	"Motor Spinning In Wrong Direction!", // DIRECTION_ERR
+	"Motor Exceeded Maximim Speed", // SPEED_ERR
+	"Position Following Error Exceeded", // FOLLOW_ERR
+	"PWM Port Deadline Missed" // PWM_TIMING_ERR
+};
+
+/*****************************************************************************/
+void print_error_string( // Print message for one error type
+	ERROR_ENUM err_id // Error type identifier
+)
+{
+	if (NUM_ERR_TYPS > (unsigned)err_id)
+	{
+		printstrln( err_strs[err_id] );
+	} // if (NUM_ERR_TYPS > (unsigned)err_id)
+	else
+	{
+		printstrln( "No Message! Please add to table in foc_errors.c" );
+	} // else !(NUM_ERR_TYPS > (unsigned)err_id)
+} // print_error_string
+/*****************************************************************************/
+// foc_errors.c
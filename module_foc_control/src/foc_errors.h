@@ -0,0 +1,43 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _FOC_ERRORS_H_
+#define _FOC_ERRORS_H_
+
+// WARNING: If altering Error types. Also update error-message table in foc_errors.c
+/** Different Motor Error types */
+typedef enum ERROR_ETAG
+{
+	OVERCURRENT_ERR = 0,
+	UNDERVOLTAGE_ERR,
+	STALLED_ERR,
+	DIRECTION_ERR,
+	SPEED_ERR,
+	FOLLOW_ERR,
+	PWM_TIMING_ERR,
+  NUM_ERR_TYPS	// Handy Value!-)
+} ERROR_ENUM;
+
+/*****************************************************************************/
+/** \brief Print message for one error type. NB Messages are held in a single constant table, shared by all motors
+ * \param err_id // Error type identifier
+ */
+void print_error_string( // Print message for one error type
+	ERROR_ENUM err_id // Error type identifier
+);
+/*****************************************************************************/
+
+#endif // _FOC_ERRORS_H_
+// foc_errors.h
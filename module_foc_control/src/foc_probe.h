@@ -0,0 +1,105 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _FOC_PROBE_H_
+#define _FOC_PROBE_H_
+
+#include "app_global.h"
+#include "foc_control_policy.h"
+
+/* Probe API for xscope output from the control loop.
+ *
+ * The probe identifiers below form the channel registry. The xscope channel for a probe is
+ *	(probe_id * NUMBER_OF_MOTORS + motor_id)
+ * so xscope_register() in main.xc must list NUM_PROBE_CHANS channels, one per motor for each probe, in this order (see PROBE_CHANS).
+ *
+ * During an iteration, FOC_PROBE() only stores a value in the per-motor probe record.
+ * At the end of the iteration, flush_probe_record() sends the whole record, but only once every 2^FOC_PROBE_DECIM_BITS iterations.
+ * If FOC_XSCOPE is 0, or a probe is masked out of FOC_PROBE_MASK, FOC_PROBE() generates no code.
+ */
+
+/** Enumeration of probes (channel registry). WARNING: Keep in step with xscope_register() in main.xc */
+typedef enum PROBE_ETAG
+{
+  PROBE_MEAS_ID = 0,	// "mId_N": Estimated radial current
+  PROBE_MEAS_IQ,			// "mIq_N": Estimated tangential current
+  PROBE_MEAS_VEL,			// "mVelN": Estimated angular velocity
+  PROBE_TARG_ID,			// "trIdN": Target radial current
+  PROBE_TARG_IQ,			// "trIqN": Target tangential current
+  PROBE_TARG_VEL,			// "tVelN": Target angular velocity
+  PROBE_PWM_MISS,			// "pMisN": Count of missed PWM port deadlines (see check_pwm_timing())
+  NUM_PROBES    // Handy Value!-)
+} PROBE_ENUM;
+
+#define NUM_PROBE_CHANS (NUM_PROBES * NUMBER_OF_MOTORS) // No. of xscope channels to register
+
+/** xscope_register() arguments for one probe: one channel per motor, named by appending the motor id to the probe prefix.
+ * NB Used by every application main.xc, so channel names always match NUMBER_OF_MOTORS
+ */
+#if (1 == NUMBER_OF_MOTORS)
+#define PROBE_CHANS( prefix ) XSCOPE_CONTINUOUS, prefix "0", XSCOPE_INT , "n"
+#elif (2 == NUMBER_OF_MOTORS)
+#define PROBE_CHANS( prefix ) XSCOPE_CONTINUOUS, prefix "0", XSCOPE_INT , "n" ,XSCOPE_CONTINUOUS, prefix "1", XSCOPE_INT , "n"
+#else
+	#error Extend PROBE_CHANS for NUMBER_OF_MOTORS in foc_probe.h
+#endif // (1 == NUMBER_OF_MOTORS)
+
+#ifndef FOC_PROBE_MASK
+#define FOC_PROBE_MASK ((1 << NUM_PROBES) - 1) // Bit-mask of enabled probes (bit N enables probe N). Default is all probes
+#endif // FOC_PROBE_MASK
+
+#ifndef FOC_PROBE_DECIM_BITS
+#define FOC_PROBE_DECIM_BITS 6 // Send probe record every 2^N iterations. NB There is not enough band-width to send every iteration
+#endif // FOC_PROBE_DECIM_BITS
+
+#define PROBE_DECIM_MASK ((1 << FOC_PROBE_DECIM_BITS) - 1) // Mask used to decimate probe records
+
+/** Structure containing one iteration of probe values for one motor */
+typedef struct PROBE_REC_TAG
+{
+	int vals[NUM_PROBES]; // Latest value of each probe
+	unsigned cnt; // Iteration counter, used for decimation
+} PROBE_REC_TYP;
+
+#if (FOC_XSCOPE)
+/** Store value in probe record. NB Compiles to a single store for an enabled probe, and to nothing for a disabled probe */
+#define FOC_PROBE( rec_s ,probe_id ,inp_val ) if (FOC_PROBE_MASK & (1 << (probe_id))) (rec_s).vals[(probe_id)] = (inp_val)
+#else // (FOC_XSCOPE)
+#define FOC_PROBE( rec_s ,probe_id ,inp_val )
+#endif // else !(FOC_XSCOPE)
+
+#if ((FOC_XSCOPE) && defined(__XC__))
+// XC Version
+/*****************************************************************************/
+/** \brief Clear probe record
+ * \param rec_s // Reference to structure containing probe record
+ */
+void init_probe_record( // Clear probe record
+	PROBE_REC_TYP &rec_s // Reference to structure containing probe record
+);
+/*****************************************************************************/
+/** \brief Send probe record to xscope, once every 2^FOC_PROBE_DECIM_BITS calls
+ * \param rec_s // Reference to structure containing probe record
+ * \param motor_id // Unique motor identifier
+ */
+void flush_probe_record( // Send probe record to xscope, once every 2^FOC_PROBE_DECIM_BITS calls
+	PROBE_REC_TYP &rec_s, // Reference to structure containing probe record
+	unsigned motor_id // Unique motor identifier
+);
+/*****************************************************************************/
+#endif // ((FOC_XSCOPE) && defined(__XC__))
+
+#endif // _FOC_PROBE_H_
+// foc_probe.h
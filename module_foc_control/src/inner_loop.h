@@ -62,43 +62,87 @@
 #define _INNER_LOOP_H_
 
 #include <stdlib.h> // Required for abs()
+#include <limits.h> // Required for INT_MAX
 
 #include <xs1.h>
 #include <print.h>
 #include <assert.h>
-#include <safestring.h>
 
 #include "app_global.h"
 #include "mathuint.h"
 #include "hall_client.h"
+#include "hall_interp.h"
+#include "sensor_fusion.h"
 #include "qei_client.h"
 #include "adc_client.h"
 #include "pwm_client.h"
 #include "qei_server.h"
 #include "pid_regulator.h"
+#include "trajectory.h"
+#include "position_loop.h"
+#include "motor_model.h"
+#include "field_weakening.h"
+#include "cordic.h"
 #include "clarke.h"
 #include "park.h"
 #include "watchdog.h"
 #include "shared_io.h"
+#include "foc_errors.h"
+
+#include "foc_control_policy.h"
+#include "foc_probe.h"
+#include "foc_budget.h"
 
 // Timing definitions
 #define MILLI_400_SECS (400 * MILLI_SEC) // 400 ms. Start-up settling time
 #define ALIGN_PERIOD (24 * MILLI_SEC) // 24ms. Time to allow for Motor colis to align opposite magnets WARNING depends on START_VQ_OPENLOOP
 
-#define PWM_MIN_LIMIT (PWM_MAX_VALUE >> 4) // Min PWM value allowed (1/16th of max range)
-#define PWM_MAX_LIMIT (PWM_MAX_VALUE - PWM_MIN_LIMIT) // Max. PWM value allowed
+#define DEAD_COMP_BAND 32 // Phase current (in ADC units) at which full dead-time compensation is applied (see pwm_convert_width.h)
 
 #define VOLT_RES_BITS 14 // No. of bits used to define No. of different Voltage magnitude levels
 #define VOLT_MAX_MAG (1 << VOLT_RES_BITS) // No.of different Voltage Magnitudes. NB Voltage is -VOLT_MAX_MAG..(VOLT_MAX_MAG-1)
 
-// Check precision data
-#if (VOLT_RES_BITS < PWM_RES_BITS)
-#error  VOLT_RES_BITS < PWM_RES_BITS
-#endif // (VOLT_RES_BITS < PWM_RES_BITS)
+#ifndef MOTOR_PSI
+	#error Define. MOTOR_PSI in app_global.h
+#endif // MOTOR_PSI
 
-#define VOLT_TO_PWM_BITS (VOLT_RES_BITS - PWM_RES_BITS + 1) // bit shift required for converting volts to PWM pulse-widths
-#define HALF_VOLT_TO_PWM (1 << (VOLT_TO_PWM_BITS - 1)) // Used for rounding
-#define VOLT_OFFSET (VOLT_MAX_MAG + HALF_VOLT_TO_PWM) // Offset required to make PWM pulse-width +ve
+// Check precision data
+#if (VOLT_RES_BITS < PWM_PERIOD_MAX_BITS)
+#error  VOLT_RES_BITS < PWM_PERIOD_MAX_BITS
+#endif // (VOLT_RES_BITS < PWM_PERIOD_MAX_BITS)
+
+/* The conversion from voltage to PWM pulse-width depends on the selected PWM period (see PWM_PERIOD_ENUM in pwm_common.h).
+ * The values for each period are precomputed in a table (see PWM_SCALE_TYP), and copied to the motor data when the period is selected.
+ * For a PWM resolution of n bits (period of 2^n PWM clock cycles) ...
+ */
+#define VOLT_TO_PWM_BITS(n) (VOLT_RES_BITS - (n) + 1) // bit shift required for converting volts to PWM pulse-widths
+#define HALF_VOLT_TO_PWM(n) (1 << (VOLT_TO_PWM_BITS(n) - 1)) // Used for rounding
+#define VOLT_OFFSET(n) (VOLT_MAX_MAG + HALF_VOLT_TO_PWM(n)) // Offset required to make PWM pulse-width +ve
+#define PWM_MIN_LIMIT(n) ((1 << (n)) >> 4) // Min PWM value allowed (1/16th of max range)
+#define PWM_MAX_LIMIT(n) ((1 << (n)) - PWM_MIN_LIMIT(n)) // Max. PWM value allowed
+
+/* The open-loop theta update is applied once per PWM period, so also depends on the selected PWM period.
+ * At the starting speed, theta advances by one Up-scaled QEI position every 2^OPEN_TICK_BITS reference clock cycles (see RF_DIV_RPM_BITS) ...
+ * For longer periods, theta is advanced by more than one position every PWM period.
+ * For shorter periods, theta is advanced by one position once enough PWM periods have elapsed (NB Half a PWM period is allowed for timing jitter)
+ */
+#define OPEN_UQ_INC(n) (((n) > OPEN_TICK_BITS) ? (1 << ((n) - OPEN_TICK_BITS)) : 1) // Open-loop theta increment
+#define OPEN_PERIOD(n) (((n) > OPEN_TICK_BITS) ? 0 : ((1 << OPEN_TICK_BITS) - (1 << ((n) - 1)))) // Min. time between open-loop theta increments
+
+/* The control loop runs once per PWM period, so gains applied every iteration are tuned for the default period (PWM_RES_BITS).
+ * For other periods they are re-scaled, so the response in real time does NOT change:-
+ *	Rates (trajectory acceleration, integrator gains) scale with the period, trajectory jerk with the period squared,
+ *	and the filter length (in iterations) inversely with the period. PID gains are scaled by ITER_RATIO(n) when initialised.
+ */
+#define PERIOD_SHIFT(n) ((n) - PWM_RES_BITS) // Bit shift from default PWM period, to a period of 2^n PWM clock cycles
+#define ITER_RATIO(n) ((float)(1 << (n)) / (float)PWM_MAX_VALUE) // FOC iteration period relative to default period
+#define ROTA_PERIOD_BITS(n) (ROTA_FILT_BITS - PERIOD_SHIFT(n)) // Bit shift of estimated-current filter
+#define FW_PERIOD_K_I(n) TRAJ_SCALE_BITS( FW_K_I ,PERIOD_SHIFT(n) ) // Field-weakening integrator gain
+
+// Builds period-dependent values for a PWM resolution of n bits (see PWM_SCALE_TYP). NB Evaluated at compile-time
+#define PWM_SCALE_VALS(n) { VOLT_TO_PWM_BITS(n) ,VOLT_OFFSET(n) ,PWM_MIN_LIMIT(n) ,PWM_MAX_LIMIT(n) ,OPEN_UQ_INC(n) ,OPEN_PERIOD(n) \
+	,TRAJ_PERIOD_ACC( TRAJ_MAX_ACC ,PERIOD_SHIFT(n) ) ,TRAJ_PERIOD_JERK( TRAJ_MAX_JERK ,PERIOD_SHIFT(n) ) \
+	,ROTA_PERIOD_BITS(n) ,(1 << (ROTA_PERIOD_BITS(n) - 1)) ,FW_PERIOD_K_I(n) ,ITER_RATIO(n) }
 
 #define STALL_TRIP_COUNT 5000
 
@@ -151,18 +195,36 @@
 #define INIT_SPEED 100 // Initial motor speed, before external request received
 
 #define MIN_SPEED 30 // This value is derived from experience
+#define STALL_SPEED (MIN_SPEED >> 3) // Speed below which motor is assumed to have stalled
 
 #define SPEC_MAX_SPEED 4000 // This value is derived from the LDO Motor Max. spec. speed
 #define SAFE_MAX_SPEED 5800 // This value is derived from the Optical Encoder Max. rate of 100kHz (gives 5860)
 #define SPEED_INC 100 // If speed change requested, this is the amount of change
 
+// Jerk-limited (S-curve) trajectory for target velocity. NB Limits are up-scaled by 2^TRAJ_RES_BITS, per FOC iteration at the default PWM period
+#define TRAJ_MAX_ACC (1 << TRAJ_RES_BITS) // Maximum acceleration. NB 1 RPM per FOC iteration (~24000 RPM/s)
+#define TRAJ_MAX_JERK (TRAJ_MAX_ACC >> 6) // Maximum jerk. NB Full acceleration reached in 64 FOC iterations (~2.6 ms)
+
+// Acceleration feed-forward added to output of velocity PID
+#define ACC_FF_BITS TRAJ_RES_BITS // No of bits in acceleration feed-forward scaling factor
+#define ACC_FF_HALF (1 << (ACC_FF_BITS - 1)) // Half acceleration feed-forward scaling factor. NB Used for rounding
+#define ACC_FF_MUX 64 // Acceleration multiplier. NB Full acceleration gives 64 units of PID output
+
+// Position control (see position_loop.h). NB Positions are Up-scaled QEI values (see QEI_UPSCALE_BITS)
+#define POSN_WINDOW (4 << QEI_UPSCALE_BITS) // Target position reached when within 4 QEI positions
+#define POSN_FOLLOW_LIM (UQ_PER_REV >> 1) // Max. allowed following error (half a revolution)
+#define POSN_CMD_LIM (INT_MAX >> QEI_UPSCALE_BITS) // Max. magnitude of commanded position (in QEI positions). NB Up-scaled value must NOT overflow
+#define POSN_TICKS_PER_POSN (TICKS_PER_MIN_PER_QEI >> QEI_UPSCALE_BITS) // Reference clock ticks, at 1 RPM, per Up-scaled QEI position. NB Exact, as SECS_PER_MIN is a multiple of 4
+
+// Angular synchronisation (see FOC_ANGLE_SYNC). NB Angles are raw QEI values
+#define SYNC_SPEED 400 // Speed below which angular synchronisation used
+#define SYNC_BITS 4 // No of bits in angle-to-velocity scaling factor
+#define SYNC_HALF (1 << (SYNC_BITS - 1)) // Half angular scaling factor. NB Used for rounding
+#define SYNC_P_MUX 1 // Angular-error multiplier. NB Angular error of 1 revolution adds (QEI_PER_REV >> SYNC_BITS) RPM
+
 // Test definitions
 #define ITER_INC 50000 // No. of FOC iterations between speed increments
 
-// MB~ Cludge to stop velocity spikes. Needs proper fix. Changed Power board, seemed to clear up QEI data
-#define VELOC_FILT 1
-#define MAX_VELOC_INC 1 // MB~ Maximum allowed velocity increment.
-
 // Set-up defines for scaling ...
 #define SHIFT_20 20
 #define SHIFT_16 16
@@ -186,6 +248,7 @@
 #define PROPORTIONAL 1 // Selects between 'proportional' and 'offset' error corrections
 #define VELOC_CLOSED 1 // MB~ 1 Selects fully closed loop (both velocity, Iq and Id)
 #define IQ_ID_CLOSED 1 // MB~ 1 Selects Iq/Id closed-loop, velocity open-loop
+#define DECOUPLE_FF 1 // Selects feed-forward of cross-coupling and back-EMF voltages into Iq/Id loops
 
 // TRANSIT state uses at least one electrical cycle per 1024 Vq values ...
 #define VOLT_DIFF_BITS 10 // NB 2^10 = 1024, Used to down-scale Voltage differences in blending function
@@ -206,23 +269,15 @@
 #define SMOOTH_VOLT_INC 2 // Maximum allowed increment in demand voltage
 #define HALF_SMOOTH_VOLT (SMOOTH_VOLT_INC >> 1)  // Half max. allowed increment
 
-// Defines for Field Weakening
-#define FW_SPEED ((3*SPEC_MAX_SPEED + 2) >> 2) // Only use field-weakening if above 3/4 of SPEC_MAX_SPEED
-#define IQ_LIM 55 // 55 Maximum allowed target Iq value, before field weakening applied
-#define IQ_ID_BITS 2 // NB Near stability, 1 unit change in Id is equivalent to a 4 unit change in Iq
-#define IQ_ID_RATIO (1 << IQ_ID_BITS) // NB Near stability, 1 unit change in Id is equivalent to a 4 unit change in Iq
-#define IQ_ID_HALF (IQ_ID_RATIO >> 1) // Quantisation error is half IQ_ID_RATIO
-
-#define VEL_SCALE_BITS 16 // Used to generate 2^n scaling factor
-#define VEL_HALF_SCALE (1 << (VEL_SCALE_BITS - 1)) // Half Scaling factor (used in rounding)
+// Used to limit demand Voltage vector. NB Limiting the vector magnitude (rather than the PWM widths) preserves the voltage angle
+#define VECT_LIM_MAG ((VOLT_MAX_MAG * 7) >> 3) // Demand voltage magnitude limit. NB Equals PWM clipping level
+#define VECT_LIM_PRIOR VECT_PRIOR_D // Radial voltage has priority, so field-weakening Id is maintained
 
-#define VEL_COEF_BITS 8 // Used to generate filter coef divisor. coef_div = 1/2^n
-#define VEL_COEF_DIV (1 << VEL_COEF_BITS) // Coef divisor
-#define VEL_HALF_COEF (VEL_COEF_DIV >> 1) // Half of Coef divisor
-
-#define PERIOD_COEF_BITS 6 // Used to generate filter coef divisor. coef_div = 1/2^n
-#define PERIOD_COEF_DIV (1 << PERIOD_COEF_BITS) // Coef divisor
-#define PERIOD_HALF_COEF (PERIOD_COEF_DIV >> 1) // Half of Coef divisor
+// Defines for Field Weakening
+#define FW_VOLT_LIM ((VOLT_MAX_MAG * 13) >> 4) // Demand voltage magnitude limit. NB Below VECT_LIM_MAG
+#define FW_CURR_LIM 120 // Total current magnitude limit
+#define FW_ID_LIM 40 // Maximum demagnetising Id magnitude
+#define FW_K_I 4 // Voltage-feedback integrator gain (at default PWM period). NB Voltage error of 1000 changes Id by 1 in ~65 iterations
 
 #if (USE_XSCOPE)
 //MB~	#define DEMO_LIMIT 100000 // XSCOPE
@@ -233,22 +288,17 @@
 	#define DEMO_LIMIT 4000
 #endif // else !(USE_XSCOPE)
 
-#define STR_LEN 80 // String Length
-
-// Debug/Tuning switches
-#define GAMMA_SWEEP 0 // IQ/ID Open-loop, Gamma swept through electrical cycle
-
-// Parameters for filtering estimated rotational current values.
+// Parameters for filtering estimated rotational current values. NB Filter length is re-scaled for the selected PWM period (see ROTA_PERIOD_BITS)
 #define ROTA_FILT_BITS 9 // WARNING: Using larger values will increase the response time of the motor
-#if (1 <  ROTA_FILT_BITS)
-#define ROTA_HALF_FILT (1 << (ROTA_FILT_BITS - 1))
-#else
-#define ROTA_HALF_FILT 0
-#endif
+#if (1 > ROTA_PERIOD_BITS(PWM_PERIOD_MAX_BITS))
+#error ROTA_FILT_BITS too small for longest PWM period
+#endif // (1 > ROTA_PERIOD_BITS(PWM_PERIOD_MAX_BITS))
 
 #define RF_DIV_RPM_BITS 24 // Bit resolution for Reference_Freq/Start_Speed = (100 MHz)/(358 RPM/60) as power of 2
 
-#define BLEND_BITS (RF_DIV_RPM_BITS - PWM_RES_BITS - POLE_PAIR_BITS) // Bit resolution for Blending denominator
+#define OPEN_TICK_BITS (RF_DIV_RPM_BITS - QEI_RES_BITS - QEI_UPSCALE_BITS) // Reference clock cycles per open-loop theta increment, as power of 2
+
+#define BLEND_BITS (QEI_RES_BITS + QEI_UPSCALE_BITS - POLE_PAIR_BITS) // Bit resolution for Blending denominator. NB Equals UQ_PER_PAIR, so independent of PWM period
 #define BLEND_DENOM (1 << BLEND_BITS) // Up-scaling factor
 #define BLEND_HALF (BLEND_DENOM >> 1) // Half Up-scaling factor. Used in rounding
 
@@ -257,9 +307,11 @@
 #define QEI_HALF_UPSCALE (QEI_UPSCALE_DENOM >> 1) // Half QEI up-scaling Factor (used for rounding)
 #define UQ_PER_PAIR (QEI_PER_PAIR << QEI_UPSCALE_BITS) // No. of different Up-scaled QEI values per pole pair
 #define UQ_PER_REV (QEI_PER_REV << QEI_UPSCALE_BITS) // No. of different Up-scaled QEI values per revolution
+#define HALF_QEI (QEI_PER_REV >> 1) // Half No. of QEI points per revolution
 #define UQ_REV_MASK (UQ_PER_REV - 1) // (16-bit) Mask used to extract Up-scaled QEI bits
 
 #define OC_ERR_LIM 512 // Number of Hall Over-current errors allowed before Board powered down
+#define PWM_ERR_LIM 16 // Number of missed PWM port deadlines allowed before Board powered down
 
 #pragma xta command "add exclusion foc_loop_motor_fault"
 #pragma xta command "add exclusion foc_loop_speed_comms"
@@ -282,18 +334,6 @@ typedef enum MOTOR_STATE_ETAG
   NUM_MOTOR_STATES	// Handy Value!-)
 } MOTOR_STATE_ENUM;
 
-// WARNING: If altering Error types. Also update error-message in init_error_data()
-/** Different Motor Phases */
-typedef enum ERROR_ETAG
-{
-	OVERCURRENT_ERR = 0,
-	UNDERVOLTAGE_ERR,
-	STALLED_ERR,
-	DIRECTION_ERR,
-	SPEED_ERR,
-  NUM_ERR_TYPS	// Handy Value!-)
-} ERROR_ENUM;
-
 /** Different Rotating Vector components (in rotor frame of reference) */
 typedef enum ROTA_VECT_ETAG
 {
@@ -313,120 +353,155 @@ typedef struct ROTA_DATA_TAG // Structure containing data for one rotating vecto
 	int prev_V;	// Previous Demand voltage
 	int diff_V;	// Difference between Start and Requested Voltage
 	int rem_V;	// Voltage remainder, used in error diffusion
+	int ff_V;	// Feed-forward voltage (cross-coupling and back-EMF)
 	int inp_I;	// Unfiltered input current value (generated by rotor motion)
 	int est_I;	// (Possibly filtered) Estimated current value (generated by rotor motion)
 	int prev_I;	// Previous estimated current value
 	int rem_I;	// Electrical current remainder used in error diffusion
 } ROTA_DATA_TYP;
 
-typedef struct STRING_TAG // Structure containing string
+typedef struct PWM_SCALE_TAG // Structure containing period-dependent values for one PWM period
 {
-	char str[STR_LEN]; // Array of characters
-} STRING_TYP;
+	int volt_bits; // bit shift required for converting volts to PWM pulse-widths
+	int volt_off; // Offset required to make PWM pulse-width +ve (including rounding)
+	unsigned min_lim; // Min PWM value allowed
+	unsigned max_lim; // Max. PWM value allowed
+	int open_uq_inc; // Increment to Upscaled theta value during open-loop phase
+	int open_period; // Min. time between open-loop theta increments (NB 0 forces update every PWM period)
+	int traj_acc; // Up-scaled maximum trajectory acceleration, per FOC iteration
+	int traj_jerk; // Up-scaled maximum trajectory jerk, per FOC iteration
+	int filt_bits; // Bit shift of estimated-current filter
+	int filt_half; // Half estimated-current filter factor. NB Used for rounding
+	int fw_K_i; // Field-weakening integrator gain
+	float iter_ratio; // FOC iteration period relative to default period. NB Scales PID integral and derivative gains
+} PWM_SCALE_TYP;
 
 typedef struct ERR_DATA_TAG // Structure containing Error handling data
 {
-	STRING_TYP err_strs[NUM_ERR_TYPS]; // Array messages for each error type
 	unsigned err_cnt[NUM_ERR_TYPS];	// Count No of Errors.
 	unsigned err_lim[NUM_ERR_TYPS];	// Error count Limit
 	int line[NUM_ERR_TYPS];	// Array of line number for NEWEST occurance of error type.
 	unsigned err_flgs;	// Set of Fault detection flags for each error type
 } ERR_DATA_TYP;
 
-typedef struct MOTOR_DATA_TAG // Structure containing motor state data
+typedef struct MOTOR_DIAG_TAG // Structure containing cold diagnostic data (NOT used every iteration)
 {
-	ADC_PARAM_TYP adc_params; // Structure containing measured data from ADC
-	HALL_PARAM_TYP hall_params; // Structure containing measured data from Hall sensors
-	PWM_COMMS_TYP pwm_comms; // Structure containing PWM communication data between Client/Server.
-	QEI_PARAM_TYP qei_params; // Structure containing measured data from QEI sensors
-	PID_CONST_TYP pid_consts[NUM_PIDS]; // array of PID const data for different IQ Estimate algorithms
-	PID_REGULATOR_TYP pid_regs[NUM_PIDS]; // array of pid regulators used for motor control
 	ERR_DATA_TYP err_data; // Structure containing data for error-handling
-	ROTA_DATA_TYP vect_data[NUM_ROTA_COMPS]; // Array of structures holding data for each rotating vector component
-	int cnts[NUM_MOTOR_STATES]; // array of counters for each motor state
+	unsigned pwm_misses; // Previous count of missed PWM port deadlines (read from PWM Server)
+	int ws_cnt; // Wrong-Spin count //MB~
+#if ((FOC_GAMMA_SWEEP) || defined(MB))
+	int tmp; // MB~
+	int temp; // MB~ Dbg
+#endif // ((FOC_GAMMA_SWEEP) || defined(MB))
+#ifdef MB
+	timer dbg_tmr; // MB~
+	unsigned dbg_orig; // MB~
+	unsigned dbg_strt;
+	unsigned dbg_end;
+	unsigned dbg_prev;
+	unsigned dbg_diff;
+	unsigned dbg_sum; // MB~
+	int dbg_err; // MB~
+#endif //MB~
+} MOTOR_DIAG_TYP;
+
+/* Structure containing motor state data.
+ * Hot scalars, accessed every FOC iteration, are placed first, so that they can be reached with short-form (small offset) load/store instructions.
+ * Hot sub-structures follow, then data only used during start-up, then cold diagnostics.
+ * Values that are the same for every motor are compile-time constants (e.g. STALL_SPEED), and are NOT held here.
+ */
+typedef struct MOTOR_DATA_TAG
+{
+	// Hot scalars: used every FOC iteration
 	MOTOR_STATE_ENUM state; // Current motor state
-	CMD_IO_ENUM cmd_id; // Speed Command
+	int iters; // Iterations of inner_loop
+	unsigned id; // Unique Motor identifier e.g. 0 or 1
+	int est_veloc;	// Estimated angular velocity (from QEI data)
+	int targ_vel;	// (Internal) Target angular velocity
+	int tot_ang;	// Total angle traversed (NB accounts for multiple revolutions)
+	int diff_ang;	// Difference angle QEI between updates
+	int est_theta;		// Estimated Angular position (from QEI data)
+	int set_theta;	// PWM theta value
+	int pid_preset; // Flag set if PID needs preseting
+	int posn_mode; // Flag set when position control is active
+	int start_dir; // Spin direction (1 or -1) at last start. NB Sets the sign convention of the control-loop frame (see update_foc_voltage())
 	int meas_speed;	// speed, i.e. magnitude of angular velocity
-	int stall_speed;	// Speed below which motor is assumed to have stalled
 	int req_veloc;	// (External) Requested angular velocity
 	int old_veloc;	// Old Requested angular velocity
-	int targ_vel;	// (Internal) Target angular velocity
-	int est_veloc;	// Estimated angular velocity (from QEI data)
-	int half_veloc;	// Half requested angular velocity
-	int speed_inc; // Speed increment when commanded
 	int prev_veloc;	// previous velocity
-	unsigned est_period;	// Estimate of QEI period: ticks per QEI position (in Reference Frequency Cycles)
-	unsigned filt_period; // Filtered QEI period
-	unsigned restart_time; // Re-start time-stamp
-	int prev_period;	// previous value of QEI period
-	int open_period;	// Time between updates PWM data during open-loop phase
-	int open_uq_inc;	// Increment to Upscaled theta value during open-loop phase
 	int pid_veloc;	// Output of angular velocity PID
 	int pid_Id;	// Output of 'radial' current PID
 	int pid_Iq;	// Output of 'tangential' current PID
-	int prev_Id;	// previous target 'radial' current value
-	int tot_ang;	// Total angle traversed (NB accounts for multiple revolutions)
+	int mag_V;	// Magnitude of demand voltage vector (before limiting)
 	int raw_ang;	// Raw total angle delivered by QEI Client
 	int prev_ang;	// Previous total angle traversed (NB accounts for multiple revolutions)
-	int diff_ang;	// Difference angle QEI between updates
 	int corr_ang;	// Correction angle (when QEI origin detected)
-	int prev_diff;	// Previous Non-zero Difference angle QEI between updates
-	int est_theta;		// Estimated Angular position (from QEI data)
 	int est_revs;	// Estimated No of revolutions (No. of origin traversals) (from QEI data)
-	int prev_revs;	// Previous No of revolutions
-	int set_theta;	// PWM theta value
-	int open_theta;	// Open-loop theta value
 	int foc_theta;	// FOC theta value
-	int pid_preset; // Flag set if PID needs preseting
+	int qei_offset;	// Phase difference between the QEI origin and PWM theta origin
+	int qei_calib; // Flag set when QEI offset has been calibrated
+	int half_veloc;	// Half requested angular velocity
+	int speed_inc; // Speed increment when commanded
+	unsigned prev_hall; // previous hall state value
+	unsigned end_hall; // hall state at end of cycle. I.e. next value is first value of cycle (001)
+	int hall_offset;	// Phase difference between the Hall sensor origin and PWM theta origin
+	int hall_found;	// Flag set when QEI orign found
+	int Iq_err;	// Error diffusion value for scaling of measured Iq
+	int coef_err; // Coefficient diffusion error
+	int scale_err; // Scaling diffusion error
+	unsigned posn_time; // Time-stamp of previous reference position update
+#if (FOC_ANGLE_SYNC)
+	int sync_on; // Flag set when angular synchronisation in operation
+	int strt_diff; // Angular-difference (master minus this motor) at start of synchronisation
+	int sync_veloc; // Velocity correction from angular synchronisation
+#endif // (FOC_ANGLE_SYNC)
+
+	// Hot sub-structures
+	ROTA_DATA_TYP vect_data[NUM_ROTA_COMPS]; // Array of structures holding data for each rotating vector component
+	PID_REGULATOR_TYP pid_regs[NUM_PIDS]; // array of pid regulators used for motor control
+	PID_CONST_TYP pid_consts[NUM_PIDS]; // array of PID const data for different IQ Estimate algorithms
+	int cnts[NUM_MOTOR_STATES]; // array of counters for each motor state
+	ADC_PARAM_TYP adc_params; // Structure containing measured data from ADC
+	ADC_CALIB_TYP adc_calib; // Structure containing ADC offset calibration data
+#ifdef ADC_PHASE_C_MUX
+	int adc_skip; // ADC phase with narrowest shunt window (re-constructed from other 2 phases)
+#endif // ADC_PHASE_C_MUX
+	HALL_PARAM_TYP hall_params; // Structure containing measured data from Hall sensors
+#if (FOC_HALL_ONLY)
+	HALL_INTERP_TYP hall_interp; // Structure containing Hall-interpolated angle data
+#endif // (FOC_HALL_ONLY)
+#if (FOC_SENSOR_FUSION)
+	SENSOR_FUSION_TYP fusion; // Structure containing fused QEI/Hall angle data
+#endif // (FOC_SENSOR_FUSION)
+	QEI_PARAM_TYP qei_params; // Structure containing measured data from QEI sensors
+	PWM_SCALE_TYP pwm_scale; // Structure containing period-dependent values for selected PWM period
+	PWM_COMMS_TYP pwm_comms; // Structure containing PWM communication data between Client/Server.
+	TRAJ_DATA_TYP traj_vel; // Structure containing jerk-limited trajectory data for target velocity
+	POSN_DATA_TYP posn_data; // Structure containing position loop data (Up-scaled QEI positions)
+	MOTOR_PARAM_TYP motor_params; // Structure containing motor electrical parameters
+#if (FOC_FIELD_WEAK)
+	FW_DATA_TYP fw_data; // Structure containing field-weakening data
+#endif // (FOC_FIELD_WEAK)
+#if (FOC_XSCOPE)
+	PROBE_REC_TYP probe_rec; // Structure containing xscope probe values for current iteration
+#endif // (FOC_XSCOPE)
+
+	// Start-up data: used in open-loop and TRANSIT states
+	unsigned restart_time; // Re-start time-stamp
+	int open_period;	// Time between updates PWM data during open-loop phase
+	int open_uq_inc;	// Increment to Upscaled theta value during open-loop phase
+	int open_theta;	// Open-loop theta value
 	int search_theta;	// theta value at end of 'SEARCH state'
 	int trans_theta;	// theta value at end of 'TRANSIT state'
 	int trans_cycles;	// Number of electrical cycles spent in 'TRANSIT state'
 	int trans_cnt;	// Incremented every time trans_theta is updated
 	int blend_weight;	// Current value of blending weight
 	int blend_inc;	// Increment to blending weight
-	int fw_on; // Flag set if Field Weakening required
-	int ws_cnt; // Wrong-Spin count //MB~
-
-	int iters; // Iterations of inner_loop
-	unsigned id; // Unique Motor identifier e.g. 0 or 1
-	unsigned prev_hall; // previous hall state value
-	unsigned end_hall; // hall state at end of cycle. I.e. next value is first value of cycle (001)
-	unsigned xscope;	// Flag set when xscope output required
-
-	int qei_offset;	// Phase difference between the QEI origin and PWM theta origin
-	int hall_offset;	// Phase difference between the Hall sensor origin and PWM theta origin
-	int qei_calib; // Flag set when QEI offset has been calibrated
-	int hall_found;	// Flag set when QEI orign found
-	int Iq_err;	// Error diffusion value for scaling of measured Iq
-	int adc_err;	// Error diffusion value for ADC extrema filter
 
 	timer tymer;	// Timer
 	unsigned prev_time; 	// previous time stamp
 
-	int filt_adc; // filtered ADC value
-	int coef_err; // Coefficient diffusion error
-	int scale_err; // Scaling diffusion error
-
-	int half_qei; // Half QEI points per revolution (used for rounding)
-	int filt_veloc; // filtered velocity value
-	int period_coef_err; // QEI-Period filter coefficient diffusion error
-	int period_scale_err; // QEI-Period scaling diffusion error
-	int coef_vel_err; // velocity filter coefficient diffusion error
-	int scale_vel_err; // Velocity scaling diffusion error
-	int veloc_calc_err; // Velocity calculation diffusion error
-
-	int tmp; // MB~
-	int temp; // MB~ Dbg
-
-timer dbg_tmr; // MB~
-unsigned dbg_orig; // MB~
-unsigned dbg_strt;
-unsigned dbg_end;
-unsigned dbg_prev;
-unsigned dbg_diff;
-unsigned dbg_sum; // MB~
-int dbg_err; // MB~
-
+	MOTOR_DIAG_TYP diag; // Structure containing cold diagnostic data
 } MOTOR_DATA_TYP;
 
 /*****************************************************************************/
@@ -0,0 +1,345 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "sensor_fusion.h"
+
+// Look-up table converting [CBA] Hall state to sector (in positive spin order)
+static const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT;
+
+/*****************************************************************************/
+void init_sensor_fusion( // Initialise fusion of QEI and Hall data
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int ang_per_pair // No. of angle units per electrical cycle
+)
+{
+	int dir_cnt; // Spin direction counter
+	int sect_cnt; // Sector counter
+
+
+	assert((1 << FUSE_GLITCH_BITS) <= ang_per_pair); // ERROR: Angle resolution too small
+
+	fuse_p->ang_per_pair = ang_per_pair;
+	fuse_p->glitch_lim = (ang_per_pair >> FUSE_GLITCH_BITS);
+
+	// Velocity-to-RPM factor. NB Only divide once, here
+	fuse_p->rpm_scale = (((S64_T)SECS_PER_MIN * (S64_T)PLATFORM_REFERENCE_HZ) << FUSE_RPM_BITS) / ((S64_T)ang_per_pair * (S64_T)NUM_POLE_PAIRS);
+
+	for (dir_cnt=0; dir_cnt<NUM_FUSE_DIRS; dir_cnt++)
+	{
+		for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+		{
+			fuse_p->anchors[dir_cnt][sect_cnt] = 0;
+			fuse_p->anchor_cnts[dir_cnt][sect_cnt] = 0; // Anchor NOT yet learnt
+		} // for sect_cnt
+	} // for dir_cnt
+
+	fuse_p->ang = 0;
+	fuse_p->ang_veloc = 0;
+	fuse_p->qei_bias = 0;
+	fuse_p->tot_ang = 0;
+	fuse_p->veloc = 0;
+	fuse_p->prev_time = 0;
+	fuse_p->recip_time = 0;
+	fuse_p->dif_time = 0; // Forces reciprocal to be calculated
+	fuse_p->sect = -1; // Sector NOT yet known
+	fuse_p->settle_cnt = 0;
+	fuse_p->glitch_run = 0;
+	fuse_p->qei_glitches = 0;
+	fuse_p->hall_rejects = 0;
+	fuse_p->started = 0;
+} // init_sensor_fusion
+/*****************************************************************************/
+static int wrap_angle( // Wrap angle into range [-ang_per_pair/2 .. ang_per_pair/2)
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int inp_ang // Input angle
+) // Returns wrapped angle
+{
+	int half_pair = (fuse_p->ang_per_pair >> 1); // Half electrical cycle
+	int out_ang = (inp_ang % fuse_p->ang_per_pair); // NB Sign follows input
+
+
+	if (-half_pair > out_ang)
+	{
+		out_ang += fuse_p->ang_per_pair;
+	} // if (-half_pair > out_ang)
+	else
+	{
+		if (half_pair <= out_ang)
+		{
+			out_ang -= fuse_p->ang_per_pair;
+		} // if (half_pair <= out_ang)
+	} // else !(-half_pair > out_ang)
+
+	return out_ang;
+} // wrap_angle
+/*****************************************************************************/
+static int elec_angle( // Convert total angle to electrical angle in range [0 .. (ang_per_pair - 1)]
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int inp_ang // Input total angle
+) // Returns electrical angle
+{
+	int out_ang = (inp_ang % fuse_p->ang_per_pair); // NB Sign follows input
+
+
+	if (0 > out_ang)
+	{
+		out_ang += fuse_p->ang_per_pair;
+	} // if (0 > out_ang)
+
+	return out_ang;
+} // elec_angle
+/*****************************************************************************/
+static int calc_velocity( // Convert observer velocity to RPM
+	SENSOR_FUSION_TYP * fuse_p // Pointer to structure containing fused angle data
+) // Returns angular velocity (RPM)
+{
+	S64_T half_rpm = ((S64_T)1 << (FUSE_FRAC_BITS + FUSE_RPM_BITS - 1)); // Used for rounding
+	S64_T ticks_rpm; // Up-scaled RPM
+
+
+	ticks_rpm = (S64_T)fuse_p->ang_veloc * fuse_p->rpm_scale;
+
+	// Account for sign: to get correct rounding
+	if (0 > ticks_rpm)
+	{
+		return -(int)((half_rpm - ticks_rpm) >> (FUSE_FRAC_BITS + FUSE_RPM_BITS));
+	} // if (0 > ticks_rpm)
+
+	return (int)((ticks_rpm + half_rpm) >> (FUSE_FRAC_BITS + FUSE_RPM_BITS));
+} // calc_velocity
+/*****************************************************************************/
+static S64_T check_qei_consistency( // Check QEI sample is consistent with prediction
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	S64_T innov // Innovation (measured minus predicted angle)
+) // Returns innovation to apply (zero for an outlier)
+{
+	// Check for outlier
+	if (((S64_T)fuse_p->glitch_lim << FUSE_FRAC_BITS) < llabs(innov))
+	{
+		fuse_p->glitch_run++;
+
+		// Check for persistent step: A QEI count error, NOT a glitch
+		if (FUSE_GLITCH_LOOPS <= fuse_p->glitch_run)
+		{
+			fuse_p->qei_bias += (int)(innov >> (FUSE_FRAC_BITS - FUSE_HALL_GAIN_BITS)); // Absorb step into QEI bias (Hall anchors correct it)
+			fuse_p->qei_glitches++;
+			fuse_p->glitch_run = 0;
+		} // if (FUSE_GLITCH_LOOPS <= fuse_p->glitch_run)
+
+		return 0; // Ignore outlier: Coast on prediction
+	} // if (((S64_T)fuse_p->glitch_lim << FUSE_FRAC_BITS) < llabs(innov))
+
+	fuse_p->glitch_run = 0;
+
+	return innov;
+} // check_qei_consistency
+/*****************************************************************************/
+static void update_qei_observer( // Update angle/velocity observer with latest QEI angle
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int qei_ang, // Latest QEI total angle
+	unsigned cur_time // Current time
+)
+{
+	unsigned dif_time = cur_time - fuse_p->prev_time; // Time since previous update. NB unsigned handles wrap-around
+	S64_T meas_ang; // Bias-corrected QEI angle
+	S64_T pred_ang; // Predicted angle
+	S64_T innov; // Innovation (measured minus predicted angle)
+
+
+	meas_ang = ((S64_T)qei_ang << FUSE_FRAC_BITS) - ((S64_T)fuse_p->qei_bias << (FUSE_FRAC_BITS - FUSE_HALL_GAIN_BITS));
+	pred_ang = fuse_p->ang + (S64_T)fuse_p->ang_veloc * (S64_T)dif_time;
+	innov = meas_ang - pred_ang;
+
+	// Check if observer has settled
+	if (FUSE_SETTLE_LOOPS > fuse_p->settle_cnt)
+	{
+		fuse_p->settle_cnt++;
+	} // if (FUSE_SETTLE_LOOPS > fuse_p->settle_cnt)
+	else
+	{
+		innov = check_qei_consistency( fuse_p ,innov );
+	} // else !(FUSE_SETTLE_LOOPS > fuse_p->settle_cnt)
+
+	fuse_p->ang = pred_ang + (innov >> FUSE_ANG_GAIN_BITS);
+
+	if (0 < dif_time)
+	{
+		// Check for change in update period. NB Usually constant, so the (32-bit) division is rare
+		if (dif_time != fuse_p->dif_time)
+		{
+			fuse_p->recip_time = ((1 << FUSE_RECIP_BITS) + (dif_time >> 1)) / dif_time;
+			fuse_p->dif_time = dif_time;
+		} // if (dif_time != fuse_p->dif_time)
+
+		fuse_p->ang_veloc += (int)((innov * (S64_T)fuse_p->recip_time) >> (FUSE_RECIP_BITS + FUSE_VEL_GAIN_BITS));
+	} // if (0 < dif_time)
+
+	fuse_p->prev_time = cur_time;
+} // update_qei_observer
+/*****************************************************************************/
+static void process_hall_edge( // Use Hall edge to learn, or correct against, an electrical-angle anchor
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int new_sect, // New sector
+	unsigned edge_time, // Time-stamp of Hall edge
+	unsigned cur_time // Current time
+)
+{
+	int diff_sect = new_sect - fuse_p->sect; // Change in sector
+	int dir_id; // Spin direction identifier
+	int bound_id; // Identifier of sector boundary crossed
+	int edge_ang; // Fused electrical angle at time of Hall edge
+	int ang_err; // Difference between fused angle and anchor
+	int cnt; // local copy of anchor count
+
+
+	if (0 > diff_sect)
+	{
+		diff_sect += NUM_HALL_SECTS;
+	} // if (0 > diff_sect)
+
+	if (1 == diff_sect)
+	{ // Positive spin: Crossed start of new sector
+		dir_id = FUSE_POSI;
+		bound_id = new_sect;
+	} // if (1 == diff_sect)
+	else
+	{
+		if ((NUM_HALL_SECTS - 1) == diff_sect)
+		{ // Negative spin: Crossed start of old sector
+			dir_id = FUSE_NEGA;
+			bound_id = fuse_p->sect;
+		} // if ((NUM_HALL_SECTS - 1) == diff_sect)
+		else
+		{ // Hall state skipped: Edge can NOT be used
+			fuse_p->sect = new_sect;
+			return;
+		} // else !((NUM_HALL_SECTS - 1) == diff_sect)
+	} // else !(1 == diff_sect)
+
+	fuse_p->sect = new_sect;
+
+	// Anchors are NOT learnt until observer has settled
+	if (FUSE_SETTLE_LOOPS > fuse_p->settle_cnt)
+	{
+		return;
+	} // if (FUSE_SETTLE_LOOPS > fuse_p->settle_cnt)
+
+	// Wind fused angle back to time of Hall edge
+	edge_ang = (int)((fuse_p->ang - (S64_T)fuse_p->ang_veloc * (S64_T)(int)(cur_time - edge_time)) >> FUSE_FRAC_BITS); // NB int handles wrap-around
+	edge_ang = elec_angle( fuse_p ,edge_ang );
+
+	cnt = fuse_p->anchor_cnts[dir_id][bound_id];
+
+	// Check if anchor still being learnt
+	if (FUSE_LEARN_CNT > cnt)
+	{
+		if (0 == cnt)
+		{
+			fuse_p->anchors[dir_id][bound_id] = edge_ang;
+		} // if (0 == cnt)
+		else
+		{ // Update running mean
+			ang_err = wrap_angle( fuse_p ,(edge_ang - fuse_p->anchors[dir_id][bound_id]) );
+			fuse_p->anchors[dir_id][bound_id] = elec_angle( fuse_p ,(fuse_p->anchors[dir_id][bound_id] + ang_err / (cnt + 1)) );
+		} // else !(0 == cnt)
+
+		fuse_p->anchor_cnts[dir_id][bound_id] = cnt + 1;
+	} // if (FUSE_LEARN_CNT > cnt)
+	else
+	{
+		ang_err = wrap_angle( fuse_p ,(edge_ang - fuse_p->anchors[dir_id][bound_id]) );
+
+		// Check for Hall glitch (more than half a sector from anchor)
+		if ((fuse_p->ang_per_pair / (NUM_HALL_SECTS << 1)) < abs(ang_err))
+		{
+			fuse_p->hall_rejects++;
+		} // if ((fuse_p->ang_per_pair / (NUM_HALL_SECTS << 1)) < abs(ang_err))
+		else
+		{
+			fuse_p->qei_bias += ang_err; // NB QEI bias is up-scaled by FUSE_HALL_GAIN_BITS, so only a fraction is corrected
+		} // else !((fuse_p->ang_per_pair / (NUM_HALL_SECTS << 1)) < abs(ang_err))
+	} // else !(FUSE_LEARN_CNT > cnt)
+} // process_hall_edge
+/*****************************************************************************/
+void update_sensor_fusion( // Update fused angle and velocity estimate
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int qei_ang, // Latest QEI total angle
+	HALL_PARAM_TYP * hall_param_p, // Pointer to structure containing latest Hall parameters
+	unsigned cur_time // Current time
+)
+{
+	int new_sect; // Sector for Hall edge
+	int edge_cnt; // Hall edge counter
+
+
+	// Check for first update
+	if (0 == fuse_p->started)
+	{ // Preset observer to QEI angle
+		fuse_p->ang = ((S64_T)qei_ang << FUSE_FRAC_BITS);
+		fuse_p->ang_veloc = 0;
+		fuse_p->prev_time = cur_time;
+		fuse_p->sect = hall_sects[hall_param_p->hall_val & HALL_PHASE_MASK];
+		fuse_p->started = 1;
+	} // if (0 == fuse_p->started)
+	else
+	{
+		update_qei_observer( fuse_p ,qei_ang ,cur_time );
+
+		// Process batch of Hall edges (oldest first)
+		for (edge_cnt=0; edge_cnt<hall_param_p->num_edges; edge_cnt++)
+		{
+			new_sect = hall_sects[hall_param_p->edges[edge_cnt].hall_val & HALL_PHASE_MASK];
+
+			// Check for valid change of sector
+			if ((0 <= new_sect) && (new_sect != fuse_p->sect))
+			{
+				if (0 > fuse_p->sect)
+				{ // First valid Hall state
+					fuse_p->sect = new_sect;
+				} // if (0 > fuse_p->sect)
+				else
+				{
+					process_hall_edge( fuse_p ,new_sect ,hall_param_p->edges[edge_cnt].time ,cur_time );
+				} // else !(0 > fuse_p->sect)
+			} // if ((0 <= new_sect) && (new_sect != fuse_p->sect))
+		} // for edge_cnt
+	} // else !(0 == fuse_p->started)
+
+	fuse_p->tot_ang = (int)((fuse_p->ang + ((S64_T)1 << (FUSE_FRAC_BITS - 1))) >> FUSE_FRAC_BITS); // NB Rounded
+	fuse_p->veloc = calc_velocity( fuse_p );
+} // update_sensor_fusion
+/*****************************************************************************/
+void shift_sensor_fusion( // Shift fused angle when QEI angle re-based
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int shift_ang // Change to QEI angle
+)
+{
+	int dir_cnt; // Spin direction counter
+	int sect_cnt; // Sector counter
+
+
+	fuse_p->ang += ((S64_T)shift_ang << FUSE_FRAC_BITS);
+
+	// Anchors are electrical angles of the fused angle, so move with it
+	for (dir_cnt=0; dir_cnt<NUM_FUSE_DIRS; dir_cnt++)
+	{
+		for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+		{
+			fuse_p->anchors[dir_cnt][sect_cnt] = elec_angle( fuse_p ,(fuse_p->anchors[dir_cnt][sect_cnt] + shift_ang) );
+		} // for sect_cnt
+	} // for dir_cnt
+} // shift_sensor_fusion
+/*****************************************************************************/
+// sensor_fusion.c
@@ -0,0 +1,139 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _SENSOR_FUSION_H_
+#define _SENSOR_FUSION_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+#include "hall_common.h"
+
+/* Fusion of QEI and Hall data into one angle and velocity estimate (see FOC_SENSOR_FUSION).
+ * The QEI supplies fine resolution, the Hall edges supply absolute electrical-angle anchors.
+ *
+ * The angle and velocity are tracked by an alpha-beta observer driven by the QEI angle. This replaces the QEI period and velocity
+ * low-pass filters, so there is far less lag. Instead of filtering, each QEI sample is checked for consistency with the prediction:
+ * an outlier is ignored, and if the outlier persists for FUSE_GLITCH_LOOPS samples, it is a QEI count error,
+ * and the step is absorbed into the QEI bias.
+ *
+ * The angle at each Hall edge is learnt for the first FUSE_LEARN_CNT edges (separately for each spin direction, to allow for hysteresis).
+ * Thereafter, the error between the fused angle and the learnt anchor slowly corrects the QEI bias.
+ * This removes QEI count errors that have accumulated. An edge further than half a sector from its anchor is rejected as a Hall glitch.
+ *
+ * Angles are in client units, with ang_per_pair units per electrical cycle (e.g. Up-scaled QEI values per pole-pair)
+ */
+
+#define FUSE_FRAC_BITS 24 // Fractional bits used in angle and velocity state
+#define FUSE_ANG_GAIN_BITS 3 // Observer angle gain (alpha) is 1/2^FUSE_ANG_GAIN_BITS
+#define FUSE_VEL_GAIN_BITS 7 // Observer velocity gain (beta) is 1/2^FUSE_VEL_GAIN_BITS
+#define FUSE_SETTLE_LOOPS 512 // No. of updates for observer to settle, before consistency checks and anchor learning start
+#define FUSE_GLITCH_BITS 6 // QEI sample is an outlier if more than (ang_per_pair >> FUSE_GLITCH_BITS) from prediction
+#define FUSE_GLITCH_LOOPS 4 // No. of consecutive QEI outliers before step is accepted as a QEI count error
+#define FUSE_LEARN_CNT 16 // No. of Hall edges averaged to learn each anchor
+#define FUSE_HALL_GAIN_BITS 3 // Fraction of Hall anchor error corrected at each Hall edge is 1/2^FUSE_HALL_GAIN_BITS
+#define FUSE_RECIP_BITS 24 // Up-scaling of reciprocal of update period. NB Replaces a 64-bit division in every update
+#define FUSE_RPM_BITS 4 // Up-scaling of velocity-to-RPM factor. NB Replaces a 64-bit division in every update
+
+/** Different spin directions for Hall anchors */
+typedef enum FUSE_DIR_ETAG
+{
+  FUSE_POSI = 0, // Positive spin
+  FUSE_NEGA,     // Negative spin
+  NUM_FUSE_DIRS  // Handy Value!-)
+} FUSE_DIR_ENUM;
+
+/** Structure containing fused angle data for one motor */
+typedef struct SENSOR_FUSION_TAG
+{
+	S64_T ang; // Fused total angle (up-scaled by FUSE_FRAC_BITS)
+	int ang_veloc; // Fused angular velocity, in angle units per Reference Frequency Cycle (up-scaled by FUSE_FRAC_BITS)
+	int anchors[NUM_FUSE_DIRS][NUM_HALL_SECTS]; // Learnt electrical angle at start of each sector
+	int anchor_cnts[NUM_FUSE_DIRS][NUM_HALL_SECTS]; // No. of Hall edges used to learn each anchor
+	int ang_per_pair; // No. of angle units per electrical cycle
+	S64_T rpm_scale; // Factor converting velocity to RPM (up-scaled by FUSE_RPM_BITS)
+	unsigned recip_time; // Reciprocal of dif_time (up-scaled by FUSE_RECIP_BITS)
+	unsigned dif_time; // Time between previous 2 updates (NB Reciprocal only recalculated when this changes)
+	int glitch_lim; // Max. difference between QEI angle and prediction
+	int qei_bias; // Correction subtracted from QEI angle (accumulated QEI count errors). NB Up-scaled by FUSE_HALL_GAIN_BITS
+	int tot_ang; // Fused total angle (output)
+	int veloc; // Fused angular velocity (RPM) (output)
+	unsigned prev_time; // Time-stamp of previous update
+	int sect; // Hall sector at previous edge (-1 if unknown)
+	int settle_cnt; // No. of updates since start (saturates at FUSE_SETTLE_LOOPS)
+	int glitch_run; // No. of consecutive QEI outliers
+	int qei_glitches; // No. of QEI count errors absorbed into QEI bias
+	int hall_rejects; // No. of Hall edges rejected as glitches
+	int started; // Flag set once observer has been preset from QEI angle
+} SENSOR_FUSION_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise fusion of QEI and Hall data
+ * \param fuse_s // Reference to structure containing fused angle data
+ * \param ang_per_pair // No. of angle units per electrical cycle
+ */
+void init_sensor_fusion( // Initialise fusion of QEI and Hall data
+	SENSOR_FUSION_TYP &fuse_s, // Reference to structure containing fused angle data
+	int ang_per_pair // No. of angle units per electrical cycle
+);
+/*****************************************************************************/
+/** \brief Update fused angle and velocity from latest QEI angle and Hall parameters
+ * \param fuse_s // Reference to structure containing fused angle data
+ * \param qei_ang // Latest QEI total angle (in angle units)
+ * \param hall_param_s // Reference to structure containing latest Hall parameters (from Hall Client)
+ * \param cur_time // Current time (in Reference Frequency Cycles)
+ */
+void update_sensor_fusion( // Update fused angle and velocity estimate
+	SENSOR_FUSION_TYP &fuse_s, // Reference to structure containing fused angle data
+	int qei_ang, // Latest QEI total angle
+	HALL_PARAM_TYP &hall_param_s, // Reference to structure containing latest Hall parameters
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+/** \brief Shift fused angle (and Hall anchors), when the QEI angle is deliberately re-based (e.g. QEI origin reset)
+ * \param fuse_s // Reference to structure containing fused angle data
+ * \param shift_ang // Change to QEI angle (in angle units)
+ */
+void shift_sensor_fusion( // Shift fused angle when QEI angle re-based
+	SENSOR_FUSION_TYP &fuse_s, // Reference to structure containing fused angle data
+	int shift_ang // Change to QEI angle
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_sensor_fusion( // Initialise fusion of QEI and Hall data
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int ang_per_pair // No. of angle units per electrical cycle
+);
+/*****************************************************************************/
+void update_sensor_fusion( // Update fused angle and velocity estimate
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int qei_ang, // Latest QEI total angle
+	HALL_PARAM_TYP * hall_param_p, // Pointer to structure containing latest Hall parameters
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+void shift_sensor_fusion( // Shift fused angle when QEI angle re-based
+	SENSOR_FUSION_TYP * fuse_p, // Pointer to structure containing fused angle data
+	int shift_ang // Change to QEI angle
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _SENSOR_FUSION_H_
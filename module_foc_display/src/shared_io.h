@@ -59,6 +59,8 @@ typedef enum CMD_IO_ETAG
 	IO_CMD_DIR,
 	IO_CMD_GET_VALS2,
 	IO_CMD_GET_FAULT,
+	IO_CMD_SET_POSITION, // Set Motor Position (in QEI positions): Expect another parameter
+	IO_CMD_SET_PWM_PERIOD, // Set PWM period (see PWM_PERIOD_ENUM), only while motor stopped: Expect another parameter
   NUM_IO_CMDS    // Handy Value!-)
 } CMD_IO_ENUM;
 
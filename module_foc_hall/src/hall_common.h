@@ -41,6 +41,19 @@
 
 #define HALL_ALL_MASK (HALL_NERR_MASK | HALL_PHASE_MASK) // Used to mask out all 4-bits of Hall Sensor Data
 
+#define NUM_HALL_SECTS 6 // No. of valid Hall states (sectors) per electrical cycle
+
+/* Look-up table initialiser, converting [CBA] Hall state to sector (in positive spin order). NB 000 and 111 are invalid states
+ * Positive spin is defined by the [CBA] sequence 001 -> 011 -> 010 -> 110 -> 100 -> 101 -> 001
+ */
+#define HALL_SECT_LUT { -1 ,0 ,2 ,1 ,4 ,5 ,3 ,-1 }
+
+#define HALL_EDGE_BITS 2 // Bit resolution of Hall edge ring size
+#define NUM_HALL_EDGES (1 << HALL_EDGE_BITS) // Max. No. of Hall edges stored between client requests
+#define HALL_EDGE_MASK (NUM_HALL_EDGES - 1) // Mask used to wrap Hall edge ring index
+
+#define HALL_STOP_TICKS (SECOND >> 2) // Time without a Hall edge after which motor is assumed to have stopped
+
 /* Calculate speed definitions, preserving precision and preventing overflow !-)
  *
  * The time difference between changes in HALL data is measured in 'ticks'.
@@ -71,10 +84,26 @@ typedef enum ERROR_HALL_ETAG
 /** Raw Hall data type (on input pins) */
 typedef unsigned long HALL_RAW_TYP;
 
+/** Structure containing data for one Hall edge */
+typedef struct HALL_EDGE_TAG //
+{
+	unsigned hall_val; // Hall phase value after edge (3 LS bits)
+	unsigned time; // Time-stamp of edge (in Reference Frequency Cycles)
+	unsigned period; // Time since previous edge, if in same direction (0 if unknown, e.g. start-up, reversal, or restart after a stop)
+	int dir; // Spin direction of edge (1 = Positive, -1 = Negative, 0 = unknown, e.g. skipped state)
+} HALL_EDGE_TYP;
+
 /** Structure containing HALL parameters for one motor */
 typedef struct HALL_PARAM_TAG //
 {
 	unsigned hall_val; // Hall sensor value (3 LS bits)
+	unsigned edge_time; // Time-stamp of latest change in Hall phase value (in Reference Frequency Cycles)
+	unsigned period; // Time between latest two Hall edges in same direction (0 if unknown)
+	int veloc; // Angular velocity (RPM). NB Reduces if next edge is overdue, and zero when stopped
+	int dir; // Spin direction of latest Hall edge (1 = Positive, -1 = Negative, 0 = unknown)
+	HALL_EDGE_TYP edges[NUM_HALL_EDGES]; // Batch of Hall edges since previous client request (oldest first). NB Only num_edges are sent
+	int num_edges; // No. of Hall edges in batch
+	int lost_edges; // No. of (oldest) Hall edges discarded because edge ring was full
 	int err; // Error Status
 } HALL_PARAM_TYP;
 
@@ -0,0 +1,241 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "hall_decode.h"
+
+// Look-up table converting [CBA] Hall state to sector (in positive spin order)
+static const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT;
+
+/*****************************************************************************/
+void init_hall_decode( // Initialise Hall data structure for one motor
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	int motor_id // Unique motor id
+)
+{
+	hall_data_p->params.hall_val = 0; // Clear hall phase value
+	hall_data_p->params.edge_time = 0; // Clear time-stamp of latest Hall phase change
+	hall_data_p->params.period = 0; // Period NOT yet known
+	hall_data_p->params.veloc = 0; // Clear velocity
+	hall_data_p->params.dir = 0; // Spin direction NOT yet known
+	hall_data_p->params.num_edges = 0; // Clear batch of Hall edges
+	hall_data_p->params.lost_edges = 0; // Clear count of discarded Hall edges
+
+	hall_data_p->wr_cnt = 0; // Clear Hall edge ring
+	hall_data_p->rd_cnt = 0;
+	hall_data_p->lost_edges = 0;
+	hall_data_p->params.err = HALL_ERR_OFF; // Clear error status flag returned to client
+
+	hall_data_p->id = motor_id; // Set unique motor id
+	hall_data_p->status_errs = 0; // Initialise counter for Hall status errors
+} // init_hall_decode
+/*****************************************************************************/
+static void estimate_error_status( // Update estimate of error status based on new data
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned new_err // Newly acquired error flag
+)
+// We require MAX_HALL_STATUS_ERR consecutive new errors before error estimate is set
+{
+	// Check if status changed
+	if (new_err)
+	{ // new error detected
+
+		// Check previous error estimate
+		if (0 == hall_data_p->params.err)
+		{ // NO previous detected Error
+			hall_data_p->status_errs++; // Increment new error count
+
+			// Check if too many errors occured
+			if (MAX_HALL_STATUS_ERR <=  hall_data_p->status_errs)
+			{
+				hall_data_p->params.err = 1; // Switch ON Error Estimate
+			} // if (MAX_HALL_STATUS_ERR <=  hall_data_p->status_errs)
+		} // if (0 == hall_data_p->params.err)
+	} // if (new_err != hall_data_p->prev_err)
+	else
+	{ // NO new error detected
+
+		// Check previous error estimate
+		if (hall_data_p->params.err)
+		{ // Already detected Error
+			hall_data_p->status_errs--; // Decrement new error count
+
+			// Check if all errors cleared
+			if (0 >=  hall_data_p->status_errs)
+			{
+				hall_data_p->params.err = 0; // Switch OFF Error Estimate
+			} // if (0 >=  hall_data_p->status_errs)
+		} // if (hall_data_p->params.err)
+	} // if (new_err != hall_data_p->prev_err)
+
+} // estimate_error_status
+/*****************************************************************************/
+static int calc_hall_velocity( // Calculate angular velocity from time between Hall edges
+	int inp_dir, // Spin direction
+	unsigned inp_period // Time between Hall edges (in Reference Frequency Cycles)
+) // Returns angular velocity (RPM)
+{
+	int out_veloc; // Output angular velocity
+
+
+	assert(0 < inp_period); // ERROR: Division by zero trap
+
+	out_veloc = (int)((TICKS_PER_MIN_PER_HALL + (inp_period >> 1)) / inp_period); // NB Rounded
+
+	return (inp_dir * out_veloc);
+} // calc_hall_velocity
+/*****************************************************************************/
+static void update_hall_speed( // Update spin direction, period and velocity at a Hall edge
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned phase_val, // New Hall phase value
+	unsigned inp_time // Time-stamp of Hall edge
+)
+{
+	int old_sect = hall_sects[hall_data_p->params.hall_val]; // Sector before Hall edge
+	int new_sect = hall_sects[phase_val]; // Sector after Hall edge
+	unsigned inp_period = inp_time - hall_data_p->params.edge_time; // Time since previous Hall edge. NB unsigned handles wrap-around
+	int diff_sect; // Change in sector
+	int new_dir = 0; // Spin direction of this edge
+
+
+	// Check for valid sectors
+	if ((0 <= old_sect) && (0 <= new_sect))
+	{
+		diff_sect = new_sect - old_sect;
+
+		if (0 > diff_sect)
+		{
+			diff_sect += NUM_HALL_SECTS;
+		} // if (0 > diff_sect)
+
+		if (1 == diff_sect)
+		{
+			new_dir = 1;
+		} // if (1 == diff_sect)
+		else
+		{
+			if ((NUM_HALL_SECTS - 1) == diff_sect)
+			{
+				new_dir = -1;
+			} // if ((NUM_HALL_SECTS - 1) == diff_sect)
+		} // else !(1 == diff_sect)
+	} // if ((0 <= old_sect) && (0 <= new_sect))
+
+	// Check if previous sector was completely traversed in the same direction, without stopping (NB Motor may have restarted after a stop)
+	if ((0 != new_dir) && (new_dir == hall_data_p->params.dir) && (HALL_STOP_TICKS >= inp_period))
+	{
+		hall_data_p->params.period = inp_period;
+		hall_data_p->params.veloc = calc_hall_velocity( new_dir ,inp_period );
+	} // if ((0 != new_dir) && (new_dir == hall_data_p->params.dir) && (HALL_STOP_TICKS >= inp_period))
+	else
+	{ // Start-up, restart, reversal or skipped state: Speed NOT known until next edge. NB Stop interval is NOT used as a period
+		hall_data_p->params.period = 0;
+		hall_data_p->params.veloc = 0;
+	} // else !((0 != new_dir) && (new_dir == hall_data_p->params.dir) && (HALL_STOP_TICKS >= inp_period))
+
+	hall_data_p->params.dir = new_dir;
+} // update_hall_speed
+/*****************************************************************************/
+static void store_hall_edge( // Store Hall edge (with its direction and period) in ring-buffer. NB If ring is full, oldest edge is discarded
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned phase_val, // New Hall phase value
+	unsigned inp_time // Time-stamp of Hall edge
+)
+{
+	unsigned wr_off = (hall_data_p->wr_cnt & HALL_EDGE_MASK); // Ring offset for new edge
+
+
+	// Check for full ring
+	if (NUM_HALL_EDGES <= (hall_data_p->wr_cnt - hall_data_p->rd_cnt))
+	{
+		hall_data_p->rd_cnt++; // Discard oldest edge
+		hall_data_p->lost_edges++;
+	} // if (NUM_HALL_EDGES <= (hall_data_p->wr_cnt - hall_data_p->rd_cnt))
+
+	hall_data_p->edge_ring[wr_off].hall_val = phase_val;
+	hall_data_p->edge_ring[wr_off].time = inp_time;
+	hall_data_p->edge_ring[wr_off].period = hall_data_p->params.period; // NB Already updated by update_hall_speed()
+	hall_data_p->edge_ring[wr_off].dir = hall_data_p->params.dir;
+	hall_data_p->wr_cnt++;
+} // store_hall_edge
+/*****************************************************************************/
+void service_hall_input_pins( // Process new Hall data
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned inp_pins, // Set of raw data values on input port pins
+	unsigned inp_time // Time-stamp of change on input port pins
+)
+{
+	unsigned phase_val; // Raw phase value on input port pins
+	unsigned err_flg; // Flag set when Error condition detected
+
+
+	phase_val = inp_pins & HALL_PHASE_MASK; // Mask out phase bits of Hall Sensor data
+	err_flg = !(inp_pins & HALL_NERR_MASK); 	// NB Bit_3=0, and err_flg=1, if error detected,
+
+	// Update estimate of error status using new error flag
+	estimate_error_status( hall_data_p ,err_flg ); // NB Updates hall_data_p->params.err
+
+	// Check for change in phase value (NB Error bit may change on its own)
+	if (phase_val != hall_data_p->params.hall_val)
+	{
+		update_hall_speed( hall_data_p ,phase_val ,inp_time ); // NB Uses previous phase value and time-stamp
+		store_hall_edge( hall_data_p ,phase_val ,inp_time );
+
+		hall_data_p->params.edge_time = inp_time; // Store time-stamp of Hall edge (used by client to interpolate angle)
+	} // if (phase_val != hall_data_p->params.hall_val)
+
+	hall_data_p->params.hall_val = phase_val; // NB Filtering not yet implemented
+
+	return;
+} // service_hall_input_pins
+/*****************************************************************************/
+void update_hall_client_params( // Update Hall parameters for Client
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned cur_time // Current time
+)
+{
+	unsigned elapsed = cur_time - hall_data_p->params.edge_time; // Time since latest Hall edge. NB unsigned handles wrap-around
+	int edge_cnt = 0; // Hall edge counter
+
+
+	// Check if speed is known
+	if (0 < hall_data_p->params.period)
+	{
+		if (HALL_STOP_TICKS < elapsed)
+		{ // No edge for a long time: Assume motor stopped
+			hall_data_p->params.period = 0;
+			hall_data_p->params.veloc = 0;
+		} // if (HALL_STOP_TICKS < elapsed)
+		else
+		{
+			// If overdue for next edge, motor is slowing down, so reduce speed estimate
+			if (hall_data_p->params.period < elapsed)
+			{
+				hall_data_p->params.veloc = calc_hall_velocity( hall_data_p->params.dir ,elapsed );
+			} // if (hall_data_p->params.period < elapsed)
+		} // else !(HALL_STOP_TICKS < elapsed)
+	} // if (0 < hall_data_p->params.period)
+
+	// Copy batch of edges from ring (oldest first)
+	while (hall_data_p->rd_cnt != hall_data_p->wr_cnt)
+	{
+		hall_data_p->params.edges[edge_cnt] = hall_data_p->edge_ring[(hall_data_p->rd_cnt & HALL_EDGE_MASK)];
+		hall_data_p->rd_cnt++;
+		edge_cnt++;
+	} // while (hall_data_p->rd_cnt != hall_data_p->wr_cnt)
+
+	hall_data_p->params.num_edges = edge_cnt;
+	hall_data_p->params.lost_edges = hall_data_p->lost_edges;
+	hall_data_p->lost_edges = 0;
+} // update_hall_client_params
+/*****************************************************************************/
@@ -0,0 +1,97 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HALL_DECODE_H_
+#define _HALL_DECODE_H_
+
+#include <assert.h>
+
+#include "app_global.h"
+#include "hall_common.h"
+
+/* Port-independent decoding of raw Hall data for one motor.
+ * The Hall Server (hall_server.xc) only waits for a change on the input pins (or a Client request), and time-stamps it.
+ * This file does the rest: error status, spin direction, period, velocity, and the ring of time-stamped Hall edges.
+ *
+ * NB This file is independent of XMOS hardware, so can also be compiled in a host test (see src.dir)
+ */
+
+#define MAX_HALL_STATUS_ERR 2  // Maximum number of consecutive HALL status errors allowed
+
+/** Structure containing HALL data for one motor */
+typedef struct HALL_DATA_TAG //
+{
+	HALL_PARAM_TYP params;	// structure containing Hall parameters (for Client)
+	HALL_EDGE_TYP edge_ring[NUM_HALL_EDGES]; // Ring-buffer of Hall edges NOT yet sent to Client
+	unsigned wr_cnt; // No. of Hall edges written to ring (NB Wraps)
+	unsigned rd_cnt; // No. of Hall edges read from ring (NB Wraps)
+	int lost_edges; // No. of Hall edges discarded since previous Client request
+	int status_errs; // counter for invalid HALL status errors
+	int id; // Unique motor identifier
+} HALL_DATA_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** Initialise Hall data structure for one motor
+ * \param hall_data_s // Reference to structure containing HALL data for one motor
+ * \param motor_id // Unique motor identifier
+ */
+void init_hall_decode( // Initialise Hall data structure for one motor
+	HALL_DATA_TYP &hall_data_s, // Reference to structure containing HALL data for one motor
+	int motor_id // Unique motor identifier
+);
+/*****************************************************************************/
+/** Process new Hall data (from a change on the input pins)
+ * \param hall_data_s // Reference to structure containing HALL data for one motor
+ * \param inp_pins // Set of raw data values on input port pins
+ * \param inp_time // Time-stamp of change on input port pins
+ */
+void service_hall_input_pins( // Process new Hall data
+	HALL_DATA_TYP &hall_data_s, // Reference to structure containing HALL data for one motor
+	unsigned inp_pins, // Set of raw data values on input port pins
+	unsigned inp_time // Time-stamp of change on input port pins
+);
+/*****************************************************************************/
+/** Update Hall parameters for Client: Check for overdue edge, and copy batch of edges from ring
+ * \param hall_data_s // Reference to structure containing HALL data for one motor
+ * \param cur_time // Current time (used to check for overdue Hall edge)
+ */
+void update_hall_client_params( // Update Hall parameters for Client
+	HALL_DATA_TYP &hall_data_s, // Reference to structure containing HALL data for one motor
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_hall_decode( // Initialise Hall data structure for one motor
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	int motor_id // Unique motor identifier
+);
+/*****************************************************************************/
+void service_hall_input_pins( // Process new Hall data
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned inp_pins, // Set of raw data values on input port pins
+	unsigned inp_time // Time-stamp of change on input port pins
+);
+/*****************************************************************************/
+void update_hall_client_params( // Update Hall parameters for Client
+	HALL_DATA_TYP * hall_data_p, // Pointer to structure containing HALL data for one motor
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _HALL_DECODE_H_
@@ -0,0 +1,318 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "hall_interp.h"
+
+// Look-up table converting [CBA] Hall state to sector (in positive spin order)
+static const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT;
+
+/*****************************************************************************/
+void init_hall_interp( // Initialise Hall-interpolated angle estimator
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	int ang_per_pair // No. of angle units per electrical cycle
+)
+{
+	int sect_cnt; // Sector counter
+
+
+	assert(NUM_HALL_SECTS <= ang_per_pair); // ERROR: Angle resolution too small
+
+	interp_p->ang_per_pair = ang_per_pair;
+
+	// Preset nominal sector boundaries (60 degrees per sector)
+	for (sect_cnt=0; sect_cnt<=NUM_HALL_SECTS; sect_cnt++)
+	{
+		interp_p->sect_ang[sect_cnt] = (sect_cnt * ang_per_pair + (NUM_HALL_SECTS >> 1)) / NUM_HALL_SECTS;
+	} // for sect_cnt
+
+	for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+	{
+		interp_p->sect_per[sect_cnt] = 0;
+		interp_p->raw_per[sect_cnt] = 0;
+	} // for sect_cnt
+
+	interp_p->base_ang = 0;
+	interp_p->edge_ang = 0;
+	interp_p->tot_ang = 0;
+	interp_p->veloc = 0;
+	interp_p->width = 0;
+	interp_p->edge_time = 0;
+	interp_p->edge_period = 0; // NB Zero signals speed NOT yet known
+	interp_p->sect = -1; // Sector NOT yet known
+	interp_p->dir = 0;
+	interp_p->cal_cnt = 0;
+	interp_p->num_cals = 0;
+} // init_hall_interp
+/*****************************************************************************/
+static int calc_velocity( // Calculate angular velocity from sector width and traversal time
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	int inp_width, // Sector width (in angle units)
+	unsigned inp_period // Time to traverse sector (in Reference Frequency Cycles)
+) // Returns angular velocity (RPM)
+{
+	S64_T ticks_rpm; // Ticks * Revolutions Per Min
+	S64_T ang_period; // Angle-units per revolution * Ticks
+	int out_veloc; // Output angular velocity
+
+
+	ticks_rpm = (S64_T)SECS_PER_MIN * (S64_T)PLATFORM_REFERENCE_HZ * (S64_T)inp_width;
+	ang_period = (S64_T)interp_p->ang_per_pair * (S64_T)NUM_POLE_PAIRS * (S64_T)inp_period;
+
+	out_veloc = (int)((ticks_rpm + (ang_period >> 1)) / ang_period); // NB Rounded
+
+	if (0 > interp_p->dir)
+	{
+		out_veloc = -out_veloc;
+	} // if (0 > interp_p->dir)
+
+	return out_veloc;
+} // calc_velocity
+/*****************************************************************************/
+static void calibrate_sectors( // Re-calculate sector boundaries from filtered sector periods
+	HALL_INTERP_TYP * interp_p // Pointer to structure containing Hall-interpolated angle data
+)
+/* At constant speed, the time spent in each sector is proportional to the sector width.
+ * Sector 0 always starts at angle zero (the Hall origin)
+ */
+{
+	U64_T sum_per = 0; // Sum of sector periods (time for one electrical cycle)
+	U64_T acc_per = 0; // Accumulated sector periods
+	int sect_cnt; // Sector counter
+
+
+	for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+	{
+		// Check for sector without steady-speed data
+		if (0 == interp_p->sect_per[sect_cnt])
+		{
+			return; // NB Calibration requires data for all sectors
+		} // if (0 == interp_p->sect_per[sect_cnt])
+
+		sum_per += (U64_T)interp_p->sect_per[sect_cnt];
+	} // for sect_cnt
+
+	for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+	{
+		interp_p->sect_ang[sect_cnt] = (int)((acc_per * (U64_T)interp_p->ang_per_pair + (sum_per >> 1)) / sum_per);
+		acc_per += (U64_T)interp_p->sect_per[sect_cnt];
+	} // for sect_cnt
+
+	interp_p->sect_ang[NUM_HALL_SECTS] = interp_p->ang_per_pair;
+
+	interp_p->num_cals++;
+} // calibrate_sectors
+/*****************************************************************************/
+static void update_sector_period( // Low-pass filter the time taken to traverse one sector, if measured at steady speed
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	int sect_id, // Sector identifier
+	unsigned inp_period // Time to traverse sector
+)
+{
+	unsigned prev_per = interp_p->raw_per[sect_id]; // Previous time to traverse this sector
+	int diff_per; // Difference between input and filtered period
+
+
+	interp_p->raw_per[sect_id] = inp_period;
+
+	// Check for speed change since this sector was last traversed (NB Sector period is only proportional to sector width at steady speed)
+	if ((int)(prev_per >> HALL_STEADY_BITS) < abs( (int)inp_period - (int)prev_per ))
+	{
+		return;
+	} // if ((int)(prev_per >> HALL_STEADY_BITS) < abs( (int)inp_period - (int)prev_per ))
+
+	// Check for first value
+	if (0 == interp_p->sect_per[sect_id])
+	{
+		interp_p->sect_per[sect_id] = inp_period;
+	} // if (0 == interp_p->sect_per[sect_id])
+	else
+	{
+		diff_per = (int)inp_period - (int)interp_p->sect_per[sect_id];
+		interp_p->sect_per[sect_id] += (diff_per >> HALL_PER_COEF_BITS);
+	} // else !(0 == interp_p->sect_per[sect_id])
+} // update_sector_period
+/*****************************************************************************/
+static void process_hall_edge( // Update angle and velocity at a Hall edge
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	int new_sect, // New sector
+	HALL_EDGE_TYP * edge_p // Pointer to Hall edge data (NB Direction and period are supplied by Hall Server)
+)
+{
+	int old_sect = interp_p->sect; // Sector just left
+	int new_dir = edge_p->dir; // Spin direction of this edge
+	int diff_sect; // Change in sector (for skipped Hall state)
+	int sect_cnt; // Sector counter
+
+
+	// Check edge follows on from current sector (NB Edges are lost if Client requests are late)
+	if (new_sect != ((old_sect + new_dir + NUM_HALL_SECTS) % NUM_HALL_SECTS))
+	{
+		new_dir = 0; // Treat as skipped state
+	} // if (new_sect != ((old_sect + new_dir + NUM_HALL_SECTS) % NUM_HALL_SECTS))
+
+	switch(new_dir)
+	{
+		case 1 : // Positive spin: Edge is at start of new sector
+			if (0 == new_sect)
+			{
+				interp_p->base_ang += interp_p->ang_per_pair; // Start of next electrical cycle
+			} // if (0 == new_sect)
+
+			interp_p->edge_ang = interp_p->base_ang + interp_p->sect_ang[new_sect];
+		break; // case 1
+
+		case -1 : // Negative spin: Edge is at end of new sector
+			if ((NUM_HALL_SECTS - 1) == new_sect)
+			{
+				interp_p->base_ang -= interp_p->ang_per_pair; // End of previous electrical cycle
+			} // if ((NUM_HALL_SECTS - 1) == new_sect)
+
+			interp_p->edge_ang = interp_p->base_ang + interp_p->sect_ang[new_sect + 1];
+		break; // case -1
+
+		default : // Hall state skipped (noise or missed edge): Re-synchronise on centre of new sector
+			diff_sect = new_sect - old_sect;
+
+			// Take the shortest way round to the new sector. NB If both ways are equal, assume spin direction is unchanged
+			if ((diff_sect > (NUM_HALL_SECTS >> 1)) || ((diff_sect == (NUM_HALL_SECTS >> 1)) && (0 > interp_p->dir)))
+			{ // Negative spin: Check for crossing from sector 0 to sector 5
+				if (0 < diff_sect)
+				{
+					interp_p->base_ang -= interp_p->ang_per_pair; // End of previous electrical cycle
+				} // if (0 < diff_sect)
+			} // if ((diff_sect > (NUM_HALL_SECTS >> 1)) || ...
+			else
+			{
+				if ((diff_sect < -(NUM_HALL_SECTS >> 1)) || ((diff_sect == -(NUM_HALL_SECTS >> 1)) && (0 <= interp_p->dir)))
+				{ // Positive spin: Crossed from sector 5 to sector 0
+					interp_p->base_ang += interp_p->ang_per_pair; // Start of next electrical cycle
+				} // if ((diff_sect < -(NUM_HALL_SECTS >> 1)) || ...
+			} // else !((diff_sect > (NUM_HALL_SECTS >> 1)) || ...
+
+			interp_p->edge_ang = interp_p->base_ang
+				+ ((interp_p->sect_ang[new_sect] + interp_p->sect_ang[new_sect + 1]) >> 1);
+		break; // default
+	} // switch(new_dir)
+
+	// Check if old sector was completely traversed in the same direction, without stopping (NB Hall Server clears period otherwise)
+	if ((0 != new_dir) && (0 < edge_p->period))
+	{
+		interp_p->width = interp_p->sect_ang[old_sect + 1] - interp_p->sect_ang[old_sect];
+		interp_p->edge_period = edge_p->period;
+		interp_p->veloc = calc_velocity( interp_p ,interp_p->width ,edge_p->period );
+
+		update_sector_period( interp_p ,old_sect ,edge_p->period );
+
+		interp_p->cal_cnt++;
+
+		// Check if enough electrical cycles for a re-calibration
+		if ((HALL_CAL_CYCLES * NUM_HALL_SECTS) <= interp_p->cal_cnt)
+		{
+			calibrate_sectors( interp_p );
+			interp_p->cal_cnt = 0;
+		} // if ((HALL_CAL_CYCLES * NUM_HALL_SECTS) <= interp_p->cal_cnt)
+	} // if ((0 != new_dir) && (0 < edge_p->period))
+	else
+	{ // Start-up, restart, reversal or skipped state: Speed NOT known until next edge. NB Stop interval is NOT used as a sector period
+		interp_p->edge_period = 0;
+		interp_p->veloc = 0;
+		interp_p->cal_cnt = 0;
+
+		// Sector periods measured before now are NOT comparable with the following ones (NB Avoids accepting a speed-up as steady speed)
+		for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+		{
+			interp_p->raw_per[sect_cnt] = 0;
+		} // for sect_cnt
+	} // else !((0 != new_dir) && (0 < edge_p->period))
+
+	interp_p->dir = new_dir;
+	interp_p->sect = new_sect;
+	interp_p->edge_time = edge_p->time;
+} // process_hall_edge
+/*****************************************************************************/
+void update_hall_interp( // Update Hall-interpolated angle and velocity estimate
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	HALL_PARAM_TYP * hall_param_p, // Pointer to structure containing latest Hall parameters
+	unsigned cur_time // Current time
+)
+{
+	int new_sect = hall_sects[hall_param_p->hall_val & HALL_PHASE_MASK]; // Sector for latest Hall state
+	int edge_cnt; // Hall edge counter
+	int cur_width; // Width of current sector
+	int ang_inc; // Extrapolated angle increment since latest Hall edge
+	unsigned elapsed; // Time since latest Hall edge
+
+
+	// Ignore invalid Hall states
+	if (0 > new_sect)
+	{
+		return;
+	} // if (0 > new_sect)
+
+	// Check for first valid Hall state
+	if (0 > interp_p->sect)
+	{ // Position inside sector is unknown, so use centre of sector
+		interp_p->sect = new_sect;
+		interp_p->edge_ang = ((interp_p->sect_ang[new_sect] + interp_p->sect_ang[new_sect + 1]) >> 1);
+		interp_p->tot_ang = interp_p->edge_ang;
+		interp_p->edge_time = cur_time;
+
+		return;
+	} // if (0 > interp_p->sect)
+
+	// Process batch of Hall edges (oldest first)
+	for (edge_cnt=0; edge_cnt<hall_param_p->num_edges; edge_cnt++)
+	{
+		new_sect = hall_sects[hall_param_p->edges[edge_cnt].hall_val & HALL_PHASE_MASK];
+
+		// Check for valid change of sector
+		if ((0 <= new_sect) && (new_sect != interp_p->sect))
+		{
+			process_hall_edge( interp_p ,new_sect ,&hall_param_p->edges[edge_cnt] );
+		} // if ((0 <= new_sect) && (new_sect != interp_p->sect))
+	} // for edge_cnt
+
+	interp_p->tot_ang = interp_p->edge_ang; // Preset to angle at latest edge
+
+	// Check if speed is unknown (NB Hall Server clears period once motor has stopped)
+	if (0 == hall_param_p->period)
+	{
+		interp_p->edge_period = 0;
+		interp_p->veloc = 0;
+	} // if (0 == hall_param_p->period)
+
+	// Check if speed is known
+	if (0 < interp_p->edge_period)
+	{
+		elapsed = cur_time - interp_p->edge_time; // NB unsigned handles wrap-around
+
+		// Extrapolate at speed of previous sector, but do NOT leave current sector
+		ang_inc = (int)(((S64_T)interp_p->width * (S64_T)elapsed) / (S64_T)interp_p->edge_period);
+		cur_width = interp_p->sect_ang[interp_p->sect + 1] - interp_p->sect_ang[interp_p->sect];
+
+		// Check if overdue for next edge (NB Sectors may have different widths)
+		if (ang_inc >= cur_width)
+		{
+			ang_inc = cur_width - 1;
+
+			// Motor is slowing down, so reduce speed estimate
+			interp_p->veloc = calc_velocity( interp_p ,cur_width ,elapsed );
+		} // if (ang_inc >= cur_width)
+
+		interp_p->tot_ang += interp_p->dir * ang_inc;
+	} // if (0 < interp_p->edge_period)
+} // update_hall_interp
+/*****************************************************************************/
+// hall_interp.c
@@ -0,0 +1,107 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _HALL_INTERP_H_
+#define _HALL_INTERP_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+#include "hall_common.h"
+
+/* Hall-interpolated angle estimator, for motors without an encoder.
+ * The 3 Hall sensors divide each electrical cycle into 6 sectors.
+ * The Hall Server time-stamps every change in Hall state, and delivers the edges in batches, so NO edges are missed between requests.
+ * The Hall Server also supplies the spin direction and period of each edge, and detects when the motor has stopped.
+ * At each edge the angle is set to the sector boundary,
+ * and the speed is calculated from the width of the sector just traversed, divided by the time taken to traverse it.
+ * Between edges, the angle is extrapolated from the time since the last edge, but is NOT allowed to leave the current sector.
+ *
+ * Sector widths are NOT exactly 60 degrees (due to sensor placement). So, the period of each sector is low-pass filtered,
+ * and after every HALL_CAL_CYCLES complete electrical cycles (in one direction) the sector boundaries are re-calibrated.
+ * Only sector periods measured at a steady speed (i.e. close to the period of the same sector one cycle earlier) are filtered,
+ * so that data from start-up, slow-down, or a restart after a stop does NOT distort the calibration.
+ *
+ * Angles are in client units, with ang_per_pair units per electrical cycle (e.g. Up-scaled QEI values per pole-pair)
+ *
+ * WARNING: By Convention Phase_A is the MS-bit. However on the XMOS Motor boards, Phase_A is the LS-bit.
+ * Positive spin is defined by HALL_SECT_LUT (see hall_common.h)
+ */
+
+#define HALL_CAL_CYCLES 8 // No. of complete electrical cycles between sector re-calibrations
+#define HALL_PER_COEF_BITS 3 // Sector-period filter coefficient is 1/2^HALL_PER_COEF_BITS
+#define HALL_STEADY_BITS 4 // Sector period is only filtered if it changed by less than 1/2^HALL_STEADY_BITS in one electrical cycle
+
+/** Structure containing Hall-interpolated angle data for one motor */
+typedef struct HALL_INTERP_TAG
+{
+	int sect_ang[NUM_HALL_SECTS + 1]; // Calibrated angle at start of each sector (NB Last entry is end of cycle)
+	unsigned sect_per[NUM_HALL_SECTS]; // Filtered time to traverse each sector (in Reference Frequency Cycles)
+	unsigned raw_per[NUM_HALL_SECTS]; // Latest (unfiltered) time to traverse each sector
+	int ang_per_pair; // No. of angle units per electrical cycle
+	int base_ang; // Total angle at start of current electrical cycle
+	int edge_ang; // Total angle at latest Hall edge
+	int tot_ang; // Interpolated total angle
+	int veloc; // Estimated angular velocity (RPM)
+	int width; // Width of sector traversed between latest two Hall edges
+	unsigned edge_time; // Time-stamp of latest Hall edge
+	unsigned edge_period; // Time between latest two Hall edges
+	int sect; // Current sector [0..(NUM_HALL_SECTS-1)] (-1 if unknown)
+	int dir; // Spin direction (1 = Positive, -1 = Negative, 0 = unknown)
+	int cal_cnt; // No. of Hall edges (in same direction) since last calibration
+	int num_cals; // No. of sector calibrations done
+} HALL_INTERP_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise Hall-interpolated angle estimator, with nominal (60 degree) sectors
+ * \param interp_s // Reference to structure containing Hall-interpolated angle data
+ * \param ang_per_pair // No. of angle units per electrical cycle
+ */
+void init_hall_interp( // Initialise Hall-interpolated angle estimator
+	HALL_INTERP_TYP &interp_s, // Reference to structure containing Hall-interpolated angle data
+	int ang_per_pair // No. of angle units per electrical cycle
+);
+/*****************************************************************************/
+/** \brief Update Hall-interpolated angle and velocity estimate from latest Hall parameters
+ * \param interp_s // Reference to structure containing Hall-interpolated angle data
+ * \param hall_param_s // Reference to structure containing latest Hall parameters (from Hall Client)
+ * \param cur_time // Current time (in Reference Frequency Cycles)
+ */
+void update_hall_interp( // Update Hall-interpolated angle and velocity estimate
+	HALL_INTERP_TYP &interp_s, // Reference to structure containing Hall-interpolated angle data
+	HALL_PARAM_TYP &hall_param_s, // Reference to structure containing latest Hall parameters
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_hall_interp( // Initialise Hall-interpolated angle estimator
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	int ang_per_pair // No. of angle units per electrical cycle
+);
+/*****************************************************************************/
+void update_hall_interp( // Update Hall-interpolated angle and velocity estimate
+	HALL_INTERP_TYP * interp_p, // Pointer to structure containing Hall-interpolated angle data
+	HALL_PARAM_TYP * hall_param_p, // Pointer to structure containing latest Hall parameters
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _HALL_INTERP_H_
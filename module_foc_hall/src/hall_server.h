@@ -21,16 +21,9 @@
 
 #include "app_global.h"
 #include "hall_common.h"
+#include "hall_decode.h"
 
-#define MAX_HALL_STATUS_ERR 2  // Maximum number of consecutive HALL status errors allowed
-
-/** Structure containing HALL data for one motor */
-typedef struct HALL_DATA_TAG //
-{
-	HALL_PARAM_TYP params;	// structure containing Hall parameters (for Client)
-	int status_errs; // counter for invalid HALL status errors
-	int id; // Unique motor identifier
-} HALL_DATA_TYP;
+#define HALL_PORT_TIME_MASK 0xFFFF // Mask for port-counter time-stamps (NB Port counter is 16-bit, and is clocked by the Reference Clock)
 
 /*****************************************************************************/
 /** Get Hall Sensor data from port (motor) and send to client
@@ -0,0 +1,206 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "cordic.h"
+
+// Arc-tangent table: atan(2^-i) in CORDIC angle units (2^CORDIC_ANG_BITS per revolution)
+static const int atan_table[CORDIC_ITERS] = {
+	8192 ,4836 ,2555 ,1297 ,651 ,326 ,163 ,81 ,41 ,20 ,10 ,5 ,3 ,1
+};
+
+/*****************************************************************************/
+unsigned square_root_64( // Integer square-root (rounded down)
+	U64_T inp_val // Input value
+) // Returns square-root
+{
+	U64_T res_val = 0; // Result value
+	U64_T bit_val = ((U64_T)1 << 62); // Highest power of 4 (for 64-bit input)
+
+
+	while (bit_val > inp_val)
+	{
+		bit_val >>= 2;
+	} // while (bit_val > inp_val)
+
+	while (bit_val)
+	{
+		if (inp_val >= (res_val + bit_val))
+		{
+			inp_val -= (res_val + bit_val);
+			res_val = (res_val >> 1) + bit_val;
+		} // if (inp_val >= (res_val + bit_val))
+		else
+		{
+			res_val >>= 1;
+		} // else !(inp_val >= (res_val + bit_val))
+
+		bit_val >>= 2;
+	} // while (bit_val)
+
+	return (unsigned)res_val;
+} // square_root_64
+/*****************************************************************************/
+void cartesian_to_polar( // Convert Cartesian vector to polar form (magnitude and angle), using CORDIC
+	POLAR_TYP * polar_p, // Pointer to structure for returned polar vector
+	int inp_x, // X-coordinate
+	int inp_y // Y-coordinate
+)
+{
+	int cur_x = (inp_x << CORDIC_PRE_BITS); // Up-scaled X-coordinate
+	int cur_y = (inp_y << CORDIC_PRE_BITS); // Up-scaled Y-coordinate
+	int tmp_x; // Temporary X-coordinate
+	int cur_ang = 0; // Accumulated rotation
+	int iter_cnt; // CORDIC iteration counter
+	S64_T tmp_64; // Magnitude at 64-bit precision
+
+
+	assert(CORDIC_MAX_INP > abs(inp_x)); // ERROR: Input too large
+	assert(CORDIC_MAX_INP > abs(inp_y)); // ERROR: Input too large
+
+	// CORDIC only converges for angles in range [-90..90] degrees, so rotate left half-plane by 180 degrees
+	if (0 > cur_x)
+	{
+		cur_x = -cur_x;
+		cur_y = -cur_y;
+		cur_ang = CORDIC_HALF_REV;
+	} // if (0 > cur_x)
+
+	// Rotate vector onto positive X-axis, accumulating rotation
+	for (iter_cnt = 0; iter_cnt < CORDIC_ITERS; iter_cnt++)
+	{
+		tmp_x = cur_x;
+
+		if (0 < cur_y)
+		{
+			cur_x += (cur_y >> iter_cnt);
+			cur_y -= (tmp_x >> iter_cnt);
+			cur_ang += atan_table[iter_cnt];
+		} // if (0 < cur_y)
+		else
+		{
+			cur_x -= (cur_y >> iter_cnt);
+			cur_y += (tmp_x >> iter_cnt);
+			cur_ang -= atan_table[iter_cnt];
+		} // else !(0 < cur_y)
+	} // for iter_cnt
+
+	// Remove CORDIC gain and input up-scaling
+	tmp_64 = (S64_T)cur_x * (S64_T)CORDIC_GAIN_INV;
+	polar_p->mag = (int)((tmp_64 + ((S64_T)1 << (CORDIC_GAIN_BITS + CORDIC_PRE_BITS - 1))) >> (CORDIC_GAIN_BITS + CORDIC_PRE_BITS));
+
+	polar_p->ang = (unsigned)cur_ang & CORDIC_ANG_MASK;
+} // cartesian_to_polar
+/*****************************************************************************/
+int vector_magnitude( // Calculate vector magnitude, using CORDIC
+	int inp_x, // X-coordinate
+	int inp_y // Y-coordinate
+) // Returns vector magnitude
+{
+	POLAR_TYP polar_s; // Polar form of vector
+
+
+	cartesian_to_polar( &polar_s ,inp_x ,inp_y );
+
+	return polar_s.mag;
+} // vector_magnitude
+/*****************************************************************************/
+static int limit_component( // Reduce one vector component, so that vector lies on circle
+	int inp_val, // Input component value
+	int fix_val, // Value of other (fixed) component
+	int lim_mag // Magnitude limit (radius of circle)
+) // Returns reduced component value (with input sign)
+{
+	int out_val = inp_val; // Output component value
+	int max_val; // Maximum magnitude allowed for this component
+
+
+	max_val = (int)square_root_64( (U64_T)((S64_T)lim_mag * (S64_T)lim_mag - (S64_T)fix_val * (S64_T)fix_val) );
+
+	if (max_val < abs(inp_val))
+	{
+		if (0 > inp_val)
+		{
+			out_val = -max_val;
+		} // if (0 > inp_val)
+		else
+		{
+			out_val = max_val;
+		} // else !(0 > inp_val)
+	} // if (max_val < abs(inp_val))
+
+	return out_val;
+} // limit_component
+/*****************************************************************************/
+static int clip_component( // Clip one vector component into range [-lim_mag..lim_mag]
+	int inp_val, // Input component value
+	int lim_mag // Magnitude limit
+) // Returns clipped component value
+{
+	int out_val = inp_val; // Output component value
+
+
+	if (out_val > lim_mag)
+	{
+		out_val = lim_mag;
+	} // if (out_val > lim_mag)
+	else
+	{
+		if (out_val < -lim_mag)
+		{
+			out_val = -lim_mag;
+		} // if (out_val < -lim_mag)
+	} // else !(out_val > lim_mag)
+
+	return out_val;
+} // clip_component
+/*****************************************************************************/
+int limit_vector_magnitude( // Limit magnitude of DQ vector to a circle, using requested priority
+	int * set_d, // Pointer to D-component (changed for output)
+	int * set_q, // Pointer to Q-component (changed for output)
+	int lim_mag, // Magnitude limit (radius of circle)
+	VECT_PRIOR_ENUM prior // Limiting priority
+) // Returns vector magnitude before limiting
+{
+	int inp_mag = vector_magnitude( *set_d ,*set_q ); // Input vector magnitude
+
+
+	assert(0 < lim_mag); // ERROR: Limit must be positive
+
+	// Check if vector lies outside circle
+	if (inp_mag > lim_mag)
+	{
+		switch(prior)
+		{
+			case VECT_PRIOR_D : // Keep as much D-component as possible
+				*set_d = clip_component( *set_d ,lim_mag );
+				*set_q = limit_component( *set_q ,*set_d ,lim_mag );
+			break; // case VECT_PRIOR_D
+
+			case VECT_PRIOR_Q : // Keep as much Q-component as possible
+				*set_q = clip_component( *set_q ,lim_mag );
+				*set_d = limit_component( *set_d ,*set_q ,lim_mag );
+			break; // case VECT_PRIOR_Q
+
+			default : // VECT_PRIOR_ANG: Scale both components by lim_mag/inp_mag
+				*set_d = (int)(((S64_T)*set_d * (S64_T)lim_mag) / (S64_T)inp_mag);
+				*set_q = (int)(((S64_T)*set_q * (S64_T)lim_mag) / (S64_T)inp_mag);
+			break; // default
+		} // switch(prior)
+	} // if (inp_mag > lim_mag)
+
+	return inp_mag;
+} // limit_vector_magnitude
+/*****************************************************************************/
+// cordic.c
@@ -0,0 +1,134 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _CORDIC_H_
+#define _CORDIC_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+
+/* Fixed-point vector functions, based on a CORDIC in vectoring mode (shift-and-add only, no multiply per iteration).
+ * The CORDIC rotates the input vector onto the positive X-axis. The accumulated rotation is the vector angle,
+ * and the final X-coordinate is the vector magnitude (after removing the CORDIC gain).
+ *
+ * Angles are unsigned, with 2^CORDIC_ANG_BITS angles per revolution (360 degrees).
+ * To convert to N-bit angle units (e.g. sine-table angles), shift right by (CORDIC_ANG_BITS - N)
+ */
+
+#define CORDIC_ANG_BITS 16 // Bit resolution of CORDIC angles
+#define CORDIC_ANGS_IN_REV (1 << CORDIC_ANG_BITS) // No. of CORDIC angles in one revolution
+#define CORDIC_ANG_MASK (CORDIC_ANGS_IN_REV - 1) // Mask used to clip angle into one revolution
+#define CORDIC_HALF_REV (CORDIC_ANGS_IN_REV >> 1) // CORDIC angle for 180 degrees
+
+#define CORDIC_ITERS 14 // No. of CORDIC iterations. NB Last arc-tangent table entry is 1 angle unit
+
+#define CORDIC_PRE_BITS 4 // Input up-scaling, reduces truncation error in CORDIC iterations
+#define CORDIC_MAX_INP (1 << (29 - CORDIC_PRE_BITS)) // Max. allowed input magnitude (leaves room for CORDIC gain)
+
+#define CORDIC_GAIN_BITS 16 // Bit resolution of reciprocal CORDIC gain
+#define CORDIC_GAIN_INV 39797 // 1/CORDIC-gain (0.60725) up-scaled by 2^CORDIC_GAIN_BITS
+
+/** Enumeration of priorities used when limiting a vector magnitude */
+typedef enum VECT_PRIOR_ETAG
+{
+	VECT_PRIOR_ANG = 0,	// Preserve vector angle: Scale both components
+	VECT_PRIOR_D,				// Radial priority: Keep D-component, reduce Q-component
+	VECT_PRIOR_Q,				// Tangential priority: Keep Q-component, reduce D-component
+  NUM_VECT_PRIORS    // Handy Value!-)
+} VECT_PRIOR_ENUM;
+
+/** Structure containing polar form of a vector */
+typedef struct POLAR_TAG
+{
+	int mag; // Vector magnitude
+	unsigned ang; // Vector angle, in range [0..CORDIC_ANG_MASK]
+} POLAR_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Integer square-root (rounded down)
+ * \param inp_val // Input value
+ * \return Square-root of input value
+ */
+unsigned square_root_64( // Integer square-root (rounded down)
+	U64_T inp_val // Input value
+);
+/*****************************************************************************/
+/** \brief Convert Cartesian vector to polar form (magnitude and angle), using CORDIC
+ * \param polar_s // Reference to structure for returned polar vector
+ * \param inp_x // X-coordinate (e.g. D-component or alpha)
+ * \param inp_y // Y-coordinate (e.g. Q-component or beta)
+ */
+void cartesian_to_polar( // Convert Cartesian vector to polar form (magnitude and angle), using CORDIC
+	POLAR_TYP &polar_s, // Reference to structure for returned polar vector
+	int inp_x, // X-coordinate
+	int inp_y // Y-coordinate
+);
+/*****************************************************************************/
+/** \brief Calculate vector magnitude, using CORDIC
+ * \param inp_x // X-coordinate
+ * \param inp_y // Y-coordinate
+ * \return Vector magnitude
+ */
+int vector_magnitude( // Calculate vector magnitude, using CORDIC
+	int inp_x, // X-coordinate
+	int inp_y // Y-coordinate
+);
+/*****************************************************************************/
+/** \brief Limit magnitude of DQ vector to a circle, using requested priority
+ * \param set_d // Reference to D-component (changed for output)
+ * \param set_q // Reference to Q-component (changed for output)
+ * \param lim_mag // Magnitude limit (radius of circle)
+ * \param prior // Limiting priority (see VECT_PRIOR_ENUM)
+ * \return Vector magnitude before limiting
+ */
+int limit_vector_magnitude( // Limit magnitude of DQ vector to a circle, using requested priority
+	int &set_d, // Reference to D-component (changed for output)
+	int &set_q, // Reference to Q-component (changed for output)
+	int lim_mag, // Magnitude limit (radius of circle)
+	VECT_PRIOR_ENUM prior // Limiting priority
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+unsigned square_root_64( // Integer square-root (rounded down)
+	U64_T inp_val // Input value
+);
+/*****************************************************************************/
+void cartesian_to_polar( // Convert Cartesian vector to polar form (magnitude and angle), using CORDIC
+	POLAR_TYP * polar_p, // Pointer to structure for returned polar vector
+	int inp_x, // X-coordinate
+	int inp_y // Y-coordinate
+);
+/*****************************************************************************/
+int vector_magnitude( // Calculate vector magnitude, using CORDIC
+	int inp_x, // X-coordinate
+	int inp_y // Y-coordinate
+);
+/*****************************************************************************/
+int limit_vector_magnitude( // Limit magnitude of DQ vector to a circle, using requested priority
+	int * set_d, // Pointer to D-component (changed for output)
+	int * set_q, // Pointer to Q-component (changed for output)
+	int lim_mag, // Magnitude limit (radius of circle)
+	VECT_PRIOR_ENUM prior // Limiting priority
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _CORDIC_H_
@@ -0,0 +1,152 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "field_weakening.h"
+
+/*****************************************************************************/
+static void init_mtpa_table( // Build MTPA table from motor parameters
+	FW_DATA_TYP * fw_p, // Pointer to structure containing field-weakening data
+	MOTOR_PARAM_TYP * params_p // Pointer to structure containing motor parameters
+)
+/* For a motor with saliency (L_q > L_d), torque is proportional to Iq.(psi + (L_q - L_d).|Id|).
+ * Minimising current magnitude for a given torque gives (L_q - L_d).(Id^2 - Iq^2) + psi.|Id| = 0, so for each tangential current
+ *	|Id| = (sqrt(psi^2 + 4.(L_q - L_d)^2.Iq^2) - psi) / (2.(L_q - L_d))
+ * NB The table is indexed by Iq, NOT by the total current magnitude
+ */
+{
+	S64_T diff_L = (S64_T)params_p->L_q - (S64_T)params_p->L_d; // Inductance difference (saliency)
+	S64_T psi = (S64_T)params_p->psi; // Magnet flux linkage
+	S64_T inp_Iq; // Tangential current for this table entry
+	S64_T root_64; // Square-root term
+	int tab_cnt; // Table entry counter
+
+
+	for (tab_cnt = 0; tab_cnt <= MTPA_TAB_SIZ; tab_cnt++)
+	{
+		fw_p->mtpa_Id[tab_cnt] = 0; // Preset to NO saliency
+
+		// Check for saliency
+		if (0 < diff_L)
+		{
+			inp_Iq = (S64_T)(tab_cnt << MTPA_STEP_BITS);
+			root_64 = (S64_T)square_root_64( (U64_T)(psi * psi + 4 * diff_L * diff_L * inp_Iq * inp_Iq) );
+
+			fw_p->mtpa_Id[tab_cnt] = (int)((root_64 - psi + diff_L) / (diff_L << 1)); // NB Rounded
+		} // if (0 < diff_L)
+	} // for tab_cnt
+} // init_mtpa_table
+/*****************************************************************************/
+void init_field_weakening( // Initialise field-weakening engine, and build MTPA table from motor parameters
+	FW_DATA_TYP * fw_p, // Pointer to structure containing field-weakening data
+	MOTOR_PARAM_TYP * params_p, // Pointer to structure containing motor parameters
+	int volt_lim, // Demand voltage magnitude limit
+	int curr_lim, // Total current magnitude limit
+	int Id_lim, // Maximum demagnetising Id magnitude
+	int K_i // Integrator gain
+)
+{
+	assert(0 < volt_lim); // ERROR: Voltage limit must be positive
+	assert(Id_lim <= curr_lim); // ERROR: Id limit larger than current limit
+
+	fw_p->volt_lim = volt_lim;
+	fw_p->curr_lim = curr_lim;
+	fw_p->Id_lim = Id_lim;
+	fw_p->K_i = K_i;
+
+	init_mtpa_table( fw_p ,params_p );
+
+	reset_field_weakening( fw_p );
+} // init_field_weakening
+/*****************************************************************************/
+void reset_field_weakening( // Clear voltage-feedback integrator
+	FW_DATA_TYP * fw_p // Pointer to structure containing field-weakening data
+)
+{
+	fw_p->sum_Id = 0;
+} // reset_field_weakening
+/*****************************************************************************/
+int update_field_weakening( // Update field-weakening engine. NB The target Iq may be clipped
+	FW_DATA_TYP * fw_p, // Pointer to structure containing field-weakening data
+	int * targ_Iq, // Pointer to target tangential current
+	int set_Vd, // Radial demand voltage
+	int set_Vq // Tangential demand voltage
+) // Returns magnitude of demagnetising radial current
+{
+	int abs_Iq = abs(*targ_Iq); // Magnitude of target tangential current
+	int tab_cnt; // MTPA table index
+	int frac_Iq; // Fractional part of MTPA table index
+	int out_Id; // Output demagnetising radial current
+	int max_Iq; // Maximum allowed tangential current magnitude
+	int err_V; // Voltage magnitude error
+
+
+	// MTPA: Linearly interpolate table
+	if (MTPA_MAX_IQ <= abs_Iq)
+	{
+		out_Id = fw_p->mtpa_Id[MTPA_TAB_SIZ];
+	} // if (MTPA_MAX_IQ <= abs_Iq)
+	else
+	{
+		tab_cnt = (abs_Iq >> MTPA_STEP_BITS);
+		frac_Iq = abs_Iq - (tab_cnt << MTPA_STEP_BITS);
+
+		out_Id = fw_p->mtpa_Id[tab_cnt]
+			+ (((fw_p->mtpa_Id[tab_cnt + 1] - fw_p->mtpa_Id[tab_cnt]) * frac_Iq + MTPA_HALF_STEP) >> MTPA_STEP_BITS);
+	} // else !(MTPA_MAX_IQ <= abs_Iq)
+
+	// Voltage feedback: Error between demand voltage magnitude and voltage limit
+	err_V = vector_magnitude( set_Vd ,set_Vq ) - fw_p->volt_lim;
+
+	fw_p->sum_Id += fw_p->K_i * err_V;
+
+	// Clip integrator into range [0..Id_lim]
+	if (0 > fw_p->sum_Id)
+	{
+		fw_p->sum_Id = 0;
+	} // if (0 > fw_p->sum_Id)
+	else
+	{
+		if ((fw_p->Id_lim << FW_RES_BITS) < fw_p->sum_Id)
+		{
+			fw_p->sum_Id = (fw_p->Id_lim << FW_RES_BITS);
+		} // if ((fw_p->Id_lim << FW_RES_BITS) < fw_p->sum_Id)
+	} // else !(0 > fw_p->sum_Id)
+
+	out_Id += ((fw_p->sum_Id + FW_HALF_SCALE) >> FW_RES_BITS);
+
+	if (fw_p->Id_lim < out_Id)
+	{
+		out_Id = fw_p->Id_lim;
+	} // if (fw_p->Id_lim < out_Id)
+
+	// Clip target Iq, so total current magnitude stays within current limit
+	max_Iq = (int)square_root_64( (U64_T)(fw_p->curr_lim * fw_p->curr_lim - out_Id * out_Id) );
+
+	if (max_Iq < abs_Iq)
+	{
+		if (0 > *targ_Iq)
+		{
+			*targ_Iq = -max_Iq;
+		} // if (0 > *targ_Iq)
+		else
+		{
+			*targ_Iq = max_Iq;
+		} // else !(0 > *targ_Iq)
+	} // if (max_Iq < abs_Iq)
+
+	return out_Id;
+} // update_field_weakening
+/*****************************************************************************/
+// field_weakening.c
@@ -0,0 +1,122 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _FIELD_WEAKENING_H_
+#define _FIELD_WEAKENING_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+#include "motor_model.h"
+#include "cordic.h"
+
+/* The field-weakening engine generates the demagnetising radial current (Id) from two sources:-
+ *	MTPA: Below base speed, a Maximum-Torque-Per-Amp lookup table gives the Id that minimises current for the requested Iq.
+ *		The table is built from the motor parameters. For a surface-magnet motor (L_d == L_q) the MTPA Id is zero.
+ *	Voltage feedback: When the demand voltage magnitude exceeds the voltage limit, an integrator increases the demagnetising Id.
+ *		When the demand voltage falls back below the limit, the integrator decays back to zero.
+ * There is no mode switch. The target Iq is then clipped so that the total current magnitude stays within the current limit.
+ *
+ * Currents are handled as magnitudes. The caller applies the spin-direction dependent sign.
+ */
+
+#define MTPA_TAB_BITS 5 // Bit resolution of MTPA table size
+#define MTPA_TAB_SIZ (1 << MTPA_TAB_BITS) // No. of MTPA table intervals
+#define MTPA_STEP_BITS 2 // Bit resolution of Iq step between MTPA table entries
+#define MTPA_HALF_STEP (1 << (MTPA_STEP_BITS - 1)) // Half Iq step. NB Used for rounding
+#define MTPA_MAX_IQ (MTPA_TAB_SIZ << MTPA_STEP_BITS) // Largest Iq magnitude covered by MTPA table
+
+#define FW_RES_BITS 18 // Bit resolution of field-weakening integrator. NB Leaves room to scale the gain with the PWM period
+#define FW_HALF_SCALE (1 << (FW_RES_BITS - 1)) // Half field-weakening up-scaling factor. NB Used for rounding
+
+/** Structure containing field-weakening data for one motor */
+typedef struct FW_DATA_TAG
+{
+	int mtpa_Id[MTPA_TAB_SIZ + 1]; // MTPA table of radial current magnitude, indexed by tangential current magnitude
+	int sum_Id; // Up-scaled integrator output: Demagnetising Id from voltage feedback
+	int volt_lim; // Demand voltage magnitude limit
+	int curr_lim; // Total current magnitude limit
+	int Id_lim; // Maximum demagnetising Id magnitude
+	int K_i; // Integrator gain
+} FW_DATA_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise field-weakening engine, and build MTPA table from motor parameters
+ * \param fw_s // Reference to structure containing field-weakening data
+ * \param params_s // Reference to structure containing motor parameters
+ * \param volt_lim // Demand voltage magnitude limit
+ * \param curr_lim // Total current magnitude limit
+ * \param Id_lim // Maximum demagnetising Id magnitude
+ * \param K_i // Integrator gain
+ */
+void init_field_weakening( // Initialise field-weakening engine, and build MTPA table from motor parameters
+	FW_DATA_TYP &fw_s, // Reference to structure containing field-weakening data
+	MOTOR_PARAM_TYP &params_s, // Reference to structure containing motor parameters
+	int volt_lim, // Demand voltage magnitude limit
+	int curr_lim, // Total current magnitude limit
+	int Id_lim, // Maximum demagnetising Id magnitude
+	int K_i // Integrator gain
+);
+/*****************************************************************************/
+/** \brief Clear voltage-feedback integrator (e.g. on motor re-start)
+ * \param fw_s // Reference to structure containing field-weakening data
+ */
+void reset_field_weakening( // Clear voltage-feedback integrator
+	FW_DATA_TYP &fw_s // Reference to structure containing field-weakening data
+);
+/*****************************************************************************/
+/** \brief Update field-weakening engine. NB The target Iq may be clipped
+ * \param fw_s // Reference to structure containing field-weakening data
+ * \param targ_Iq // Reference to target tangential current
+ * \param set_Vd // Radial demand voltage
+ * \param set_Vq // Tangential demand voltage
+ * \return Magnitude of demagnetising radial current
+ */
+int update_field_weakening( // Update field-weakening engine. NB The target Iq may be clipped
+	FW_DATA_TYP &fw_s, // Reference to structure containing field-weakening data
+	int &targ_Iq, // Reference to target tangential current
+	int set_Vd, // Radial demand voltage
+	int set_Vq // Tangential demand voltage
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_field_weakening( // Initialise field-weakening engine, and build MTPA table from motor parameters
+	FW_DATA_TYP * fw_p, // Pointer to structure containing field-weakening data
+	MOTOR_PARAM_TYP * params_p, // Pointer to structure containing motor parameters
+	int volt_lim, // Demand voltage magnitude limit
+	int curr_lim, // Total current magnitude limit
+	int Id_lim, // Maximum demagnetising Id magnitude
+	int K_i // Integrator gain
+);
+/*****************************************************************************/
+void reset_field_weakening( // Clear voltage-feedback integrator
+	FW_DATA_TYP * fw_p // Pointer to structure containing field-weakening data
+);
+/*****************************************************************************/
+int update_field_weakening( // Update field-weakening engine. NB The target Iq may be clipped
+	FW_DATA_TYP * fw_p, // Pointer to structure containing field-weakening data
+	int * targ_Iq, // Pointer to target tangential current
+	int set_Vd, // Radial demand voltage
+	int set_Vq // Tangential demand voltage
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _FIELD_WEAKENING_H_
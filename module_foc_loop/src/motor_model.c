@@ -0,0 +1,73 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "motor_model.h"
+
+/*****************************************************************************/
+void init_motor_params( // Initialise a set of motor parameters
+	MOTOR_PARAM_TYP * params_p, // Pointer to structure containing motor parameters
+	int inp_L_d, // Up-scaled radial inductance
+	int inp_L_q, // Up-scaled tangential inductance
+	int inp_psi // Up-scaled magnet flux linkage
+)
+{
+	assert(0 <= inp_L_d); // ERROR: Negative values NOT supported
+	assert(0 <= inp_L_q); // ERROR: Negative values NOT supported
+	assert(0 <= inp_psi); // ERROR: Negative values NOT supported
+
+	params_p->L_d = inp_L_d;
+	params_p->L_q = inp_L_q;
+	params_p->psi = inp_psi;
+} // init_motor_params
+/*****************************************************************************/
+void calc_decoupling_voltages( // Calculate feed-forward voltages for cross-coupling decoupling and back-EMF
+	MOTOR_PARAM_TYP * params_p, // Pointer to structure containing motor parameters
+	int * ff_Vd, // Pointer to returned radial feed-forward voltage
+	int * ff_Vq, // Pointer to returned tangential feed-forward voltage
+	int veloc, // Angular velocity (RPM)
+	int inp_Id, // Radial current
+	int inp_Iq // Tangential current
+)
+{
+	S64_T tmp_64; // Up-scaled voltage at 64-bit precision
+
+
+	// Radial component: -w.Lq.Iq
+	tmp_64 = -(S64_T)params_p->L_q * (S64_T)veloc * (S64_T)inp_Iq;
+	*ff_Vd = (int)((tmp_64 + (S64_T)MOTOR_PARAM_HALF) >> MOTOR_PARAM_BITS);
+
+	// Tangential component: w.Ld.Id + w.psi
+	tmp_64 = (S64_T)veloc * ((S64_T)params_p->L_d * (S64_T)inp_Id + (S64_T)params_p->psi);
+	*ff_Vq = (int)((tmp_64 + (S64_T)MOTOR_PARAM_HALF) >> MOTOR_PARAM_BITS);
+} // calc_decoupling_voltages
+/*****************************************************************************/
+int convert_loop_radial( // Convert a radial current or voltage between the control-loop frame and the model frame. NB Self-inverse
+	int inp_val, // Radial value to convert
+	int spin_vel // Requested velocity (NB Only the sign is used)
+) // Returns converted radial value
+{
+	int out_val = inp_val; // Converted radial value. NB Axes agree for negative spin
+
+
+	// Control-loop demagnetising current follows the spin direction, model demagnetising current is always negative
+	if (0 <= spin_vel)
+	{
+		out_val = -inp_val;
+	} // if (0 <= spin_vel)
+
+	return out_val;
+} // convert_loop_radial
+/*****************************************************************************/
+// motor_model.c
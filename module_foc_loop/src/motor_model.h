@@ -0,0 +1,117 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _MOTOR_MODEL_H_
+#define _MOTOR_MODEL_H_
+
+#include <assert.h>
+
+#include "app_global.h"
+
+/* The motor model holds the electrical parameters of one motor, in control-loop units.
+ * I.e. voltages are demand voltages (as fed to the PWM conversion), currents are ADC current units,
+ * and angular velocity is the mechanical speed in RPM (the No. of pole-pairs is absorbed into the parameters).
+ *
+ * In the rotor frame of reference, the steady-state coil voltages are
+ *   Vd = R.Id - w.Lq.Iq
+ *   Vq = R.Iq + w.Ld.Id + w.psi
+ * The speed-dependent terms are fed-forward, so the current PIDs only need to correct the residual error.
+ *
+ * The model uses the standard rotor frame, where demagnetising radial current is negative for both spin directions.
+ * The control loop uses a radial axis where demagnetising current has the same sign as the spin direction,
+ * so radial currents and voltages are converted with convert_loop_radial() at the model boundary.
+ */
+
+#define MOTOR_PARAM_BITS 16 // Bit resolution of motor parameters
+#define MOTOR_PARAM_HALF (1 << (MOTOR_PARAM_BITS - 1)) // Half motor parameter scaling factor. NB Used for rounding
+
+/** Structure containing electrical parameters for one motor */
+typedef struct MOTOR_PARAM_TAG
+{
+	int L_d; // Radial inductance: Voltage per (RPM * Current), up-scaled by 2^MOTOR_PARAM_BITS
+	int L_q; // Tangential inductance: Voltage per (RPM * Current), up-scaled by 2^MOTOR_PARAM_BITS
+	int psi; // Magnet flux linkage (back-EMF constant): Voltage per RPM, up-scaled by 2^MOTOR_PARAM_BITS
+} MOTOR_PARAM_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise a set of motor parameters
+ * \param params_s // Reference to structure containing motor parameters
+ * \param inp_L_d // Up-scaled radial inductance
+ * \param inp_L_q // Up-scaled tangential inductance
+ * \param inp_psi // Up-scaled magnet flux linkage
+ */
+void init_motor_params( // Initialise a set of motor parameters
+	MOTOR_PARAM_TYP &params_s, // Reference to structure containing motor parameters
+	int inp_L_d, // Up-scaled radial inductance
+	int inp_L_q, // Up-scaled tangential inductance
+	int inp_psi // Up-scaled magnet flux linkage
+);
+/*****************************************************************************/
+/** \brief Calculate feed-forward voltages for cross-coupling decoupling and back-EMF
+ * \param params_s // Reference to structure containing motor parameters
+ * \param ff_Vd // Reference to returned radial feed-forward voltage
+ * \param ff_Vq // Reference to returned tangential feed-forward voltage
+ * \param veloc // Angular velocity (RPM)
+ * \param inp_Id // Radial current
+ * \param inp_Iq // Tangential current
+ */
+void calc_decoupling_voltages( // Calculate feed-forward voltages for cross-coupling decoupling and back-EMF
+	MOTOR_PARAM_TYP &params_s, // Reference to structure containing motor parameters
+	int &ff_Vd, // Reference to returned radial feed-forward voltage
+	int &ff_Vq, // Reference to returned tangential feed-forward voltage
+	int veloc, // Angular velocity (RPM)
+	int inp_Id, // Radial current
+	int inp_Iq // Tangential current
+);
+/*****************************************************************************/
+/** \brief Convert a radial current or voltage between the control-loop frame and the model frame. NB Self-inverse
+ * \param inp_val // Radial value to convert
+ * \param spin_vel // Requested velocity (NB Only the sign is used)
+ * \return Converted radial value
+ */
+int convert_loop_radial( // Convert a radial current or voltage between the control-loop frame and the model frame. NB Self-inverse
+	int inp_val, // Radial value to convert
+	int spin_vel // Requested velocity (NB Only the sign is used)
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_motor_params( // Initialise a set of motor parameters
+	MOTOR_PARAM_TYP * params_p, // Pointer to structure containing motor parameters
+	int inp_L_d, // Up-scaled radial inductance
+	int inp_L_q, // Up-scaled tangential inductance
+	int inp_psi // Up-scaled magnet flux linkage
+);
+/*****************************************************************************/
+void calc_decoupling_voltages( // Calculate feed-forward voltages for cross-coupling decoupling and back-EMF
+	MOTOR_PARAM_TYP * params_p, // Pointer to structure containing motor parameters
+	int * ff_Vd, // Pointer to returned radial feed-forward voltage
+	int * ff_Vq, // Pointer to returned tangential feed-forward voltage
+	int veloc, // Angular velocity (RPM)
+	int inp_Id, // Radial current
+	int inp_Iq // Tangential current
+);
+/*****************************************************************************/
+int convert_loop_radial( // Convert a radial current or voltage between the control-loop frame and the model frame. NB Self-inverse
+	int inp_val, // Radial value to convert
+	int spin_vel // Requested velocity (NB Only the sign is used)
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _MOTOR_MODEL_H_
@@ -0,0 +1,155 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "position_loop.h"
+
+/*****************************************************************************/
+void init_position_loop( // Initialise position loop limits, and clear position loop state
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int max_veloc, // Max. magnitude of requested velocity
+	int window, // Target reached when reference position within this distance
+	int follow_lim, // Max. allowed magnitude of following error
+	int ticks_per_posn // No. of reference clock ticks, at a velocity of 1 RPM, per position unit
+)
+{
+	assert(0 < max_veloc); // ERROR: Velocity limit must be positive
+	assert(0 <= window); // ERROR: Target window must NOT be negative
+	assert(window < follow_lim); // ERROR: Following-error limit smaller than target window
+	assert(0 < ticks_per_posn); // ERROR: Velocity-to-position conversion must be positive
+
+	posn_p->max_veloc = max_veloc;
+	posn_p->window = window;
+	posn_p->follow_lim = follow_lim;
+	posn_p->ticks_per_posn = ticks_per_posn;
+
+	posn_p->targ = 0;
+	preset_position_loop( posn_p ,0 );
+} // init_position_loop
+/*****************************************************************************/
+void preset_position_loop( // Preset reference position to measured position, and clear following error
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int meas_posn // Measured position
+)
+{
+	posn_p->ref = meas_posn; // Start reference from measured position
+	posn_p->ref_rem = 0; // Clear error diffusion remainder
+	posn_p->follow_err = 0; // Clear following error
+	posn_p->veloc = 0; // Clear velocity correction
+} // preset_position_loop
+/*****************************************************************************/
+static int calc_profile_velocity( // Calculate velocity proportional to a distance, clipped to max. velocity
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int dist // Distance to target position
+) // Returns clipped velocity
+{
+	S64_T veloc_64; // Velocity at 64-bit precision
+
+
+	veloc_64 = (S64_T)POSN_PROF_MUX * (S64_T)dist;
+	veloc_64 = (veloc_64 + (S64_T)POSN_HALF) >> POSN_BITS;
+
+	// Clip into specified speed range
+	if (veloc_64 > (S64_T)posn_p->max_veloc)
+	{
+		return posn_p->max_veloc;
+	} // if (veloc_64 > (S64_T)posn_p->max_veloc)
+
+	if (veloc_64 < (S64_T)(-posn_p->max_veloc))
+	{
+		return -posn_p->max_veloc;
+	} // if (veloc_64 < (S64_T)(-posn_p->max_veloc))
+
+	return (int)veloc_64;
+} // calc_profile_velocity
+/*****************************************************************************/
+int calc_position_start( // Calculate requested velocity to start a stationary motor towards the target position
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int meas_posn, // Measured position
+	int start_dist, // Max. distance travelled under open-loop control, while starting
+	int min_veloc // Min. velocity magnitude at which motor can start
+) // Returns requested velocity, or zero if target NOT further away than start_dist
+/* The open-loop start always travels its full distance, so a target within this distance would be overshot.
+ * The motor then stays stopped, and the target is NOT reached.
+ */
+{
+	int dist = posn_p->targ - meas_posn; // Distance to target position
+	int out_veloc; // Output requested velocity
+
+
+	preset_position_loop( posn_p ,meas_posn ); // Motor is stationary, so reference starts from measured position
+
+	// Check if target too close for an open-loop start
+	if (start_dist >= abs(dist)) return 0;
+
+	out_veloc = calc_profile_velocity( posn_p ,dist );
+
+	// Motor can NOT start below min_veloc, so keep moving towards the target position
+	if (min_veloc > abs(out_veloc))
+	{
+		out_veloc = ((0 > dist) ? -min_veloc : min_veloc);
+	} // if (min_veloc > abs(out_veloc))
+
+	return out_veloc;
+} // calc_position_start
+/*****************************************************************************/
+int calc_position_request( // Calculate requested velocity from distance between reference and target positions
+	POSN_DATA_TYP * posn_p // Pointer to position loop data structure
+) // Returns requested velocity (zero once target reached)
+{
+	// Check if reference has reached the target
+	if (posn_p->window >= abs(posn_p->targ - posn_p->ref))
+	{
+		// Hold reference on target, so the following-error P-term holds the measured position there
+		posn_p->ref = posn_p->targ;
+		posn_p->ref_rem = 0;
+
+		return 0;
+	} // if (posn_p->window >= abs(posn_p->targ - posn_p->ref))
+
+	return calc_profile_velocity( posn_p ,(posn_p->targ - posn_p->ref) );
+} // calc_position_request
+/*****************************************************************************/
+int update_position_loop( // Integrate target velocity into reference position, and update velocity correction from following error
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int targ_vel, // Target velocity (output of trajectory generator)
+	unsigned dif_ticks, // No. of reference clock ticks since previous update
+	int meas_posn // Measured position
+) // Returns 1 if following error exceeds limit, otherwise 0
+{
+	S64_T inc_64; // Reference position increment (in ticks), plus remainder
+	int inc_posn; // Reference position increment
+
+
+	// Integrate target velocity into reference position, with error diffusion
+	inc_64 = ((S64_T)targ_vel * (S64_T)dif_ticks) + (S64_T)posn_p->ref_rem;
+	inc_posn = (int)(inc_64 / (S64_T)posn_p->ticks_per_posn);
+	posn_p->ref_rem = (int)(inc_64 - ((S64_T)inc_posn * (S64_T)posn_p->ticks_per_posn)); // Update remainder
+
+	posn_p->ref += inc_posn;
+	posn_p->follow_err = posn_p->ref - meas_posn;
+
+	// Check for excessive following error
+	if (posn_p->follow_lim < abs(posn_p->follow_err))
+	{
+		posn_p->veloc = 0;
+
+		return 1;
+	} // if (posn_p->follow_lim < abs(posn_p->follow_err))
+
+	posn_p->veloc = ((POSN_P_MUX * posn_p->follow_err) + POSN_HALF) >> POSN_BITS;
+
+	return 0;
+} // update_position_loop
+/*****************************************************************************/
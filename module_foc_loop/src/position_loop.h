@@ -0,0 +1,156 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _POSITION_LOOP_H_
+#define _POSITION_LOOP_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+
+/* The position loop is cascaded on top of the speed loop, and runs while the motor is under closed-loop (FOC) control.
+ * The requested velocity is proportional to the distance between the reference and target positions.
+ * It is then shaped by the trajectory generator, and the resulting target velocity is integrated into the reference position.
+ * A P-term on the following error (reference minus measured position) is added to the speed PID request.
+ *
+ * There is NO minimum speed while under closed-loop control, so the requested velocity passes smoothly through zero,
+ * both when a move reverses, and when the target is reached. Once the reference is within 'window' of the target, it is held on the target,
+ * and the following-error P-term then holds the measured position at the target (through the speed PID, to the tangential current).
+ *
+ * A stationary motor can only be started (under open-loop control) towards a target further away than the open-loop travel.
+ *
+ * Positions are in any consistent unit (e.g. up-scaled QEI positions), velocities are in RPM.
+ */
+
+#define POSN_BITS 12 // No of bits in position-to-velocity scaling factors
+#define POSN_HALF (1 << (POSN_BITS - 1)) // Half position scaling factor. NB Used for rounding
+#define POSN_PROF_MUX 240 // Profile multiplier. NB Remaining distance of 1 revolution (of up-scaled QEI positions) requests 240 RPM
+#define POSN_P_MUX 480 // Following-error multiplier. NB Following error of 1 revolution (of up-scaled QEI positions) adds 480 RPM
+
+/** Structure containing position loop data for one motor */
+typedef struct POSN_DATA_TAG
+{
+	int targ; // (External) Target position
+	int ref; // Reference position, integrated from target velocity
+	int ref_rem; // Reference position remainder, used in error diffusion
+	int follow_err; // Following error: Reference position minus measured position
+	int veloc; // Velocity correction from following error
+	int max_veloc; // Max. magnitude of requested velocity
+	int window; // Target reached when reference position within this distance
+	int follow_lim; // Max. allowed magnitude of following error
+	int ticks_per_posn; // No. of reference clock ticks, at a velocity of 1 RPM, per position unit
+} POSN_DATA_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise position loop limits, and clear position loop state
+ * \param posn_s // Reference to position loop data structure
+ * \param max_veloc // Max. magnitude of requested velocity
+ * \param window // Target reached when reference position within this distance
+ * \param follow_lim // Max. allowed magnitude of following error
+ * \param ticks_per_posn // No. of reference clock ticks, at a velocity of 1 RPM, per position unit
+ */
+void init_position_loop( // Initialise position loop limits, and clear position loop state
+	POSN_DATA_TYP &posn_s, // Reference to position loop data structure
+	int max_veloc, // Max. magnitude of requested velocity
+	int window, // Target reached when reference position within this distance
+	int follow_lim, // Max. allowed magnitude of following error
+	int ticks_per_posn // No. of reference clock ticks, at a velocity of 1 RPM, per position unit
+);
+/*****************************************************************************/
+/** \brief Preset reference position to measured position, and clear following error
+ * \param posn_s // Reference to position loop data structure
+ * \param meas_posn // Measured position
+ */
+void preset_position_loop( // Preset reference position to measured position, and clear following error
+	POSN_DATA_TYP &posn_s, // Reference to position loop data structure
+	int meas_posn // Measured position
+);
+/*****************************************************************************/
+/** \brief Calculate requested velocity to start a stationary motor towards the target position
+ * \param posn_s // Reference to position loop data structure
+ * \param meas_posn // Measured position
+ * \param start_dist // Max. distance travelled under open-loop control, while starting
+ * \param min_veloc // Min. velocity magnitude at which motor can start
+ * \return Requested velocity, or zero if target NOT further away than start_dist
+ */
+int calc_position_start( // Calculate requested velocity to start a stationary motor towards the target position
+	POSN_DATA_TYP &posn_s, // Reference to position loop data structure
+	int meas_posn, // Measured position
+	int start_dist, // Max. distance travelled under open-loop control, while starting
+	int min_veloc // Min. velocity magnitude at which motor can start
+);
+/*****************************************************************************/
+/** \brief Calculate requested velocity from distance between reference and target positions
+ * \param posn_s // Reference to position loop data structure
+ * \return Requested velocity (zero once target reached)
+ */
+int calc_position_request( // Calculate requested velocity from distance between reference and target positions
+	POSN_DATA_TYP &posn_s // Reference to position loop data structure
+);
+/*****************************************************************************/
+/** \brief Integrate target velocity into reference position, and update velocity correction from following error
+ * \param posn_s // Reference to position loop data structure
+ * \param targ_vel // Target velocity (output of trajectory generator)
+ * \param dif_ticks // No. of reference clock ticks since previous update
+ * \param meas_posn // Measured position
+ * \return 1 if following error exceeds limit, otherwise 0
+ */
+int update_position_loop( // Integrate target velocity into reference position, and update velocity correction from following error
+	POSN_DATA_TYP &posn_s, // Reference to position loop data structure
+	int targ_vel, // Target velocity (output of trajectory generator)
+	unsigned dif_ticks, // No. of reference clock ticks since previous update
+	int meas_posn // Measured position
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_position_loop( // Initialise position loop limits, and clear position loop state
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int max_veloc, // Max. magnitude of requested velocity
+	int window, // Target reached when reference position within this distance
+	int follow_lim, // Max. allowed magnitude of following error
+	int ticks_per_posn // No. of reference clock ticks, at a velocity of 1 RPM, per position unit
+);
+/*****************************************************************************/
+void preset_position_loop( // Preset reference position to measured position, and clear following error
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int meas_posn // Measured position
+);
+/*****************************************************************************/
+int calc_position_start( // Calculate requested velocity to start a stationary motor towards the target position
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int meas_posn, // Measured position
+	int start_dist, // Max. distance travelled under open-loop control, while starting
+	int min_veloc // Min. velocity magnitude at which motor can start
+);
+/*****************************************************************************/
+int calc_position_request( // Calculate requested velocity from distance between reference and target positions
+	POSN_DATA_TYP * posn_p // Pointer to position loop data structure
+);
+/*****************************************************************************/
+int update_position_loop( // Integrate target velocity into reference position, and update velocity correction from following error
+	POSN_DATA_TYP * posn_p, // Pointer to position loop data structure
+	int targ_vel, // Target velocity (output of trajectory generator)
+	unsigned dif_ticks, // No. of reference clock ticks since previous update
+	int meas_posn // Measured position
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _POSITION_LOOP_H_
@@ -0,0 +1,136 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#include "trajectory.h"
+
+/*****************************************************************************/
+void init_trajectory( // Initialise trajectory limits, and clear trajectory state
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int max_acc, // Up-scaled maximum acceleration
+	int max_jerk // Up-scaled maximum jerk
+)
+{
+	assert(0 < max_jerk); // ERROR: Jerk limit must be positive
+	assert(max_jerk <= max_acc); // ERROR: Jerk limit larger than acceleration limit
+
+	traj_p->max_acc = max_acc;
+	traj_p->max_jerk = max_jerk;
+
+	preset_trajectory( traj_p ,0 );
+} // init_trajectory
+/*****************************************************************************/
+void preset_trajectory( // Preset trajectory to a steady velocity (with zero acceleration)
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int inp_vel // New output velocity
+)
+{
+	traj_p->vel = (inp_vel << TRAJ_RES_BITS); // Up-scale velocity
+	traj_p->acc = 0;
+} // preset_trajectory
+/*****************************************************************************/
+static int clip_acceleration( // Clip acceleration into allowed range
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int inp_acc // Up-scaled acceleration
+) // Returns clipped acceleration
+{
+	if (inp_acc > traj_p->max_acc)
+	{
+		inp_acc = traj_p->max_acc;
+	} // if (inp_acc > traj_p->max_acc)
+	else
+	{
+		if (inp_acc < -traj_p->max_acc)
+		{
+			inp_acc = -traj_p->max_acc;
+		} // if (inp_acc < -traj_p->max_acc)
+	} // else !(inp_acc > traj_p->max_acc)
+
+	return inp_acc;
+} // clip_acceleration
+/*****************************************************************************/
+static S64_T stop_velocity( // Velocity change if acceleration is applied for this iteration, then ramped down to zero
+	int inp_acc, // Up-scaled acceleration for this iteration
+	int jerk // Up-scaled jerk limit
+) // Returns up-scaled velocity change
+/* Applying acceleration a, then ramping down to zero in steps of jerk j, changes velocity by
+ * a + (a - j) + (a - 2j) + ... = a*(|a| + j)/(2*j)
+ */
+{
+	return ((S64_T)inp_acc * (S64_T)(abs(inp_acc) + jerk)) / (S64_T)(jerk << 1);
+} // stop_velocity
+/*****************************************************************************/
+int update_trajectory( // Move output velocity one iteration towards requested velocity
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int req_vel // Requested velocity
+) // Returns updated output velocity
+{
+	int jerk = traj_p->max_jerk; // Local copy of jerk limit
+	int acc = traj_p->acc; // Local copy of current acceleration
+	int err_vel = (req_vel << TRAJ_RES_BITS) - traj_p->vel; // Up-scaled velocity error
+	int up_acc = clip_acceleration( traj_p ,(acc + jerk) ); // Acceleration if increased
+	int down_acc = clip_acceleration( traj_p ,(acc - jerk) ); // Acceleration if decreased
+
+
+	// Check if close enough to finish in this iteration
+	if ((abs(err_vel) <= jerk) && (abs(acc) <= jerk))
+	{
+		traj_p->vel += err_vel; // Land exactly on requested velocity
+		traj_p->acc = err_vel; // NB Zero on next iteration
+	} // if ((abs(err_vel) <= jerk) && (abs(acc) <= jerk))
+	else
+	{
+		/* Choose the acceleration that moves fastest towards the requested velocity,
+		 * while still allowing the acceleration to be ramped down to zero without passing it.
+		 * If no choice avoids passing it (e.g. after a change of request), reduce the acceleration towards it
+		 */
+		if (0 <= err_vel)
+		{ // Requested velocity above output velocity
+			if ((S64_T)err_vel >= stop_velocity( up_acc ,jerk ))
+			{
+				acc = up_acc; // Accelerate
+			} // if ((S64_T)err_vel >= stop_velocity( up_acc ,jerk ))
+			else
+			{
+				if ((S64_T)err_vel < stop_velocity( acc ,jerk ))
+				{
+					acc = down_acc; // Decelerate
+				} // if ((S64_T)err_vel < stop_velocity( acc ,jerk ))
+			} // else !((S64_T)err_vel >= stop_velocity( up_acc ,jerk ))
+		} // if (0 <= err_vel)
+		else
+		{ // Requested velocity below output velocity
+			if ((S64_T)err_vel <= stop_velocity( down_acc ,jerk ))
+			{
+				acc = down_acc; // Decelerate
+			} // if ((S64_T)err_vel <= stop_velocity( down_acc ,jerk ))
+			else
+			{
+				if ((S64_T)err_vel > stop_velocity( acc ,jerk ))
+				{
+					acc = up_acc; // Accelerate
+				} // if ((S64_T)err_vel > stop_velocity( acc ,jerk ))
+			} // else !((S64_T)err_vel <= stop_velocity( down_acc ,jerk ))
+		} // else !(0 <= err_vel)
+
+		acc = clip_acceleration( traj_p ,acc ); // NB Limit may have been reduced
+
+		traj_p->acc = acc;
+		traj_p->vel += acc;
+	} // else !((abs(err_vel) <= jerk) && (abs(acc) <= jerk))
+
+	return ((traj_p->vel + TRAJ_HALF_SCALE) >> TRAJ_RES_BITS); // Return rounded output velocity
+} // update_trajectory
+/*****************************************************************************/
+// trajectory.c
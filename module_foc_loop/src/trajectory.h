@@ -0,0 +1,108 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _TRAJECTORY_H_
+#define _TRAJECTORY_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+
+/* The trajectory generator produces a jerk-limited (S-curve) velocity profile.
+ * It is called once per control-loop iteration, and moves the output velocity towards the requested velocity.
+ * The acceleration is ramped up and down by at most 'max_jerk' per iteration, and is clipped to 'max_acc'.
+ * The acceleration is reduced early, so that it reaches zero as the output velocity reaches the requested velocity.
+ *
+ * Velocity, acceleration and jerk are held up-scaled by 2^TRAJ_RES_BITS,
+ * and the limits are specified in up-scaled units per iteration.
+ * E.g. max_acc = (1 << TRAJ_RES_BITS) allows a velocity change of 1 unit per iteration.
+ */
+
+#define TRAJ_RES_BITS 16 // Bit resolution of trajectory up-scaling
+#define TRAJ_HALF_SCALE (1 << (TRAJ_RES_BITS - 1)) // Half trajectory up-scaling factor. NB Used for rounding
+
+/* As the limits are per iteration, they must be re-scaled if the iteration period changes (e.g. with the PWM period),
+ * to keep the same limits in real time. For an iteration period 2^sh times longer (sh may be negative),
+ * the acceleration limit scales by 2^sh, and the jerk limit by 2^(2*sh)
+ */
+#define TRAJ_SCALE_BITS(val ,sh) (((val) << (((sh) > 0) ? (sh) : 0)) >> (((sh) < 0) ? -(sh) : 0)) // Scale by 2^sh
+#define TRAJ_PERIOD_ACC(acc ,sh) TRAJ_SCALE_BITS( (acc) ,(sh) ) // Acceleration limit for iteration period scaled by 2^sh
+#define TRAJ_PERIOD_JERK(jerk ,sh) TRAJ_SCALE_BITS( (jerk) ,((sh) << 1) ) // Jerk limit for iteration period scaled by 2^sh
+
+/** Structure containing trajectory data for one set-point */
+typedef struct TRAJ_DATA_TAG
+{
+	int vel; // Up-scaled output velocity
+	int acc; // Up-scaled output acceleration (velocity change per iteration). NB Used for feed-forward
+	int max_acc; // Up-scaled maximum allowed acceleration
+	int max_jerk; // Up-scaled maximum allowed jerk (acceleration change per iteration)
+} TRAJ_DATA_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** \brief Initialise trajectory limits, and clear trajectory state
+ * \param traj_s // Reference to trajectory data structure
+ * \param max_acc // Up-scaled maximum acceleration
+ * \param max_jerk // Up-scaled maximum jerk
+ */
+void init_trajectory( // Initialise trajectory limits, and clear trajectory state
+	TRAJ_DATA_TYP &traj_s, // Reference to trajectory data structure
+	int max_acc, // Up-scaled maximum acceleration
+	int max_jerk // Up-scaled maximum jerk
+);
+/*****************************************************************************/
+/** \brief Preset trajectory to a steady velocity (with zero acceleration)
+ * \param traj_s // Reference to trajectory data structure
+ * \param inp_vel // New output velocity
+ */
+void preset_trajectory( // Preset trajectory to a steady velocity (with zero acceleration)
+	TRAJ_DATA_TYP &traj_s, // Reference to trajectory data structure
+	int inp_vel // New output velocity
+);
+/*****************************************************************************/
+/** \brief Move output velocity one iteration towards requested velocity
+ * \param traj_s // Reference to trajectory data structure
+ * \param req_vel // Requested velocity
+ * \return Updated output velocity
+ */
+int update_trajectory( // Move output velocity one iteration towards requested velocity
+	TRAJ_DATA_TYP &traj_s, // Reference to trajectory data structure
+	int req_vel // Requested velocity
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_trajectory( // Initialise trajectory limits, and clear trajectory state
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int max_acc, // Up-scaled maximum acceleration
+	int max_jerk // Up-scaled maximum jerk
+);
+/*****************************************************************************/
+void preset_trajectory( // Preset trajectory to a steady velocity (with zero acceleration)
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int inp_vel // New output velocity
+);
+/*****************************************************************************/
+int update_trajectory( // Move output velocity one iteration towards requested velocity
+	TRAJ_DATA_TYP * traj_p, // Pointer to trajectory data structure
+	int req_vel // Requested velocity
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _TRAJECTORY_H_
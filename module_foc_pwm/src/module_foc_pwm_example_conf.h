@@ -56,6 +56,12 @@
 /** Define if Shared Memory is used to transfer PWM data from Client to Server */
 #define PWM_SHARED_MEM 0 // 0: Use c_pwm channel for pwm data transfer
 
+/** Define if one PWM Server core drives all motors (see pwm_multi_server.h) */
+#define PWM_MULTI_SERVER 0 // 0: One PWM Server core per motor
+
+/** Define if phases are centred at different times (see pwm_common.h). WARNING: Keep at 0 with leg shunts */
+#define PWM_PHASE_SHIFT 0 // 0: All phases centred on the same reference time
+
 /** Define flag for verbose printing */
 #define PRINT_TST_PWM 0
 
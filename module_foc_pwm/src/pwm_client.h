@@ -25,6 +25,23 @@
 #include "pwm_common.h"
 #include "pwm_convert_width.h"
 
+/*****************************************************************************/
+/** \brief Select PWM period, and send selection from Client to Server
+ *
+ *  Loads the precomputed timing values for this period, and sends the selection to the Server.
+ *  The Server then waits for the next call to foc_pwm_put_parameters(), and re-aligns its reference time to the new period.
+ *  Called once at start-up (after the shared memory address is received), and may be called again while the PWM is off.
+ *  NB All subsequent pulse-widths must be in the range [0..pwm_comms_s.timing.max_value]
+ *
+ *  \param pwm_comms_s  Reference to structure containing PWM communication data
+ *  \param c_pwm  Channel between Client and Server
+ *  \param period_sel  Selected PWM period (see PWM_PERIOD_ENUM)
+ */
+void foc_pwm_set_period( // Select PWM period, and send selection from Client to Server
+	REFERENCE_PARAM( PWM_COMMS_TYP ,pwm_data_sp ), // Reference/Pointer to structure containing PWM communication data
+	chanend c_pwm, // Channel between Client and Server
+	int period_sel // Selected PWM period (see PWM_PERIOD_ENUM)
+);
 /*****************************************************************************/
 /** \brief Send PWM parameters from Client to Server
  *
@@ -39,5 +56,17 @@ void foc_pwm_put_parameters( // Send PWM parameters from Client to Server
 	chanend c_pwm 				// Channel between Client and Server
 );
 /*****************************************************************************/
+/** \brief Get No. of PWM periods where the Server missed a port deadline
+ *
+ *  When a deadline is missed, the Server forces all PWM legs off for the rest of that period.
+ *  The count only increases, so the Client detects new misses by comparing with its previous value.
+ *
+ *  \param pwm_comms_s  Reference to structure containing PWM communication data
+ *  \return Miss count
+ */
+unsigned foc_pwm_get_miss_count( // Get No. of PWM periods where the Server missed a port deadline
+	REFERENCE_PARAM( PWM_COMMS_TYP ,pwm_data_sp ) // Reference/Pointer to structure containing PWM communication data
+);
+/*****************************************************************************/
 
 #endif // _PWM_CLIENT_H_
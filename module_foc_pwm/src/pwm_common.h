@@ -22,10 +22,26 @@
 	#error Define. PWM_SHARED_MEM in app_global.h
 #endif // PWM_SHARED_MEM
 
+#ifndef PWM_MULTI_SERVER
+	#define PWM_MULTI_SERVER 0 // Default: One PWM Server core per motor
+#endif // PWM_MULTI_SERVER
+
+#ifndef PWM_PHASE_SHIFT
+	#define PWM_PHASE_SHIFT 0 // Default: All phases centred on the same reference time
+#endif // PWM_PHASE_SHIFT
+
+#ifndef PWM_SINGLE_SHUNT
+	#define PWM_SINGLE_SHUNT 0 // Default: One ADC trigger per PWM period (Leg shunts)
+#endif // PWM_SINGLE_SHUNT
+
 #ifndef PWM_MAX_VALUE
 	#error Define. PWM_MAX_VALUE in app_global.h
 #endif // PWM_MAX_VALUE
 
+#ifndef PWM_RES_BITS
+	#error Define. PWM_RES_BITS in app_global.h
+#endif // PWM_RES_BITS
+
 /** Define Number of buffers in storage ring */
 #define NUM_PWM_BUFS 2  // Double-buffered
 
@@ -41,10 +57,75 @@
 
 #define HALF_PWM_MAX (PWM_MAX_VALUE >> 1)  // Half of maximum PWM width value
 
+/* Selectable PWM period.
+ * PWM_MAX_VALUE (in app_global.h) only defines the default period. Each motor can select a different period at start-up
+ * (e.g. short for low-inductance motors, long for efficiency). The period is always a power of 2 PWM clock cycles.
+ * All values that depend on the period are precomputed in a table (see pwm_convert_width.c), so the Server and Client
+ * just read them from a PWM_TIMING_TYP structure. WARNING: Periods shorter than 2048 cycles do NOT leave time for the ADC
+ */
+#define PWM_PERIOD_MIN_BITS 11 // Resolution bits of shortest selectable PWM period
+#define PWM_PERIOD_MAX_BITS 13 // Resolution bits of longest selectable PWM period
+
+/** Different selectable PWM periods (in PWM clock cycles) */
+typedef enum PWM_PERIOD_ETAG
+{
+  PWM_PERIOD_2048 = 0,	// Short period (High switching frequency)
+  PWM_PERIOD_4096,			// Medium period
+  PWM_PERIOD_8192,			// Long period (Low switching frequency)
+  NUM_PWM_PERIODS    // Handy Value!-)
+} PWM_PERIOD_ENUM;
+
+#define PWM_PERIOD_DEF (PWM_RES_BITS - PWM_PERIOD_MIN_BITS) // Default PWM period (selected by PWM_RES_BITS)
+
+#if ((PWM_RES_BITS < PWM_PERIOD_MIN_BITS) || (PWM_RES_BITS > PWM_PERIOD_MAX_BITS))
+#error PWM_RES_BITS does NOT match a selectable PWM period
+#endif // ((PWM_RES_BITS < PWM_PERIOD_MIN_BITS) || (PWM_RES_BITS > PWM_PERIOD_MAX_BITS))
+
+/* Phase-shifted PWM.
+ * If PWM_PHASE_SHIFT is set, Phase_A pulses are centred PWM_SHIFT_CYCLES before the reference time,
+ * and Phase_C pulses PWM_SHIFT_CYCLES after it. The pulse-widths (and so the phase voltages) are unchanged.
+ * This spreads the switching edges, and opens a window between the rising edges of each pair of phases.
+ * During each window a DC-link (single) shunt carries the current of ONE phase (or minus one phase).
+ * If PWM_SINGLE_SHUNT is also set, the ADC is triggered twice per period, once inside each window,
+ * and 3 phase currents are reconstructed from the 2 samples (see rebuild_shunt_frame() in module_foc_adc).
+ * A window shorter than PWM_SHUNT_MIN_WIN leaves NO time for the shunt signal to settle,
+ * so NO triggers are sent for that period (the ADC holds its previous values).
+ * WARNING: With leg shunts, keep PWM_PHASE_SHIFT at 0. The shift shortens the window where all low legs are on by 2*PWM_SHIFT_CYCLES
+ */
+#ifndef PWM_SHIFT_CYCLES
+	#define PWM_SHIFT_CYCLES (3 * MICRO_SEC) // Phase shift (NB Only used if PWM_PHASE_SHIFT set)
+#endif // PWM_SHIFT_CYCLES
+
+#define PWM_SHIFT_LIM ((1 << (PWM_PERIOD_MIN_BITS - 2)) - (PWM_PORT_WID << 2)) // Max. phase shift (leaves time for ADC trigger wait)
+
+#if ((PWM_PHASE_SHIFT) && (PWM_SHIFT_CYCLES > PWM_SHIFT_LIM))
+#error PWM_SHIFT_CYCLES too large: Falling edges of Phase_A would precede the ADC trigger
+#endif // ((PWM_PHASE_SHIFT) && (PWM_SHIFT_CYCLES > PWM_SHIFT_LIM))
+
+#if ((PWM_SINGLE_SHUNT) && (0 == PWM_PHASE_SHIFT))
+#error PWM_SINGLE_SHUNT requires PWM_PHASE_SHIFT (NO measurement windows without phase shift)
+#endif // ((PWM_SINGLE_SHUNT) && (0 == PWM_PHASE_SHIFT))
+
+#if ((PWM_SINGLE_SHUNT) && (0 == PWM_MULTI_SERVER))
+#error PWM_SINGLE_SHUNT requires PWM_MULTI_SERVER (Single-motor Server only has one blocking ADC trigger per period)
+#endif // ((PWM_SINGLE_SHUNT) && (0 == PWM_MULTI_SERVER))
+
+#define PWM_SHUNT_TRIGS 2 // No. of ADC triggers per PWM period in single-shunt mode
+#define PWM_SHUNT_MIN_WIN ((15 * MICRO_SEC + 5) / 10) // 1500ns Min. single-shunt window (settling time)
+#define PWM_SHUNT_GUARD HALF_PORT_WID // Trigger point is this early, before end of single-shunt window (allows for timing jitter)
+#define PWM_SHUNT_MIN_GAP ((25 * MICRO_SEC + 5) / 10) // 2500ns Min. time between triggers (ADC conversion time)
+
+/* In single-shunt mode, each trigger is a control token, which tells the ADC which sample it is, and which phase is measured.
+ * WARNING: Must match ADC_SHUNT_CT_BASE in adc_common.h (module_foc_adc)
+ */
+#define PWM_SHUNT_CT_BASE 0x10 // 1st single-shunt control token (NB Above tokens reserved by XS1 architecture)
+#define PWM_SHUNT_CT(samp ,phase) (PWM_SHUNT_CT_BASE + ((samp) * NUM_PWM_PHASES) + (phase)) // Token for one sample
+
 /** Different PWM Control Commands (Client --> Server) */
 typedef enum CMD_PWM_ETAG
 {
 	// NB Don't use non-negative integer, due to conflicts with Buffer indices
+	PWM_CMD_PERIOD = (-3),	// Select PWM period: Expect another parameter (PWM_PERIOD_ENUM)
 	PWM_CMD_ACK = (-2),	// PWM Server Command Acknowledged (Control)
 	PWM_CMD_LOOP_STOP = (-1), // Stop while-loop.
 } CMD_PWM_ENUM;
@@ -73,10 +154,22 @@ typedef struct PWM_PARAM_TAG //
 	int id; // Unique Motor identifier e.g. 0 or 1 (NB -1 used to signal termination)
 } PWM_PARAM_TYP;
 
+/** Structure containing precomputed timing values for one PWM period */
+typedef struct PWM_TIMING_TAG
+{
+	int res_bits; // No. of bits used to define No. of different PWM pulse-widths
+	unsigned max_value; // No. of different PWM pulse-widths (PWM period in PWM clock cycles)
+	unsigned half_max; // Half of maximum PWM width value
+	unsigned quart_max; // Quarter of maximum PWM width value (NB ADC trigger is sent this early)
+	unsigned stagger; // The time at which each motor starts the PWM, is staggered by this amount
+	int shift; // Phase shift: Phase_A is centred this much early, Phase_C this much late (see PWM_PHASE_SHIFT)
+} PWM_TIMING_TYP;
+
 /** Structure containing pwm communication control data */
 typedef struct PWM_COMMS_TAG
 {
 	PWM_PARAM_TYP params; // Structure of PWM parameters (for Server)
+	PWM_TIMING_TYP timing; // Structure of timing values for selected PWM period. NB NOT sent with parameters
 	int buf; 	// double-buffer identifier. e.g. 0 or 1
 	unsigned mem_addr; // Shared memory address (if used)
 } PWM_COMMS_TYP;
@@ -99,19 +192,30 @@ typedef struct PWM_PHASE_TAG // Structure containing string
 typedef struct PWM_EDGE_TAG
 {
 	PWM_PHASE_TYP phase_data[NUM_PWM_PHASES]; // Array of phase-data structures, one for each phase
+	signed first_off; // Earliest time-offset of this edge (used to check port deadline)
 } PWM_EDGE_TYP;
 
+// Structure containing ADC trigger data for single-shunt mode (see PWM_SINGLE_SHUNT)
+typedef struct PWM_SHUNT_TAG
+{
+	signed trig_offs[PWM_SHUNT_TRIGS]; // time-offset of each ADC trigger point
+	unsigned tokens[PWM_SHUNT_TRIGS]; // control token sent for each ADC trigger (see PWM_SHUNT_CT)
+	int valid; // Flag set if both measurement windows are wide enough
+} PWM_SHUNT_TYP;
+
 // Structure containing pwm output data for one buffer
 typedef struct PWM_BUFFER_TAG
 {
 	PWM_EDGE_TYP rise_edg; // data structure for rising edge of all pulses
 	PWM_EDGE_TYP fall_edg; // data structure for falling edge of all pulses
+	PWM_SHUNT_TYP shunt; // data structure for single-shunt ADC triggers
 } PWM_BUFFER_TYP;
 
 // Structure containing pwm output data for all buffers
 typedef struct PWM_ARRAY_TAG
 {
 	PWM_BUFFER_TYP buf_data[NUM_PWM_BUFS]; // Array of buffer-data structures, one for each buffer
+	unsigned miss_cnt; // No. of PWM periods where a port deadline was missed (Written by Server, read by Client)
 } PWM_ARRAY_TYP;
 
 #endif // _PWM_COMMON_H_
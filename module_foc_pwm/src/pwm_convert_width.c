@@ -14,6 +14,23 @@
 
 #include "pwm_convert_width.h"
 
+#if (PWM_PHASE_SHIFT)
+#define PWM_SHIFT_VAL PWM_SHIFT_CYCLES // Phase shift used in timing table
+#else // PWM_PHASE_SHIFT
+#define PWM_SHIFT_VAL 0 // Phase shift used in timing table
+#endif // else !PWM_PHASE_SHIFT
+
+// Builds timing values for PWM period of 2^n cycles. NB Evaluated at compile-time
+#define PWM_TIMING_VALS(n) { (n) ,(1 << (n)) ,(1 << ((n) - 1)) ,(1 << ((n) - 2)) \
+	,(((1 << (n)) + (NUMBER_OF_MOTORS >> 1)) / NUMBER_OF_MOTORS) ,PWM_SHIFT_VAL }
+
+/** Table of precomputed timing values, one entry for each selectable PWM period (see PWM_PERIOD_ENUM) */
+static const PWM_TIMING_TYP pwm_timing_tab[NUM_PWM_PERIODS] = {
+	PWM_TIMING_VALS(PWM_PERIOD_MIN_BITS) // PWM_PERIOD_2048
+	,PWM_TIMING_VALS(PWM_PERIOD_MIN_BITS + 1) // PWM_PERIOD_4096
+	,PWM_TIMING_VALS(PWM_PERIOD_MIN_BITS + 2) // PWM_PERIOD_8192
+};
+
 /******************************************************************************/
 unsigned long get_pwm_struct_address( // Converts PWM structure reference to address
 	PWM_ARRAY_TYP * pwm_ps // Pointer to PWM control structure
@@ -22,6 +39,17 @@ unsigned long get_pwm_struct_address( // Converts PWM structure reference to add
 	return (unsigned long)pwm_ps; // Return Address
 } // get_pwm_struct_address
 /*****************************************************************************/
+void init_pwm_timing( // Load precomputed timing values for selected PWM period
+	PWM_TIMING_TYP * timing_ps, // Pointer to structure containing timing values for selected PWM period
+	int period_sel // Selected PWM period (see PWM_PERIOD_ENUM)
+)
+{
+	assert(0 <= period_sel); // ERROR: Unknown PWM period
+	assert(NUM_PWM_PERIODS > period_sel); // ERROR: Unknown PWM period
+
+	*timing_ps = pwm_timing_tab[period_sel]; // Copy table entry
+} // init_pwm_timing
+/*****************************************************************************/
 static void convert_pulse_width( // convert pulse width to a 32-bit pattern and a time-offset
 	PWM_COMMS_TYP * pwm_comms_ps, // Pointer to structure containing PWM communication data
 	PWM_PORT_TYP * rise_port_data_ps, // Pointer to port data structure (for one leg of balanced line for rising edge )
@@ -60,7 +88,7 @@ static void convert_pulse_width( // convert pulse width to a 32-bit pattern and
 	} // if (inp_wid < PWM_PORT_WID)
 	else
 	{ // NOT a short pulse
-		num_zeros = PWM_MAX_VALUE - inp_wid; // Calculate No. of 0's in this pulse
+		num_zeros = pwm_comms_ps->timing.max_value - inp_wid; // Calculate No. of 0's in this pulse
 
 		// Check for mid-range pulse
 		if (num_zeros > (PWM_PORT_WID - 1))
@@ -79,13 +107,13 @@ static void convert_pulse_width( // convert pulse width to a 32-bit pattern and
 
 			// earlier edge ( zeros transmitted 1st)
 			// NB Need MSB to be 1, as this lasts for long high section of pulse
-			rise_port_data_ps->time_off = -(PWM_MAX_VALUE >> 1); // Fixed time-offset is half PWM-cycle earlier
+			rise_port_data_ps->time_off = -(signed)pwm_comms_ps->timing.half_max; // Fixed time-offset is half PWM-cycle earlier
 			tmp = (num_zeros >> 1); // Range [15..0]
 			tmp = ((1 << tmp)-1); // Range 0x0000_7FFF .. 0x0000_0000
 			rise_port_data_ps->pattern = ~tmp; // Invert Pattern: Range 0xFFFF_8000 .. 0xFFFF_FFFF
 
 			// later edge ( zeros transmitted last):
-			fall_port_data_ps->time_off = (PWM_MAX_VALUE >> 1) - PWM_PORT_WID; // Fixed time-offset is (half PWM-cycle - 32 bits) later
+			fall_port_data_ps->time_off = pwm_comms_ps->timing.half_max - PWM_PORT_WID; // Fixed time-offset is (half PWM-cycle - 32 bits) later
 			tmp = ((num_zeros + 1) >> 1); // Range [16..0]
 			tmp = ((1 << tmp)-1); // Range 0x0000_FFFF .. 0x0000_0000
 			tmp = ~tmp; // Invert Pattern: Range 0xFFFF_0000 .. 0xFFFF_FFFF
@@ -101,7 +129,8 @@ static void convert_phase_pulse_widths(  // Convert PWM pulse widths for current
 	PWM_COMMS_TYP * pwm_comms_ps, // Pointer to structure containing PWM communication data
 	PWM_PHASE_TYP * rise_phase_data_ps, // Pointer to PWM output data structure for rising edge of current phase
 	PWM_PHASE_TYP * fall_phase_data_ps, // Pointer to PWM output data structure for falling edge of current phase
-	unsigned hi_wid // PWM pulse-width value for Hi-leg
+	unsigned hi_wid, // PWM pulse-width value for Hi-leg
+	signed centre_off // time-offset of pulse centre for current phase (see PWM_PHASE_SHIFT)
 )
 	/* WARNING: Both legs of the balanced line must NOT be switched at the same time. Safety Critical.
 	 * Calculate PWM Pulse data for low leg (V+) of balanced line
@@ -114,7 +143,7 @@ static void convert_phase_pulse_widths(  // Convert PWM pulse widths for current
 	unsigned lo_wid = (hi_wid + PWM_DEAD_TIME); // PWM pulse-width value for Lo-leg
 
 
-	assert(lo_wid < PWM_MAX_VALUE); // Ensure Low-leg pulse NOT too wide
+	assert(lo_wid < pwm_comms_ps->timing.max_value); // Ensure Low-leg pulse NOT too wide
 
 	// Calculate PWM Pulse data for high leg (V+) of balanced line
 	convert_pulse_width( pwm_comms_ps ,&(rise_phase_data_ps->hi) ,&(fall_phase_data_ps->hi) ,hi_wid );
@@ -122,8 +151,121 @@ static void convert_phase_pulse_widths(  // Convert PWM pulse widths for current
 	// NB In do_pwm_period() (pwm_service_inv.xc) ADC Sync occurs at (ref_time + HALF_DEAD_TIME)
 
 	convert_pulse_width( pwm_comms_ps ,&(rise_phase_data_ps->lo) ,&(fall_phase_data_ps->lo) ,lo_wid );
+
+	// Move both legs to centre of this phase. NB Dead-time is preserved, as both legs move together
+	rise_phase_data_ps->hi.time_off += centre_off;
+	fall_phase_data_ps->hi.time_off += centre_off;
+	rise_phase_data_ps->lo.time_off += centre_off;
+	fall_phase_data_ps->lo.time_off += centre_off;
 } // convert_phase_pulse_widths
 /*****************************************************************************/
+static void find_first_offset( // Find earliest time-offset for one pulse edge (used by Server to check port deadline)
+	PWM_EDGE_TYP * edge_data_ps // Pointer to PWM output data structure for one edge of all phases
+)
+{
+	signed first_off = edge_data_ps->phase_data[0].hi.time_off; // Initialise to 1st time-offset
+
+
+	// Loop through PWM phases
+	for (int phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		if (edge_data_ps->phase_data[phase_cnt].hi.time_off < first_off)
+		{
+			first_off = edge_data_ps->phase_data[phase_cnt].hi.time_off;
+		} // if (edge_data_ps->phase_data[phase_cnt].hi.time_off < first_off)
+
+		if (edge_data_ps->phase_data[phase_cnt].lo.time_off < first_off)
+		{
+			first_off = edge_data_ps->phase_data[phase_cnt].lo.time_off;
+		} // if (edge_data_ps->phase_data[phase_cnt].lo.time_off < first_off)
+	} // for phase_cnt
+
+	edge_data_ps->first_off = first_off;
+} // find_first_offset
+/*****************************************************************************/
+static void find_shunt_triggers( // Find ADC trigger points inside single-shunt measurement windows
+	PWM_COMMS_TYP * pwm_comms_ps, // Pointer to structure containing PWM communication data
+	PWM_SHUNT_TYP * shunt_data_ps // Pointer to structure containing single-shunt trigger data
+)
+/* The phases are sorted by the time their Hi-leg switches on (i.e. the 1st one-bit, at -(width+1)/2 from the pulse centre).
+ * Window k runs from the Hi-leg switch-on of the k'th phase, to the Lo-leg switch-off of the (k+1)'th phase,
+ * or to the earlier Hi-leg switch-off (at width/2 from the pulse centre) of any phase already switched on.
+ * During window 0, the DC-link carries the current of the 1st phase, and during window 1, minus the current of the last phase.
+ * Each trigger is placed at the end of its window, to give the shunt signal the longest time to settle.
+ */
+{
+	signed on_offs[NUM_PWM_PHASES]; // Array of Hi-leg switch-on time-offsets
+	signed end_offs[NUM_PWM_PHASES]; // Array of Hi-leg switch-off time-offsets
+	signed off_offs[NUM_PWM_PHASES]; // Array of Lo-leg switch-off time-offsets
+	int order[NUM_PWM_PHASES]; // Array of phase identifiers, in order of Hi-leg switch-on
+	signed centre_off; // time-offset of pulse centre
+	signed on_end; // Earliest Hi-leg switch-off of phases already switched on
+	signed win_end; // time-offset of end of window
+	unsigned wid; // PWM pulse-width value for Hi-leg
+	int phase_cnt; // phase counter
+	int samp_cnt; // sample counter
+	int tmp_id; // Temporary phase identifier
+
+
+	// Loop through PWM phases
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		centre_off = (phase_cnt - PWM_PHASE_B) * pwm_comms_ps->timing.shift;
+		wid = pwm_comms_ps->params.widths[phase_cnt];
+
+		on_offs[phase_cnt] = centre_off - (signed)((wid + 1) >> 1);
+		end_offs[phase_cnt] = centre_off + (signed)(wid >> 1);
+		off_offs[phase_cnt] = centre_off - (signed)((wid + PWM_DEAD_TIME + 1) >> 1);
+		order[phase_cnt] = phase_cnt;
+	} // for phase_cnt
+
+	// Sort 3 phases by switch-on time (NB Stable, so equal times keep phase order)
+	for (phase_cnt = 1; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		for (samp_cnt = phase_cnt; (0 < samp_cnt) && (on_offs[order[samp_cnt - 1]] > on_offs[order[samp_cnt]]); samp_cnt--)
+		{
+			tmp_id = order[samp_cnt];
+			order[samp_cnt] = order[samp_cnt - 1];
+			order[samp_cnt - 1] = tmp_id;
+		} // for samp_cnt
+	} // for phase_cnt
+
+	shunt_data_ps->valid = 1; // Preset flag to valid
+	on_end = end_offs[order[0]];
+
+	// Loop through samples
+	for (samp_cnt = 0; samp_cnt < PWM_SHUNT_TRIGS; samp_cnt++)
+	{
+		if (end_offs[order[samp_cnt]] < on_end)
+		{
+			on_end = end_offs[order[samp_cnt]];
+		} // if (end_offs[order[samp_cnt]] < on_end)
+
+		win_end = off_offs[order[samp_cnt + 1]];
+
+		if (on_end < win_end)
+		{
+			win_end = on_end;
+		} // if (on_end < win_end)
+
+		if (PWM_SHUNT_MIN_WIN > (win_end - on_offs[order[samp_cnt]]))
+		{
+			shunt_data_ps->valid = 0; // Window too short
+		} // if (PWM_SHUNT_MIN_WIN > (win_end - on_offs[order[samp_cnt]]))
+
+		shunt_data_ps->trig_offs[samp_cnt] = win_end - PWM_SHUNT_GUARD;
+	} // for samp_cnt
+
+	// Check ADC has time to convert 1st sample
+	if (PWM_SHUNT_MIN_GAP > (shunt_data_ps->trig_offs[1] - shunt_data_ps->trig_offs[0]))
+	{
+		shunt_data_ps->valid = 0;
+	} // if (PWM_SHUNT_MIN_GAP > ...
+
+	shunt_data_ps->tokens[0] = PWM_SHUNT_CT( 0 ,order[0] ); // +ve current of 1st phase
+	shunt_data_ps->tokens[1] = PWM_SHUNT_CT( 1 ,order[NUM_PWM_PHASES - 1] ); // -ve current of last phase
+} // find_shunt_triggers
+/*****************************************************************************/
 void convert_all_pulse_widths( // Convert all PWM pulse widths to pattern/time_offset port data
 	PWM_COMMS_TYP * pwm_comms_ps, // Pointer to structure containing PWM communication data
 	PWM_BUFFER_TYP * pwm_buf_ps // Pointer to Structure containing buffered PWM output data
@@ -131,22 +273,88 @@ void convert_all_pulse_widths( // Convert all PWM pulse widths to pattern/time_o
 {
 	// Loop through PWM phases
 	for (int phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
-	{ // Convert PWM pulse widths for this phase to pattern/time_offset port data
+	{ // Convert PWM pulse widths for this phase to pattern/time_offset port data. NB Phase_B stays centred
 
 		convert_phase_pulse_widths( pwm_comms_ps ,&(pwm_buf_ps->rise_edg.phase_data[phase_cnt])
-			,&(pwm_buf_ps->fall_edg.phase_data[phase_cnt]) ,pwm_comms_ps->params.widths[phase_cnt] );
+			,&(pwm_buf_ps->fall_edg.phase_data[phase_cnt]) ,pwm_comms_ps->params.widths[phase_cnt]
+			,((phase_cnt - PWM_PHASE_B) * pwm_comms_ps->timing.shift) );
 	} // for phase_cnt
+
+	find_first_offset( &(pwm_buf_ps->rise_edg) );
+	find_first_offset( &(pwm_buf_ps->fall_edg) );
+
+	if (PWM_SINGLE_SHUNT)
+	{
+		find_shunt_triggers( pwm_comms_ps ,&(pwm_buf_ps->shunt) );
+	} // if (PWM_SINGLE_SHUNT)
 } // convert_all_pulse_widths
 /*****************************************************************************/
 void convert_widths_in_shared_mem( // Converts PWM Pulse-width to port data in shared memory area
 	PWM_COMMS_TYP * pwm_comms_ps // Pointer to structure containing PWM communication data
 )
-{	// Cast shared memory address pointer to PWM double-buffered data structure
-	PWM_ARRAY_TYP * pwm_ctrl_ps = (PWM_ARRAY_TYP *)pwm_comms_ps->mem_addr;
+{	// Cast shared memory address pointer to PWM double-buffered data structure. NB Via unsigned long, so host builds (64-bit pointers) compile cleanly
+	PWM_ARRAY_TYP * pwm_ctrl_ps = (PWM_ARRAY_TYP *)(unsigned long)pwm_comms_ps->mem_addr;
 
 	// Convert widths and write to current PWM buffer
 	convert_all_pulse_widths( pwm_comms_ps ,&(pwm_ctrl_ps->buf_data[pwm_comms_ps->buf]) );
 
 } // convert_widths_in_shared_mem
 /*****************************************************************************/
+unsigned get_pwm_miss_count( // Returns No. of PWM periods where Server missed a port deadline
+	PWM_COMMS_TYP * pwm_comms_ps // Pointer to structure containing PWM communication data
+)
+{	// Cast shared memory address pointer to PWM double-buffered data structure. NB Address is always sent by Server
+	volatile PWM_ARRAY_TYP * pwm_ctrl_ps = (volatile PWM_ARRAY_TYP *)(unsigned long)pwm_comms_ps->mem_addr;
+
+
+	return pwm_ctrl_ps->miss_cnt; // NB Written by PWM Server
+} // get_pwm_miss_count
+/*****************************************************************************/
+static int get_dead_time_correction( // Returns pulse-width correction for one phase current
+	int inp_curr, // Phase current (+ve flows into motor)
+	int curr_band // Current at which full correction is applied
+) // Returns correction in range [-PWM_DEAD_TIME .. 0]
+{
+	// Check for large positive current
+	if (curr_band <= inp_curr)
+	{
+		return 0; // Effective width already equals Hi-leg width
+	} // if (curr_band <= inp_curr)
+
+	// Check for large negative current
+	if (inp_curr <= -curr_band)
+	{
+		return -PWM_DEAD_TIME; // Remove whole dead-time gained from freewheeling current
+	} // if (inp_curr <= -curr_band)
+
+	// Smooth transition through zero current. NB Half correction at zero current
+	return (((inp_curr - curr_band) * PWM_DEAD_TIME) / (curr_band << 1));
+} // get_dead_time_correction
+/*****************************************************************************/
+void compensate_dead_time( // Corrects all PWM pulse widths for dead-time distortion
+	PWM_COMMS_TYP * pwm_comms_ps, // Pointer to structure containing PWM communication data
+	int phase_currs[], // Array of phase currents (+ve flows into motor)
+	int curr_band // Current at which full correction is applied
+)
+{
+	int new_wid; // Corrected pulse-width
+
+
+	assert(0 < curr_band); // Ensure transition band is valid
+
+	// Loop through PWM phases
+	for (int phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		new_wid = (int)pwm_comms_ps->params.widths[phase_cnt] + get_dead_time_correction( phase_currs[phase_cnt] ,curr_band );
+
+		// Clip to valid range
+		if (new_wid < 0)
+		{
+			new_wid = 0;
+		} // if (new_wid < 0)
+
+		pwm_comms_ps->params.widths[phase_cnt] = (unsigned)new_wid;
+	} // for phase_cnt
+} // compensate_dead_time
+/*****************************************************************************/
 // pwm_cli_common.c
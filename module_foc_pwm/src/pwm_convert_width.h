@@ -23,12 +23,25 @@
 #include "pwm_common.h"
 #include "pwm_client.h"
 
+#ifndef NUMBER_OF_MOTORS
+	#error Define. NUMBER_OF_MOTORS in app_global.h
+#endif // NUMBER_OF_MOTORS
+
 #ifndef PWM_DEAD_TIME
 	#error Define. PWM_DEAD_TIME in app_global.h
 #endif // PWM_DEAD_TIME
 
 #define HALF_DEAD_TIME (PWM_DEAD_TIME >> 1) // Used for rounding
 
+/* Dead-time compensation.
+ * During the dead-time both legs are off, and the phase voltage is set by the direction of the phase current:
+ *	Positive current (flowing out of the PWM phase into the motor) freewheels through the low-side diode, so the phase is low.
+ *	Negative current (flowing from the motor into the PWM phase) freewheels through the high-side diode, so the phase is high.
+ * Therefore the effective (average) pulse-width is the Hi-leg width for positive current, and (Hi-leg width + PWM_DEAD_TIME) for negative current.
+ * The compensation reduces the Hi-leg width by PWM_DEAD_TIME for negative current.
+ * Near zero current the sign is uncertain, so inside a band of +/- curr_band the correction changes linearly with current.
+ */
+
 /******************************************************************************/
 /** Converts PWM structure reference to address.
  * \param pwm_ps // Pointer to PWM control structure
@@ -38,6 +51,15 @@ unsigned long get_pwm_struct_address( // Converts PWM structure reference to add
 	REFERENCE_PARAM( PWM_ARRAY_TYP ,pwm_ps ) // Pointer to PWM structure containing array of buffers
 ); // Return address
 /*****************************************************************************/
+/** Load precomputed timing values for selected PWM period
+ * \param timing_ps // Pointer to structure containing timing values for selected PWM period
+ * \param period_sel // Selected PWM period (see PWM_PERIOD_ENUM)
+ */
+void init_pwm_timing( // Load precomputed timing values for selected PWM period
+	REFERENCE_PARAM( PWM_TIMING_TYP ,timing_ps ), // Pointer to structure containing timing values for selected PWM period
+	int period_sel // Selected PWM period (see PWM_PERIOD_ENUM)
+);
+/*****************************************************************************/
 void convert_all_pulse_widths( // Convert all PWM pulse widths to pattern/time_offset port data
 	REFERENCE_PARAM( PWM_COMMS_TYP ,pwm_comms_ps), // Pointer to structure containing PWM communication data
 	REFERENCE_PARAM( PWM_BUFFER_TYP ,pwm_buf_ps) // Pointer to Structure containing buffered PWM output data
@@ -47,5 +69,24 @@ void convert_widths_in_shared_mem( // Converts PWM Pulse-width to port data in s
 	REFERENCE_PARAM( PWM_COMMS_TYP ,pwm_comms_ps) // Pointer to structure containing PWM communication data
 );
 /*****************************************************************************/
+/** Returns No. of PWM periods where Server missed a port deadline (read from Server data structure)
+ * \param pwm_comms_ps // Pointer to structure containing PWM communication data
+ * \return Miss count
+ */
+unsigned get_pwm_miss_count( // Returns No. of PWM periods where Server missed a port deadline
+	REFERENCE_PARAM( PWM_COMMS_TYP ,pwm_comms_ps ) // Pointer to structure containing PWM communication data
+);
+/*****************************************************************************/
+/** Corrects all PWM pulse widths for dead-time distortion, using the phase currents
+ * \param pwm_comms_ps // Pointer to structure containing PWM communication data
+ * \param phase_currs // Array of phase currents (+ve flows into motor). NB Only the sign (and size relative to curr_band) is used
+ * \param curr_band // Current at which full correction is applied (Must be +ve)
+ */
+void compensate_dead_time( // Corrects all PWM pulse widths for dead-time distortion
+	REFERENCE_PARAM( PWM_COMMS_TYP ,pwm_comms_ps ), // Pointer to structure containing PWM communication data
+	int phase_currs[], // Array of phase currents (+ve flows into motor)
+	int curr_band // Current at which full correction is applied
+);
+/*****************************************************************************/
 
 #endif /* _PWM_CLI_COMMON__H_ */
@@ -0,0 +1,61 @@
+/*
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ *
+ **/
+
+#ifndef _PWM_MULTI_SERVER_H_
+#define _PWM_MULTI_SERVER_H_
+
+#include <xs1.h>
+#include <assert.h>
+#include <print.h>
+
+#include "app_global.h"
+#include "pwm_common.h"
+#include "pwm_convert_width.h"
+#include "pwm_schedule.h"
+#include "pwm_server.h"
+
+/* Multi-motor PWM Server (selected by PWM_MULTI_SERVER in app_global.h).
+ * One logical core drives the PWM ports of all motors, instead of one foc_pwm_do_triggered() core per motor.
+ * The Client side is unchanged (see pwm_client.xc).
+ *
+ * A single-motor Server spends most of each period blocked in timed port loads and the ADC trigger wait.
+ * Here, each motor's port data is expanded into an edge schedule (see pwm_schedule.h),
+ * and the schedules of all motors are merged, so the core only waits for the next event of any motor.
+ * The motor periods are staggered by a quarter period (for 2 motors), so most events of different motors do NOT coincide.
+ * The ADC trigger is timed with the timer, rather than a blocking wait on the dummy p16_adc_sync port.
+ * So this Server can also send the 2 triggers per period needed in single-shunt mode (see PWM_SINGLE_SHUNT in pwm_common.h).
+ *
+ * Each event is checked against its deadline. A miss only switches off the legs of the motor concerned (see foc_pwm_get_miss_count()).
+ * WARNING: Two motors at the shortest PWM period (2048 cycles) miss deadlines, as the rebuilds do NOT fit between the edges.
+ * Periods of 4096 cycles or more (same or different for each motor) are checked by a host model (see src.dir/pwm_merge_model.c)
+ */
+
+/*****************************************************************************/
+/** \brief Implementation of the Centre-aligned, High-Low pair, PWM server for all motors, with ADC synchronization
+ *
+ *  \param c_pwm array of PWM channels between Clients and Server (one per motor)
+ *  \param p32_pwm_hi the array of PWM ports (HI side) for all motors
+ *  \param p32_pwm_lo the array of PWM ports (LO side) for all motors
+ *  \param c_adc_trig the array of control channels for triggering the ADC (one per motor)
+ */
+void foc_pwm_do_triggered_multi( // Implementation of the Centre-aligned, High-Low pair, PWM server for all motors
+	chanend c_pwm[NUMBER_OF_MOTORS], // Array of PWM channels between Clients and Server
+	buffered out port:32 p32_pwm_hi[NUMBER_OF_MOTORS][NUM_PWM_PHASES], // array of PWM ports (High side)
+	buffered out port:32 p32_pwm_lo[NUMBER_OF_MOTORS][NUM_PWM_PHASES], // array of PWM ports (Low side)
+	chanend c_adc_trig[NUMBER_OF_MOTORS] // Array of ADC trigger channels
+);
+/*****************************************************************************/
+
+#endif // _PWM_MULTI_SERVER_H_
@@ -0,0 +1,354 @@
+/*
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "pwm_schedule.h"
+
+/*****************************************************************************/
+void init_pwm_schedule( // Clear edge schedule, and mark all ports of one motor as free
+	PWM_SCHED_TYP * sched_ps, // Pointer to structure containing edge schedule for one motor
+	unsigned free_time // Port time from which all ports are free
+)
+{
+	int port_cnt; // port counter
+
+
+	for (port_cnt = 0; port_cnt < NUM_PWM_PORTS; port_cnt++)
+	{
+		sched_ps->port_time[port_cnt] = free_time;
+	} // for port_cnt
+
+	sched_ps->num_events = 0;
+	sched_ps->next = 0;
+	sched_ps->accept_data = 1;
+} // init_pwm_schedule
+/*****************************************************************************/
+static void add_pwm_event( // Append one event to edge schedule
+	PWM_SCHED_TYP * sched_ps, // Pointer to structure containing edge schedule for one motor
+	unsigned ready, // Port time from which event can be issued
+	unsigned time, // Port time of event
+	unsigned pattern, // Bit-pattern written to port
+	int port_id // Port identifier, or PWM_EVENT_ADC
+)
+{
+	PWM_EVENT_TYP * event_ps = &(sched_ps->events[sched_ps->num_events]); // Pointer to new event
+
+
+	assert(PWM_SCHED_LEN > sched_ps->num_events); // ERROR: Edge schedule overflow
+
+	event_ps->ready = ready;
+	event_ps->time = time;
+	event_ps->pattern = pattern;
+	event_ps->port_id = port_id;
+
+	sched_ps->num_events++;
+} // add_pwm_event
+/*****************************************************************************/
+static void add_port_event( // Append one timed port load to edge schedule
+	PWM_SCHED_TYP * sched_ps, // Pointer to structure containing edge schedule for one motor
+	PWM_PORT_TYP * port_data_ps, // Pointer to port data structure (for one leg of one edge)
+	unsigned ref_time, // Reference time (centre) of PWM period
+	int port_id // Port identifier
+)
+{
+	unsigned time = ref_time + port_data_ps->time_off; // Absolute port time of edge
+
+
+	// NB Load can NOT start until previous load on this port has started
+	add_pwm_event( sched_ps ,(sched_ps->port_time[port_id] - PWM_READY_LEAD) ,time ,port_data_ps->pattern ,port_id );
+
+	sched_ps->port_time[port_id] = time;
+} // add_port_event
+/*****************************************************************************/
+static void add_edge_events( // Append timed port loads for one edge of all phases to edge schedule
+	PWM_SCHED_TYP * sched_ps, // Pointer to structure containing edge schedule for one motor
+	PWM_EDGE_TYP * edge_data_ps, // Pointer to PWM output data structure for one edge of all phases
+	unsigned ref_time // Reference time (centre) of PWM period
+)
+{
+	int phase_cnt; // phase counter
+
+
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		add_port_event( sched_ps ,&(edge_data_ps->phase_data[phase_cnt].hi) ,ref_time ,PWM_PORT_ID( PWM_HI_LEG ,phase_cnt ) );
+		add_port_event( sched_ps ,&(edge_data_ps->phase_data[phase_cnt].lo) ,ref_time ,PWM_PORT_ID( PWM_LO_LEG ,phase_cnt ) );
+	} // for phase_cnt
+} // add_edge_events
+/*****************************************************************************/
+static int pwm_event_later( // Check if one event is issued after another in edge schedule
+	PWM_EVENT_TYP * a_event_ps, // Pointer to 1st event
+	PWM_EVENT_TYP * b_event_ps // Pointer to 2nd event
+) // Returns 1 if 1st event is later
+/* Events are issued in order of ready time, then event time.
+ * NB Ordering on event time alone, would hold a load whose port is already free behind the ADC trigger wait
+ */
+{
+	int diff = (int)(a_event_ps->ready - b_event_ps->ready); // Difference of ready times
+
+
+	if (0 == diff)
+	{
+		diff = (int)(a_event_ps->time - b_event_ps->time);
+	} // if (0 == diff)
+
+	return (0 < diff);
+} // pwm_event_later
+/*****************************************************************************/
+static void sort_pwm_events( // Sort events into issue order
+	PWM_SCHED_TYP * sched_ps // Pointer to structure containing edge schedule for one motor
+)
+/* Insertion sort: only 14 (or 15) new events, appended to events already in order, and rising and falling edges are grouped.
+ * NB Times are compared as signed differences, so the sort is safe when the port time wraps
+ */
+{
+	PWM_EVENT_TYP tmp_event; // Event being inserted
+	int new_cnt; // Index of event being inserted
+	int old_cnt; // Index of sorted event
+
+
+	for (new_cnt = 1; new_cnt < sched_ps->num_events; new_cnt++)
+	{
+		tmp_event = sched_ps->events[new_cnt];
+		old_cnt = new_cnt;
+
+		// Shift later events up one place
+		while ((0 < old_cnt) && pwm_event_later( &(sched_ps->events[old_cnt - 1]) ,&tmp_event ))
+		{
+			sched_ps->events[old_cnt] = sched_ps->events[old_cnt - 1];
+			old_cnt--;
+		} // while ((0 < old_cnt) && ...
+
+		sched_ps->events[old_cnt] = tmp_event;
+	} // for new_cnt
+} // sort_pwm_events
+/*****************************************************************************/
+void build_pwm_schedule( // Build ordered edge schedule for next PWM period, and merge it with events NOT yet issued
+	PWM_SCHED_TYP * sched_ps, // Pointer to structure containing edge schedule for one motor
+	PWM_BUFFER_TYP * pwm_buf_ps, // Pointer to structure containing buffered PWM output data
+	unsigned ref_time, // Reference time (centre) of PWM period
+	PWM_TIMING_TYP * timing_ps, // Pointer to structure containing timing values for selected PWM period
+	int use_adc // Flag set if ADC trigger is scheduled
+)
+{
+	unsigned adc_time = ref_time - timing_ps->quart_max; // NB ADC trigger is sent 1/4 of a PWM period early
+	int old_cnt = sched_ps->num_events - sched_ps->next; // No. of events of current period NOT yet issued
+	int event_cnt; // event counter
+	int trig_cnt; // ADC trigger counter
+
+
+	// Keep events of current period NOT yet issued. NB Each new load is ready only once the current load on its port has started
+	for (event_cnt = 0; event_cnt < old_cnt; event_cnt++)
+	{
+		sched_ps->events[event_cnt] = sched_ps->events[sched_ps->next + event_cnt];
+	} // for event_cnt
+
+	sched_ps->num_events = old_cnt;
+	sched_ps->next = 0;
+	sched_ps->accept_data = 1; // Previous data now used, so Client can send data for next period
+
+	// NB Rising edges first, so each falling edge waits for the rising edge on the same port
+	add_edge_events( sched_ps ,&(pwm_buf_ps->rise_edg) ,ref_time );
+	add_edge_events( sched_ps ,&(pwm_buf_ps->fall_edg) ,ref_time );
+
+	if (use_adc)
+	{ // NB NOT a port load, so ready as soon as it is due
+		if (PWM_SINGLE_SHUNT)
+		{ // NB If a window is too short, NO triggers are sent, and the ADC holds its previous values
+			if (pwm_buf_ps->shunt.valid)
+			{
+				for (trig_cnt = 0; trig_cnt < PWM_SHUNT_TRIGS; trig_cnt++)
+				{
+					add_pwm_event( sched_ps ,(adc_time + pwm_buf_ps->shunt.trig_offs[trig_cnt])
+						,(adc_time + pwm_buf_ps->shunt.trig_offs[trig_cnt]) ,pwm_buf_ps->shunt.tokens[trig_cnt] ,PWM_EVENT_ADC );
+				} // for trig_cnt
+			} // if (pwm_buf_ps->shunt.valid)
+		} // if (PWM_SINGLE_SHUNT)
+		else
+		{
+			add_pwm_event( sched_ps ,adc_time ,adc_time ,0 ,PWM_EVENT_ADC );
+		} // else !(PWM_SINGLE_SHUNT)
+	} // if (use_adc)
+
+	/* Rebuild is ready at the start of this period (half a period before this reference time). It must finish before the earliest edge
+	 * of the next period, which is at least half a period (less the phase shift of Phase_A) after this reference time
+	 */
+	add_pwm_event( sched_ps ,(ref_time - timing_ps->half_max)
+		,(ref_time + timing_ps->half_max - timing_ps->shift - PWM_BUILD_CYCLES) ,0 ,PWM_EVENT_BUILD );
+
+	sort_pwm_events( sched_ps );
+} // build_pwm_schedule
+/*****************************************************************************/
+static int pwm_event_first( // Check if one event should be issued before another
+	PWM_EVENT_TYP * a_event_ps, // Pointer to 1st event
+	PWM_EVENT_TYP * b_event_ps, // Pointer to 2nd event
+	unsigned cur_time // Current port time
+) // Returns 1 if 1st event should be issued first
+{
+	int a_wait = (int)(a_event_ps->ready - cur_time); // Cycles until 1st event ready (-ve if already ready)
+	int b_wait = (int)(b_event_ps->ready - cur_time); // Cycles until 2nd event ready (-ve if already ready)
+
+
+	if ((PWM_READY_WINDOW >= a_wait) && (PWM_READY_WINDOW >= b_wait))
+	{ // Both ready (or nearly): Earliest deadline first
+		return (0 > (int)(a_event_ps->time - b_event_ps->time));
+	} // if ((PWM_READY_WINDOW >= a_wait) && (PWM_READY_WINDOW >= b_wait))
+
+	return (a_wait < b_wait);
+} // pwm_event_first
+/*****************************************************************************/
+static int pwm_events_clear( // Check that NO event (excluding rebuilds) of any running motor is due within a number of cycles
+	PWM_SCHED_TYP sched_arr[], // Array of edge schedules, one for each motor
+	int num_mots, // No. of motors
+	unsigned start_time, // Port time from which events are checked
+	int num_cycles // No. of cycles checked
+) // Returns 1 if NO event due
+{
+	PWM_SCHED_TYP * sched_ps; // Pointer to edge schedule of current motor
+	int mot_cnt; // motor counter
+	int event_cnt; // event counter
+
+
+	// NB Events are sorted by ready time, NOT deadline, so all remaining events are checked
+	for (mot_cnt = 0; mot_cnt < num_mots; mot_cnt++)
+	{
+		sched_ps = &(sched_arr[mot_cnt]);
+
+		if (PWM_SCHED_RUN == sched_ps->state)
+		{
+			for (event_cnt = sched_ps->next; event_cnt < sched_ps->num_events; event_cnt++)
+			{
+				if ((PWM_EVENT_BUILD != sched_ps->events[event_cnt].port_id)
+					&& (num_cycles > (int)(sched_ps->events[event_cnt].time - start_time)))
+				{
+					return 0; // Event would be delayed
+				} // if ((PWM_EVENT_BUILD != sched_ps->events[event_cnt].port_id) && ...
+			} // for event_cnt
+		} // if (PWM_SCHED_RUN == sched_ps->state)
+	} // for mot_cnt
+
+	return 1;
+} // pwm_events_clear
+/*****************************************************************************/
+int next_pwm_event_motor( // Merge edge schedules of all motors: Find motor whose next event should be issued first
+	PWM_SCHED_TYP sched_arr[], // Array of edge schedules, one for each motor
+	int num_mots, // No. of motors
+	unsigned cur_time // Current port time
+) // Returns Motor identifier, or -1 if NO motor is running
+/* Loads of one motor that are ready at nearly the same time are NOT in deadline order (e.g. rising edges of different phases),
+ * so all ready events of each motor are searched. The chosen event is moved to events[next], so the Server always issues events[next].
+ * NB A deferred rebuild does NOT hold up the later events of its own motor
+ */
+{
+	PWM_SCHED_TYP * sched_ps; // Pointer to edge schedule of current motor
+	PWM_EVENT_TYP * event_ps; // Pointer to current event
+	PWM_EVENT_TYP tmp_event; // Event being moved
+	unsigned build_time; // Port time when earliest rebuild can start
+	int mot_event; // Index of earliest event (excluding rebuild) of current motor
+	int best_event = 0; // Index of earliest event (excluding rebuilds)
+	int best_id = -1; // Motor with earliest event (excluding rebuilds)
+	int build_event = 0; // Index of earliest rebuild
+	int build_id = -1; // Motor with earliest rebuild
+	int event_cnt; // event counter
+	int mot_cnt; // motor counter
+
+
+	for (mot_cnt = 0; mot_cnt < num_mots; mot_cnt++)
+	{
+		sched_ps = &(sched_arr[mot_cnt]);
+
+		if (PWM_SCHED_RUN == sched_ps->state)
+		{
+			mot_event = -1;
+
+			for (event_cnt = sched_ps->next; event_cnt < sched_ps->num_events; event_cnt++)
+			{
+				event_ps = &(sched_ps->events[event_cnt]);
+
+				if (PWM_EVENT_BUILD == event_ps->port_id)
+				{
+					if ((0 > build_id) || (0 > (int)(event_ps->time - sched_arr[build_id].events[build_event].time)))
+					{
+						build_id = mot_cnt;
+						build_event = event_cnt;
+					} // if ((0 > build_id) || ...
+				} // if (PWM_EVENT_BUILD == event_ps->port_id)
+				else
+				{
+					if (PWM_READY_WINDOW >= (int)(event_ps->ready - cur_time))
+					{ // Ready (or nearly): Earliest deadline first
+						if ((0 > mot_event) || (0 > (int)(event_ps->time - sched_ps->events[mot_event].time)))
+						{
+							mot_event = event_cnt;
+						} // if ((0 > mot_event) || ...
+					} // if (PWM_READY_WINDOW >= (int)(event_ps->ready - cur_time))
+					else
+					{ // NB Events are in order of ready time, so NO later event is ready
+						if (0 > mot_event)
+						{
+							mot_event = event_cnt;
+						} // if (0 > mot_event)
+
+						break;
+					} // else !(PWM_READY_WINDOW >= (int)(event_ps->ready - cur_time))
+				} // else !(PWM_EVENT_BUILD == event_ps->port_id)
+			} // for event_cnt
+
+			if ((0 <= mot_event) && ((0 > best_id)
+				|| pwm_event_first( &(sched_ps->events[mot_event]) ,&(sched_arr[best_id].events[best_event]) ,cur_time )))
+			{
+				best_id = mot_cnt;
+				best_event = mot_event;
+			} // if ((0 <= mot_event) && ...
+		} // if (PWM_SCHED_RUN == sched_ps->state)
+	} // for mot_cnt
+
+	/* Check for rebuild. It is chosen if overdue, or NO other event is due within PWM_BUILD_CYCLES.
+	 * NB If NOT yet ready, it is checked at its ready time, and an event ready earlier goes first
+	 */
+	if (0 <= build_id)
+	{
+		event_ps = &(sched_arr[build_id].events[build_event]);
+		build_time = event_ps->ready;
+
+		if (0 > (int)(build_time - cur_time))
+		{
+			build_time = cur_time;
+		} // if (0 > (int)(build_time - cur_time))
+
+		if ((0 > best_id) || (((0 <= (int)(sched_arr[best_id].events[best_event].ready - build_time)) || (build_time == cur_time))
+			&& ((0 >= (int)(event_ps->time - build_time)) || pwm_events_clear( sched_arr ,num_mots ,build_time ,PWM_BUILD_CYCLES ))))
+		{
+			best_id = build_id;
+			best_event = build_event;
+		} // if ((0 > best_id) || ...
+	} // if (0 <= build_id)
+
+	// Move chosen event to front of its schedule. NB Order of other events is kept
+	if (0 <= best_id)
+	{
+		sched_ps = &(sched_arr[best_id]);
+		tmp_event = sched_ps->events[best_event];
+
+		for (event_cnt = best_event; event_cnt > sched_ps->next; event_cnt--)
+		{
+			sched_ps->events[event_cnt] = sched_ps->events[event_cnt - 1];
+		} // for event_cnt
+
+		sched_ps->events[sched_ps->next] = tmp_event;
+	} // if (0 <= best_id)
+
+	return best_id;
+} // next_pwm_event_motor
+/*****************************************************************************/
+// pwm_schedule.c
@@ -0,0 +1,125 @@
+/*
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _PWM_SCHEDULE_H_
+#define _PWM_SCHEDULE_H_
+
+#include <assert.h>
+#include <xccompat.h>
+
+#include "pwm_common.h"
+
+/* Edge schedule for the Multi-motor PWM Server (see pwm_multi_server.xc).
+ * Every PWM period, the precomputed port data for one motor (PWM_BUFFER_TYP) is expanded into a list of events,
+ * (a timed load for the rising and falling edge of each port, plus the ADC trigger), with absolute port times.
+ * In single-shunt mode (see PWM_SINGLE_SHUNT) there are 2 ADC triggers, each inside one measurement window.
+ * A timed load waits (blocks) until the previous load on the same port has started. A blocked Server would hold up
+ * the other motors, so each load has a 'ready' time, which is only PWM_READY_LEAD cycles before its port is free.
+ *
+ * Each list is sorted by ready time. The Server merges the lists of all motors into one time-ordered sequence,
+ * by always issuing the ready event with the earliest deadline (see next_pwm_event_motor()).
+ * One event of each list builds the events of the next period, and appends them to the events of this period NOT yet issued.
+ * It is ready at the start of this period, so has most of a period to find a gap between the edges of the other motors.
+ * A rebuild takes much longer than a load, so it is deferred until NO other event is due within PWM_BUILD_CYCLES,
+ * or its own deadline is reached.
+ * Client data is used by the next rebuild, so the Server accepts at most one data set per rebuild (see accept_data).
+ *
+ * NB This file is independent of XMOS hardware, so can also be compiled in a host test (see src.dir)
+ */
+
+#define NUM_PWM_PORTS (NUM_PWM_LEGS * NUM_PWM_PHASES) // No. of PWM ports per motor
+#define NUM_PWM_EVENTS ((NUM_PWM_PORTS << 1) + PWM_SHUNT_TRIGS + 1) // No. of events per PWM period (2 edges per port, ADC triggers, and rebuild)
+#define PWM_SCHED_LEN (NUM_PWM_EVENTS << 1) // Max. No. of events in edge schedule (rest of current period, plus next period)
+#define PWM_READY_LEAD (PWM_PORT_WID >> 1) // Load may be issued this early (NB Max. time the Server blocks on a port)
+#define PWM_READY_WINDOW PWM_PORT_WID // Events ready within this many cycles of each other are issued earliest deadline first
+#define PWM_EVENT_MARGIN 8 // Min. No. of cycles required to check the deadline and load one edge
+#define PWM_BUILD_CYCLES 768 // Allowance for converting new widths and building the next schedule (Conversion is max. 178 cycles)
+
+#define PWM_EVENT_ADC (-1) // Port identifier used for ADC trigger event
+#define PWM_EVENT_BUILD (-2) // Port identifier used for event that builds schedule for next PWM period
+
+#define PWM_PORT_ID(leg ,phase) (((leg) * NUM_PWM_PHASES) + (phase)) // Port identifier for one leg of one phase
+
+/** Different states of one motor in the Multi-motor PWM Server */
+typedef enum PWM_SCHED_STATE_ETAG
+{
+  PWM_SCHED_PERIOD = 0,	// Waiting for PWM period selection
+  PWM_SCHED_DATA,				// Waiting for 1st data at selected period
+  PWM_SCHED_RUN,				// Issuing events
+  PWM_SCHED_STOP,				// Stopped by Client
+  NUM_PWM_SCHED_STATES	// Handy Value!-)
+} PWM_SCHED_STATE_ENUM;
+
+/** Structure containing data for one scheduled event */
+typedef struct PWM_EVENT_TAG
+{
+	unsigned ready; // Port time from which event can be issued
+	unsigned time; // Port time of event (NB For a load, this is the deadline)
+	unsigned pattern; // Bit-pattern written to port (or control token for single-shunt ADC trigger)
+	int port_id; // Port identifier (see PWM_PORT_ID), or PWM_EVENT_ADC, or PWM_EVENT_BUILD
+} PWM_EVENT_TYP;
+
+/** Structure containing edge schedule for one motor */
+typedef struct PWM_SCHED_TAG
+{
+	PWM_EVENT_TYP events[PWM_SCHED_LEN]; // Array of events NOT yet issued, in order of ready time
+	unsigned port_time[NUM_PWM_PORTS]; // Time of latest load on each port (NB Next load on port can NOT start earlier)
+	int num_events; // No. of events in edge schedule
+	int next; // Index of next event to issue
+	int accept_data; // Flag set while Client data for the next PWM period can be accepted (Cleared on receipt, set by rebuild)
+	PWM_SCHED_STATE_ENUM state; // Motor state
+} PWM_SCHED_TYP;
+
+/*****************************************************************************/
+/** Clear edge schedule, and mark all ports of one motor as free. NB Client data can be accepted
+ * \param sched_ps // Pointer to structure containing edge schedule for one motor
+ * \param free_time // Port time from which all ports are free
+ */
+void init_pwm_schedule( // Clear edge schedule, and mark all ports of one motor as free
+	REFERENCE_PARAM( PWM_SCHED_TYP ,sched_ps ), // Pointer to structure containing edge schedule for one motor
+	unsigned free_time // Port time from which all ports are free
+);
+/*****************************************************************************/
+/** Build ordered edge schedule for next PWM period, from precomputed port data, and merge it with events NOT yet issued.
+ * NB Client data can be accepted again
+ * \param sched_ps // Pointer to structure containing edge schedule for one motor
+ * \param pwm_buf_ps // Pointer to structure containing buffered PWM output data
+ * \param ref_time // Reference time (centre) of PWM period
+ * \param timing_ps // Pointer to structure containing timing values for selected PWM period
+ * \param use_adc // Flag set if ADC trigger is scheduled (see LOCK_ADC_TO_PWM)
+ */
+void build_pwm_schedule( // Build ordered edge schedule for next PWM period, and merge it with events NOT yet issued
+	REFERENCE_PARAM( PWM_SCHED_TYP ,sched_ps ), // Pointer to structure containing edge schedule for one motor
+	REFERENCE_PARAM( PWM_BUFFER_TYP ,pwm_buf_ps ), // Pointer to structure containing buffered PWM output data
+	unsigned ref_time, // Reference time (centre) of PWM period
+	REFERENCE_PARAM( PWM_TIMING_TYP ,timing_ps ), // Pointer to structure containing timing values for selected PWM period
+	int use_adc // Flag set if ADC trigger is scheduled
+);
+/*****************************************************************************/
+/** Merge edge schedules of all motors: Find motor whose next event should be issued first, and move that event to events[next].
+ * Of two events that are ready (or nearly ready, see PWM_READY_WINDOW), the earlier time wins, otherwise the earlier ready time.
+ * NB A rebuild is chosen if it is overdue, or NO other event is due within PWM_BUILD_CYCLES.
+ * \param sched_arr // Array of edge schedules, one for each motor
+ * \param num_mots // No. of motors
+ * \param cur_time // Current port time
+ * \return Motor identifier, or -1 if NO motor is running
+ */
+int next_pwm_event_motor( // Merge edge schedules of all motors: Find motor whose next event should be issued first
+	PWM_SCHED_TYP sched_arr[], // Array of edge schedules, one for each motor
+	int num_mots, // No. of motors
+	unsigned cur_time // Current port time
+);
+/*****************************************************************************/
+
+#endif /* _PWM_SCHEDULE_H_ */
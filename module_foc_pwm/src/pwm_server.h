@@ -28,10 +28,6 @@
 	#error Define. NUMBER_OF_MOTORS in app_global.h
 #endif // NUMBER_OF_MOTORS
 
-#ifndef PWM_STAGGER
-	#error Define. PWM_STAGGER in app_global.h
-#endif // PWM_STAGGER
-
 #ifndef LOCK_ADC_TO_PWM
 	#error Define. LOCK_ADC_TO_PWM in app_global.h
 #endif // LOCK_ADC_TO_PWM
@@ -40,20 +36,28 @@
 	#error Define. PLATFORM_REFERENCE_MHZ in app_global.h
 #endif // PLATFORM_REFERENCE_MHZ
 
-#ifndef INIT_SYNC_INCREMENT
-	#error Define. INIT_SYNC_INCREMENT in app_global.h
-#endif // INIT_SYNC_INCREMENT
-
 #define PWM_CLK_MHZ 250 // For historical reasons, PWM timings are based on a 250 MHz clock
 
+/* Port deadline checking.
+ * A timed port load whose time has already passed, waits for the 16-bit port timer to wrap (2^16 cycles).
+ * During this time the PWM legs hold their previous level, which could damage the motor.
+ * Therefore, before each set of timed loads, the Server checks there is at least PWM_LOAD_MARGIN cycles until the earliest edge.
+ * If not, the loads are skipped, all legs are switched off, and the miss is counted (see foc_pwm_get_miss_count()).
+ */
+#define PWM_LOAD_MARGIN 64 // Min. No. of cycles required to load one set of edges (~44 cycles) and check the deadline
+#define PWM_SAFE_HI_PATN 0 // Safe pattern for Hi-leg (switch off)
+#define PWM_SAFE_LO_PATN PWM_ONES_PATN // Safe pattern for Lo-leg. NB Lo-leg port is inverted, so all-ones switches Lo-leg off
+
 /** Structure containing pwm server control data */
 typedef struct PWM_SERV_TAG
 {
 	int id; // Motor Id
 	unsigned ref_time; // Reference Time incremented every PWM period, all other times are measured relative to this value
+	unsigned port_off; // Offset from timer value to port time (used to check port deadlines)
 	int data_ready; //Data ready flag
 } PWM_SERV_TYP;
 
+#ifdef __XC__ // NB The structure above is also sized by the host budget model (see src.dir/foc_budget_model.c)
 /*****************************************************************************/
 /** \brief Configures PWM clock, and synchronises all PWM cores
  *
@@ -89,5 +93,6 @@ void foc_pwm_do_triggered( // Implementation of the Centre-aligned, High-Low pai
 	in port p16_adc_sync // Dummy port used with ADC trigger
 );
 /*****************************************************************************/
+#endif // __XC__
 
 #endif // _PWM_SERVER_H_
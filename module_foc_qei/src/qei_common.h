@@ -44,6 +44,7 @@ typedef struct QEI_PARAM_TAG //
 	int tot_ang_this;	// Total angle traveresed since time=0, for this motor
 	int tot_ang_master;	// Total angle traveresed since time=0, for master motor (NB Maybe same as this motor)
 	unsigned phase_period; // time (in ticks) to traverse one QEI phase (angular position)
+	int veloc; // M/T angular velocity (RPM). NB Reduces if next edge is overdue, and zero when stopped
 	int corr_ang;	// Angular correction (Old - New)
 	int orig_corr; // Flag set if origin correction available
 	ERROR_QEI_ENUM err;	// Flag set when Error condition detected
@@ -0,0 +1,414 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "qei_decode.h"
+
+/*****************************************************************************/
+static void init_phase_data( // Initialise structure of QEI phase data
+	QEI_PHASE_TYP * phase_p, // Pointer to structure containing data for one QEI phase
+	QEI_PHASE_ETYP phase_index, // Unique QEI Phase Identifier
+	int motor_index // Unique Motor Identifier
+)
+{
+	phase_p->up_filt = 0; // Filterd phase value
+	phase_p->scale_err = 0; // Error diffusion value for scaling
+	phase_p->filt_err = 0; // Error diffusion value for filtering
+	phase_p->prev = 0; // Previous phase value
+	phase_p->phase_id = phase_index; // Unique QEI phase identifier
+	phase_p->motor_id = motor_index; // Unique motor identifier
+} // init_phase_data
+/*****************************************************************************/
+void init_qei_decode( // Initialise QEI data for one motor
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	int inp_id, // Input unique motor identifier
+	unsigned start_time // Time-stamp used to initialise all QEI times
+)
+{
+  /* Look-up table for converting phase changes to angle increments,
+	 * inner(fastest) changing index is NEW phase combination
+	 * WARNING: Using a 1-D table is slower, because index is calculated in XC.
+	 */
+	QEI_LUT_TYP ang_incs = {{{ 0 , 1 , -1 ,  0},
+													 {-1 , 0 ,  0 ,  1},
+													 { 1 , 0 ,  0 , -1},
+													 { 0 , -1 , 1 ,  0}}};
+
+
+	assert( QEI_PER_REV == (1 << QEI_RES_BITS) ); // Check consistency of pre-defined QEI values
+
+	inp_qei_p->ang_lut = ang_incs; // Assign table converting phase changes to angle increments
+
+	inp_qei_p->params.tot_ang_this = 0;  // Clear total angle for this motor
+	inp_qei_p->params.tot_ang_master = 0;  // Clear total angle for master motor
+	inp_qei_p->params.phase_period = 0; // Clear Time taken to traverse previous QEI phase
+	inp_qei_p->params.veloc = 0; // Clear M/T velocity
+	inp_qei_p->params.corr_ang = 0; // Clear correction angle
+	inp_qei_p->params.orig_corr = 0; // Preset flag to QEI correction NOT available
+	inp_qei_p->params.err = QEI_ERR_OFF; // Clear error status flag returned to client
+
+	inp_qei_p->pins_idle = 1; // NB Flag set until first pin-change is detected
+	inp_qei_p->id = inp_id; // Assign unique motor identifier
+	inp_qei_p->rev_period = QEI_PER_REV; // Preset No. of QEI phases changes between each origin detection
+	inp_qei_p->ang_tot = 0; // Reset counter indicating total angular position of motor (since time=0)
+	inp_qei_p->prev_ang = 0; // Reset previous total angle value
+	inp_qei_p->ang_inc = 0; // Reset angular position increment
+	inp_qei_p->status_errs = 0; // Initialise counter for QEI status errors
+
+	inp_qei_p->mt_strt_ang = 0; // Start M/T window at current angle
+	inp_qei_p->mt_period = 0;
+	inp_qei_p->mt_cnt = 0; // NB No M/T measurement yet
+
+	inp_qei_p->prev_orig = 0; // Clear value of previous origin flag
+	inp_qei_p->prev_phases = 0; // Clear value of previous phase combination
+
+	inp_qei_p->change_time = start_time; // Initialise time-stamp with sensible value
+	inp_qei_p->prev_change = start_time; // Initialise time-stamp with sensible value
+	inp_qei_p->prev_time = start_time; // Initialise time-stamp with sensible value
+	inp_qei_p->mt_strt_time = start_time; // Initialise time-stamp with sensible value
+
+	// Initialise data for both QEI Phases
+	init_phase_data( &inp_qei_p->phase_data[QEI_PHASE_A] ,QEI_PHASE_A ,inp_id );
+	init_phase_data( &inp_qei_p->phase_data[QEI_PHASE_B] ,QEI_PHASE_B ,inp_id );
+
+	return;
+} // init_qei_decode
+/*****************************************************************************/
+static void estimate_error_status( // Update estimate of error status based on new data
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	ERROR_QEI_ENUM new_err // Newly acquired error flag
+)
+// NB We require MAX_QEI_STATUS_ERR consecutive new errors before error estimate is set
+{
+	// Check if status changed
+	if (QEI_ERR_ON == new_err)
+	{ // new error detected
+
+		// Check previous error estimate
+		if (QEI_ERR_OFF == inp_qei_p->params.err)
+		{ // NO previous detected Error
+			inp_qei_p->status_errs++; // Increment new error count
+
+			// Check if too many errors occured
+			if (MAX_QEI_STATUS_ERR <=  inp_qei_p->status_errs)
+			{
+				inp_qei_p->params.err = QEI_ERR_ON; // Switch ON Error Estimate
+			} // if (MAX_QEI_STATUS_ERR <=  inp_qei_p->status_errs)
+		} // if (QEI_ERR_OFF == inp_qei_p->params.err)
+	} // if (QEI_ERR_ON == new_err)
+	else
+	{ // NO new error detected
+
+		// Check previous error estimate
+		if (QEI_ERR_ON == inp_qei_p->params.err)
+		{ // Already detected Error
+			inp_qei_p->status_errs--; // Decrement new error count
+
+			// Check if all errors cleared
+			if (0 >=  inp_qei_p->status_errs)
+			{
+				inp_qei_p->params.err = QEI_ERR_OFF; // Switch OFF Error Estimate
+			} // if (0 >=  inp_qei_p->status_errs)
+		} // if (QEI_ERR_ON == inp_qei_p->params.err)
+	} // else !(QEI_ERR_ON == new_err)
+
+} // estimate_error_status
+/*****************************************************************************/
+static void process_new_origin( // Process new origin state
+	QEI_DATA_TYP * inp_qei_p // Pointer to structure containing QEI parameters for one motor
+)
+{
+	int diff_ang = inp_qei_p->params.tot_ang_this - inp_qei_p->prev_ang; // Calculate change in angle since last origin
+	int abs_diff = abs(diff_ang); // Magnitude of angle change since last origin
+	int drift_ang = abs(abs_diff - inp_qei_p->rev_period);	// QEI drift from estimated origin position
+	int uncorr_ang;	// Angular position before correction
+
+
+	// Check for sensible drift value
+	if (PERIOD_DELTA_LIM > drift_ang)
+	{ // Valid drift value
+		uncorr_ang = inp_qei_p->ang_tot; // Store angle before correction
+
+		// Re-calibrate total-angle by rounding to multiple of QEI_PER_REV;
+		inp_qei_p->ang_tot += HALF_QEI_CNT; // Add offset to get rounding
+		inp_qei_p->ang_tot &= ~QEI_REV_MASK; // Clear least significant bits
+
+		// Check that previous correction has been processed by client
+		assert(0 == inp_qei_p->params.orig_corr); // ERROR: Unused correction
+
+		// Update client data parameters
+		inp_qei_p->params.corr_ang = uncorr_ang - inp_qei_p->ang_tot; // Evaluate correction
+		inp_qei_p->params.orig_corr = 1; // Set flag to 'correction available'
+
+		inp_qei_p->mt_strt_ang -= inp_qei_p->params.corr_ang; // Keep M/T window start consistent with corrected total-angle
+
+		// Update estimate of QEI period
+		if (inp_qei_p->rev_period < abs_diff)
+		{ // Allow small increase in estimated QEI period
+			inp_qei_p->rev_period++;
+
+			assert( inp_qei_p->rev_period < (QEI_PER_REV << 1)); // MB~ Check for overflow
+		} // if (inp_qei_p->rev_period < abs_diff)
+	else
+		{
+			if (inp_qei_p->rev_period > abs_diff)
+			{ // Allow small decrease in estimated QEI period
+				inp_qei_p->rev_period--;
+
+				assert( inp_qei_p->rev_period > (QEI_PER_REV >> 1)); // MB~ Check for underflow
+			} // if (inp_qei_p->rev_period > abs_diff)
+		} // else !(inp_qei_p->rev_period < abs_diff)
+	} // if (PERIOD_DELTA_LIM > drift_ang)
+
+	inp_qei_p->prev_ang = inp_qei_p->params.tot_ang_this; // Store origin angle for next iteration
+
+	return;
+} // process_new_origin
+/*****************************************************************************/
+static int calc_mt_velocity( // Calculate M/T velocity from latest complete window
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	unsigned cur_time // Current time
+) // Returns angular velocity (RPM)
+{
+	unsigned idle_time = cur_time - inp_qei_p->change_time; // Time since latest QEI edge. NB unsigned handles wrap-around
+	int ticks_rpm; // Ticks * Revolutions Per Min
+	int out_veloc; // Output angular velocity
+
+
+	// Check for stopped motor
+	if ((0 == inp_qei_p->mt_cnt) || (QEI_MT_STOP_TICKS < idle_time))
+	{
+		return 0;
+	} // if ((0 == inp_qei_p->mt_cnt) || (QEI_MT_STOP_TICKS < idle_time))
+
+	// Check if next edge is overdue (I.e. motor slowing down)
+	if (inp_qei_p->mt_period < (idle_time * (unsigned)abs(inp_qei_p->mt_cnt)))
+	{ // Time since latest edge gives an upper bound on speed
+		out_veloc = (TICKS_PER_MIN_PER_QEI + (idle_time >> 1)) / idle_time;
+
+		if (0 > inp_qei_p->mt_cnt)
+		{
+			out_veloc = -out_veloc;
+		} // if (0 > inp_qei_p->mt_cnt)
+	} // if (inp_qei_p->mt_period < (idle_time * (unsigned)abs(inp_qei_p->mt_cnt)))
+	else
+	{
+		ticks_rpm = inp_qei_p->mt_cnt * TICKS_PER_MIN_PER_QEI;
+
+		// Account for sign: to get correct rounding
+		if (0 > ticks_rpm)
+		{
+			ticks_rpm -= (int)(inp_qei_p->mt_period >> 1);
+		} // if (0 > ticks_rpm)
+		else
+		{
+			ticks_rpm += (int)(inp_qei_p->mt_period >> 1);
+		} // else !(0 > ticks_rpm)
+
+		out_veloc = ticks_rpm / (int)inp_qei_p->mt_period;
+	} // else !(inp_qei_p->mt_period < (idle_time * (unsigned)abs(inp_qei_p->mt_cnt)))
+
+	return out_veloc;
+} // calc_mt_velocity
+/*****************************************************************************/
+static unsigned update_one_phase( // Returns filtered phase value NB Only works on Binary data
+	QEI_PHASE_TYP * phase_p, // Pointer to structure containing data for one QEI phase
+	unsigned inp_phase // Input raw phase value (Zero or One)
+)
+{
+	unsigned scaled_inp = (inp_phase << QEI_SCALE_BITS); // NB Scale by 65536
+	int inp_diff; // Difference between previous filtered value and new input value
+	int filt_corr; // Correction to filtered value
+	int out_phase; // Output (Down-sampled) filtered phase value (Zero or One)
+
+
+	inp_diff = ((int)scaled_inp - (int)phase_p->up_filt); // Evaluate input change
+	inp_diff += phase_p->filt_err; // Add diffusion error
+
+ 	filt_corr = (inp_diff + QEI_VELOC_HALF) >> QEI_VELOC_BITS; // Multiply by filter coeficient (1/(2^n))
+	phase_p->filt_err = inp_diff - (filt_corr << QEI_VELOC_BITS); // Update filtering diffusion error
+
+	phase_p->up_filt += filt_corr; // Update scaled filtered output
+
+	if (QEI_SCALE_HALF > phase_p->up_filt)
+	{
+		out_phase = 0;
+	} // if (QEI_SCALE_HALF > phase_p->up_filt)
+	else
+	{
+		out_phase = 1;
+	} // if (QEI_SCALE_HALF > phase_p->up_filt)
+
+	return (unsigned)out_phase;
+} // update_one_phase
+/*****************************************************************************/
+static void update_first_phase( // Special case filter for 1st phase value
+	QEI_PHASE_TYP * phase_p, // Pointer to structure containing data for one QEI phase
+	int inp_phase // Input raw phase value (Zero or One)
+)
+{
+	phase_p->up_filt = (inp_phase << QEI_SCALE_BITS);
+	phase_p->prev =  phase_p->up_filt;
+} // update_first_phase
+/*****************************************************************************/
+static void update_mt_window( // Update M/T velocity window at a valid QEI edge
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	unsigned edge_time // Time-stamp of QEI edge
+)
+{
+	unsigned win_time = edge_time - inp_qei_p->mt_strt_time; // Length of current window. NB unsigned handles wrap-around
+
+
+	// Check if window is complete
+	if (QEI_MT_WINDOW <= win_time)
+	{
+		// Check for restart after a stop: previous edge too old for a sensible measurement
+		if (QEI_MT_STOP_TICKS < win_time)
+		{
+			inp_qei_p->mt_cnt = 0;
+		} // if (QEI_MT_STOP_TICKS < win_time)
+		else
+		{
+			inp_qei_p->mt_period = win_time;
+			inp_qei_p->mt_cnt = inp_qei_p->ang_tot - inp_qei_p->mt_strt_ang;
+		} // else !(QEI_MT_STOP_TICKS < win_time)
+
+		// Start new window on this edge
+		inp_qei_p->mt_strt_time = edge_time;
+		inp_qei_p->mt_strt_ang = inp_qei_p->ang_tot;
+	} // if (QEI_MT_WINDOW <= win_time)
+} // update_mt_window
+/*****************************************************************************/
+static void update_rs_phase_states( // Regular-Sampling: Update phase state
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	unsigned samp_time, // sample time-stamp (32-bit value)
+	unsigned cur_phases // Current set of phase values
+)
+{
+	int filt_a;  // Filtered Phase_A value (Zero or One)
+	int filt_b;  // Filtered Phase_B value (Zero or One)
+	unsigned filt_phases; // New set of phase values
+
+
+	// Filter each phase seperately
+	filt_a = update_one_phase( &inp_qei_p->phase_data[QEI_PHASE_A] ,(cur_phases & 0b01) ); // Phase_A
+	filt_b = update_one_phase( &inp_qei_p->phase_data[QEI_PHASE_B] ,((cur_phases & 0b10) >> 1) ); // Phase_B
+
+	filt_phases = (filt_b << 1) | filt_a; // Recombine phases
+
+	// Check for change in filtered phase data
+	if (inp_qei_p->prev_phases != filt_phases)
+	{	// Phase data change detected
+
+		inp_qei_p->ang_inc = inp_qei_p->ang_lut.incs[inp_qei_p->prev_phases][filt_phases]; // Decode new angular increment
+
+		// Check for valid transition
+		if (0 != inp_qei_p->ang_inc)
+		{
+			inp_qei_p->ang_tot += inp_qei_p->ang_inc; // Update new angle with angular increment
+
+			inp_qei_p->prev_change = inp_qei_p->change_time; // Store previous phase change time
+			inp_qei_p->change_time = samp_time; // Store time of filtered phase change
+
+			update_mt_window( inp_qei_p ,samp_time ); // NB No division in sampling loop
+
+			inp_qei_p->prev_phases = filt_phases; // Store filtered phases for next iteration
+		} //if (0 != inp_qei_p->ang_inc)
+	} // if (inp_qei_p->prev_phases != filt_phases)
+
+	return;
+} // update_rs_phase_states
+/*****************************************************************************/
+void service_qei_input_pins( // Process one sample of the QEI input pins
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	unsigned time_stamp, // 32-bit time-stamp
+	QEI_RAW_TYP inp_pins // Set of raw data values on input port pins
+)
+{
+	unsigned cur_phases; // Current set of phase values
+	unsigned orig_flg; // Flag set when motor at origin position
+	unsigned err_flg; // Flag set when Error condition detected
+
+
+	// NB Due to noise corrupting bit-values, flags may change, even though phase does NOT appear to have changed
+	cur_phases = inp_pins & QEI_PHASE_MASK; // Extract Phase bits from input pins
+			orig_flg = inp_pins & QEI_ORIG_MASK; 		// Extract origin flag
+	err_flg = !(inp_pins & QEI_NERR_MASK); 	// Extract error flag. NB Bit_3=0, and err_flg=1, if error detected,
+
+	// Check for first data
+	if (inp_qei_p->pins_idle)
+	{ // Initialise 'previous data'
+		inp_qei_p->pins_idle= 0; // Switch OFF idle flag
+
+		inp_qei_p->prev_phases = cur_phases; // Store phase value
+		inp_qei_p->prev_orig = orig_flg; // Store origin flag value
+		inp_qei_p->params.err = err_flg; // Preset client error flag.
+
+		update_first_phase( &inp_qei_p->phase_data[QEI_PHASE_A] ,(cur_phases & 0b01) ); // Phase_A
+		update_first_phase( &inp_qei_p->phase_data[QEI_PHASE_B] ,((cur_phases & 0b10) >> 1) ); // Phase_B
+	} // if (0 == inp_qei_p->pin_changes)
+			else
+	{ // NOT first data
+		update_rs_phase_states( inp_qei_p ,time_stamp ,cur_phases ); // update phase state
+
+		// Check for change in origin state
+		if (orig_flg != inp_qei_p->prev_orig)
+		{ // Process change of origin flag
+
+			// Check if new origin flag found
+			if (orig_flg)
+			{ // New origin found
+				process_new_origin( inp_qei_p ); // process new origin
+			} // if (orig_flg)
+
+			inp_qei_p->prev_orig = orig_flg; // Store origin flag value
+		} // if (orig_flg != inp_qei_p->prev_orig)
+
+		// Check for change in error state
+		if (err_flg != inp_qei_p->params.err)
+		{ // Change in error state detected
+
+			// Update estimate of error status using new error flag
+			estimate_error_status( inp_qei_p ,err_flg ); // NB Updates inp_qei_p->params.err
+		} // if (err_flg != inp_qei_p->params.err)
+	} // else !(0 == inp_qei_p->pin_changes)
+
+	return;
+} // service_qei_input_pins
+/*****************************************************************************/
+void get_qei_client_params( // Get QEI parameters for Client
+	QEI_DATA_TYP * inp_qei_p, // Pointer to structure containing QEI parameters for one motor
+	QEI_PARAM_TYP * out_params_p, // Pointer to structure of QEI parameters for Client
+	int master_tot_ang, // Total angle for master motor
+	unsigned cur_time // Current time
+)
+{
+	inp_qei_p->params.phase_period = (inp_qei_p->change_time - inp_qei_p->prev_change); // Time taken to traverse previous QEI phase
+	inp_qei_p->params.veloc = calc_mt_velocity( inp_qei_p ,cur_time ); // NB Division done here, NOT in sampling loop
+	inp_qei_p->params.tot_ang_this = inp_qei_p->ang_tot; // Transfer total-angle to client data structure
+	inp_qei_p->params.tot_ang_master = master_tot_ang;
+
+#if (LDO_MOTOR_SPIN)
+	// NB The QEI sensor on the LDO motor is inverted with respect to the other sensors
+	inp_qei_p->params.tot_ang_this = -inp_qei_p->params.tot_ang_this;
+	inp_qei_p->params.corr_ang = -inp_qei_p->params.corr_ang;
+	inp_qei_p->params.veloc = -inp_qei_p->params.veloc;
+#endif // (LDO_MOTOR_SPIN)
+
+	*out_params_p = inp_qei_p->params; // Copy QEI parameters for Client
+
+	inp_qei_p->params.corr_ang = 0; // Clear correction value
+	inp_qei_p->params.orig_corr = 0; // Reset flag to correction NOT available
+} // get_qei_client_params
+/*****************************************************************************/
+// qei_decode.c
@@ -0,0 +1,250 @@
+/*
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ */
+
+#ifndef _QEI_DECODE_H_
+#define _QEI_DECODE_H_
+
+#include <stdlib.h> // Required for abs()
+#include <assert.h>
+
+#include "app_global.h"
+#include "qei_common.h"
+
+/* Port-independent decoding of raw QEI samples for one motor (see qei_server.h for the QEI signals).
+ * The QEI Server (qei_server.xc) only reads buffers of regular samples from the QEI port, and time-stamps them.
+ * This file does the rest: phase filtering, angle, origin correction, error status, and the M/T velocity estimate.
+ *
+ * NB This file is independent of XMOS hardware, so can also be compiled in a host test (see src.dir)
+ */
+
+#ifndef QEI_PER_REV
+	#error Define. QEI_PER_REV in app_global.h
+#endif // QEI_PER_REV
+
+#ifndef QEI_RES_BITS
+	#error Define. QEI_RES_BITS in app_global.h
+#endif // QEI_RES_BITS
+
+#ifndef NUMBER_OF_MOTORS
+	#error Define. NUMBER_OF_MOTORS in app_global.h
+#endif // NUMBER_OF_MOTORS
+
+#ifndef MAX_SPEC_RPM
+	#error Define. MAX_SPEC_RPM in app_global.h
+#endif // MAX_SPEC_RPM
+
+#ifndef SECS_PER_MIN
+	#error Define. SECS_PER_MIN in app_global.h
+#endif // SECS_PER_MIN
+
+#ifndef MILLI_SEC
+	#error Define. MILLI_SEC in app_global.h
+#endif // MILLI_SEC
+
+#define QEI_REV_MASK (QEI_PER_REV - 1) // Mask used to force QEI count into base-range [0..QEI_REV_MASK]
+
+#define QEI_SAMP_BITS 4 // Size of QEI input port sample in bits
+#define QEI_SAMP_SIZ (1 << QEI_SAMP_BITS) // Max. No. of possible QEI sample values
+#define QEI_SAMP_MASK (QEI_SAMP_SIZ - 1) // Mask used to extract sample bits from buffer
+
+/** 2 LS-bits contain [A,B] phase info. */
+#define QEI_PHASE_MASK (0b0011) // 2 LS-bits contain [A,B] phase info.
+
+/** Bit_2 contain origin info. */
+#define QEI_ORIG_MASK (0b0100) // Bit_2 contain origin info.
+
+/** Bit_3 contains error status (1 == No Errors) */
+#define QEI_NERR_MASK (0b1000)
+
+#define QEI_PERIOD_LEN (QEI_PHASE_MASK + 1) // Number of different Phase combinations before a repeat. e.g [00 10 11 01]
+
+/* Calculate speed definitions, preserving precision and preventing overflow !-)
+ *
+ * The time difference between changes in QEI data is measured in 'ticks'.
+ * For a Platform Reference frequency of 100 MHz, there will be 6,000,000,000 ticks/minute
+ * If there are 1024 different QEI points per revolution, then angular velocity (in RPM) is
+ * (60 * 100000000)/(1024 * Tick_Diff) or (TICKS_PER_MIN_PER_QEI / Tick_Diff)
+ */
+#define TICKS_PER_SEC_PER_QEI ((PLATFORM_REFERENCE_HZ + (QEI_PER_REV >> 1)) / QEI_PER_REV) // Ticks/sec/angular_position (rounded) // 18-bits
+#define TICKS_PER_MIN_PER_QEI (SECS_PER_MIN * TICKS_PER_SEC_PER_QEI) // Ticks/min/angular_position // 24 bits
+
+#define QEI_DBG 0 // Set flag for printout of debug info.
+
+#define HALF_QEI_CNT (QEI_PER_REV >> 1) // 180 degrees of mechanical rotation
+
+#define MIN_TICKS_PER_QEI (TICKS_PER_MIN_PER_QEI / MAX_SPEC_RPM) // Min. expected Ticks/QEI // 12 bits
+#define THR_TICKS_PER_QEI (MIN_TICKS_PER_QEI >> 1) // Threshold value used to trap annomalies // 11 bits
+
+#define QEI_SCALE_BITS 16 // Used to generate 2^n scaling factor
+#define QEI_SCALE_DIV (1 << QEI_SCALE_BITS) // Scaling factor
+#define QEI_SCALE_HALF (QEI_SCALE_DIV >>1) // Half Scaling factor (used in rounding)
+
+#define MAX_QEI_STATUS_ERR 3 // 3 Maximum number of consecutive QEI status errors allowed
+
+/* HALF_PERIOD determines the clock frequency for port sampling.
+ * The sampling period must allow enough time (inbetween samples) for processing
+ * Currently this is about 660..680 cycles per 32-bit buffer.
+ * Therefore ~85 cycles/sample. There are a maximum of 2 motors to service.
+ * Therefore, 170 cycles/sample/motor. With safety margin lets make it 192 cycles.
+ */
+#define HALF_PERIOD 98 // 94 (Min 87) // ~100 Half of Max. allowed No. of ticks-per-sample
+#define TICKS_PER_SAMP (HALF_PERIOD << 1) // ~200 Max. allowed No. of ticks-per-sample
+
+#define SAMP_LOOP_BITS 3 // Used to define No. of samples in 32-bit port buffer
+#define SAMPS_PER_LOOP (1 << SAMP_LOOP_BITS) // 8  No. of samples in 32-bit port buffer
+#define TICKS_PER_LOOP (TICKS_PER_SAMP << SAMP_LOOP_BITS) // ~1600 Time taken to service a buffer of samples
+#define STAG_TICKS ((TICKS_PER_LOOP + (NUMBER_OF_MOTORS >> 1)) / NUMBER_OF_MOTORS) // ~800 NB Used to stagger servicing of port buffers
+
+// Require filter to decay from 1 to 1/2 after 5 samples. This is equivalent to filter coef of 0.1295 (~ 1/8)
+#define QEI_VELOC_BITS 3 // bit resolution of QEI filter coefficient
+#define QEI_VELOC_DIV (1 << QEI_VELOC_BITS) // 8 Divisor for filter coefficient
+#define QEI_VELOC_HALF (QEI_VELOC_DIV >> 1) // 4 Half of filt-coef divisor (used for rounding)
+
+#define MAX_TIME_ERR 1 // Max. No of consecutive timing errors allowed
+
+/* M/T velocity estimate. QEI edges are counted over a window which starts and ends on an edge, and lasts at least QEI_MT_WINDOW.
+ * Velocity = (No. of edges in window) / (exact time between first and last edge).
+ * At high speed, many edges are counted. At low speed, the window stretches to the next edge.
+ * So the relative precision is about TICKS_PER_SAMP/QEI_MT_WINDOW (~0.2%) at all speeds, without filtering.
+ * NB (edge count * TICKS_PER_MIN_PER_QEI) must fit in 31 bits: MAX_SPEC_RPM gives ~70 edges per ms
+ */
+#define QEI_MT_WINDOW MILLI_SEC // Min. length of M/T window
+#define QEI_MT_STOP_TICKS (MILLI_SEC << 7) // 128ms. Time without a QEI edge after which motor is assumed stopped
+
+#define PERIOD_DELTA_LIM 5 // Allow a change in QEI PERIOD of upto 5 phases
+
+typedef signed char ANG_INC_TYP; // Angular Increment type
+
+/** Different QEI phases */
+typedef enum QEI_PHASE_ETAG
+{
+  QEI_PHASE_A = 0,  // Phase_A identifier
+  QEI_PHASE_B,  // Phase_B identifier
+	NUM_QEI_PHASES // Number of different QEI Phase signals
+} QEI_PHASE_ETYP;
+
+/** Type containing 2-D array for look-up table */
+typedef struct QEI_LUT_TAG
+{
+	int incs[QEI_PERIOD_LEN][QEI_PERIOD_LEN];	// 2-D Look-up table
+} QEI_LUT_TYP;
+
+/** Structure containing all data for one QEI phase */
+typedef struct QEI_PHASE_TAG //
+{
+	int up_filt; // Up-scaled Low-pass filtered Phase signal
+	unsigned prev; // Previous value of filtered phase signal
+	int scale_err; // Error diffusion value for scaling
+	int filt_err; // Error diffusion value for filtering
+	QEI_PHASE_ETYP phase_id; // Unique QEI Phase identifier
+	int motor_id; // Unique motor identifier
+} QEI_PHASE_TYP;
+
+/** Structure containing QEI parameters for one motor */
+typedef struct QEI_DATA_TAG //
+{
+	QEI_PARAM_TYP params; // QEI Parameter data (sent to QEI Client)
+	QEI_LUT_TYP ang_lut;	// Look-up table for converting phase changes to angle increments
+	QEI_PHASE_TYP phase_data[NUM_QEI_PHASES];	// Structure containing all data for one QEI phase
+
+	unsigned prev_phases; // Previous phase values
+
+	unsigned prev_time; // Previous port time-stamp
+	unsigned change_time; // Time-stamp when valid phase change detected
+	unsigned prev_change; // Previous valid phase change Time-stamp
+	unsigned mt_strt_time; // Time-stamp of QEI edge at start of current M/T window
+	int mt_strt_ang; // Total angle at start of current M/T window
+	unsigned mt_period; // Time between first and last QEI edge of latest complete M/T window
+	int mt_cnt; // Net No. of QEI edges in latest complete M/T window (signed)
+	int ang_tot; // Counts total angular position of motor from time=0
+	int prev_ang;	// Angular position when previous origin detected (possibly false)
+	ANG_INC_TYP ang_inc; // angular increment value
+	unsigned rev_period; // number of QEI phases changes per revolution
+	int prev_orig; // Previous origin flag
+
+	int status_errs; // counter for invalid QEI status errors
+	int pins_idle; // Flag set until first pin change detected
+	int id; // Unique motor identifier
+
+	char dbg_str[3]; // String representing BA values as charaters (e.g. "10" )
+	int dbg; // Debug
+	int dbg_ang; // Debug
+
+	int tmp_raw; // Debug
+	int tmp_i[4]; // Debug
+} QEI_DATA_TYP;
+
+#ifdef __XC__
+// XC Version
+/*****************************************************************************/
+/** Initialise QEI data for one motor
+ * \param qei_data_s // Reference to structure containing QEI parameters for one motor
+ * \param motor_id // Unique motor identifier
+ * \param start_time // Time-stamp used to initialise all QEI times
+ */
+void init_qei_decode( // Initialise QEI data for one motor
+	QEI_DATA_TYP &qei_data_s, // Reference to structure containing QEI parameters for one motor
+	int motor_id, // Unique motor identifier
+	unsigned start_time // Time-stamp used to initialise all QEI times
+);
+/*****************************************************************************/
+/** Process one sample of the QEI input pins
+ * \param qei_data_s // Reference to structure containing QEI parameters for one motor
+ * \param time_stamp // 32-bit time-stamp of sample
+ * \param inp_pins // Set of raw data values on input port pins
+ */
+void service_qei_input_pins( // Process one sample of the QEI input pins
+	QEI_DATA_TYP &qei_data_s, // Reference to structure containing QEI parameters for one motor
+	unsigned time_stamp, // 32-bit time-stamp of sample
+	QEI_RAW_TYP inp_pins // Set of raw data values on input port pins
+);
+/*****************************************************************************/
+/** Get QEI parameters for Client, and clear any origin correction (as it is now delivered)
+ * \param qei_data_s // Reference to structure containing QEI parameters for one motor
+ * \param out_params_s // Reference to structure of QEI parameters for Client (output)
+ * \param master_tot_ang // Total angle for master motor
+ * \param cur_time // Current time (used to check for overdue QEI edge)
+ */
+void get_qei_client_params( // Get QEI parameters for Client
+	QEI_DATA_TYP &qei_data_s, // Reference to structure containing QEI parameters for one motor
+	QEI_PARAM_TYP &out_params_s, // Reference to structure of QEI parameters for Client
+	int master_tot_ang, // Total angle for master motor
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+#else // ifdef __XC__
+// C Version
+/*****************************************************************************/
+void init_qei_decode( // Initialise QEI data for one motor
+	QEI_DATA_TYP * qei_data_p, // Pointer to structure containing QEI parameters for one motor
+	int motor_id, // Unique motor identifier
+	unsigned start_time // Time-stamp used to initialise all QEI times
+);
+/*****************************************************************************/
+void service_qei_input_pins( // Process one sample of the QEI input pins
+	QEI_DATA_TYP * qei_data_p, // Pointer to structure containing QEI parameters for one motor
+	unsigned time_stamp, // 32-bit time-stamp of sample
+	QEI_RAW_TYP inp_pins // Set of raw data values on input port pins
+);
+/*****************************************************************************/
+void get_qei_client_params( // Get QEI parameters for Client
+	QEI_DATA_TYP * qei_data_p, // Pointer to structure containing QEI parameters for one motor
+	QEI_PARAM_TYP * out_params_p, // Pointer to structure of QEI parameters for Client
+	int master_tot_ang, // Total angle for master motor
+	unsigned cur_time // Current time
+);
+/*****************************************************************************/
+#endif // else !__XC__
+
+#endif // _QEI_DECODE_H_
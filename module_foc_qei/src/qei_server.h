@@ -65,150 +65,7 @@
 #include <syscall.h>
 
 #include "qei_common.h"
-
-#ifndef QEI_PER_REV
-	#error Define. QEI_PER_REV in app_global.h
-#endif // QEI_PER_REV
-
-#ifndef QEI_RES_BITS
-	#error Define. QEI_RES_BITS in app_global.h
-#endif // QEI_RES_BITS
-
-#ifndef NUMBER_OF_MOTORS
-	#error Define. NUMBER_OF_MOTORS in app_global.h
-#endif // NUMBER_OF_MOTORS
-
-#ifndef MAX_SPEC_RPM
-	#error Define. MAX_SPEC_RPM in app_global.h
-#endif // MAX_SPEC_RPM
-
-#ifndef SECS_PER_MIN
-	#error Define. SECS_PER_MIN in app_global.h
-#endif // SECS_PER_MIN
-
-#ifndef MILLI_SEC
-	#error Define. MILLI_SEC in app_global.h
-#endif // MILLI_SEC
-
-#define QEI_REV_MASK (QEI_PER_REV - 1) // Mask used to force QEI count into base-range [0..QEI_REV_MASK]
-
-#define QEI_SAMP_BITS 4 // Size of QEI input port sample in bits
-#define QEI_SAMP_SIZ (1 << QEI_SAMP_BITS) // Max. No. of possible QEI sample values
-#define QEI_SAMP_MASK (QEI_SAMP_SIZ - 1) // Mask used to extract sample bits from buffer
-
-/** 2 LS-bits contain [A,B] phase info. */
-#define QEI_PHASE_MASK (0b0011) // 2 LS-bits contain [A,B] phase info.
-
-/** Bit_2 contain origin info. */
-#define QEI_ORIG_MASK (0b0100) // Bit_2 contain origin info.
-
-/** Bit_3 contains error status (1 == No Errors) */
-#define QEI_NERR_MASK (0b1000)
-
-#define QEI_PERIOD_LEN (QEI_PHASE_MASK + 1) // Number of different Phase combinations before a repeat. e.g [00 10 11 01]
-
-/* Calculate speed definitions, preserving precision and preventing overflow !-)
- *
- * The time difference between changes in QEI data is measured in 'ticks'.
- * For a Platform Reference frequency of 100 MHz, there will be 6,000,000,000 ticks/minute
- * If there are 1024 different QEI points per revolution, then angular velocity (in RPM) is
- * (60 * 100000000)/(1024 * Tick_Diff) or (TICKS_PER_MIN_PER_QEI / Tick_Diff)
- */
-#define TICKS_PER_SEC_PER_QEI ((PLATFORM_REFERENCE_HZ + (QEI_PER_REV >> 1)) / QEI_PER_REV) // Ticks/sec/angular_position (rounded) // 18-bits
-#define TICKS_PER_MIN_PER_QEI (SECS_PER_MIN * TICKS_PER_SEC_PER_QEI) // Ticks/min/angular_position // 24 bits
-
-#define QEI_DBG 0 // Set flag for printout of debug info.
-
-#define HALF_QEI_CNT (QEI_PER_REV >> 1) // 180 degrees of mechanical rotation
-
-#define MIN_TICKS_PER_QEI (TICKS_PER_MIN_PER_QEI / MAX_SPEC_RPM) // Min. expected Ticks/QEI // 12 bits
-#define THR_TICKS_PER_QEI (MIN_TICKS_PER_QEI >> 1) // Threshold value used to trap annomalies // 11 bits
-
-#define QEI_SCALE_BITS 16 // Used to generate 2^n scaling factor
-#define QEI_SCALE_DIV (1 << QEI_SCALE_BITS) // Scaling factor
-#define QEI_SCALE_HALF (QEI_SCALE_DIV >>1) // Half Scaling factor (used in rounding)
-
-#define MAX_QEI_STATUS_ERR 3 // 3 Maximum number of consecutive QEI status errors allowed
-
-/* HALF_PERIOD determines the clock frequency for port sampling.
- * The sampling period must allow enough time (inbetween samples) for processing
- * Currently this is about 660..680 cycles per 32-bit buffer.
- * Therefore ~85 cycles/sample. There are a maximum of 2 motors to service.
- * Therefore, 170 cycles/sample/motor. With safety margin lets make it 192 cycles.
- */
-#define HALF_PERIOD 98 // 94 (Min 87) // ~100 Half of Max. allowed No. of ticks-per-sample
-#define TICKS_PER_SAMP (HALF_PERIOD << 1) // ~200 Max. allowed No. of ticks-per-sample
-
-#define SAMP_LOOP_BITS 3 // Used to define No. of samples in 32-bit port buffer
-#define SAMPS_PER_LOOP (1 << SAMP_LOOP_BITS) // 8  No. of samples in 32-bit port buffer
-#define TICKS_PER_LOOP (TICKS_PER_SAMP << SAMP_LOOP_BITS) // ~1600 Time taken to service a buffer of samples
-#define STAG_TICKS ((TICKS_PER_LOOP + (NUMBER_OF_MOTORS >> 1)) / NUMBER_OF_MOTORS) // ~800 NB Used to stagger servicing of port buffers
-
-// Require filter to decay from 1 to 1/2 after 5 samples. This is equivalent to filter coef of 0.1295 (~ 1/8)
-#define QEI_VELOC_BITS 3 // bit resolution of QEI filter coefficient
-#define QEI_VELOC_DIV (1 << QEI_VELOC_BITS) // 8 Divisor for filter coefficient
-#define QEI_VELOC_HALF (QEI_VELOC_DIV >> 1) // 4 Half of filt-coef divisor (used for rounding)
-
-#define MAX_TIME_ERR 1 // Max. No of consecutive timing errors allowed
-
-#define PERIOD_DELTA_LIM 5 // Allow a change in QEI PERIOD of upto 5 phases
-
-typedef signed char ANG_INC_TYP; // Angular Increment type
-
-/** Different QEI phases */
-typedef enum QEI_PHASE_ETAG
-{
-  QEI_PHASE_A = 0,  // Phase_A identifier
-  QEI_PHASE_B,  // Phase_B identifier
-	NUM_QEI_PHASES // Number of different QEI Phase signals
-} QEI_PHASE_ETYP;
-
-/** Type containing 2-D array for look-up table */
-typedef struct QEI_LUT_TAG
-{
-	int incs[QEI_PERIOD_LEN][QEI_PERIOD_LEN];	// 2-D Look-up table
-} QEI_LUT_TYP;
-
-/** Structure containing all data for one QEI phase */
-typedef struct QEI_PHASE_TAG //
-{
-	int up_filt; // Up-scaled Low-pass filtered Phase signal
-	unsigned prev; // Previous value of filtered phase signal
-	int scale_err; // Error diffusion value for scaling
-	int filt_err; // Error diffusion value for filtering
-	QEI_PHASE_ETYP phase_id; // Unique QEI Phase identifier
-	int motor_id; // Unique motor identifier
-} QEI_PHASE_TYP;
-
-/** Structure containing QEI parameters for one motor */
-typedef struct QEI_DATA_TAG //
-{
-	QEI_PARAM_TYP params; // QEI Parameter data (sent to QEI Client)
-	QEI_LUT_TYP ang_lut;	// Look-up table for converting phase changes to angle increments
-	QEI_PHASE_TYP phase_data[NUM_QEI_PHASES];	// Structure containing all data for one QEI phase
-
-	unsigned prev_phases; // Previous phase values
-
-	unsigned prev_time; // Previous port time-stamp
-	unsigned change_time; // Time-stamp when valid phase change detected
-	unsigned prev_change; // Previous valid phase change Time-stamp
-	int ang_tot; // Counts total angular position of motor from time=0
-	int prev_ang;	// Angular position when previous origin detected (possibly false)
-	ANG_INC_TYP ang_inc; // angular increment value
-	unsigned rev_period; // number of QEI phases changes per revolution
-	int prev_orig; // Previous origin flag
-
-	int status_errs; // counter for invalid QEI status errors
-	int pins_idle; // Flag set until first pin change detected
-	int id; // Unique motor identifier
-
-	char dbg_str[3]; // String representing BA values as charaters (e.g. "10" )
-	int dbg; // Debug
-	int dbg_ang; // Debug
-
-	int tmp_raw; // Debug
-	int tmp_i[4]; // Debug
-} QEI_DATA_TYP;
+#include "qei_decode.h"
 
 #define QEI_PORT port:32 // Use 32-bit buffering for Regular-Sampling mode
 
@@ -0,0 +1,15 @@
+# ansi C compile: Host test of ADC trigger-delay calibration
+
+MAIN =	adc_delay_model
+
+CMODS =	$(MAIN) \
+	adc_delay_calib \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+
+INC_DIR = ../module_foc_adc/src
+
+include host_model.mak
+
+#
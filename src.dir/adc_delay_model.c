@@ -0,0 +1,134 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "adc_delay_model.h"
+
+/* Host test of ADC trigger-delay calibration (see module_foc_adc/src/adc_delay_calib.c)
+ * The ADC samples of a stopped motor are modelled as offset plus noise, plus decaying ringing after each PWM edge.
+ * For each PWM configuration, the PWM centre is (deliberately) moved away from the nominal trigger delay,
+ * and the calibration is checked to select a delay inside the quiet part of the PWM 'OFF' period, and close to its centre.
+ * Usage: adc_delay_model.x
+ */
+
+// Test configurations: PWM resolution bits, dead-time, shift of PWM centre
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ 12 ,120 ,0 } ,{ 12 ,120 ,-300 } ,{ 12 ,120 ,250 } ,{ 12 ,240 ,0 } ,{ 12 ,60 ,-150 } ,{ 11 ,120 ,0 } ,{ 13 ,120 ,400 }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+#define NUM_PWM_EDGES 4 // No. of PWM edges modelled (either side of 'OFF' period)
+/*****************************************************************************/
+static double gauss_noise( void ) // Returns Gaussian noise with unit variance
+{
+	double rnd_a = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0); // Uniform random value (0..1)
+	double rnd_b = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0); // Uniform random value (0..1)
+
+
+	return sqrt( -2.0 * log( rnd_a ) ) * cos( 2.0 * M_PI * rnd_b ); // Box-Muller transform
+} // gauss_noise
+/*****************************************************************************/
+static int model_adc_sample( // Model one ADC sample of a stopped motor
+	const MODEL_CONFIG_TYP * config_p, // Pointer to test configuration
+	int cent_time, // Time of centre of PWM 'OFF' period (after control token)
+	int samp_time // Time of ADC sample (after control token)
+) // Returns ADC value
+{
+	int quart_max = (1 << config_p->res_bits) >> 2; // Quarter PWM period (NB Half-width of 'OFF' period when stopped)
+	int edge_times[NUM_PWM_EDGES]; // Array of PWM edge times
+	double adc_val = MODEL_ADC_OFFSET + MODEL_NOISE_SIGMA * gauss_noise(); // ADC value
+	double ring_time; // Time since PWM edge
+	int edge_cnt; // PWM edge counter
+
+
+	// High-leg off, Low-leg on (after dead-time), Low-leg off, High-leg on (after dead-time)
+	edge_times[0] = cent_time - quart_max;
+	edge_times[1] = edge_times[0] + config_p->dead_time;
+	edge_times[2] = cent_time + quart_max;
+	edge_times[3] = edge_times[2] + config_p->dead_time;
+
+	for (edge_cnt=0; edge_cnt<NUM_PWM_EDGES; edge_cnt++)
+	{
+		ring_time = (double)(samp_time - edge_times[edge_cnt]);
+
+		if ((0.0 <= ring_time) && (MODEL_RING_END > ring_time))
+		{
+			adc_val += MODEL_RING_AMP * exp( -ring_time / MODEL_RING_TAU )
+				* sin( 2.0 * M_PI * (ring_time / MODEL_RING_PERIOD + (double)rand() / (double)RAND_MAX) );
+		} // if ((0.0 <= ring_time) && (MODEL_RING_END > ring_time))
+	} // for edge_cnt
+
+	return (int)floor( adc_val + 0.5 );
+} // model_adc_sample
+/*****************************************************************************/
+static int test_one_config( // Run delay calibration for one test configuration, and check result
+	const MODEL_CONFIG_TYP * config_p // Pointer to test configuration
+) // Returns 1 if test passes, else 0
+{
+	ADC_DELAY_CALIB_TYP calib_s; // Structure containing data for ADC trigger delay calibration
+	int quart_max = (1 << config_p->res_bits) >> 2; // Quarter PWM period
+	int nom_delay = quart_max - MODEL_TRIGGER_CORR; // Nominal trigger delay (see ADC_TRIGGER_DELAY)
+	int cent_time = nom_delay + config_p->shift; // Actual centre of PWM 'OFF' period
+	int quiet_strt = cent_time - quart_max + config_p->dead_time + (int)ceil( MODEL_RING_QUIET ); // Start of quiet period
+	int quiet_end = cent_time + quart_max; // End of quiet period
+	int quiet_cent = (quiet_strt + quiet_end) >> 1; // Centre of quiet period
+	int step = quart_max >> ADC_SWEEP_STEP_BITS; // Time between candidate delays
+	int adc_vals[ADC_SWEEP_PHASES]; // Array of ADC values
+	int phase_cnt; // ADC Phase counter
+	int pass; // Flag set if test passes
+
+
+	init_adc_delay_calib( &calib_s ,nom_delay ,step );
+
+	while (0 == calib_s.done)
+	{
+		for (phase_cnt=0; phase_cnt<ADC_SWEEP_PHASES; phase_cnt++)
+		{
+			adc_vals[phase_cnt] = model_adc_sample( config_p ,cent_time ,calib_s.delay );
+		} // for phase_cnt
+
+		update_adc_delay_calib( &calib_s ,adc_vals ,ADC_SWEEP_PHASES );
+	} // while (0 == calib_s.done)
+
+	pass = ((quiet_strt <= calib_s.delay) && (quiet_end >= calib_s.delay) && (step >= abs(calib_s.delay - quiet_cent)));
+
+	printf("  Res=%2d Dead=%4d Shift=%5d: Nominal=%5d Quiet=[%5d..%5d] Selected=%5d Error=%5d %s\n"
+		,config_p->res_bits ,config_p->dead_time ,config_p->shift ,nom_delay ,quiet_strt ,quiet_end
+		,calib_s.delay ,(calib_s.delay - quiet_cent) ,(pass ? "PASS" : "FAIL") );
+
+	return pass;
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	srand( 1 ); // NB Repeatable results
+
+	printf("ADC trigger-delay calibration tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,41 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _ADC_DELAY_MODEL_H_
+#define _ADC_DELAY_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "adc_delay_calib.h"
+
+#define MODEL_TRIGGER_CORR 128 // Same as ADC_TRIGGER_CORR (see module_foc_adc/src/adc_7265.h)
+#define MODEL_ADC_OFFSET 37 // DC offset of modelled ADC
+#define MODEL_NOISE_SIGMA 3.0 // Standard deviation of ADC noise, away from PWM edges
+#define MODEL_RING_AMP 300.0 // Initial amplitude of ringing after a PWM edge
+#define MODEL_RING_TAU 60.0 // Decay time-constant of ringing (in Reference Frequency Cycles)
+#define MODEL_RING_PERIOD 40.0 // Period of ringing oscillation (in Reference Frequency Cycles)
+#define MODEL_RING_END (MODEL_RING_TAU * 8.0) // Time after which ringing is ignored
+#define MODEL_RING_QUIET (MODEL_RING_TAU * log( MODEL_RING_AMP / MODEL_NOISE_SIGMA )) // Time for ringing to decay to noise level
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	int res_bits; // PWM resolution bits (see PWM_RES_BITS)
+	int dead_time; // PWM dead-time (see PWM_DEAD_TIME)
+	int shift; // Unexpected shift of PWM centre (e.g. due to clocking change)
+} MODEL_CONFIG_TYP;
+
+#endif /* _ADC_DELAY_MODEL_H_ */
@@ -0,0 +1,16 @@
+# ansi C compile: Host test and benchmark of ADC pipeline, with mock ADC driver
+
+MAIN =	adc_mock_model
+
+CMODS =	$(MAIN) \
+	adc_pipeline \
+	adc_delay_calib \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+
+INC_DIR = ../module_foc_adc/src ../app_test_adc/src
+
+include host_model.mak
+
+#
@@ -0,0 +1,374 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "adc_mock_model.h"
+
+/* Host test and benchmark of the chip-independent ADC pipeline (see module_foc_adc/src/adc_pipeline.c)
+ * The mock ADC driver replaces the AD7265 driver (adc_7265.xc). It generates raw frames from the tabulated sine values
+ * used by app_test_adc, plus a DC offset and noise for each phase.
+ * For each configuration, the offset calibration (PWM off) and the zero-mean output (PWM on) are checked,
+ * then the time to process one frame is measured.
+ * Usage: adc_mock_model.x  (NB Run from src.dir, so that the sine table is found)
+ */
+
+// Test configurations: measured phases, filter, trigger delay sweep, Phase_A offset
+static const MOCK_CONFIG_TYP test_configs[] = {
+	{ 2 ,0 ,0 ,37 } ,{ 2 ,1 ,0 ,-54 } ,{ 2 ,0 ,1 ,0 } ,{ 2 ,1 ,1 ,113 } ,{ 3 ,0 ,1 ,-21 } ,{ 3 ,1 ,0 ,76 }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MOCK_CONFIG_TYP))
+#define MOCK_OFFSET_INC 17 // Change of DC offset between phases
+#define MOCK_BENCH_BUF 1024 // No. of pre-generated frames used in benchmark
+/*****************************************************************************/
+static double gauss_noise( void ) // Returns Gaussian noise with unit variance
+{
+	double rnd_a = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0); // Uniform random value (0..1)
+	double rnd_b = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0); // Uniform random value (0..1)
+
+
+	return sqrt( -2.0 * log( rnd_a ) ) * cos( 2.0 * M_PI * rnd_b ); // Box-Muller transform
+} // gauss_noise
+/*****************************************************************************/
+static int configure_mock_adc( // Configure mock ADC driver (Read sine table)
+	MOCK_ADC_TYP * mock_p, // Pointer to structure containing data for mock ADC chip
+	const MOCK_CONFIG_TYP * config_p // Pointer to test configuration
+) // Returns 0 on success
+{
+	FILE * file_p; // Pointer to sine table file
+	size_t num_vals; // No. of sine values read
+	int phase_cnt; // ADC Phase counter
+
+
+	file_p = fopen( MOCK_SIN_NAME ,"rb" );
+	if (NULL == file_p)
+	{
+		printf("ERROR: Opening File %s\n" ,MOCK_SIN_NAME );
+		return -1;
+	} // if (NULL == file_p)
+
+	num_vals = fread( mock_p->table ,sizeof(SIN_TYP) ,MOCK_SIN_VALS ,file_p );
+	fclose( file_p );
+
+	if (MOCK_SIN_VALS != num_vals)
+	{
+		printf("ERROR: Only %d of %d values read\n" ,(int)num_vals ,MOCK_SIN_VALS );
+		return -1;
+	} // if (MOCK_SIN_VALS != num_vals)
+
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		mock_p->offsets[phase_cnt] = config_p->offset + phase_cnt * MOCK_OFFSET_INC;
+	} // for phase_cnt
+
+	mock_p->num_phases = config_p->num_phases;
+	mock_p->noise_sigma = MOCK_NOISE_SIGMA;
+	mock_p->amp = 0; // PWM off
+	mock_p->ang = 0;
+
+	return 0;
+} // configure_mock_adc
+/*****************************************************************************/
+static int mock_sine( // Look up sine value for any angle
+	MOCK_ADC_TYP * mock_p, // Pointer to structure containing data for mock ADC chip
+	int inp_ang // Electrical angle (in angle units)
+) // Returns up-scaled sine value (-MOCK_SIN_SCALE .. MOCK_SIN_SCALE)
+{
+	int index = inp_ang & (MOCK_SIN_PERIOD - 1); // Wrap angle into one sine period
+	int quad = index >> MOCK_SIN_BITS; // Quadrant
+	int quad_off = index & (MOCK_SIN_VALS - 1); // Offset into quadrant
+
+
+	switch(quad)
+	{
+		case 0 : // 1st Quadrant
+			return mock_p->table[quad_off];
+
+		case 1 : // 2nd Quadrant: Mirror around PI/2
+			return mock_p->table[MOCK_SIN_VALS - 1 - quad_off];
+
+		case 2 : // 3rd Quadrant: Mirror around X-axis
+			return -mock_p->table[quad_off];
+
+		default : // 4th Quadrant: Mirror around X-axis and 3.PI/2
+			return -mock_p->table[MOCK_SIN_VALS - 1 - quad_off];
+	} // switch(quad)
+} // mock_sine
+/*****************************************************************************/
+static int ideal_current( // Coil current (in ADC units) for one phase
+	MOCK_ADC_TYP * mock_p, // Pointer to structure containing data for mock ADC chip
+	int phase_id // ADC Phase identifier
+) // Returns coil current
+{
+	int ang = mock_p->ang - (phase_id * MOCK_SIN_PERIOD) / 3; // Phases are 120 degrees apart
+
+
+	return (int)(((long long)mock_p->amp * mock_sine( mock_p ,ang ) + (MOCK_SIN_SCALE >> 1)) / MOCK_SIN_SCALE);
+} // ideal_current
+/*****************************************************************************/
+static void trigger_mock_adc( // Mock PWM trigger: Advance electrical angle by one PWM period
+	MOCK_ADC_TYP * mock_p // Pointer to structure containing data for mock ADC chip
+)
+{
+	mock_p->ang += MOCK_ANG_INC;
+} // trigger_mock_adc
+/*****************************************************************************/
+static void read_mock_frame( // Read one raw ADC frame from mock ADC chip
+	MOCK_ADC_TYP * mock_p, // Pointer to structure containing data for mock ADC chip
+	int raw_vals[] // Array of raw ADC values, for each measured phase
+)
+{
+	int phase_cnt; // ADC Phase counter
+	int adc_val; // ADC value
+
+
+	for (phase_cnt=0; phase_cnt<mock_p->num_phases; phase_cnt++)
+	{
+		adc_val = ideal_current( mock_p ,phase_cnt ) + mock_p->offsets[phase_cnt]
+			+ (int)floor( mock_p->noise_sigma * gauss_noise() + 0.5 );
+
+		// Clip to ADC range
+		if (MOCK_ADC_MAX < adc_val)
+		{
+			adc_val = MOCK_ADC_MAX;
+		} // if (MOCK_ADC_MAX < adc_val)
+
+		if (MOCK_ADC_MIN > adc_val)
+		{
+			adc_val = MOCK_ADC_MIN;
+		} // if (MOCK_ADC_MIN > adc_val)
+
+		raw_vals[phase_cnt] = adc_val;
+	} // for phase_cnt
+} // read_mock_frame
+/*****************************************************************************/
+static int check_calibration( // Calibrate offsets with PWM off, and check result
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data
+	MOCK_ADC_TYP * mock_p // Pointer to structure containing data for mock ADC chip
+) // Returns 1 if test passes, else 0
+{
+	int raw_vals[ADC_PIPE_PHASES]; // Array of raw ADC values
+	int max_frames = (NUM_ADC_SWEEP_STEPS * ADC_SWEEP_SAMPS) + ADC_CALIB_SAMPS + 2; // Max. frames needed for calibration
+	int frame_cnt = 0; // Frame counter
+	int phase_cnt; // ADC Phase counter
+	int pass = 1; // Flag set if test passes
+
+
+	mock_p->amp = 0; // PWM off
+	start_adc_pipeline_calib( pipe_p );
+
+	while ((0 == pipe_p->calib_done) && (max_frames > frame_cnt))
+	{
+		trigger_mock_adc( mock_p );
+		read_mock_frame( mock_p ,raw_vals );
+		process_adc_frame( pipe_p ,raw_vals );
+		frame_cnt++;
+	} // while ((0 == pipe_p->calib_done) && (max_frames > frame_cnt))
+
+	if (0 == pipe_p->calib_done)
+	{
+		pass = 0;
+	} // if (0 == pipe_p->calib_done)
+
+	printf("    Calibration: Frames=%5d Delay=%4d Offsets=" ,frame_cnt ,pipe_p->trig_delay );
+
+	for (phase_cnt=0; phase_cnt<mock_p->num_phases; phase_cnt++)
+	{
+		printf("%5d(%5d)" ,pipe_p->phase_data[phase_cnt].mean ,mock_p->offsets[phase_cnt] );
+
+		if (1 < abs(pipe_p->phase_data[phase_cnt].mean - mock_p->offsets[phase_cnt]))
+		{
+			pass = 0;
+		} // if (1 < abs(pipe_p->phase_data[phase_cnt].mean - mock_p->offsets[phase_cnt]))
+	} // for phase_cnt
+
+	printf(" %s\n" ,(pass ? "PASS" : "FAIL") );
+
+	return pass;
+} // check_calibration
+/*****************************************************************************/
+static int check_run_mode( // Process frames with PWM on, and check zero-mean output
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data
+	MOCK_ADC_TYP * mock_p // Pointer to structure containing data for mock ADC chip
+) // Returns 1 if test passes, else 0
+{
+	int raw_vals[ADC_PIPE_PHASES]; // Array of raw ADC values
+	int out_vals[ADC_PIPE_PHASES]; // Array of zero-mean ADC values (NB Inferred phase added at end)
+	long long sums[ADC_PIPE_PHASES]; // Sum of output values for each phase
+	double max_step = 2.0 * M_PI * MOCK_AMP * MOCK_ANG_INC / MOCK_SIN_PERIOD; // Max. change of current per frame
+	int err_lim = (int)ceil( 6.0 * MOCK_NOISE_SIGMA ) + 1; // Max. error allowed
+	int max_err = 0; // Largest error
+	int max_mean = 0; // Largest mean
+	int phase_cnt; // ADC Phase counter
+	int frame_cnt; // Frame counter
+	int adc_sum; // Sum of measured phases
+	int err; // Error in one output value
+	int pass; // Flag set if test passes
+
+
+	// Allow for phase lag of filter, and for inferred phase (sum of 2 errors)
+	if (pipe_p->filter)
+	{
+		err_lim += (int)ceil( (ADC_FILT_DIV + 1) * max_step );
+	} // if (pipe_p->filter)
+
+	if (ADC_PIPE_PHASES > mock_p->num_phases)
+	{
+		err_lim <<= 1;
+	} // if (ADC_PIPE_PHASES > mock_p->num_phases)
+
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		sums[phase_cnt] = 0;
+	} // for phase_cnt
+
+	mock_p->amp = MOCK_AMP; // PWM on
+
+	for (frame_cnt=0; frame_cnt<MOCK_RUN_FRAMES; frame_cnt++)
+	{
+		trigger_mock_adc( mock_p );
+		read_mock_frame( mock_p ,raw_vals );
+		process_adc_frame( pipe_p ,raw_vals );
+
+		adc_sum = get_adc_pipeline_vals( pipe_p ,out_vals );
+
+		// NB Last phase is inferred if NOT measured (see service_data_request() in adc_7265.xc)
+		if (ADC_PIPE_PHASES > mock_p->num_phases)
+		{
+			out_vals[(ADC_PIPE_PHASES - 1)] = -adc_sum;
+		} // if (ADC_PIPE_PHASES > mock_p->num_phases)
+
+		for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+		{
+			sums[phase_cnt] += out_vals[phase_cnt];
+
+			// Skip filter start-up
+			if (MOCK_SIN_VALS < frame_cnt)
+			{
+				err = abs(out_vals[phase_cnt] - ideal_current( mock_p ,phase_cnt ));
+				if (max_err < err)
+				{
+					max_err = err;
+				} // if (max_err < err)
+			} // if (MOCK_SIN_VALS < frame_cnt)
+		} // for phase_cnt
+	} // for frame_cnt
+
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		int mean = (int)llabs( sums[phase_cnt] / MOCK_RUN_FRAMES ); // Mean output value
+
+
+		if (max_mean < mean)
+		{
+			max_mean = mean;
+		} // if (max_mean < mean)
+	} // for phase_cnt
+
+	pass = ((err_lim >= max_err) && (1 >= max_mean));
+
+	printf("    Run mode:    Frames=%5d Max_Error=%3d (Limit=%3d) Max_Mean=%2d %s\n"
+		,MOCK_RUN_FRAMES ,max_err ,err_lim ,max_mean ,(pass ? "PASS" : "FAIL") );
+
+	return pass;
+} // check_run_mode
+/*****************************************************************************/
+static void bench_pipeline( // Measure time to process one frame
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data
+	MOCK_ADC_TYP * mock_p // Pointer to structure containing data for mock ADC chip
+)
+{
+	static int bench_vals[MOCK_BENCH_BUF][ADC_PIPE_PHASES]; // Pre-generated raw frames (NB Mock NOT timed)
+	int out_vals[ADC_PIPE_PHASES]; // Array of zero-mean ADC values
+	volatile int chk_sum = 0; // Prevents pipeline being optimised away
+	clock_t strt_clk; // Clock at start of benchmark
+	double secs; // Elapsed time
+	int frame_cnt; // Frame counter
+
+
+	for (frame_cnt=0; frame_cnt<MOCK_BENCH_BUF; frame_cnt++)
+	{
+		trigger_mock_adc( mock_p );
+		read_mock_frame( mock_p ,bench_vals[frame_cnt] );
+	} // for frame_cnt
+
+	strt_clk = clock();
+
+	for (frame_cnt=0; frame_cnt<MOCK_BENCH_FRAMES; frame_cnt++)
+	{
+		process_adc_frame( pipe_p ,bench_vals[frame_cnt & (MOCK_BENCH_BUF - 1)] );
+		chk_sum += get_adc_pipeline_vals( pipe_p ,out_vals );
+	} // for frame_cnt
+
+	secs = (double)(clock() - strt_clk) / (double)CLOCKS_PER_SEC;
+
+	printf("    Benchmark:   Frames=%d Time=%.1f ns/frame\n" ,MOCK_BENCH_FRAMES ,(1.0e9 * secs / MOCK_BENCH_FRAMES) );
+} // bench_pipeline
+/*****************************************************************************/
+static int test_one_config( // Run pipeline with mock ADC driver for one test configuration
+	const MOCK_CONFIG_TYP * config_p // Pointer to test configuration
+) // Returns 1 if test passes, else 0
+{
+	static MOCK_ADC_TYP mock_s; // Structure containing data for mock ADC chip
+	ADC_PIPE_TYP pipe_s; // Structure containing pipeline data
+	int pass = 1; // Flag set if test passes
+
+
+	printf("  Phases=%d Filter=%d Sweep=%d Offset=%4d\n"
+		,config_p->num_phases ,config_p->filter ,config_p->sweep ,config_p->offset );
+
+	if (0 != configure_mock_adc( &mock_s ,config_p ))
+	{
+		return 0;
+	} // if (0 != configure_mock_adc( &mock_s ,config_p ))
+
+	init_adc_pipeline( &pipe_s ,config_p->num_phases ,config_p->filter ,config_p->sweep ,MOCK_TRIGGER_DELAY ,MOCK_SWEEP_STEP );
+
+	if (0 == check_calibration( &pipe_s ,&mock_s ))
+	{
+		pass = 0;
+	} // if (0 == check_calibration( &pipe_s ,&mock_s ))
+
+	if (0 == check_run_mode( &pipe_s ,&mock_s ))
+	{
+		pass = 0;
+	} // if (0 == check_run_mode( &pipe_s ,&mock_s ))
+
+	bench_pipeline( &pipe_s ,&mock_s );
+
+	return pass;
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	srand( 1 ); // NB Repeatable results
+
+	printf("ADC pipeline tests (mock ADC driver)\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
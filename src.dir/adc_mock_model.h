@@ -0,0 +1,63 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _ADC_MOCK_MODEL_H_
+#define _ADC_MOCK_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+#include "sine_common.h"
+#include "adc_pipeline.h"
+
+#define MOCK_SIN_NAME "../app_test_adc/sine_table.bin" // File of tabulated sine values (see gen_sine_data.c)
+#define MOCK_SIN_BITS 12 // No. of bits in table size
+#define MOCK_SIN_VALS (1 << MOCK_SIN_BITS) // No. of tabulated values in 1st quadrant [0 .. PI/2]
+#define MOCK_SIN_QUADS 4 // No. of quadrants in one sine period
+#define MOCK_SIN_PERIOD (MOCK_SIN_QUADS * MOCK_SIN_VALS) // No. of angle units in one sine period
+#define MOCK_SIN_SCALE 65535 // Scaling of tabulated sine values
+
+#define MOCK_ADC_MAX 2047 // Max. 12-bit ADC value (see ADC_ACTIVE_BITS)
+#define MOCK_ADC_MIN (-MOCK_ADC_MAX - 1) // Min. 12-bit ADC value
+#define MOCK_TRIGGER_DELAY 896 // Nominal trigger delay (see ADC_TRIGGER_DELAY)
+#define MOCK_SWEEP_STEP 128 // Time between candidate trigger delays (see ADC_SWEEP_STEP)
+#define MOCK_NOISE_SIGMA 2.0 // Standard deviation of ADC noise
+#define MOCK_AMP 1500 // Amplitude of coil current (in ADC units)
+#define MOCK_ANG_INC 7 // Change of electrical angle per PWM period (in angle units)
+#define MOCK_RUN_FRAMES (1 << 16) // No. of frames checked in run mode
+#define MOCK_BENCH_FRAMES (1 << 22) // No. of frames timed in benchmark
+
+/** Structure containing data for mock ADC chip (host-side ADC driver) */
+typedef struct MOCK_ADC_TAG
+{
+	SIN_TYP table[MOCK_SIN_VALS]; // Array of tabulated sine values for 1st quadrant
+	int offsets[ADC_PIPE_PHASES]; // DC offset of each phase
+	int num_phases; // No. of measured phases in each raw frame
+	int amp; // Amplitude of coil current (0 == PWM off)
+	int ang; // Electrical angle (in angle units)
+	double noise_sigma; // Standard deviation of ADC noise
+} MOCK_ADC_TYP;
+
+/** Structure containing one test configuration */
+typedef struct MOCK_CONFIG_TAG
+{
+	int num_phases; // No. of measured phases (see MEAS_ADC_PHASES)
+	int filter; // Flag set if raw values are filtered (see ADC_FILTER)
+	int sweep; // Flag set if trigger delay is calibrated (see ADC_DELAY_CALIB)
+	int offset; // DC offset of Phase_A (other phases are different)
+} MOCK_CONFIG_TYP;
+
+#endif /* _ADC_MOCK_MODEL_H_ */
@@ -0,0 +1,16 @@
+# ansi C compile: Host check of single-shunt ADC rebuild and capture queueing
+
+MAIN =	adc_shunt_model
+
+CMODS =	$(MAIN) \
+	adc_pipeline \
+	adc_delay_calib \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+
+INC_DIR = ../module_foc_adc/src
+
+include host_model.mak
+
+#
@@ -0,0 +1,328 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "adc_shunt_model.h"
+
+/* Host check of single-shunt ADC processing (see rebuild_shunt_frame() and store_shunt_sample() in module_foc_adc/src/adc_pipeline.c)
+ * Each PWM period has random coil currents, and a random order of the phases (as chosen by the PWM Server).
+ * The mock ADC converts the shunt as (offset + I_first) for the 1st sample, and (offset - I_last) for the 2nd sample.
+ * The following are checked:-
+ *	Calibration: With NO current, the offsets are calibrated through the rebuilt frames, and every phase mean is the shunt offset
+ *	Run mode: For all phase orders, the zero-mean pipeline output equals the coil currents
+ *	Queueing: For each token/capture sequence (see ADC_SHUNT_MUX in adc_7265.xc), the expected No. of frames is rebuilt,
+ *		and each rebuilt frame holds the currents of the PWM period of its 2nd sample
+ * Usage: adc_shunt_model.x
+ */
+
+// Test configurations: Name, Shunt offset, Expected frames, Event sequence
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "Sequential" ,37 ,3 ,12 ,{ REQ_FIRST ,CAPTURE ,REQ_LAST ,CAPTURE ,REQ_FIRST ,CAPTURE ,REQ_LAST ,CAPTURE
+		,REQ_FIRST ,CAPTURE ,REQ_LAST ,CAPTURE } }
+	,{ "Queued 2nd" ,-54 ,2 ,8 ,{ REQ_FIRST ,REQ_LAST ,CAPTURE ,CAPTURE ,REQ_FIRST ,REQ_LAST ,CAPTURE ,CAPTURE } }
+	,{ "Queued 1st" ,113 ,3 ,12 ,{ REQ_FIRST ,CAPTURE ,REQ_LAST ,REQ_FIRST ,CAPTURE ,CAPTURE ,REQ_LAST ,REQ_FIRST ,CAPTURE ,CAPTURE
+		,REQ_LAST ,CAPTURE } }
+	,{ "Lost 1st" ,-21 ,1 ,6 ,{ REQ_LAST ,CAPTURE ,REQ_FIRST ,CAPTURE ,REQ_LAST ,CAPTURE } }
+	,{ "Queue full" ,76 ,1 ,7 ,{ REQ_FIRST ,REQ_LAST ,REQ_FIRST ,CAPTURE ,CAPTURE ,REQ_LAST ,CAPTURE } }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+#define MODEL_CALIB_OFFSET 58 // Shunt offset used in calibration and run-mode checks
+/*****************************************************************************/
+static int rand_range( // Returns random value in range [min_val .. max_val]
+	int min_val, // Min. value
+	int max_val // Max. value
+)
+{
+	return min_val + (rand() % (max_val - min_val + 1));
+} // rand_range
+/*****************************************************************************/
+static void new_model_period( // Generate random currents and phase order for one PWM period
+	MODEL_PERIOD_TYP * period_p, // Pointer to structure containing modelled period
+	int amp // Max. coil current
+)
+{
+	period_p->currs[0] = rand_range( -amp ,amp );
+	period_p->currs[1] = rand_range( -amp ,amp );
+	period_p->currs[2] = -period_p->currs[0] - period_p->currs[1];
+
+	period_p->first = rand_range( 0 ,(ADC_PIPE_PHASES - 1) );
+	period_p->last = (period_p->first + rand_range( 1 ,(ADC_PIPE_PHASES - 1) )) % ADC_PIPE_PHASES; // NB Different from 1st
+} // new_model_period
+/*****************************************************************************/
+static int mock_shunt_sample( // Mock ADC conversion of single shunt
+	const MODEL_PERIOD_TYP * period_p, // Pointer to structure containing modelled period
+	int samp_id, // Sample index
+	int offset // Shunt offset
+) // Returns raw single-shunt sample
+{
+	if (0 == samp_id)
+	{
+		return offset + period_p->currs[period_p->first];
+	} // if (0 == samp_id)
+
+	return offset - period_p->currs[period_p->last];
+} // mock_shunt_sample
+/*****************************************************************************/
+static int check_run_frame( // Check one processed frame against modelled currents
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data
+	const MODEL_PERIOD_TYP * period_p // Pointer to structure containing modelled period
+) // Returns No. of phases in error
+{
+	int out_vals[ADC_PIPE_PHASES]; // Array of zero-mean ADC values
+	int phase_cnt; // ADC Phase counter
+	int num_errs = 0; // No. of phases in error
+
+
+	get_adc_pipeline_vals( pipe_p ,out_vals );
+
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		if (out_vals[phase_cnt] != period_p->currs[phase_cnt]) num_errs++;
+	} // for phase_cnt
+
+	return num_errs;
+} // check_run_frame
+/*****************************************************************************/
+static int run_one_period( // Pass both samples of one PWM period (in order) through single-shunt processing
+	ADC_PIPE_TYP * pipe_p, // Pointer to structure containing pipeline data
+	ADC_SHUNT_TYP * shunt_p, // Pointer to structure containing single-shunt sample data
+	const MODEL_PERIOD_TYP * period_p, // Pointer to structure containing modelled period
+	int offset // Shunt offset
+) // Returns 1 if frame rebuilt and processed
+{
+	int raw_vals[ADC_PIPE_PHASES]; // Array of raw ADC values
+	int done; // Flag set if frame rebuilt
+
+
+	request_shunt_sample( shunt_p ,0 ,period_p->first );
+	store_shunt_sample( pipe_p ,shunt_p ,raw_vals ,mock_shunt_sample( period_p ,0 ,offset ) );
+	request_shunt_sample( shunt_p ,1 ,period_p->last );
+	done = store_shunt_sample( pipe_p ,shunt_p ,raw_vals ,mock_shunt_sample( period_p ,1 ,offset ) );
+
+	if (done)
+	{
+		process_adc_frame( pipe_p ,raw_vals );
+	} // if (done)
+
+	return done;
+} // run_one_period
+/*****************************************************************************/
+static int check_pipeline( void ) // Calibrate offsets, then check run-mode output for all phase orders
+/* NB The frames are rebuilt with NO trigger delay sweep and NO filter, so the run-mode output must exactly equal the currents
+ */
+{
+	ADC_PIPE_TYP pipe_s; // Structure containing pipeline data
+	ADC_SHUNT_TYP shunt_s; // Structure containing single-shunt sample data
+	MODEL_PERIOD_TYP period_s; // Structure containing modelled period
+	int orders[ADC_PIPE_PHASES][ADC_PIPE_PHASES]; // Frames checked for each phase order [first][last]
+	int frame_cnt; // Frame counter
+	int phase_cnt; // ADC Phase counter
+	int calib_errs = 0; // No. of calibration errors
+	int run_errs = 0; // No. of run-mode errors
+	int missing = 0; // No. of phase orders NOT checked
+	int pass; // Flag set if test passes
+
+
+	init_adc_pipeline( &pipe_s ,ADC_PIPE_PHASES ,0 ,0 ,1 ,1 );
+	init_adc_shunt( &shunt_s );
+	start_adc_pipeline_calib( &pipe_s );
+
+	// Calibration: PWM off, so NO current. NB Phase order still changes
+	for (frame_cnt=0; frame_cnt<ADC_CALIB_SAMPS; frame_cnt++)
+	{
+		new_model_period( &period_s ,0 );
+		run_one_period( &pipe_s ,&shunt_s ,&period_s ,(MODEL_CALIB_OFFSET + rand_range( -MODEL_NOISE ,MODEL_NOISE )) );
+	} // for frame_cnt
+
+	if (0 == pipe_s.calib_done) calib_errs++;
+
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		if (1 < abs(pipe_s.phase_data[phase_cnt].mean - MODEL_CALIB_OFFSET)) calib_errs++;
+	} // for phase_cnt
+
+	// Run mode
+	for (phase_cnt=0; phase_cnt<(ADC_PIPE_PHASES * ADC_PIPE_PHASES); phase_cnt++)
+	{
+		orders[phase_cnt / ADC_PIPE_PHASES][phase_cnt % ADC_PIPE_PHASES] = 0;
+	} // for phase_cnt
+
+	// NB Use exact shunt offset, so the run-mode check does NOT depend on the calibration noise
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		pipe_s.phase_data[phase_cnt].mean = MODEL_CALIB_OFFSET;
+	} // for phase_cnt
+
+	for (frame_cnt=0; frame_cnt<MODEL_RUN_FRAMES; frame_cnt++)
+	{
+		new_model_period( &period_s ,MODEL_AMP );
+
+		if (run_one_period( &pipe_s ,&shunt_s ,&period_s ,MODEL_CALIB_OFFSET ))
+		{
+			run_errs += check_run_frame( &pipe_s ,&period_s );
+			orders[period_s.first][period_s.last]++;
+		} // if (run_one_period( &pipe_s ,&shunt_s ,&period_s ,MODEL_CALIB_OFFSET ))
+		else
+		{
+			run_errs++;
+		} // else !(run_one_period( &pipe_s ,&shunt_s ,&period_s ,MODEL_CALIB_OFFSET ))
+	} // for frame_cnt
+
+	for (phase_cnt=0; phase_cnt<(ADC_PIPE_PHASES * ADC_PIPE_PHASES); phase_cnt++)
+	{
+		// Check each order of 2 different phases was exercised
+		if ((phase_cnt / ADC_PIPE_PHASES) != (phase_cnt % ADC_PIPE_PHASES))
+		{
+			if (0 == orders[phase_cnt / ADC_PIPE_PHASES][phase_cnt % ADC_PIPE_PHASES]) missing++;
+		} // if ((phase_cnt / ADC_PIPE_PHASES) != (phase_cnt % ADC_PIPE_PHASES))
+	} // for phase_cnt
+
+	pass = (0 == (calib_errs + run_errs + missing));
+
+	printf("  %-12s: Offsets=%4d %4d %4d (Shunt=%4d) Frames=%5d Errors: Calib=%d Run=%d Orders=%d %s\n" ,"Pipeline"
+		,pipe_s.phase_data[0].mean ,pipe_s.phase_data[1].mean ,pipe_s.phase_data[2].mean ,MODEL_CALIB_OFFSET
+		,MODEL_RUN_FRAMES ,calib_errs ,run_errs ,missing ,(pass ? "PASS" : "FAIL") );
+
+	return pass;
+} // check_pipeline
+/*****************************************************************************/
+static int test_one_config( // Run one token/capture sequence through single-shunt processing
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+/* The mock ADC converts outstanding captures in request order. A request made while 2 captures are outstanding
+ * replaces the queued one (as its capture time is overwritten in adc_7265.xc).
+ */
+{
+	MODEL_PERIOD_TYP periods[MODEL_MAX_EVENTS]; // Modelled currents for each PWM period
+	MODEL_CAPT_TYP capts[ADC_SHUNT_QUEUE]; // Outstanding captures of mock ADC (oldest first)
+	ADC_PIPE_TYP pipe_s; // Structure containing pipeline data
+	ADC_SHUNT_TYP shunt_s; // Structure containing single-shunt sample data
+	int offsets[ADC_PIPE_PHASES]; // Calibrated offsets
+	int raw_vals[ADC_PIPE_PHASES]; // Array of rebuilt raw ADC values
+	const MODEL_PERIOD_TYP * period_p; // Pointer to modelled period of capture
+	int num_capts = 0; // No. of outstanding captures
+	int period_id = 0; // Current PWM period. NB Sequence may start part-way through period 0
+	int num_frames = 0; // No. of rebuilt frames
+	int frame_errs = 0; // No. of rebuilt values in error
+	int queue_errs = 0; // No. of requests where start/queue decision was wrong
+	int event_cnt; // Event counter
+	int phase_cnt; // ADC Phase counter
+	int samp_id; // Sample index
+	int start; // Flag set if capture must start now
+	int err_val; // Error value
+
+
+	for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+	{
+		offsets[phase_cnt] = cfg_p->offset;
+	} // for phase_cnt
+
+	init_adc_pipeline( &pipe_s ,ADC_PIPE_PHASES ,0 ,0 ,1 ,1 );
+	preset_adc_pipeline_offsets( &pipe_s ,offsets );
+	init_adc_shunt( &shunt_s );
+
+	new_model_period( &periods[0] ,MODEL_AMP );
+
+	for (event_cnt=0; event_cnt<cfg_p->num_events; event_cnt++)
+	{
+		switch(cfg_p->events[event_cnt])
+		{
+			case REQ_FIRST : case REQ_LAST :
+				samp_id = (REQ_LAST == cfg_p->events[event_cnt]);
+
+				// Check for start of new PWM period
+				if ((0 == samp_id) && (0 < event_cnt))
+				{
+					period_id++;
+					new_model_period( &periods[period_id] ,MODEL_AMP );
+				} // if ((0 == samp_id) && (0 < event_cnt))
+
+				period_p = &periods[period_id];
+				start = request_shunt_sample( &shunt_s ,samp_id ,(samp_id ? period_p->last : period_p->first) );
+
+				// Capture starts now only if NO capture outstanding
+				if (start != (0 == num_capts)) queue_errs++;
+
+				if (ADC_SHUNT_QUEUE <= num_capts) num_capts = ADC_SHUNT_QUEUE - 1; // Replace queued capture
+
+				capts[num_capts].period = period_id;
+				capts[num_capts].samp_id = samp_id;
+				num_capts++;
+			break; // case REQ_FIRST : case REQ_LAST
+
+			case CAPTURE :
+				period_p = &periods[capts[0].period];
+
+				if (store_shunt_sample( &pipe_s ,&shunt_s ,raw_vals ,mock_shunt_sample( period_p ,capts[0].samp_id ,cfg_p->offset ) ))
+				{
+					num_frames++;
+
+					// Rebuilt frame must be from a 2nd sample, and hold the currents of its period
+					if (0 == capts[0].samp_id) frame_errs++;
+
+					for (phase_cnt=0; phase_cnt<ADC_PIPE_PHASES; phase_cnt++)
+					{
+						if (raw_vals[phase_cnt] != (cfg_p->offset + period_p->currs[phase_cnt])) frame_errs++;
+					} // for phase_cnt
+				} // if (store_shunt_sample( &pipe_s ,&shunt_s ,raw_vals ,mock_shunt_sample( ...
+
+				num_capts--;
+				if (num_capts) capts[0] = capts[1];
+
+				// Check driver sees same No. of outstanding captures
+				if (num_capts != shunt_s.queue_cnt) queue_errs++;
+			break; // case CAPTURE
+
+			default:
+				assert(0 == 1); // ERROR: Unknown event
+			break; // default
+		} // switch(cfg_p->events[event_cnt])
+	} // for event_cnt
+
+	err_val = frame_errs + queue_errs + (num_frames != cfg_p->num_frames);
+
+	printf("  %-12s: Periods=%d Frames=%d (Expected=%d) Errors: Frame=%d Queue=%d %s\n"
+		,cfg_p->name ,(period_id + 1) ,num_frames ,cfg_p->num_frames ,frame_errs ,queue_errs ,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	srand( 1 ); // NB Repeatable results
+
+	printf("Single-shunt ADC tests\n");
+
+	if (0 == check_pipeline())
+	{
+		num_fails++;
+	} // if (0 == check_pipeline())
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)(NUM_TEST_CONFIGS + 1) );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
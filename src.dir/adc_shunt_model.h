@@ -0,0 +1,63 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+
+#ifndef _ADC_SHUNT_MODEL_H_
+#define _ADC_SHUNT_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "adc_pipeline.h"
+
+#define MODEL_AMP 1500 // Max. coil current (in ADC units)
+#define MODEL_NOISE 3 // Max. ADC noise during offset calibration (in ADC units)
+#define MODEL_MAX_EVENTS 24 // Max. No. of events in a test sequence
+#define MODEL_RUN_FRAMES 4096 // No. of frames checked in run mode
+
+/** Different types of event in a test sequence */
+typedef enum SHUNT_EVENT_ETAG
+{
+  REQ_FIRST = 0, // Token for 1st sample received (starts new PWM period)
+  REQ_LAST, // Token for 2nd sample received
+  CAPTURE, // Oldest outstanding capture converted
+  NUM_SHUNT_EVENTS // Handy Value!-)
+} SHUNT_EVENT_ENUM;
+
+/** Structure containing the modelled currents for one PWM period */
+typedef struct MODEL_PERIOD_TAG
+{
+	int currs[ADC_PIPE_PHASES]; // Coil current of each phase (sum to zero)
+	int first; // Phase whose Hi-leg switched on first (measured by 1st sample)
+	int last; // Phase whose Hi-leg switched on last (measured by 2nd sample)
+} MODEL_PERIOD_TYP;
+
+/** Structure containing one outstanding capture of the mock ADC */
+typedef struct MODEL_CAPT_TAG
+{
+	int period; // PWM period of request
+	int samp_id; // Sample index of request
+} MODEL_CAPT_TYP;
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int offset; // Shunt offset (in ADC units)
+	int num_frames; // Expected No. of rebuilt frames
+	int num_events; // No. of events in sequence
+	SHUNT_EVENT_ENUM events[MODEL_MAX_EVENTS]; // Sequence of events
+} MODEL_CONFIG_TYP;
+
+#endif /* _ADC_SHUNT_MODEL_H_ */
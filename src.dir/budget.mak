@@ -0,0 +1,16 @@
+# ansi C compile: Host-side model of MOTOR_TILE resource budget
+
+MAIN =	foc_budget_model
+
+CMODS =	$(MAIN) \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	foc_budget.h \
+
+INC_DIR = host_inc ../module_foc_control/src ../module_foc_pwm/src ../module_foc_qei/src ../module_foc_hall/src ../module_foc_adc/src \
+	../module_foc_util/src ../__app_foc_demo/src
+
+include host_model.mak
+
+#
@@ -0,0 +1,199 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "foc_budget_model.h"
+
+/* Host-side model of MOTOR_TILE resource budget.
+ * Prints per-module threads, channel-ends, clock blocks and RAM for a given number of motors,
+ * using the same budget definitions as the build-time checks (see module_foc_control/src/foc_budget.h)
+ * Usage: foc_budget_model.x [num_motors [use_xscope]]
+ * If num_motors is omitted, all configurations up to MAX_MODEL_MOTORS are reported.
+ * The budgeted structure sizes are first checked against sizeof(). If any differ, the check fails, and the measured sizes are printed.
+ */
+
+// Budgeted structure sizes. NB MOTOR_DATA_TYP is XC-only, and is checked on the target (see init_motor() in inner_loop.xc)
+static const BUDGET_SIZE_TYP budget_sizes[] = {
+	{ "BUDGET_PWM_ARRAY_BYTES" ,BUDGET_PWM_ARRAY_BYTES ,sizeof(PWM_ARRAY_TYP) }
+	,{ "BUDGET_PWM_SERV_BYTES" ,BUDGET_PWM_SERV_BYTES ,sizeof(PWM_SERV_TYP) }
+	,{ "BUDGET_PWM_COMMS_BYTES" ,BUDGET_PWM_COMMS_BYTES ,sizeof(PWM_COMMS_TYP) }
+	,{ "BUDGET_PWM_SCHED_BYTES" ,BUDGET_PWM_SCHED_BYTES ,sizeof(PWM_SCHED_TYP) }
+	,{ "BUDGET_QEI_DATA_BYTES" ,BUDGET_QEI_DATA_BYTES ,sizeof(QEI_DATA_TYP) }
+	,{ "BUDGET_HALL_DATA_BYTES" ,BUDGET_HALL_DATA_BYTES ,sizeof(HALL_DATA_TYP) }
+	,{ "BUDGET_ADC_DATA_BYTES" ,BUDGET_ADC_DATA_BYTES ,sizeof(ADC_DATA_TYP) }
+};
+
+#define NUM_BUDGET_SIZES (sizeof(budget_sizes) / sizeof(BUDGET_SIZE_TYP))
+/*****************************************************************************/
+static int check_budget_sizes( void ) // Check budgeted structure sizes against sizeof()
+/* NB Host and XS1 have the same size and alignment for word and smaller members (including timer, see host_inc/xs1.h).
+ * 64-bit members (e.g. ADC_NOISE_TYP) may be padded to 8 bytes on the host, so the budget errs on the large side.
+ */
+{
+	int size_cnt; // Size counter
+	int match = 1; // Flag cleared if any size differs
+
+
+	printf("Budgeted structure sizes\n");
+
+	for (size_cnt=0; size_cnt<NUM_BUDGET_SIZES; size_cnt++)
+	{
+		const BUDGET_SIZE_TYP * size_p = &budget_sizes[size_cnt]; // Pointer to size data
+
+
+		printf("  %-24s %6d (sizeof %6d) %s\n" ,size_p->name ,size_p->budget ,size_p->measured
+			,((size_p->budget == size_p->measured) ? "PASS" : "FAIL") );
+
+		if (size_p->budget != size_p->measured) match = 0;
+	} // for size_cnt
+
+	// Print corrected definitions for foc_budget.h
+	if (0 == match)
+	{
+		printf("Update foc_budget.h with:-\n");
+
+		for (size_cnt=0; size_cnt<NUM_BUDGET_SIZES; size_cnt++)
+		{
+			printf("#define %s %d\n" ,budget_sizes[size_cnt].name ,budget_sizes[size_cnt].measured );
+		} // for size_cnt
+	} // if (0 == match)
+
+	printf("\n");
+
+	return match;
+} // check_budget_sizes
+/*****************************************************************************/
+static void build_budget_table( // Populates budget table for one configuration
+	BUDGET_TYP budget_tab[], // Array of module budgets
+	int num_mots // No. of motors
+)
+{
+	budget_tab[BUDGET_CONTROL].name = "Control";
+	budget_tab[BUDGET_CONTROL].threads = BUDGET_CONTROL_THREADS(num_mots);
+	budget_tab[BUDGET_CONTROL].chanends = BUDGET_CONTROL_CHANENDS(num_mots);
+	budget_tab[BUDGET_CONTROL].clk_blks = BUDGET_CONTROL_CLK_BLKS(num_mots);
+	budget_tab[BUDGET_CONTROL].ram = BUDGET_CONTROL_RAM(num_mots);
+
+	budget_tab[BUDGET_PWM].name = "PWM";
+	budget_tab[BUDGET_PWM].threads = BUDGET_PWM_THREADS(num_mots);
+	budget_tab[BUDGET_PWM].chanends = BUDGET_PWM_CHANENDS(num_mots);
+	budget_tab[BUDGET_PWM].clk_blks = BUDGET_PWM_CLK_BLKS(num_mots);
+	budget_tab[BUDGET_PWM].ram = BUDGET_PWM_RAM(num_mots);
+
+	budget_tab[BUDGET_QEI].name = "QEI";
+	budget_tab[BUDGET_QEI].threads = BUDGET_QEI_THREADS(num_mots);
+	budget_tab[BUDGET_QEI].chanends = BUDGET_QEI_CHANENDS(num_mots);
+	budget_tab[BUDGET_QEI].clk_blks = BUDGET_QEI_CLK_BLKS(num_mots);
+	budget_tab[BUDGET_QEI].ram = BUDGET_QEI_RAM(num_mots);
+
+	budget_tab[BUDGET_HALL].name = "Hall";
+	budget_tab[BUDGET_HALL].threads = BUDGET_HALL_THREADS(num_mots);
+	budget_tab[BUDGET_HALL].chanends = BUDGET_HALL_CHANENDS(num_mots);
+	budget_tab[BUDGET_HALL].clk_blks = BUDGET_HALL_CLK_BLKS(num_mots);
+	budget_tab[BUDGET_HALL].ram = BUDGET_HALL_RAM(num_mots);
+
+	budget_tab[BUDGET_ADC].name = "ADC";
+	budget_tab[BUDGET_ADC].threads = BUDGET_ADC_THREADS(num_mots);
+	budget_tab[BUDGET_ADC].chanends = BUDGET_ADC_CHANENDS(num_mots);
+	budget_tab[BUDGET_ADC].clk_blks = BUDGET_ADC_CLK_BLKS(num_mots);
+	budget_tab[BUDGET_ADC].ram = BUDGET_ADC_RAM(num_mots);
+} // build_budget_table
+/*****************************************************************************/
+static int check_one_resource( // Print total for one resource, and check against tile limit
+	const char * res_name, // Resource name
+	int tot_val, // Total used
+	int lim_val // Tile limit
+) // Returns 1 if resource fits, else 0
+{
+	int fits = (tot_val <= lim_val); // Flag set if resource fits
+
+
+	printf("  %-10s %6d of %6d %s\n" ,res_name ,tot_val ,lim_val ,(fits ? "" : "<-- DOES NOT FIT") );
+
+	return fits;
+} // check_one_resource
+/*****************************************************************************/
+static int report_one_config( // Print budget report for one configuration
+	int num_mots, // No. of motors
+	int use_xscope // Flag set if xscope enabled
+) // Returns 1 if configuration fits, else 0
+{
+	BUDGET_TYP budget_tab[NUM_BUDGET_MODS]; // Array of module budgets
+	int mod_cnt; // module counter
+	int fits = 1; // Flag cleared if any resource does NOT fit
+
+
+	build_budget_table( budget_tab ,num_mots );
+
+	printf("MOTOR_TILE budget for %d motor(s), xscope %s\n" ,num_mots ,(use_xscope ? "on" : "off") );
+	printf("  %-10s %6s %6s %6s %6s\n" ,"Module" ,"Thrd" ,"Chan" ,"Clk" ,"RAM" );
+
+	for (mod_cnt=0; mod_cnt<NUM_BUDGET_MODS; mod_cnt++)
+	{
+		printf("  %-10s %6d %6d %6d %6d\n" ,budget_tab[mod_cnt].name ,budget_tab[mod_cnt].threads
+			,budget_tab[mod_cnt].chanends ,budget_tab[mod_cnt].clk_blks ,budget_tab[mod_cnt].ram );
+	} // for mod_cnt
+
+	printf("  %-10s %6s %6d %6s %6d\n" ,"xscope/code" ,"" ,BUDGET_XSCOPE_CHANENDS(use_xscope) ,"" ,BUDGET_CODE_RAM );
+
+	fits &= check_one_resource( "Threads" ,BUDGET_TOTAL_THREADS(num_mots) ,BUDGET_TILE_THREADS );
+	fits &= check_one_resource( "Chanends" ,BUDGET_TOTAL_CHANENDS(num_mots ,use_xscope) ,BUDGET_TILE_CHANENDS );
+	fits &= check_one_resource( "Clk_Blks" ,BUDGET_TOTAL_CLK_BLKS(num_mots) ,BUDGET_TILE_CLK_BLKS );
+	fits &= check_one_resource( "RAM" ,BUDGET_TOTAL_RAM(num_mots) ,BUDGET_TILE_RAM );
+
+	printf("  Result: %s\n\n" ,(fits ? "FITS" : "FAILS") );
+
+	return fits;
+} // report_one_config
+/*****************************************************************************/
+int main(
+	int argc, // No. of command-line arguments
+	char * argv[] // Array of command-line arguments
+)
+{
+	int num_mots; // No. of motors
+	int use_xscope = 1; // Flag set if xscope enabled
+	int fits = 1; // Flag cleared if requested configuration does NOT fit
+	int sizes_ok; // Flag cleared if any budgeted structure size is wrong
+
+
+	sizes_ok = check_budget_sizes();
+
+	if (2 < argc)
+	{
+		use_xscope = atoi( argv[2] );
+	} // if (2 < argc)
+
+	if (1 < argc)
+	{
+		num_mots = atoi( argv[1] );
+
+		if (0 >= num_mots)
+		{
+			printf("ERROR: Number of motors must be positive\n");
+			return -1;
+		} // if (0 >= num_mots)
+
+		fits = report_one_config( num_mots ,use_xscope );
+	} // if (1 < argc)
+	else
+	{
+		for (num_mots=1; num_mots<=MAX_MODEL_MOTORS; num_mots++)
+		{
+			report_one_config( num_mots ,use_xscope );
+		} // for num_mots
+	} // else !(1 < argc)
+
+	return ((fits && sizes_ok) ? 0 : 1);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,62 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _FOC_BUDGET_MODEL_H_
+#define _FOC_BUDGET_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// NB Structures are sized for the __app_foc_demo configuration (see budget.mak)
+#include "pwm_common.h"
+#include "pwm_schedule.h"
+#include "pwm_server.h"
+#include "qei_decode.h"
+#include "hall_decode.h"
+#include "adc_7265.h"
+
+#include "foc_budget.h" // NB Included last, so application configuration takes precedence
+
+#define MAX_MODEL_MOTORS 4 // Largest No. of motors reported by default
+
+/** Different MOTOR_TILE modules */
+typedef enum BUDGET_MOD_ETAG
+{
+  BUDGET_CONTROL = 0,	// Motor-control engine
+  BUDGET_PWM,					// PWM servers
+  BUDGET_QEI,					// QEI server
+  BUDGET_HALL,				// Hall server
+  BUDGET_ADC,					// ADC server
+  NUM_BUDGET_MODS	// Handy Value!-)
+} BUDGET_MOD_ENUM;
+
+/** Structure containing the budgeted and measured size of one data structure */
+typedef struct BUDGET_SIZE_TAG
+{
+	const char * name; // Budget size name (see foc_budget.h)
+	int budget; // Budgeted size (bytes)
+	int measured; // Measured size: sizeof() (bytes)
+} BUDGET_SIZE_TYP;
+
+/** Structure containing resource usage for one module */
+typedef struct BUDGET_TAG
+{
+	const char * name; // Module name
+	int threads; // No. of threads
+	int chanends; // No. of channel-ends
+	int clk_blks; // No. of clock blocks
+	int ram; // Bytes of RAM
+} BUDGET_TYP;
+
+#endif /* _FOC_BUDGET_MODEL_H_ */
@@ -0,0 +1,21 @@
+# ansi C compile: Host check of Hall-interpolated angle estimator through start, reversal and stop
+
+MAIN =	hall_interp_model
+
+CMODS =	$(MAIN) \
+	hall_interp \
+	hall_decode \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	hall_interp.h \
+	hall_decode.h \
+	hall_common.h \
+
+INC_DIR = host_inc ../module_foc_hall/src ../module_foc_util/src ../__app_foc_demo/src
+
+OPT = -O2
+
+include host_model.mak
+
+#
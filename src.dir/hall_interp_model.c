@@ -0,0 +1,240 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "hall_interp_model.h"
+
+/* Host check of the Hall-interpolated angle estimator (see module_foc_hall/src/hall_interp.c)
+ * A motor is modelled following a piecewise-linear speed profile, and its Hall edges are fed to the Hall decoder (hall_decode.c),
+ * which supplies the Hall parameters to the estimator at every Client request. For each profile, the following are checked:-
+ *	Once the speed has settled, the velocity and interpolated angle estimates are close to the modelled values
+ *	The velocity estimate never has the wrong sign (e.g. after a reversal)
+ *	Once the motor has stopped for HALL_STOP_TICKS, the velocity estimate is zero
+ *	At the end of the profile, the calibrated sector boundaries are close to the modelled ones (NB A restart after a stop must NOT corrupt them)
+ *	After a skipped Hall state (e.g. a missed edge), the angle estimate re-synchronises to the correct electrical cycle,
+ *		including when the skip crosses the sector 5/0 boundary in either direction
+ * Usage: hall_interp_model.x
+ */
+
+// Test configurations: Name, Sector boundaries, Speed profile, Skipped Hall state (optional)
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "Start" ,{ 0 ,167 ,333 ,500 ,667 ,833 } ,3 ,{ { 0 ,0 } ,{ 200 ,1000 } ,{ 600 ,1000 } } }
+	,{ "Reversal" ,{ 0 ,167 ,333 ,500 ,667 ,833 } ,4 ,{ { 0 ,500 } ,{ 300 ,500 } ,{ 500 ,-500 } ,{ 900 ,-500 } } }
+	,{ "Stop/Restart" ,{ 0 ,167 ,333 ,500 ,667 ,833 } ,6 ,{ { 0 ,1000 } ,{ 300 ,1000 } ,{ 350 ,0 } ,{ 850 ,0 } ,{ 950 ,1000 } ,{ 1500 ,1000 } } }
+	,{ "Offset Sectors" ,{ 0 ,150 ,340 ,500 ,650 ,830 } ,3 ,{ { 0 ,0 } ,{ 100 ,2000 } ,{ 700 ,2000 } } }
+	,{ "Skip Sector 2" ,{ 0 ,167 ,333 ,500 ,667 ,833 } ,3 ,{ { 0 ,0 } ,{ 200 ,1000 } ,{ 800 ,1000 } } ,400 ,2 }
+	,{ "Skip Sector 0" ,{ 0 ,167 ,333 ,500 ,667 ,833 } ,3 ,{ { 0 ,0 } ,{ 200 ,1000 } ,{ 800 ,1000 } } ,400 ,0 }
+	,{ "Skip Sector 5" ,{ 0 ,167 ,333 ,500 ,667 ,833 } ,3 ,{ { 0 ,0 } ,{ 200 ,-1000 } ,{ 800 ,-1000 } } ,400 ,5 }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+/*****************************************************************************/
+static double model_speed( // Returns modelled speed at one time, and whether the speed has settled
+	const MODEL_CONFIG_TYP * cfg_p, // Pointer to test configuration
+	int sim_ticks, // Time since start of profile (in Reference Frequency Cycles)
+	int * settled // Pointer to flag set if speed has been constant for at least MODEL_SETTLE_MS
+) // Returns speed (RPM)
+{
+	const MODEL_POINT_TYP * prev_p; // Pointer to point at start of profile segment
+	const MODEL_POINT_TYP * next_p; // Pointer to point at end of profile segment
+	double seg_ms = (double)sim_ticks / (double)MODEL_TICKS_PER_MS; // Time (milli-seconds)
+	int pnt_cnt; // Point counter
+
+
+	// Find profile segment
+	for (pnt_cnt=1; pnt_cnt<(cfg_p->num_points - 1); pnt_cnt++)
+	{
+		if (seg_ms < cfg_p->points[pnt_cnt].time_ms) break;
+	} // for pnt_cnt
+
+	prev_p = &cfg_p->points[pnt_cnt - 1];
+	next_p = &cfg_p->points[pnt_cnt];
+
+	*settled = ((prev_p->rpm == next_p->rpm) && ((prev_p->time_ms + MODEL_SETTLE_MS) <= seg_ms));
+
+	return prev_p->rpm + (double)(next_p->rpm - prev_p->rpm) * (seg_ms - prev_p->time_ms) / (next_p->time_ms - prev_p->time_ms);
+} // model_speed
+/*****************************************************************************/
+static int find_sector( // Returns modelled sector for one electrical angle
+	const MODEL_CONFIG_TYP * cfg_p, // Pointer to test configuration
+	double elec_ang // Total electrical angle (in electrical cycles)
+)
+{
+	double frac_ang = elec_ang - floor( elec_ang ); // Angle within electrical cycle [0..1)
+	int sect_id = (NUM_HALL_SECTS - 1); // Preset to last sector
+
+
+	while ((frac_ang * 1000.0) < cfg_p->bounds[sect_id])
+	{
+		sect_id--;
+	} // while ((frac_ang * 1000.0) < cfg_p->bounds[sect_id])
+
+	return sect_id;
+} // find_sector
+/*****************************************************************************/
+static int test_one_config( // Run one speed profile through Hall decoder and Hall-interpolated angle estimator
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+{
+	static const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT; // Converts [CBA] Hall state to sector
+	HALL_DATA_TYP hall_s; // Hall decoder data (Server)
+	HALL_INTERP_TYP interp_s; // Hall-interpolated angle data (Client)
+	MODEL_ERRS_TYP errs = { 0 ,0 ,0 ,0 ,0 }; // Error counts
+	unsigned sect_vals[NUM_HALL_SECTS]; // Hall state for each sector
+	unsigned cur_time = MODEL_START_TIME; // Modelled timer value. NB Wraps during test
+	double elec_ang; // Modelled total electrical angle (in electrical cycles)
+	double speed; // Modelled speed (RPM)
+	int end_ticks = cfg_p->points[cfg_p->num_points - 1].time_ms * MODEL_TICKS_PER_MS; // Length of profile
+	int edge_ticks = 0; // Time of latest modelled Hall edge
+	int skip_ticks = -1; // Time of skipped Hall state (-1 if not yet skipped)
+	int skipping = 0; // Flag set while Hall state is being skipped
+	int sim_ticks; // Time since start of profile
+	int settled; // Flag set if modelled speed has settled
+	int cur_sect; // Modelled sector
+	int new_sect; // New modelled sector
+	int sect_cnt; // Sector counter
+	int err_val; // Error value
+
+
+	for (sect_cnt=0; sect_cnt<=HALL_PHASE_MASK; sect_cnt++)
+	{
+		if (0 <= hall_sects[sect_cnt]) sect_vals[hall_sects[sect_cnt]] = sect_cnt;
+	} // for sect_cnt
+
+	init_hall_decode( &hall_s ,0 );
+	init_hall_interp( &interp_s ,MODEL_ANG_PER_PAIR );
+
+	// Start in centre of sector 0 (where the estimator places an unknown initial position)
+	elec_ang = (double)cfg_p->bounds[1] / 2000.0;
+	cur_sect = find_sector( cfg_p ,elec_ang );
+	service_hall_input_pins( &hall_s ,(sect_vals[cur_sect] | HALL_NERR_MASK) ,cur_time );
+
+	for (sim_ticks=0; sim_ticks<end_ticks; sim_ticks += MODEL_SIM_TICKS)
+	{
+		speed = model_speed( cfg_p ,sim_ticks ,&settled );
+		elec_ang += speed * NUM_POLE_PAIRS * MODEL_SIM_TICKS / ((double)SECS_PER_MIN * (double)SECOND);
+		cur_time += MODEL_SIM_TICKS;
+
+		new_sect = find_sector( cfg_p ,elec_ang );
+
+		// Check for Hall state to skip (Once only). NB Hall pins stay in previous sector
+		if ((new_sect == cfg_p->skip_sect) && (cur_sect != new_sect) && (0 < cfg_p->skip_ms) && (0 > skip_ticks)
+			&& ((cfg_p->skip_ms * MODEL_TICKS_PER_MS) <= sim_ticks))
+		{
+			skip_ticks = sim_ticks;
+			skipping = 1;
+		} // if ((new_sect == cfg_p->skip_sect) && ...
+
+		if (skipping)
+		{
+			if (new_sect == cfg_p->skip_sect)
+			{
+				new_sect = cur_sect;
+			} // if (new_sect == cfg_p->skip_sect)
+			else
+			{
+				skipping = 0; // Skipped sector has been left
+			} // else !(new_sect == cfg_p->skip_sect)
+		} // if (skipping)
+
+		// Allow estimates to re-synchronise after skipped Hall state
+		if ((0 <= skip_ticks) && (sim_ticks < (skip_ticks + MODEL_SETTLE_MS * MODEL_TICKS_PER_MS)))
+		{
+			settled = 0;
+		} // if ((0 <= skip_ticks) && ...
+
+		// Check for Hall edge
+		if (new_sect != cur_sect)
+		{
+			service_hall_input_pins( &hall_s ,(sect_vals[new_sect] | HALL_NERR_MASK) ,cur_time );
+			cur_sect = new_sect;
+			edge_ticks = sim_ticks;
+		} // if (new_sect != cur_sect)
+
+		// Check for Client request
+		if (0 == (sim_ticks % MODEL_REQ_TICKS))
+		{
+			update_hall_client_params( &hall_s ,cur_time );
+			update_hall_interp( &interp_s ,&hall_s.params ,cur_time );
+
+			errs.checks++;
+
+			// Check velocity has correct sign
+			if ((MODEL_SIGN_RPM < fabs( speed )) && (0 > (interp_s.veloc * speed)))
+			{
+				errs.veloc++;
+			} // if ((MODEL_SIGN_RPM < fabs( speed )) && (0 > (interp_s.veloc * speed)))
+
+			if (settled)
+			{
+				if (0 == (int)speed)
+				{
+					// Check stopped motor has zero velocity
+					if (((HALL_STOP_TICKS + MODEL_REQ_TICKS) < (sim_ticks - edge_ticks)) && (0 != interp_s.veloc))
+					{
+						errs.stop++;
+					} // if (((HALL_STOP_TICKS + MODEL_REQ_TICKS) < (sim_ticks - edge_ticks)) && (0 != interp_s.veloc))
+				} // if (0 == (int)speed)
+				else
+				{
+					if ((fabs( speed ) * MODEL_VELOC_PERCENT / 100.0 + MODEL_VELOC_ERR) < fabs( interp_s.veloc - speed ))
+					{
+						errs.veloc++;
+					} // if ((fabs( speed ) * MODEL_VELOC_PERCENT / 100.0 + MODEL_VELOC_ERR) < fabs( interp_s.veloc - speed ))
+
+					if (MODEL_ANG_ERR < fabs( interp_s.tot_ang - elec_ang * MODEL_ANG_PER_PAIR ))
+					{
+						errs.angle++;
+					} // if (MODEL_ANG_ERR < fabs( interp_s.tot_ang - elec_ang * MODEL_ANG_PER_PAIR ))
+				} // else !(0 == (int)speed)
+			} // if (settled)
+		} // if (0 == (sim_ticks % MODEL_REQ_TICKS))
+	} // for sim_ticks
+
+	// Check calibrated sector boundaries
+	for (sect_cnt=0; sect_cnt<NUM_HALL_SECTS; sect_cnt++)
+	{
+		err_val = abs( interp_s.sect_ang[sect_cnt] - (cfg_p->bounds[sect_cnt] * MODEL_ANG_PER_PAIR + 500) / 1000 );
+		if (errs.calib < err_val) errs.calib = err_val;
+	} // for sect_cnt
+
+	err_val = errs.veloc + errs.angle + errs.stop + (MODEL_ANG_ERR < errs.calib) + (0 == interp_s.num_cals);
+
+	printf("  %-14s: %4d requests checked, %2d calibrations. Errors: Veloc=%d Angle=%d Stop=%d Calib=%d %s\n"
+		,cfg_p->name ,errs.checks ,interp_s.num_cals ,errs.veloc ,errs.angle ,errs.stop ,errs.calib
+		,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("Hall-interpolated angle tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,65 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HALL_INTERP_MODEL_H_
+#define _HALL_INTERP_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "hall_decode.h"
+#include "hall_interp.h"
+
+#define MODEL_ANG_PER_PAIR 1024 // No. of angle units per electrical cycle (Same as UQ_PER_PAIR of __app_foc_demo)
+#define MODEL_SIM_TICKS 50 // Simulation time-step (in Reference Frequency Cycles)
+#define MODEL_REQ_TICKS 6250 // Time between Client requests (16 kHz, in Reference Frequency Cycles)
+#define MODEL_START_TIME ((unsigned)(-SECOND)) // Initial timer value (so timer wrap-around is tested)
+#define MODEL_TICKS_PER_MS (SECOND / 1000) // No. of Reference Frequency Cycles per milli-second
+#define MODEL_SETTLE_MS 100 // Time allowed for estimates to settle, after a change in speed
+#define MODEL_MAX_POINTS 8 // Max. No. of points in a speed profile
+#define MODEL_VELOC_PERCENT 3 // Max. error in settled velocity estimate (per cent)
+#define MODEL_VELOC_ERR 10 // Additional max. error in settled velocity estimate (RPM)
+#define MODEL_ANG_ERR (MODEL_ANG_PER_PAIR / 64) // Max. error of settled interpolated angle (and of calibrated sector boundary)
+#define MODEL_SIGN_RPM 200 // Speed above which velocity estimate must NOT have the wrong sign
+
+/** Structure containing one point of a speed profile. NB Speed is linearly interpolated between points */
+typedef struct MODEL_POINT_TAG
+{
+	int time_ms; // Time of point (milli-seconds)
+	int rpm; // Mechanical speed at point (RPM)
+} MODEL_POINT_TYP;
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int bounds[NUM_HALL_SECTS]; // Actual start of each sector (per mille of an electrical cycle). NB Sector 0 starts at zero
+	int num_points; // No. of points in speed profile
+	MODEL_POINT_TYP points[MODEL_MAX_POINTS]; // Speed profile
+	int skip_ms; // Time after which one Hall state is skipped (0 if none)
+	int skip_sect; // Sector whose Hall state is skipped (NB Hall pins stay in previous sector)
+} MODEL_CONFIG_TYP;
+
+/** Structure containing error counts for one test */
+typedef struct MODEL_ERRS_TAG
+{
+	int checks; // No. of checked Client requests
+	int veloc; // No. of velocity errors (settled error too large, or wrong sign)
+	int angle; // No. of settled angle errors
+	int stop; // No. of requests where a stopped motor had a non-zero velocity estimate
+	int calib; // Max. error of calibrated sector boundary (angle units)
+} MODEL_ERRS_TYP;
+
+#endif /* _HALL_INTERP_MODEL_H_ */
@@ -0,0 +1,437 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "host_adc_test.h"
+
+/* Host version of app_test_adc (see generate_adc_tests.xc and check_adc_tests.xc)
+ * Generator: Raw ADC frames of 3-phase sinusoidal coil currents, with a DC offset per phase, and Gaussian noise.
+ * The PWM is off (zero current) for the 1st ADC_CALIB_SAMPS frames, while the offsets are calibrated.
+ * NB The noise is pseudo-random, but seeded per job, so every run gives the same results.
+ * Server: ADC pipeline of the ADC Server (module_foc_adc/src/adc_pipeline.c), with paced or non-paced Client requests.
+ * Checker: Checks calibrated offsets, each zero-mean value, the inferred phase (Zero-Sum), the mean error (Zero-Mean),
+ * and the spin direction.
+ */
+
+static void run_adc_job( HOST_JOB_TYP * job_p );
+
+const HOST_SUITE_TYP host_adc_suite = { "adc" ,"../app_test_adc/adc_tests.txt" ,NUM_ADC_OPTS ,NUMBER_OF_MOTORS ,0 ,run_adc_job };
+
+/*****************************************************************************/
+static int adc_offset( // DC offset of one ADC phase (NB Used by Generator and Checker)
+	int motor_id, // Unique motor identifier
+	int phase_id // ADC phase identifier
+) // Returns offset (in ADC units)
+{
+	return (23 + (41 * motor_id) - (17 * phase_id));
+} // adc_offset
+/*****************************************************************************/
+static double adc_gauss_noise( // Gaussian noise with unit variance (Box-Muller)
+	ADC_JOB_TYP * adc_job_p // Pointer to structure containing data for one ADC test job
+) // Returns noise value
+{
+	double uni_a; // 1st uniform value in range (0..1]
+	double uni_b; // 2nd uniform value in range (0..1]
+
+
+	// NB Linear congruential generator, so each job has its own repeatable sequence
+	adc_job_p->rand_state = 1664525u * adc_job_p->rand_state + 1013904223u;
+	uni_a = ((adc_job_p->rand_state >> 8) + 1.0) / 16777216.0;
+
+	adc_job_p->rand_state = 1664525u * adc_job_p->rand_state + 1013904223u;
+	uni_b = ((adc_job_p->rand_state >> 8) + 1.0) / 16777216.0;
+
+	return (sqrt( -2.0 * log( uni_a ) ) * cos( 2.0 * M_PI * uni_b ));
+} // adc_gauss_noise
+/*****************************************************************************/
+static void send_adc_vector( // Send new test vector (to Checker, via Server)
+	ADC_JOB_TYP * adc_job_p, // Pointer to structure containing data for one ADC test job
+	ADC_CNTRL_ENUM inp_cntrl // Control state of new vector
+)
+{
+	ADC_GEN_ITEM_TYP * item_p = &(adc_job_p->gen_item); // Pointer to Generator item
+
+
+	adc_job_p->vect[ADC_CNTRL] = inp_cntrl;
+
+	item_p->type = HOST_ITEM_VECT;
+	memcpy( item_p->vect ,adc_job_p->vect ,sizeof(item_p->vect) );
+	put_host_queue( &(adc_job_p->gen_q) ,item_p );
+} // send_adc_vector
+/*****************************************************************************/
+static void send_adc_frames( // Generate raw ADC frames, and send them (to Server)
+	ADC_JOB_TYP * adc_job_p, // Pointer to structure containing data for one ADC test job
+	int num_frames // No. of frames to send
+)
+{
+	ADC_GEN_ITEM_TYP * item_p = &(adc_job_p->gen_item); // Pointer to Generator item
+	int speed = ((ADC_FAST == adc_job_p->vect[ADC_SPEED]) ? ADC_HI_SPEED : ADC_LO_SPEED); // Speed (RPM)
+	double ang_inc; // Change of electrical angle per frame (radians)
+	int raw_val; // Raw ADC value
+	int frame_cnt; // Frame counter
+	int phase_cnt; // ADC Phase counter
+
+
+	ang_inc = (2.0 * M_PI * speed * NUM_POLE_PAIRS * ADC_FRAME_TICKS) / ((double)SECS_PER_MIN * SECOND);
+	ang_inc *= adc_job_p->vect[ADC_SPIN];
+
+	for (frame_cnt = 0; frame_cnt < num_frames; frame_cnt++)
+	{
+		adc_job_p->theta += ang_inc;
+
+		item_p->type = HOST_ITEM_DATA;
+		item_p->time += ADC_FRAME_TICKS; // NB unsigned wraps, like the target timer
+
+		// NB The 3 phases are 120 degrees apart, so sum to zero
+		for (phase_cnt = 0; phase_cnt < NUM_ADC_PHASES; phase_cnt++)
+		{
+			item_p->ideal[phase_cnt] = adc_job_p->amp * sin( adc_job_p->theta - ((2.0 * M_PI * phase_cnt) / NUM_ADC_PHASES) );
+		} // for phase_cnt
+
+		for (phase_cnt = 0; phase_cnt < MEAS_ADC_PHASES; phase_cnt++)
+		{
+			raw_val = adc_offset( adc_job_p->job_p->opts[ADC_OPT_MOTOR] ,phase_cnt )
+				+ (int)lround( item_p->ideal[phase_cnt] + (ADC_NOISE_SIGMA * adc_gauss_noise( adc_job_p )) );
+
+			// Clip to ADC range
+			if (ADC_MAX_VAL < raw_val) raw_val = ADC_MAX_VAL;
+			if (ADC_MIN_VAL > raw_val) raw_val = ADC_MIN_VAL;
+
+			item_p->raw_vals[phase_cnt] = raw_val;
+		} // for phase_cnt
+
+		put_host_queue( &(adc_job_p->gen_q) ,item_p );
+	} // for frame_cnt
+} // send_adc_frames
+/*****************************************************************************/
+static void send_adc_test( // Send one test: set-up frames (NOT checked), then checked frames
+	ADC_JOB_TYP * adc_job_p, // Pointer to structure containing data for one ADC test job
+	ADC_PACE_ENUM inp_pace, // Pacing of Client requests
+	int inp_spin, // Spin direction (1 = Clock-wise, -1 = Anti-clockwise)
+	ADC_GAIN_ENUM inp_gain, // Amplitude-state
+	ADC_SPEED_ENUM inp_speed // Speed-state
+)
+{
+	int cycle_frames; // No. of frames in one electrical cycle
+	int num_cycles; // No. of electrical cycles checked
+
+
+	adc_job_p->vect[ADC_PACE] = inp_pace;
+	adc_job_p->vect[ADC_SPIN] = inp_spin;
+	adc_job_p->vect[ADC_GAIN] = inp_gain;
+	adc_job_p->vect[ADC_SPEED] = inp_speed;
+	adc_job_p->amp = ((ADC_SMALL == inp_gain) ? ADC_SMALL_AMP : ADC_LARGE_AMP);
+
+	if (ADC_FAST == inp_speed)
+	{
+		cycle_frames = (int)(((double)SECS_PER_MIN * SECOND) / (ADC_HI_SPEED * NUM_POLE_PAIRS * ADC_FRAME_TICKS));
+		num_cycles = ADC_FAST_CYCLES;
+	} // if (ADC_FAST == inp_speed)
+	else
+	{
+		cycle_frames = (int)(((double)SECS_PER_MIN * SECOND) / (ADC_LO_SPEED * NUM_POLE_PAIRS * ADC_FRAME_TICKS));
+		num_cycles = ADC_SLOW_CYCLES;
+	} // else !(ADC_FAST == inp_speed)
+
+	send_adc_vector( adc_job_p ,ADC_SKIP );
+	send_adc_frames( adc_job_p ,ADC_SKIP_FRAMES );
+
+	send_adc_vector( adc_job_p ,ADC_VALID );
+	send_adc_frames( adc_job_p ,(num_cycles * cycle_frames) );
+} // send_adc_test
+/*****************************************************************************/
+static void * gen_adc_tests( // Generator thread: Generate ADC test data for one job
+	void * arg_p // Pointer to structure containing data for one ADC test job
+)
+{
+	ADC_JOB_TYP * adc_job_p = (ADC_JOB_TYP *)arg_p; // Pointer to structure containing data for one ADC test job
+	int * opts = adc_job_p->job_p->opts; // Array of test options
+
+
+	adc_job_p->rand_state = 0x5eed0000u + (unsigned)opts[ADC_OPT_MOTOR]; // NB Same noise for every run
+	adc_job_p->gen_item.time = 0u - ADC_WRAP_LEAD - (unsigned)(opts[ADC_OPT_MOTOR] * MILLI_SEC);
+
+	// Calibrate offsets with PWM off. NB Calibration is done for every job, and the offsets are checked
+	adc_job_p->vect[ADC_PACE] = ADC_NO_PACE;
+	adc_job_p->vect[ADC_SPIN] = 1;
+	adc_job_p->vect[ADC_GAIN] = ADC_SMALL;
+	adc_job_p->vect[ADC_SPEED] = ADC_FAST;
+	adc_job_p->amp = 0;
+	send_adc_vector( adc_job_p ,ADC_CALIB );
+	send_adc_frames( adc_job_p ,ADC_CALIB_SAMPS );
+
+	// Check if Small-gain test activated
+	if (opts[ADC_OPT_SMALL])
+	{
+		send_adc_test( adc_job_p ,ADC_NO_PACE ,1 ,ADC_SMALL ,ADC_FAST );
+	} // if (opts[ADC_OPT_SMALL])
+
+	// Check if Paced test activated
+	if (opts[ADC_OPT_PACE])
+	{
+		send_adc_test( adc_job_p ,ADC_PACE_ON ,-1 ,ADC_LARGE ,ADC_FAST );
+	} // if (opts[ADC_OPT_PACE])
+
+	// Check if Slow-speed test activated. NB Quick on host
+	if (opts[ADC_OPT_SLOW])
+	{
+		send_adc_test( adc_job_p ,ADC_NO_PACE ,1 ,ADC_LARGE ,ADC_SLOW );
+	} // if (opts[ADC_OPT_SLOW])
+
+	adc_job_p->gen_item.type = HOST_ITEM_STOP;
+	put_host_queue( &(adc_job_p->gen_q) ,&(adc_job_p->gen_item) );
+
+	return NULL;
+} // gen_adc_tests
+/*****************************************************************************/
+static void check_adc_values( // Check one set of zero-mean ADC values against ideal currents
+	HOST_JOB_TYP * job_p, // Pointer to test job
+	ADC_CHK_ITEM_TYP * chk_item_p, // Pointer to Checker item
+	double meas_vals[] // Array of ADC values for all phases, (output). NB Includes inferred phase
+)
+{
+	int phase_cnt; // ADC Phase counter
+
+
+	for (phase_cnt = 0; phase_cnt < MEAS_ADC_PHASES; phase_cnt++)
+	{
+		meas_vals[phase_cnt] = chk_item_p->adc_vals[phase_cnt];
+
+		host_check( job_p ,(ADC_ERR_LIM >= fabs( meas_vals[phase_cnt] - chk_item_p->ideal[phase_cnt] ))
+			,"Time=%u Phase_%c=%d, Expected %.1f" ,chk_item_p->time ,('A' + phase_cnt)
+			,chk_item_p->adc_vals[phase_cnt] ,chk_item_p->ideal[phase_cnt] );
+	} // for phase_cnt
+
+	// Check if a phase is inferred (Zero-Sum test)
+	if (MEAS_ADC_PHASES < NUM_ADC_PHASES)
+	{
+		meas_vals[ADC_PHASE_C] = -chk_item_p->adc_sum;
+
+		host_check( job_p ,((ADC_ERR_LIM << 1) >= fabs( meas_vals[ADC_PHASE_C] - chk_item_p->ideal[ADC_PHASE_C] ))
+			,"Time=%u Inferred Phase_C=%d, Expected %.1f" ,chk_item_p->time ,-chk_item_p->adc_sum ,chk_item_p->ideal[ADC_PHASE_C] );
+	} // if (MEAS_ADC_PHASES < NUM_ADC_PHASES)
+} // check_adc_values
+/*****************************************************************************/
+static void check_adc_segment( // Check accumulated results at end of one test vector
+	ADC_JOB_TYP * adc_job_p, // Pointer to structure containing data for one ADC test job
+	int vect[], // Test vector that has ended
+	ADC_CHK_ITEM_TYP * last_item_p, // Pointer to last Checker item of test vector
+	double err_sums[], // Array of accumulated errors for each phase
+	double cross_sum, // Accumulated cross-product of successive current vectors
+	int num_vals // No. of Client requests in test vector
+)
+{
+	HOST_JOB_TYP * job_p = adc_job_p->job_p; // Pointer to test job
+	int phase_cnt; // ADC Phase counter
+
+
+	if (0 == num_vals) return;
+
+	if (ADC_CALIB == vect[ADC_CNTRL])
+	{ // Check calibrated offsets
+		host_check( job_p ,(0 != last_item_p->calib_done) ,"Offset calibration NOT complete" );
+
+		for (phase_cnt = 0; phase_cnt < MEAS_ADC_PHASES; phase_cnt++)
+		{
+			host_check( job_p ,(ADC_MEAN_LIM >= abs( last_item_p->means[phase_cnt] - adc_offset( job_p->opts[ADC_OPT_MOTOR] ,phase_cnt ) ))
+				,"Phase_%c Offset=%d, Expected %d" ,('A' + phase_cnt) ,last_item_p->means[phase_cnt]
+				,adc_offset( job_p->opts[ADC_OPT_MOTOR] ,phase_cnt ) );
+		} // for phase_cnt
+	} // if (ADC_CALIB == vect[ADC_CNTRL])
+
+	if (ADC_VALID == vect[ADC_CNTRL])
+	{ // Check Zero-Mean error, and Spin direction
+		for (phase_cnt = 0; phase_cnt < NUM_ADC_PHASES; phase_cnt++)
+		{
+			host_check( job_p ,(ADC_MEAN_LIM >= fabs( err_sums[phase_cnt] / num_vals ))
+				,"Phase_%c Mean error=%.2f" ,('A' + phase_cnt) ,(err_sums[phase_cnt] / num_vals) );
+		} // for phase_cnt
+
+		host_check( job_p ,(0 < (vect[ADC_SPIN] * cross_sum)) ,"Rotation NOT in spin direction %d" ,vect[ADC_SPIN] );
+	} // if (ADC_VALID == vect[ADC_CNTRL])
+} // check_adc_segment
+/*****************************************************************************/
+static void * check_adc_tests( // Checker thread: Check ADC values for one job
+	void * arg_p // Pointer to structure containing data for one ADC test job
+)
+{
+	ADC_JOB_TYP * adc_job_p = (ADC_JOB_TYP *)arg_p; // Pointer to structure containing data for one ADC test job
+	ADC_CHK_ITEM_TYP chk_item; // Checker item
+	ADC_CHK_ITEM_TYP last_item; // Last Checker item of current test vector
+	int vect[NUM_ADC_COMPS]; // Current test vector
+	double meas_vals[NUM_ADC_PHASES]; // ADC values for all phases (NB Includes inferred phase)
+	double err_sums[NUM_ADC_PHASES]; // Accumulated errors for each phase
+	double alpha = 0; // Alpha component of current vector (Clarke transform)
+	double beta = 0; // Beta component of current vector (Clarke transform)
+	double prev_alpha = 0; // Previous Alpha component
+	double prev_beta = 0; // Previous Beta component
+	double cross_sum = 0; // Accumulated cross-product of successive current vectors. NB Sign gives spin
+	int num_vals = 0; // No. of Client requests in current test vector
+	int phase_cnt; // ADC Phase counter
+
+
+	memset( vect ,0 ,sizeof(vect) );
+	memset( err_sums ,0 ,sizeof(err_sums) );
+	vect[ADC_CNTRL] = ADC_SKIP; // NB Skip until 1st vector
+
+	for (;;)
+	{
+		get_host_queue( &(adc_job_p->chk_q) ,&chk_item );
+
+		if (HOST_ITEM_DATA != chk_item.type)
+		{ // End of current test vector
+			check_adc_segment( adc_job_p ,vect ,&last_item ,err_sums ,cross_sum ,num_vals );
+
+			if (HOST_ITEM_STOP == chk_item.type) break;
+
+			memcpy( vect ,chk_item.vect ,sizeof(vect) );
+			memset( err_sums ,0 ,sizeof(err_sums) );
+			cross_sum = 0;
+			num_vals = 0;
+
+			continue;
+		} // if (HOST_ITEM_DATA != chk_item.type)
+
+		last_item = chk_item;
+
+		if (ADC_VALID == vect[ADC_CNTRL])
+		{
+			check_adc_values( adc_job_p->job_p ,&chk_item ,meas_vals );
+
+			for (phase_cnt = 0; phase_cnt < NUM_ADC_PHASES; phase_cnt++)
+			{
+				err_sums[phase_cnt] += meas_vals[phase_cnt] - chk_item.ideal[phase_cnt];
+			} // for phase_cnt
+
+			alpha = meas_vals[ADC_PHASE_A];
+			beta = (meas_vals[ADC_PHASE_A] + 2.0 * meas_vals[ADC_PHASE_B]) / sqrt( 3.0 );
+
+			if (0 < num_vals)
+			{
+				cross_sum += (prev_alpha * beta) - (prev_beta * alpha);
+			} // if (0 < num_vals)
+
+			prev_alpha = alpha;
+			prev_beta = beta;
+		} // if (ADC_VALID == vect[ADC_CNTRL])
+
+		num_vals++;
+	} // for (;;)
+
+	return NULL;
+} // check_adc_tests
+/*****************************************************************************/
+static void send_adc_client_params( // Answer one Client request with latest zero-mean ADC values
+	ADC_JOB_TYP * adc_job_p, // Pointer to structure containing data for one ADC test job
+	ADC_GEN_ITEM_TYP * frame_p, // Pointer to latest frame
+	unsigned req_time // Time of Client request
+)
+{
+	ADC_CHK_ITEM_TYP chk_item; // Checker item
+	int phase_cnt; // ADC Phase counter
+
+
+	chk_item.type = HOST_ITEM_DATA;
+	chk_item.adc_sum = get_adc_pipeline_vals( &(adc_job_p->pipe) ,chk_item.adc_vals );
+	chk_item.calib_done = adc_job_p->pipe.calib_done;
+
+	for (phase_cnt = 0; phase_cnt < MEAS_ADC_PHASES; phase_cnt++)
+	{
+		chk_item.means[phase_cnt] = adc_job_p->pipe.phase_data[phase_cnt].mean;
+	} // for phase_cnt
+
+	memcpy( chk_item.ideal ,frame_p->ideal ,sizeof(chk_item.ideal) );
+	chk_item.time = req_time;
+	put_host_queue( &(adc_job_p->chk_q) ,&chk_item );
+} // send_adc_client_params
+/*****************************************************************************/
+static void serve_adc_tests( // Server: Process raw ADC frames, and answer Client requests
+	ADC_JOB_TYP * adc_job_p // Pointer to structure containing data for one ADC test job
+)
+{
+	ADC_GEN_ITEM_TYP gen_item; // Generator item
+	ADC_CHK_ITEM_TYP chk_item; // Checker item
+	unsigned req_time = 0; // Time of next Client request
+	unsigned req_ticks = ADC_FRAME_TICKS; // Time between Client requests
+	int started = 0; // Flag set once 1st frame received
+
+
+	// NB Same configuration as ADC Server, except trigger delay is NOT swept (see adc_delay_model.c)
+	init_adc_pipeline( &(adc_job_p->pipe) ,MEAS_ADC_PHASES ,ADC_FILTER ,0 ,(ADC_FRAME_TICKS >> 1) ,(ADC_FRAME_TICKS >> 4) );
+	start_adc_pipeline_calib( &(adc_job_p->pipe) );
+
+	for (;;)
+	{
+		get_host_queue( &(adc_job_p->gen_q) ,&gen_item );
+
+		if (HOST_ITEM_DATA != gen_item.type)
+		{ // Forward test vector, or end of test
+			chk_item.type = gen_item.type;
+			memcpy( chk_item.vect ,gen_item.vect ,sizeof(chk_item.vect) );
+			put_host_queue( &(adc_job_p->chk_q) ,&chk_item );
+
+			if (HOST_ITEM_STOP == gen_item.type) break;
+
+			// NB Client (pace) rate is part of test vector
+			req_ticks = ((ADC_PACE_ON == gen_item.vect[ADC_PACE]) ? ADC_PACE_TICKS : ADC_FRAME_TICKS);
+			continue;
+		} // if (HOST_ITEM_DATA != gen_item.type)
+
+		if (0 == started)
+		{
+			req_time = gen_item.time + (ADC_FRAME_TICKS >> 1);
+			started = 1;
+		} // if (0 == started)
+
+		process_adc_frame( &(adc_job_p->pipe) ,gen_item.raw_vals );
+
+		// Answer all Client requests made before next frame. NB int handles wrap-around
+		while (0 < (int)(gen_item.time + ADC_FRAME_TICKS - req_time))
+		{
+			send_adc_client_params( adc_job_p ,&gen_item ,req_time );
+			req_time += req_ticks;
+		} // while (0 < (int)(gen_item.time + ADC_FRAME_TICKS - req_time))
+	} // for (;;)
+} // serve_adc_tests
+/*****************************************************************************/
+static void run_adc_job( // Run Generator, Server and Checker for one ADC test job
+	HOST_JOB_TYP * job_p // Pointer to test job
+)
+{
+	ADC_JOB_TYP adc_job_s; // Structure containing data for one ADC test job
+	pthread_t gen_thread; // Generator thread
+	pthread_t chk_thread; // Checker thread
+
+
+	memset( &adc_job_s ,0 ,sizeof(ADC_JOB_TYP) );
+	adc_job_s.job_p = job_p;
+
+	if ((0 != init_host_queue( &(adc_job_s.gen_q) ,sizeof(ADC_GEN_ITEM_TYP) ,HOST_QUEUE_DEPTH ))
+		|| (0 != init_host_queue( &(adc_job_s.chk_q) ,sizeof(ADC_CHK_ITEM_TYP) ,HOST_QUEUE_DEPTH )))
+	{
+		host_check( job_p ,0 ,"Allocating queues" );
+		return;
+	} // if ((0 != init_host_queue( &(adc_job_s.gen_q) ,...
+
+	host_spawn( &gen_thread ,gen_adc_tests ,&adc_job_s );
+	host_spawn( &chk_thread ,check_adc_tests ,&adc_job_s );
+
+	serve_adc_tests( &adc_job_s ); // NB Server runs on worker thread
+
+	pthread_join( gen_thread ,NULL );
+	pthread_join( chk_thread ,NULL );
+
+	free_host_queue( &(adc_job_s.chk_q) );
+	free_host_queue( &(adc_job_s.gen_q) );
+} // run_adc_job
+/*****************************************************************************/
@@ -0,0 +1,132 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_ADC_TEST_H_
+#define _HOST_ADC_TEST_H_
+
+#include <math.h>
+
+#include "host_tests.h"
+#include "adc_common.h"
+#include "adc_pipeline.h"
+
+// NB Test values match app_test_adc (see test_adc_common.h)
+#define ADC_HI_SPEED MAX_SPEC_RPM // Fast speed (RPM)
+#define ADC_LO_SPEED 100 // Slow speed (RPM)
+#define ADC_FRAME_TICKS (40 * MICRO_SEC) // Time between ADC frames (PWM triggers)
+#define ADC_PACE_TICKS ((3 * ADC_FRAME_TICKS) >> 1) // Time between paced Client requests
+#define ADC_SMALL_AMP 32 // Small amplitude of coil current (in ADC units)
+#define ADC_LARGE_AMP 1900 // Large amplitude of coil current (in ADC units). NB Leaves head-room for offset and noise
+#define ADC_MAX_VAL 2047 // Max. 12-bit ADC value (see ADC_ACTIVE_BITS)
+#define ADC_MIN_VAL (-ADC_MAX_VAL - 1) // Min. 12-bit ADC value
+#define ADC_NOISE_SIGMA 2.0 // Standard deviation of ADC noise
+#define ADC_ERR_LIM 14 // Max. error of one ADC value (6 sigma, plus rounding and offset error)
+#define ADC_MEAN_LIM 1 // Max. error of mean ADC value over one test
+#define ADC_SKIP_FRAMES 16 // No. of set-up frames after each change of test vector
+#define ADC_FAST_CYCLES 4 // No. of electrical cycles checked at Fast speed
+#define ADC_SLOW_CYCLES 1 // No. of electrical cycles checked at Slow speed (NB ~3750 frames)
+#define ADC_WRAP_LEAD (SECOND >> 8) // Virtual timer starts this long before it wraps (so wrap-around is tested)
+
+/** Different ADC test options (see adc_tests.txt) */
+typedef enum ADC_OPT_ETAG
+{
+  ADC_OPT_MOTOR = 0,	// Select which motor to test
+  ADC_OPT_SMALL,			// Small-Gain tests (Also tests Non-Paced, Fast-Speed, and Clockwise)
+  ADC_OPT_PACE,				// Paced tests (Also tests Large-Gain, Fast-Speed, and Anti-Clockwise)
+  ADC_OPT_SLOW,				// Slow speed Tests (Also tests Non-Paced, Large-Gain, and Clockwise)
+  NUM_ADC_OPTS				// Handy Value!-)
+} ADC_OPT_ENUM;
+
+/** Different components of ADC test vector */
+typedef enum ADC_COMP_ETAG
+{
+  ADC_CNTRL = 0,	// Control state (see ADC_CNTRL_ENUM)
+  ADC_PACE,				// Pacing of Client requests (see ADC_PACE_ENUM)
+  ADC_SPIN,				// Spin-state (1 = Clock-wise, -1 = Anti-clockwise)
+  ADC_GAIN,				// Amplitude-state (see ADC_GAIN_ENUM)
+  ADC_SPEED,			// Speed-state (see ADC_SPEED_ENUM)
+  NUM_ADC_COMPS		// Handy Value!-)
+} ADC_COMP_ENUM;
+
+/** Different ADC Control states */
+typedef enum ADC_CNTRL_ETAG
+{
+  ADC_CALIB = 0,	// Offset calibration (PWM off, so NO current). Offsets checked at end
+  ADC_SKIP,				// Skip checks (test set-up)
+  ADC_VALID,			// Valid test
+  NUM_ADC_CNTRLS	// Handy Value!-)
+} ADC_CNTRL_ENUM;
+
+/** Different ADC Pacing states */
+typedef enum ADC_PACE_ETAG
+{
+  ADC_NO_PACE = 0,	// One Client request per frame
+  ADC_PACE_ON,			// Client requests paced to ADC_PACE_TICKS
+  NUM_ADC_PACES			// Handy Value!-)
+} ADC_PACE_ENUM;
+
+/** Different ADC Amplitude states */
+typedef enum ADC_GAIN_ETAG
+{
+  ADC_SMALL = 0,	// Small Amplitude
+  ADC_LARGE,			// Large Amplitude
+  NUM_ADC_GAINS		// Handy Value!-)
+} ADC_GAIN_ENUM;
+
+/** Different ADC Speed states */
+typedef enum ADC_SPEED_ETAG
+{
+  ADC_SLOW = 0,	// Slow Speed
+  ADC_FAST,			// Fast Speed
+  NUM_ADC_SPEEDS	// Handy Value!-)
+} ADC_SPEED_ENUM;
+
+/** Structure containing one item sent from Generator to Server (NB replaces ADC chip and test-vector channel) */
+typedef struct ADC_GEN_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_ADC_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	int raw_vals[MEAS_ADC_PHASES]; // Raw ADC frame (NB Includes offsets and noise)
+	double ideal[NUM_ADC_PHASES]; // Ideal coil currents for frame (NB Only used by Checker)
+	unsigned time; // Time of PWM trigger
+} ADC_GEN_ITEM_TYP;
+
+/** Structure containing one item sent from Server to Checker (NB replaces ADC Client channel) */
+typedef struct ADC_CHK_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_ADC_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	int adc_vals[MEAS_ADC_PHASES]; // Zero-mean ADC values returned to Client
+	int adc_sum; // Sum of zero-mean ADC values
+	int means[MEAS_ADC_PHASES]; // Calibrated offsets of pipeline
+	int calib_done; // Flag set when offsets calibrated
+	double ideal[NUM_ADC_PHASES]; // Ideal coil currents of latest frame
+	unsigned time; // Time of Client request
+} ADC_CHK_ITEM_TYP;
+
+/** Structure containing all data for one ADC test job */
+typedef struct ADC_JOB_TAG
+{
+	HOST_JOB_TYP * job_p; // Pointer to test job
+	HOST_QUEUE_TYP gen_q; // Queue from Generator to Server
+	HOST_QUEUE_TYP chk_q; // Queue from Server to Checker
+	ADC_PIPE_TYP pipe; // ADC pipeline for motor under test (Server)
+	ADC_GEN_ITEM_TYP gen_item; // Current Generator item
+	int vect[NUM_ADC_COMPS]; // Current test vector (Generator)
+	double theta; // Electrical angle (Generator)
+	double amp; // Amplitude of coil current (Generator)
+	unsigned rand_state; // State of pseudo-random noise generator (Generator)
+} ADC_JOB_TYP;
+
+#endif /* _HOST_ADC_TEST_H_ */
@@ -0,0 +1,321 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "host_hall_test.h"
+
+/* Host version of app_test_hall (see generate_hall_tests.xc and check_hall_tests.xc)
+ * Generator: Steps the Hall sensor through its sectors, at a fixed period for each speed-state, with optional error-bit.
+ * Server: Hall decoding of the Hall Server (module_foc_hall/src/hall_decode.c), with a Client request every HALL_REQ_TICKS.
+ * Checker: Checks error-status, phase change, spin direction and speed of each set of Hall parameters.
+ * NB A request only sees the Hall edges before it. So the parameters requested under a new test vector,
+ * are those after the last edge of the previous vector.
+ */
+
+static void run_hall_job( HOST_JOB_TYP * job_p );
+
+const HOST_SUITE_TYP host_hall_suite = { "hall" ,"../app_test_hall/hall_tests.txt" ,NUM_HALL_OPTS ,NUMBER_OF_MOTORS ,0 ,run_hall_job };
+
+/*****************************************************************************/
+static unsigned hall_speed_to_ticks( // Convert Velocity (in RPM) to ticks per Hall position
+	int speed // input speed
+) // Returns time in ticks
+{
+	return ((TICKS_PER_MIN_PER_HALL + (unsigned)(speed >> 1)) / (unsigned)speed);
+}	// hall_speed_to_ticks
+/*****************************************************************************/
+static void send_hall_vector( // Send new test vector (to Checker, via Server)
+	HALL_JOB_TYP * hall_job_p, // Pointer to structure containing data for one Hall test job
+	HALL_CNTRL_ENUM inp_cntrl // Control state of new vector
+)
+{
+	HALL_GEN_ITEM_TYP * item_p = &(hall_job_p->gen_item); // Pointer to Generator item
+
+
+	hall_job_p->vect[HALL_CNTRL] = inp_cntrl;
+
+	item_p->type = HOST_ITEM_VECT;
+	memcpy( item_p->vect ,hall_job_p->vect ,sizeof(item_p->vect) );
+	put_host_queue( &(hall_job_p->gen_q) ,item_p );
+} // send_hall_vector
+/*****************************************************************************/
+static void send_hall_edges( // Step Hall sensor through sectors, and send each new Hall value (to Server)
+	HALL_JOB_TYP * hall_job_p, // Pointer to structure containing data for one Hall test job
+	int num_edges // No. of Hall edges to send
+)
+{
+	HALL_GEN_ITEM_TYP * item_p = &(hall_job_p->gen_item); // Pointer to Generator item
+	int edge_cnt; // Hall edge counter
+
+
+	for (edge_cnt = 0; edge_cnt < num_edges; edge_cnt++)
+	{
+		hall_job_p->sect += hall_job_p->vect[HALL_SPIN];
+
+		// Wrap Hall sector
+		if (0 > hall_job_p->sect)
+		{
+			hall_job_p->sect += NUM_HALL_SECTS;
+		} // if (0 > hall_job_p->sect)
+
+		if (NUM_HALL_SECTS <= hall_job_p->sect)
+		{
+			hall_job_p->sect -= NUM_HALL_SECTS;
+		} // if (NUM_HALL_SECTS <= hall_job_p->sect)
+
+		item_p->type = HOST_ITEM_DATA;
+		item_p->time += hall_job_p->period; // NB unsigned wraps, like the target timer
+		item_p->pins = (unsigned)hall_job_p->phases[hall_job_p->sect];
+
+		// NB Error-bit is active low
+		if (HALL_ERR_OFF == hall_job_p->vect[HALL_ERROR])
+		{
+			item_p->pins |= HALL_NERR_MASK;
+		} // if (HALL_ERR_OFF == hall_job_p->vect[HALL_ERROR])
+
+		put_host_queue( &(hall_job_p->gen_q) ,item_p );
+	} // for edge_cnt
+} // send_hall_edges
+/*****************************************************************************/
+static void send_hall_test( // Send one test: set-up edges (NOT checked), then checked edges
+	HALL_JOB_TYP * hall_job_p, // Pointer to structure containing data for one Hall test job
+	int skip_edges, // No. of set-up edges
+	int valid_edges // No. of checked edges
+)
+{
+	send_hall_vector( hall_job_p ,HALL_SKIP );
+	send_hall_edges( hall_job_p ,skip_edges );
+
+	send_hall_vector( hall_job_p ,HALL_VALID );
+	send_hall_edges( hall_job_p ,valid_edges );
+} // send_hall_test
+/*****************************************************************************/
+static void * gen_hall_tests( // Generator thread: Generate Hall test data for one job
+	void * arg_p // Pointer to structure containing data for one Hall test job
+)
+{
+	HALL_JOB_TYP * hall_job_p = (HALL_JOB_TYP *)arg_p; // Pointer to structure containing data for one Hall test job
+	int * opts = hall_job_p->job_p->opts; // Array of test options
+	const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT; // Table converting Hall value to sector
+	int val_cnt; // Hall value counter
+
+
+	// Invert look-up table, to get Hall value of each sector
+	for (val_cnt = 0; val_cnt <= HALL_PHASE_MASK; val_cnt++)
+	{
+		if (0 <= hall_sects[val_cnt])
+		{
+			hall_job_p->phases[hall_sects[val_cnt]] = val_cnt;
+		} // if (0 <= hall_sects[val_cnt])
+	} // for val_cnt
+
+	hall_job_p->vect[HALL_ERROR] = HALL_ERR_OFF;
+	hall_job_p->vect[HALL_SPIN] = 1;
+	hall_job_p->vect[HALL_SPEED] = HALL_FAST;
+	hall_job_p->period = hall_speed_to_ticks( HALL_HIGH_SPEED );
+	hall_job_p->sect = opts[HALL_OPT_MOTOR]; // NB Each motor starts in a different sector
+	hall_job_p->gen_item.time = 0u - HALL_WRAP_LEAD - (unsigned)(opts[HALL_OPT_MOTOR] * MILLI_SEC);
+
+	send_hall_test( hall_job_p ,3 ,(HALL_MAX_TESTS >> 1) ); // NB Spin unknown at 1st edge, so speed unknown until 3rd edge
+
+	// Check if Error-status test activated
+	if (opts[HALL_OPT_ERROR])
+	{ // NB Server needs MAX_HALL_STATUS_ERR consecutive errors (or non-errors) to change error-status
+		hall_job_p->vect[HALL_ERROR] = HALL_ERR_ON;
+		send_hall_test( hall_job_p ,MAX_HALL_STATUS_ERR ,MAX_HALL_STATUS_ERR );
+
+		hall_job_p->vect[HALL_ERROR] = HALL_ERR_OFF;
+		send_hall_test( hall_job_p ,MAX_HALL_STATUS_ERR ,MAX_HALL_STATUS_ERR );
+	} // if (opts[HALL_OPT_ERROR])
+	else
+	{
+		send_hall_test( hall_job_p ,0 ,(HALL_MAX_TESTS >> 1) );
+	} // else !(opts[HALL_OPT_ERROR])
+
+	// Check if Negative-spin test activated
+	if (opts[HALL_OPT_NEGA])
+	{ // NB Speed is unknown until 2nd edge after reversal
+		hall_job_p->vect[HALL_SPIN] = -1;
+		send_hall_test( hall_job_p ,2 ,(HALL_MAX_TESTS >> 1) );
+	} // if (opts[HALL_OPT_NEGA])
+
+	// Slow speed test. NB Virtual timer wraps during this test
+	hall_job_p->vect[HALL_SPEED] = HALL_SLOW;
+	hall_job_p->period = hall_speed_to_ticks( HALL_LOW_SPEED );
+	send_hall_test( hall_job_p ,2 ,HALL_MIN_TESTS );
+
+	hall_job_p->gen_item.type = HOST_ITEM_STOP;
+	put_host_queue( &(hall_job_p->gen_q) ,&(hall_job_p->gen_item) );
+
+	return NULL;
+} // gen_hall_tests
+/*****************************************************************************/
+static void check_hall_params( // Check one set of Hall parameters against test vector
+	HOST_JOB_TYP * job_p, // Pointer to test job
+	int vect[], // Current test vector
+	HALL_PARAM_TYP * params_p, // Pointer to Hall parameters
+	unsigned prev_val, // Hall value at previous request
+	unsigned req_time // Time of Client request
+)
+{
+	const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT; // Table converting Hall value to sector
+	int spin = vect[HALL_SPIN]; // Expected spin direction
+	int speed = ((HALL_FAST == vect[HALL_SPEED]) ? HALL_HIGH_SPEED : HALL_LOW_SPEED); // Expected speed magnitude
+	int diff_sect; // Change in sector since previous request
+
+
+	host_check( job_p ,(vect[HALL_ERROR] == params_p->err) ,"Time=%u Error-status=%d, Expected %d"
+		,req_time ,params_p->err ,vect[HALL_ERROR] );
+
+	host_check( job_p ,(spin == params_p->dir) ,"Time=%u Spin=%d, Expected %d" ,req_time ,params_p->dir ,spin );
+
+	host_check( job_p ,((speed >> HALL_SPEED_ERR_BITS) >= abs( params_p->veloc - (spin * speed) ))
+		,"Time=%u Velocity=%d, Expected %d" ,req_time ,params_p->veloc ,(spin * speed) );
+
+	// Check for phase change
+	if (prev_val != params_p->hall_val)
+	{
+		diff_sect = hall_sects[params_p->hall_val & HALL_PHASE_MASK] - hall_sects[prev_val & HALL_PHASE_MASK];
+
+		if (0 > diff_sect)
+		{
+			diff_sect += NUM_HALL_SECTS;
+		} // if (0 > diff_sect)
+
+		host_check( job_p ,(((0 < spin) ? 1 : (NUM_HALL_SECTS - 1)) == diff_sect)
+			,"Time=%u Phase change %u -> %u, NOT in spin direction %d" ,req_time ,prev_val ,params_p->hall_val ,spin );
+
+		host_check( job_p ,((1 == params_p->num_edges) && (0 == params_p->lost_edges)
+			&& (params_p->hall_val == params_p->edges[0].hall_val) && (params_p->edge_time == params_p->edges[0].time)
+			&& (params_p->dir == params_p->edges[0].dir) && (params_p->period == params_p->edges[0].period))
+			,"Time=%u Edge batch: %d edges, %d lost" ,req_time ,params_p->num_edges ,params_p->lost_edges );
+	} // if (prev_val != params_p->hall_val)
+} // check_hall_params
+/*****************************************************************************/
+static void * check_hall_tests( // Checker thread: Check Hall parameters for one job
+	void * arg_p // Pointer to structure containing data for one Hall test job
+)
+{
+	HALL_JOB_TYP * hall_job_p = (HALL_JOB_TYP *)arg_p; // Pointer to structure containing data for one Hall test job
+	HALL_CHK_ITEM_TYP chk_item; // Checker item
+	int vect[NUM_HALL_COMPS]; // Current test vector
+	unsigned prev_val = 0; // Hall value at previous request
+
+
+	memset( vect ,0 ,sizeof(vect) ); // NB Skip until 1st vector
+
+	for (;;)
+	{
+		get_host_queue( &(hall_job_p->chk_q) ,&chk_item );
+
+		if (HOST_ITEM_STOP == chk_item.type) break;
+
+		if (HOST_ITEM_VECT == chk_item.type)
+		{
+			memcpy( vect ,chk_item.vect ,sizeof(vect) );
+		} // if (HOST_ITEM_VECT == chk_item.type)
+		else
+		{
+			if (HALL_VALID == vect[HALL_CNTRL])
+			{
+				check_hall_params( hall_job_p->job_p ,vect ,&(chk_item.params) ,prev_val ,chk_item.time );
+			} // if (HALL_VALID == vect[HALL_CNTRL])
+
+			prev_val = chk_item.params.hall_val;
+		} // else !(HOST_ITEM_VECT == chk_item.type)
+	} // for (;;)
+
+	return NULL;
+} // check_hall_tests
+/*****************************************************************************/
+static void serve_hall_tests( // Server: Decode Hall data, and answer Client requests
+	HALL_JOB_TYP * hall_job_p // Pointer to structure containing data for one Hall test job
+)
+{
+	HALL_GEN_ITEM_TYP gen_item; // Generator item
+	HALL_CHK_ITEM_TYP chk_item; // Checker item
+	unsigned req_time = 0; // Time of next Client request
+	int started = 0; // Flag set once 1st Hall value received
+
+
+	init_hall_decode( &(hall_job_p->hall_data) ,hall_job_p->job_p->opts[HALL_OPT_MOTOR] );
+
+	for (;;)
+	{
+		get_host_queue( &(hall_job_p->gen_q) ,&gen_item );
+
+		if (HOST_ITEM_DATA != gen_item.type)
+		{ // Forward test vector, or end of test
+			chk_item.type = gen_item.type;
+			memcpy( chk_item.vect ,gen_item.vect ,sizeof(chk_item.vect) );
+			put_host_queue( &(hall_job_p->chk_q) ,&chk_item );
+
+			if (HOST_ITEM_STOP == gen_item.type) break;
+
+			continue;
+		} // if (HOST_ITEM_DATA != gen_item.type)
+
+		if (0 == started)
+		{
+			req_time = gen_item.time + HALL_REQ_TICKS;
+			started = 1;
+		} // if (0 == started)
+
+		// Answer all Client requests made before this change on input pins. NB int handles wrap-around
+		while (0 < (int)(gen_item.time - req_time))
+		{
+			update_hall_client_params( &(hall_job_p->hall_data) ,req_time );
+
+			chk_item.type = HOST_ITEM_DATA;
+			chk_item.params = hall_job_p->hall_data.params;
+			chk_item.time = req_time;
+			put_host_queue( &(hall_job_p->chk_q) ,&chk_item );
+
+			req_time += HALL_REQ_TICKS;
+		} // while (0 < (int)(gen_item.time - req_time))
+
+		service_hall_input_pins( &(hall_job_p->hall_data) ,gen_item.pins ,gen_item.time );
+	} // for (;;)
+} // serve_hall_tests
+/*****************************************************************************/
+static void run_hall_job( // Run Generator, Server and Checker for one Hall test job
+	HOST_JOB_TYP * job_p // Pointer to test job
+)
+{
+	HALL_JOB_TYP hall_job_s; // Structure containing data for one Hall test job
+	pthread_t gen_thread; // Generator thread
+	pthread_t chk_thread; // Checker thread
+
+
+	memset( &hall_job_s ,0 ,sizeof(HALL_JOB_TYP) );
+	hall_job_s.job_p = job_p;
+
+	if ((0 != init_host_queue( &(hall_job_s.gen_q) ,sizeof(HALL_GEN_ITEM_TYP) ,HOST_QUEUE_DEPTH ))
+		|| (0 != init_host_queue( &(hall_job_s.chk_q) ,sizeof(HALL_CHK_ITEM_TYP) ,HOST_QUEUE_DEPTH )))
+	{
+		host_check( job_p ,0 ,"Allocating queues" );
+		return;
+	} // if ((0 != init_host_queue( &(hall_job_s.gen_q) ,...
+
+	host_spawn( &gen_thread ,gen_hall_tests ,&hall_job_s );
+	host_spawn( &chk_thread ,check_hall_tests ,&hall_job_s );
+
+	serve_hall_tests( &hall_job_s ); // NB Server runs on worker thread
+
+	pthread_join( gen_thread ,NULL );
+	pthread_join( chk_thread ,NULL );
+
+	free_host_queue( &(hall_job_s.chk_q) );
+	free_host_queue( &(hall_job_s.gen_q) );
+} // run_hall_job
+/*****************************************************************************/
@@ -0,0 +1,97 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_HALL_TEST_H_
+#define _HOST_HALL_TEST_H_
+
+#include "host_tests.h"
+#include "hall_decode.h"
+
+// NB Test values match app_test_hall (see test_hall_common.h and generate_hall_tests.h)
+#define HALL_HIGH_SPEED 4000 // Fast speed (RPM)
+#define HALL_LOW_SPEED 50 // Slow speed (RPM)
+#define HALL_MAX_TESTS 18 // No. of Hall edges used for Max. speed check
+#define HALL_MIN_TESTS 3 // No. of Hall edges used for Min. speed check
+#define HALL_SPEED_ERR_BITS 4 // Speed error must be less than 1/16 of test speed
+#define HALL_REQ_TICKS (40 * MICRO_SEC) // Time between Client requests for Hall parameters
+#define HALL_WRAP_LEAD (SECOND >> 4) // Virtual timer starts this long before it wraps (so wrap-around is tested)
+
+/** Different Hall test options (see hall_tests.txt) */
+typedef enum HALL_OPT_ETAG
+{
+  HALL_OPT_MOTOR = 0,	// Select which motor to test
+  HALL_OPT_NEGA,			// Test Negative spin
+  HALL_OPT_ERROR,			// Test Error-Status
+  NUM_HALL_OPTS				// Handy Value!-)
+} HALL_OPT_ENUM;
+
+/** Different components of Hall test vector (NB Same as app_test_hall, except Phase-change is always checked) */
+typedef enum HALL_COMP_ETAG
+{
+  HALL_CNTRL = 0,	// Control state (see HALL_CNTRL_ENUM)
+  HALL_ERROR,			// Error-state (see ERROR_HALL_ENUM)
+  HALL_SPIN,			// Spin-state (1 = Positive, -1 = Negative)
+  HALL_SPEED,			// Speed-state (see HALL_SPEED_ENUM)
+  NUM_HALL_COMPS	// Handy Value!-)
+} HALL_COMP_ENUM;
+
+/** Different Hall Control states */
+typedef enum HALL_CNTRL_ETAG
+{
+  HALL_SKIP = 0,	// Skip checks (test set-up)
+  HALL_VALID,			// Valid test
+  NUM_HALL_CNTRLS	// Handy Value!-)
+} HALL_CNTRL_ENUM;
+
+/** Different Hall Speed states */
+typedef enum HALL_SPEED_ETAG
+{
+  HALL_FAST = 0,	// Constant Fast Speed
+  HALL_SLOW,			// Constant Slow Speed
+  NUM_HALL_SPEEDS	// Handy Value!-)
+} HALL_SPEED_ENUM;
+
+/** Structure containing one item sent from Generator to Server (NB replaces Hall port and test-vector channel) */
+typedef struct HALL_GEN_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_HALL_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	unsigned pins; // New value on Hall input pins
+	unsigned time; // Time-stamp of change on input pins
+} HALL_GEN_ITEM_TYP;
+
+/** Structure containing one item sent from Server to Checker (NB replaces Hall Client channel) */
+typedef struct HALL_CHK_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_HALL_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	HALL_PARAM_TYP params; // Hall parameters returned to Client
+	unsigned time; // Time of Client request
+} HALL_CHK_ITEM_TYP;
+
+/** Structure containing all data for one Hall test job */
+typedef struct HALL_JOB_TAG
+{
+	HOST_JOB_TYP * job_p; // Pointer to test job
+	HOST_QUEUE_TYP gen_q; // Queue from Generator to Server
+	HOST_QUEUE_TYP chk_q; // Queue from Server to Checker
+	HALL_DATA_TYP hall_data; // Hall data for motor under test (Server)
+	HALL_GEN_ITEM_TYP gen_item; // Current Generator item
+	int phases[NUM_HALL_SECTS]; // Array of Hall phase values, in positive spin order (Generator)
+	int vect[NUM_HALL_COMPS]; // Current test vector (Generator)
+	int sect; // Current Hall sector (Generator)
+	unsigned period; // Time between Hall edges (Generator)
+} HALL_JOB_TYP;
+
+#endif /* _HOST_HALL_TEST_H_ */
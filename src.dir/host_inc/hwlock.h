@@ -0,0 +1,20 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_HWLOCK_H_
+#define _HOST_HWLOCK_H_
+
+/* Host stand-in for the XMOS hwlock.h: Empty, as host models are single-threaded */
+
+#endif /* _HOST_HWLOCK_H_ */
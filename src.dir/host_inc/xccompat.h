@@ -0,0 +1,24 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_XCCOMPAT_H_
+#define _HOST_XCCOMPAT_H_
+
+/* Host stand-in for the XMOS xccompat.h: Only the definitions used by C modules compiled into host models */
+
+#define REFERENCE_PARAM( type ,name ) type * name // XC reference becomes C pointer
+
+typedef unsigned chanend; // NB Channels are NOT used by host models
+
+#endif /* _HOST_XCCOMPAT_H_ */
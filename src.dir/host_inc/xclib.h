@@ -0,0 +1,39 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_XCLIB_H_
+#define _HOST_XCLIB_H_
+
+/* Host stand-in for the XMOS xclib.h: Only the definitions used by C modules compiled into host models */
+
+/*****************************************************************************/
+static inline unsigned bitrev( // Reverse the bit order of a 32-bit word (Same as XS1 instruction)
+	unsigned inp_val // Input value
+) // Returns bit-reversed value
+{
+	unsigned out_val = 0; // Output value
+	int bit_cnt; // bit counter
+
+
+	for (bit_cnt = 0; bit_cnt < 32; bit_cnt++)
+	{
+		out_val = (out_val << 1) | (inp_val & 1);
+		inp_val >>= 1;
+	} // for bit_cnt
+
+	return out_val;
+} // bitrev
+/*****************************************************************************/
+
+#endif /* _HOST_XCLIB_H_ */
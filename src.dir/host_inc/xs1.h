@@ -0,0 +1,24 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_XS1_H_
+#define _HOST_XS1_H_
+
+/* Host stand-in for the XMOS xs1.h: Host models do NOT use ports, timers or channels.
+ * A timer is declared only so that server structures containing one can be sized (see foc_budget_model.c)
+ */
+
+typedef unsigned timer; // Timer resource identifier (NB One word, as on XS1)
+
+#endif /* _HOST_XS1_H_ */
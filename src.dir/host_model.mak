@@ -0,0 +1,67 @@
+# ansi C compile: Rules shared by the host-side models and tests in src.dir
+#
+# Each model makefile sets the following, then includes this file:-
+#	MAIN: Main module (and executable) name
+#	CMODS: Modules to compile (NB Include $(MAIN))
+#	CINCS: Common include files (NB triggers recompilation of all source)
+#	INC_DIR: Include directories (NB host_inc contains host stand-ins for the XMOS headers)
+# and optionally:-
+#	SRC_DIR: Source directories (default INC_DIR). LIBS: Extra libraries. OPT: Optimisation. CONF: Configuration flags
+#	CHECK_ARGS: Command-line arguments used by the 'check' target
+#
+# Targets: Executable (default), 'check' (runs executable, and fails if any check fails: e.g. for Continuous Integration), 'clean'
+
+# get Operating System
+OS = $(shell uname)
+
+SRC_DIR ?= $(INC_DIR)
+
+vpath %.c $(SRC_DIR)
+vpath %.h $(SRC_DIR)
+
+# NB Each makefile has its own object directory, as modules are compiled with different flags and include paths
+OBJ_DIR = $(OS).dir/$(MAIN)
+EXE_DIR = $(OS).dir
+
+# Compiler command, recorded so that objects are rebuilt when it changes (e.g. make OPT=-O0)
+FLAG_FILE = $(OBJ_DIR)/cflags.txt
+
+EXE = $(MAIN:%=$(EXE_DIR)/%.x)
+
+COBJS   = $(CMODS:%=$(OBJ_DIR)/%.o)
+FLIBS   = $(LIBS:%=-l%) -lm
+FINCS   = $(INC_DIR:%=-I%)
+
+CC = gcc
+
+# This section assigns CFLAGS ...
+
+CFLAGS = $(OPT) -Wall $(CONF)
+
+LDFLAGS = $(FLDIRS)
+
+# NB Objects also depend on the makefiles, as these hold the module list and include paths
+MAK_FILES := $(MAKEFILE_LIST)
+
+$(EXE):	$(COBJS)
+	$(LINK.c) $(COBJS) $(FLIBS) -o $(EXE)
+
+$(COBJS) : $(OBJ_DIR)/%.o: %.c %.h $(CINCS) $(FLAG_FILE) $(MAK_FILES)
+	$(CC) -c $(FINCS) $(CFLAGS) $< -o $@
+
+check:	$(EXE)
+	$(EXE) $(CHECK_ARGS)
+
+$(FLAG_FILE): FORCE
+	@mkdir -p $(OBJ_DIR)
+	@echo '$(CC) $(CFLAGS)' | cmp -s - $@ || echo '$(CC) $(CFLAGS)' > $@
+
+FORCE:
+
+clean:
+	\rm -f $(OBJ_DIR)/*.o $(FLAG_FILE)
+	\rm -f $(EXE)
+
+.PHONY: check clean FORCE
+
+#
@@ -0,0 +1,555 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "host_pwm_test.h"
+
+/* Host version of app_test_pwm (see generate_pwm_tests.xc and check_pwm_tests.xc)
+ * Generator: Sends the widths of app_test_pwm (scaled to each selectable PWM period), with optional dead-time compensation.
+ * Server: Width conversion and edge schedule of the PWM Server (module_foc_pwm/src/pwm_convert_width.c and pwm_schedule.c).
+ * Checker: Replays the scheduled loads on a model of the Hi-leg and Lo-leg ports of the phase under test
+ *	(as in pwm_wave_model.c), then checks loads, width, centre, dead-time, ADC trigger and effective (compensated) width.
+ * NB The ports start in the safe state, and hold their value between periods, so every period is replayed,
+ * but only periods of a valid test vector are checked.
+ */
+
+static void run_pwm_job( HOST_JOB_TYP * job_p );
+
+const HOST_SUITE_TYP host_pwm_suite = { "pwm" ,"../app_test_pwm/pwm_tests.txt" ,NUM_PWM_OPTS ,NUM_PWM_PHASES ,1 ,run_pwm_job };
+
+/*****************************************************************************/
+static unsigned pwm_test_width( // Returns demanded width for one width-state, at one PWM period (see test_pwm_common.h)
+	PWM_TIMING_TYP * timing_p, // Pointer to structure containing timing values for selected PWM period
+	PWM_WIDTH_ENUM wid_state // Width-state
+)
+{
+	unsigned small_wid = (1 << ((PORT_RES_BITS + timing_p->res_bits - 1) >> 1)); // NB Geometric mean of MINI and EQUAL widths
+
+
+	switch( wid_state )
+	{
+		case PWM_MINI :
+			return PWM_PORT_WID;
+		break; // case PWM_MINI
+
+		case PWM_SMALL :
+			return small_wid;
+		break; // case PWM_SMALL
+
+		case PWM_EQUAL :
+			return timing_p->half_max;
+		break; // case PWM_EQUAL
+
+		case PWM_LARGE :
+			return (timing_p->max_value - small_wid);
+		break; // case PWM_LARGE
+
+		default : // PWM_MAXI
+			return (timing_p->max_value - PWM_DEAD_TIME - PWM_PORT_WID - 1);
+		break; // default
+	} // switch( wid_state )
+} // pwm_test_width
+/*****************************************************************************/
+static void send_pwm_vector( // Send new test vector (to Checker, via Server)
+	PWM_JOB_TYP * pwm_job_p, // Pointer to structure containing data for one PWM test job
+	PWM_CNTRL_ENUM inp_cntrl // Control state of new vector
+)
+{
+	PWM_GEN_ITEM_TYP * item_p = &(pwm_job_p->gen_item); // Pointer to Generator item
+
+
+	pwm_job_p->vect[PWM_CNTRL] = inp_cntrl;
+
+	item_p->type = HOST_ITEM_VECT;
+	memcpy( item_p->vect ,pwm_job_p->vect ,sizeof(item_p->vect) );
+	put_host_queue( &(pwm_job_p->gen_q) ,item_p );
+} // send_pwm_vector
+/*****************************************************************************/
+static void send_pwm_widths( // Send PWM widths for a number of PWM periods (to Server)
+	PWM_JOB_TYP * pwm_job_p, // Pointer to structure containing data for one PWM test job
+	int num_periods // No. of PWM periods
+)
+{
+	PWM_GEN_ITEM_TYP * item_p = &(pwm_job_p->gen_item); // Pointer to Generator item
+	PWM_COMMS_TYP * comms_p = &(pwm_job_p->gen_comms); // Pointer to Client communication data
+	int phase = pwm_job_p->job_p->opts[PWM_OPT_PHASE]; // Phase under test
+	int period_cnt; // PWM period counter
+	int phase_cnt; // phase counter
+
+
+	item_p->type = HOST_ITEM_DATA;
+	item_p->demand = (int)pwm_test_width( &(comms_p->timing) ,pwm_job_p->vect[PWM_WIDTH] );
+
+	for (period_cnt = 0; period_cnt < num_periods; period_cnt++)
+	{
+		// NB Like app_test_pwm, only the phase under test is driven
+		for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+		{
+			comms_p->params.widths[phase_cnt] = 0;
+		} // for phase_cnt
+
+		comms_p->params.widths[phase] = (unsigned)item_p->demand;
+
+		if (PWM_NO_COMP != pwm_job_p->vect[PWM_COMP])
+		{
+			compensate_dead_time( comms_p ,pwm_job_p->currs ,PWM_COMP_BAND );
+		} // if (PWM_NO_COMP != pwm_job_p->vect[PWM_COMP])
+
+		memcpy( item_p->widths ,comms_p->params.widths ,sizeof(item_p->widths) );
+		put_host_queue( &(pwm_job_p->gen_q) ,item_p );
+	} // for period_cnt
+} // send_pwm_widths
+/*****************************************************************************/
+static void send_pwm_test( // Send one test: set-up periods (NOT checked), then checked periods
+	PWM_JOB_TYP * pwm_job_p, // Pointer to structure containing data for one PWM test job
+	PWM_WIDTH_ENUM wid_state // Width-state
+)
+{
+	pwm_job_p->vect[PWM_WIDTH] = wid_state;
+
+	send_pwm_vector( pwm_job_p ,PWM_SKIP );
+	send_pwm_widths( pwm_job_p ,PWM_SKIP_TESTS );
+
+	send_pwm_vector( pwm_job_p ,PWM_VALID );
+	send_pwm_widths( pwm_job_p ,PWM_MAX_TESTS );
+} // send_pwm_test
+/*****************************************************************************/
+static void send_pwm_comp_tests( // Send dead-time compensation tests for one modelled phase-current
+	PWM_JOB_TYP * pwm_job_p, // Pointer to structure containing data for one PWM test job
+	PWM_CURR_ENUM curr_state // Compensation state
+)
+{
+	static const int comp_currs[NUM_PWM_CURRS] = { 0 ,PWM_COMP_CURR ,PWM_COMP_HALF ,0 ,-PWM_COMP_HALF ,-PWM_COMP_CURR }; // Current for each state
+	int phase = pwm_job_p->job_p->opts[PWM_OPT_PHASE]; // Phase under test
+	int phase_cnt; // phase counter
+
+
+	// NB Other phases carry large positive current, so their (zero) widths are NOT corrected
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		pwm_job_p->currs[phase_cnt] = PWM_COMP_CURR;
+	} // for phase_cnt
+
+	pwm_job_p->currs[phase] = comp_currs[curr_state];
+
+	pwm_job_p->vect[PWM_COMP] = curr_state;
+	send_pwm_test( pwm_job_p ,PWM_SMALL );
+	send_pwm_test( pwm_job_p ,PWM_LARGE );
+
+	pwm_job_p->vect[PWM_COMP] = PWM_NO_COMP;
+} // send_pwm_comp_tests
+/*****************************************************************************/
+static void * gen_pwm_tests( // Generator thread: Generate PWM test data for one job
+	void * arg_p // Pointer to structure containing data for one PWM test job
+)
+{
+	PWM_JOB_TYP * pwm_job_p = (PWM_JOB_TYP *)arg_p; // Pointer to structure containing data for one PWM test job
+	int * opts = pwm_job_p->job_p->opts; // Array of test options
+	int period_cnt; // PWM period-selection counter
+	int curr_cnt; // Compensation state counter
+
+
+	pwm_job_p->vect[PWM_ADC] = opts[PWM_OPT_ADC];
+	pwm_job_p->vect[PWM_COMP] = PWM_NO_COMP;
+
+	// NB app_test_pwm only tests the default period. Here every selectable period is tested
+	for (period_cnt = 0; period_cnt < NUM_PWM_PERIODS; period_cnt++)
+	{
+		pwm_job_p->vect[PWM_PERIOD] = period_cnt;
+		init_pwm_timing( &(pwm_job_p->gen_comms.timing) ,period_cnt );
+
+		if (opts[PWM_OPT_NARROW])
+		{
+			send_pwm_test( pwm_job_p ,PWM_MINI );
+		} // if (opts[PWM_OPT_NARROW])
+
+		send_pwm_test( pwm_job_p ,PWM_SMALL );
+
+		if (opts[PWM_OPT_EQUAL])
+		{
+			send_pwm_test( pwm_job_p ,PWM_EQUAL );
+		} // if (opts[PWM_OPT_EQUAL])
+
+		send_pwm_test( pwm_job_p ,PWM_LARGE );
+
+		if (opts[PWM_OPT_NARROW])
+		{
+			send_pwm_test( pwm_job_p ,PWM_MAXI );
+		} // if (opts[PWM_OPT_NARROW])
+
+		if (opts[PWM_OPT_COMP])
+		{
+			for (curr_cnt = (PWM_NO_COMP + 1); curr_cnt < NUM_PWM_CURRS; curr_cnt++)
+			{
+				send_pwm_comp_tests( pwm_job_p ,curr_cnt );
+			} // for curr_cnt
+		} // if (opts[PWM_OPT_COMP])
+	} // for period_cnt
+
+	pwm_job_p->gen_item.type = HOST_ITEM_STOP;
+	put_host_queue( &(pwm_job_p->gen_q) ,&(pwm_job_p->gen_item) );
+
+	return NULL;
+} // gen_pwm_tests
+/*****************************************************************************/
+static void load_host_port( // Model one timed load of a 32-bit buffered port
+	PWM_HOST_PORT_TYP * port_p, // Pointer to structure containing state of one modelled port
+	unsigned win_start, // Time at start of current PWM period
+	int num_bits, // No. of port bits in PWM period
+	unsigned load_time, // Port time of load
+	unsigned pattern // Bit-pattern written to port
+)
+{
+	int off = (int)(load_time - win_start); // Offset of load into current PWM period. NB int handles wrap-around
+	int bit_cnt; // bit counter
+
+
+	// Check load is inside this period, and does NOT overlap previous load
+	if ((0 > off) || (num_bits < (off + PWM_PORT_WID)) || (0 > (int)(load_time - port_p->free_time)))
+	{
+		port_p->load_err = 1;
+	} // if ((0 > off) || ...
+
+	// Shift out pattern, LS-bit first, then hold MS-bit until next load
+	port_p->hold = (pattern >> (PWM_PORT_WID - 1)) & 1;
+
+	for (bit_cnt = off; bit_cnt < num_bits; bit_cnt++)
+	{
+		if (0 <= bit_cnt)
+		{
+			if (bit_cnt < (off + PWM_PORT_WID))
+			{
+				port_p->bits[bit_cnt] = (unsigned char)((pattern >> (bit_cnt - off)) & 1);
+			} // if (bit_cnt < (off + PWM_PORT_WID))
+			else
+			{
+				port_p->bits[bit_cnt] = (unsigned char)port_p->hold;
+			} // else !(bit_cnt < (off + PWM_PORT_WID))
+		} // if (0 <= bit_cnt)
+	} // for bit_cnt
+
+	port_p->free_time = load_time + PWM_PORT_WID;
+} // load_host_port
+/*****************************************************************************/
+static void measure_host_pulse( // Measure pulse in one PWM period of one port
+	PWM_HOST_PORT_TYP * port_p, // Pointer to structure containing state of one modelled port
+	int num_bits, // No. of port bits in PWM period
+	PWM_HOST_PULSE_TYP * pulse_p // Pointer to structure containing measured pulse
+)
+{
+	int half_max = (num_bits >> 1); // Offset of reference time into PWM period
+	unsigned prev_bit = 0; // Previous port value
+	int bit_cnt; // bit counter
+
+
+	memset( pulse_p ,0 ,sizeof(PWM_HOST_PULSE_TYP) );
+
+	for (bit_cnt = 0; bit_cnt < num_bits; bit_cnt++)
+	{
+		if (port_p->bits[bit_cnt])
+		{
+			if (0 == pulse_p->ones)
+			{
+				pulse_p->first = bit_cnt - half_max;
+			} // if (0 == pulse_p->ones)
+
+			if (0 == prev_bit)
+			{
+				pulse_p->runs++; // Start of new pulse
+			} // if (0 == prev_bit)
+
+			pulse_p->last = bit_cnt - half_max;
+			pulse_p->ones++;
+		} // if (port_p->bits[bit_cnt])
+
+		prev_bit = port_p->bits[bit_cnt];
+	} // for bit_cnt
+} // measure_host_pulse
+/*****************************************************************************/
+static void check_pwm_period( // Replay scheduled loads for one PWM period, and check them against test vector
+	PWM_JOB_TYP * pwm_job_p, // Pointer to structure containing data for one PWM test job
+	int vect[], // Current test vector
+	PWM_CHK_ITEM_TYP * item_p // Pointer to Checker item
+)
+{
+	/* Expected values for each compensation state (see PWM_CURR_ENUM). NB Linear correction inside the band, so zero current gets half
+	 *	comp_quarts: Reduction of Hi-leg width (in quarters of dead-time)
+	 *	curr_signs: Sign of modelled phase-current
+	 *	eff_quarts: Residual error in effective width (in quarters of dead-time). NB Only zero outside the band
+	 */
+	static const int comp_quarts[NUM_PWM_CURRS] = { 0 ,0 ,1 ,2 ,3 ,4 };
+	static const int curr_signs[NUM_PWM_CURRS] = { 0 ,1 ,1 ,0 ,-1 ,-1 };
+	static const int eff_quarts[NUM_PWM_CURRS] = { 0 ,0 ,-1 ,0 ,1 ,0 };
+	HOST_JOB_TYP * job_p = pwm_job_p->job_p; // Pointer to test job
+	int phase = job_p->opts[PWM_OPT_PHASE]; // Phase under test
+	PWM_TIMING_TYP timing_s; // Timing values for selected PWM period
+	PWM_EVENT_TYP * event_p; // Pointer to scheduled event
+	int num_bits; // No. of port bits in PWM period
+	unsigned win_start; // Time at start of current PWM period
+	PWM_HOST_PULSE_TYP pulses[NUM_PWM_LEGS]; // Measured pulse, for each leg
+	int hi_wid; // Expected Hi-leg width
+	int lo_wid; // Expected Lo-leg width
+	int eff_wid; // Measured effective width
+	int adc_cnt = 0; // No. of ADC triggers found
+	int build_cnt = 0; // No. of rebuild events found
+	int sorted = 1; // Flag cleared if events NOT in order of ready time
+	int event_cnt; // event counter
+	int leg_cnt; // leg counter
+
+
+	init_pwm_timing( &timing_s ,vect[PWM_PERIOD] );
+	num_bits = (int)timing_s.max_value;
+
+	// NB Expected widths are built from the demand, independently of the compensation arithmetic
+	hi_wid = item_p->demand - comp_quarts[vect[PWM_COMP]] * PWM_DEAD_QUART;
+	lo_wid = hi_wid + PWM_DEAD_TIME;
+
+	win_start = item_p->ref_time - timing_s.half_max;
+
+	// Port holds value from previous period
+	for (leg_cnt = 0; leg_cnt < NUM_PWM_LEGS; leg_cnt++)
+	{
+		memset( pwm_job_p->ports[leg_cnt].bits ,(int)pwm_job_p->ports[leg_cnt].hold ,num_bits );
+		pwm_job_p->ports[leg_cnt].load_err = 0;
+	} // for leg_cnt
+
+	// NB Issue events in schedule order, like the Server
+	for (event_cnt = 0; event_cnt < item_p->num_events; event_cnt++)
+	{
+		event_p = &(item_p->events[event_cnt]);
+
+		if ((0 < event_cnt) && (0 > (int)(event_p->ready - item_p->events[event_cnt - 1].ready)))
+		{
+			sorted = 0;
+		} // if ((0 < event_cnt) && ...
+
+		if (PWM_EVENT_ADC == event_p->port_id)
+		{
+			host_check( job_p ,(0 == (int)(event_p->time - (item_p->ref_time - timing_s.quart_max)))
+				,"Ref=%u ADC trigger at %u, Expected %u" ,item_p->ref_time ,event_p->time ,(item_p->ref_time - timing_s.quart_max) );
+
+			adc_cnt++;
+		} // if (PWM_EVENT_ADC == event_p->port_id)
+
+		if (PWM_EVENT_BUILD == event_p->port_id)
+		{
+			build_cnt++;
+		} // if (PWM_EVENT_BUILD == event_p->port_id)
+
+		for (leg_cnt = 0; leg_cnt < NUM_PWM_LEGS; leg_cnt++)
+		{
+			if (PWM_PORT_ID( leg_cnt ,phase ) == event_p->port_id)
+			{
+				load_host_port( &(pwm_job_p->ports[leg_cnt]) ,win_start ,num_bits ,event_p->time ,event_p->pattern );
+			} // if (PWM_PORT_ID( leg_cnt ,phase ) == event_p->port_id)
+		} // for leg_cnt
+	} // for event_cnt
+
+	if (PWM_VALID != vect[PWM_CNTRL]) return;
+
+	for (leg_cnt = 0; leg_cnt < NUM_PWM_LEGS; leg_cnt++)
+	{
+		measure_host_pulse( &(pwm_job_p->ports[leg_cnt]) ,num_bits ,&(pulses[leg_cnt]) );
+	} // for leg_cnt
+
+	host_check( job_p ,(sorted && (1 == build_cnt))
+		,"Ref=%u Edge schedule NOT in issue order, or %d rebuilds (Expected 1)" ,item_p->ref_time ,build_cnt );
+
+	host_check( job_p ,((0 == pwm_job_p->ports[PWM_HI_LEG].load_err) && (0 == pwm_job_p->ports[PWM_LO_LEG].load_err))
+		,"Ref=%u Width=%d Port load overlaps, or outside PWM period" ,item_p->ref_time ,hi_wid );
+
+	host_check( job_p ,((hi_wid == pulses[PWM_HI_LEG].ones) && (lo_wid == pulses[PWM_LO_LEG].ones)
+		&& (1 == pulses[PWM_HI_LEG].runs) && (1 == pulses[PWM_LO_LEG].runs))
+		,"Ref=%u Width=%d Hi=%d ones in %d pulses, Lo=%d ones in %d pulses" ,item_p->ref_time ,hi_wid
+		,pulses[PWM_HI_LEG].ones ,pulses[PWM_HI_LEG].runs ,pulses[PWM_LO_LEG].ones ,pulses[PWM_LO_LEG].runs );
+
+	// NB Centre may be half a bit early, when the width is odd
+	host_check( job_p ,((1 >= abs( pulses[PWM_HI_LEG].first + pulses[PWM_HI_LEG].last + 1 ))
+		&& (1 >= abs( pulses[PWM_LO_LEG].first + pulses[PWM_LO_LEG].last + 1 )))
+		,"Ref=%u Width=%d Pulses NOT centred: Hi=[%d..%d] Lo=[%d..%d]" ,item_p->ref_time ,hi_wid
+		,pulses[PWM_HI_LEG].first ,pulses[PWM_HI_LEG].last ,pulses[PWM_LO_LEG].first ,pulses[PWM_LO_LEG].last );
+
+	host_check( job_p ,(((pulses[PWM_HI_LEG].first - pulses[PWM_LO_LEG].first) >= HALF_DEAD_TIME)
+		&& ((pulses[PWM_LO_LEG].last - pulses[PWM_HI_LEG].last) >= HALF_DEAD_TIME))
+		,"Ref=%u Width=%d Dead-time too short: Hi=[%d..%d] Lo=[%d..%d]" ,item_p->ref_time ,hi_wid
+		,pulses[PWM_HI_LEG].first ,pulses[PWM_HI_LEG].last ,pulses[PWM_LO_LEG].first ,pulses[PWM_LO_LEG].last );
+
+	if (vect[PWM_ADC])
+	{
+		host_check( job_p ,(1 == adc_cnt) ,"Ref=%u %d ADC triggers, Expected 1" ,item_p->ref_time ,adc_cnt );
+	} // if (vect[PWM_ADC])
+
+	if (PWM_NO_COMP == vect[PWM_COMP]) return;
+
+	/* Sign convention: During the dead-time, positive current (into motor) holds the phase low, and negative current holds it high.
+	 * So the effective width is the measured Hi-leg width for positive current, the measured Lo-leg width (Lo-leg off) for negative current,
+	 * and is taken as their mean at zero current. Outside the compensation band this must equal the demand.
+	 */
+	switch( curr_signs[vect[PWM_COMP]] )
+	{
+		case 1 :
+			eff_wid = pulses[PWM_HI_LEG].ones;
+		break; // case 1
+
+		case -1 :
+			eff_wid = pulses[PWM_LO_LEG].ones;
+		break; // case -1
+
+		default :
+			eff_wid = (pulses[PWM_HI_LEG].ones + pulses[PWM_LO_LEG].ones + 1) >> 1;
+		break; // default
+	} // switch( curr_signs[vect[PWM_COMP]] )
+
+	host_check( job_p ,(1 >= abs( eff_wid - (item_p->demand + eff_quarts[vect[PWM_COMP]] * PWM_DEAD_QUART) ))
+		,"Ref=%u Effective width=%d, Demand %d, Expected error %d quarter dead-times" ,item_p->ref_time ,eff_wid ,item_p->demand
+		,eff_quarts[vect[PWM_COMP]] );
+} // check_pwm_period
+/*****************************************************************************/
+static void * check_pwm_tests( // Checker thread: Check PWM port data for one job
+	void * arg_p // Pointer to structure containing data for one PWM test job
+)
+{
+	PWM_JOB_TYP * pwm_job_p = (PWM_JOB_TYP *)arg_p; // Pointer to structure containing data for one PWM test job
+	PWM_CHK_ITEM_TYP * chk_item_p; // Pointer to Checker item (NB Large, so NOT on thread stack)
+	int vect[NUM_PWM_COMPS]; // Current test vector
+
+
+	chk_item_p = (PWM_CHK_ITEM_TYP *)malloc( sizeof(PWM_CHK_ITEM_TYP) );
+
+	if (NULL == chk_item_p)
+	{
+		host_check( pwm_job_p->job_p ,0 ,"Allocating Checker item" );
+		exit(1); // NB Server would block on full queue
+	} // if (NULL == chk_item_p)
+
+	memset( vect ,0 ,sizeof(vect) ); // NB Skip until 1st vector
+
+	// Ports start in safe state (Hi-leg off, Lo-leg high)
+	pwm_job_p->ports[PWM_HI_LEG].hold = 0;
+	pwm_job_p->ports[PWM_LO_LEG].hold = 1;
+
+	for (;;)
+	{
+		get_host_queue( &(pwm_job_p->chk_q) ,chk_item_p );
+
+		if (HOST_ITEM_STOP == chk_item_p->type) break;
+
+		if (HOST_ITEM_VECT == chk_item_p->type)
+		{
+			memcpy( vect ,chk_item_p->vect ,sizeof(vect) );
+		} // if (HOST_ITEM_VECT == chk_item_p->type)
+		else
+		{
+			check_pwm_period( pwm_job_p ,vect ,chk_item_p );
+		} // else !(HOST_ITEM_VECT == chk_item_p->type)
+	} // for (;;)
+
+	free( chk_item_p );
+
+	return NULL;
+} // check_pwm_tests
+/*****************************************************************************/
+static void serve_pwm_tests( // Server: Convert PWM widths, and build edge schedule for each PWM period
+	PWM_JOB_TYP * pwm_job_p // Pointer to structure containing data for one PWM test job
+)
+{
+	PWM_COMMS_TYP * comms_p = &(pwm_job_p->srv_comms); // Pointer to Server communication data
+	PWM_SCHED_TYP * sched_p = &(pwm_job_p->sched); // Pointer to edge schedule
+	PWM_GEN_ITEM_TYP gen_item; // Generator item
+	PWM_CHK_ITEM_TYP chk_item; // Checker item
+	unsigned start_time = 0u - PWM_WRAP_LEAD; // Time at start of next PWM period
+	int period_sel = -1; // Selected PWM period (NB None until 1st vector)
+
+
+	for (;;)
+	{
+		get_host_queue( &(pwm_job_p->gen_q) ,&gen_item );
+
+		if (HOST_ITEM_DATA != gen_item.type)
+		{ // Forward test vector, or end of test
+			if ((HOST_ITEM_VECT == gen_item.type) && (period_sel != gen_item.vect[PWM_PERIOD]))
+			{ // New PWM period selected: NB Next period starts where previous one ended
+				period_sel = gen_item.vect[PWM_PERIOD];
+				init_pwm_timing( &(comms_p->timing) ,period_sel );
+				init_pwm_schedule( sched_p ,start_time );
+			} // if ((HOST_ITEM_VECT == gen_item.type) && ...
+
+			chk_item.type = gen_item.type;
+			memcpy( chk_item.vect ,gen_item.vect ,sizeof(chk_item.vect) );
+			put_host_queue( &(pwm_job_p->chk_q) ,&chk_item );
+
+			if (HOST_ITEM_STOP == gen_item.type) break;
+
+			continue;
+		} // if (HOST_ITEM_DATA != gen_item.type)
+
+		memcpy( comms_p->params.widths ,gen_item.widths ,sizeof(comms_p->params.widths) );
+
+		chk_item.type = HOST_ITEM_DATA;
+		chk_item.ref_time = start_time + comms_p->timing.half_max;
+		chk_item.demand = gen_item.demand;
+
+		convert_all_pulse_widths( comms_p ,&(pwm_job_p->buf) );
+		build_pwm_schedule( sched_p ,&(pwm_job_p->buf) ,chk_item.ref_time ,&(comms_p->timing) ,LOCK_ADC_TO_PWM );
+
+		// Issue all events (NB Checker replays them on the modelled ports)
+		chk_item.num_events = sched_p->num_events;
+		memcpy( chk_item.events ,sched_p->events ,(sched_p->num_events * sizeof(PWM_EVENT_TYP)) );
+		sched_p->next = sched_p->num_events;
+
+		put_host_queue( &(pwm_job_p->chk_q) ,&chk_item );
+
+		start_time += comms_p->timing.max_value; // NB unsigned wraps, like the target port timer
+	} // for (;;)
+} // serve_pwm_tests
+/*****************************************************************************/
+static void run_pwm_job( // Run Generator, Server and Checker for one PWM test job
+	HOST_JOB_TYP * job_p // Pointer to test job
+)
+{
+	PWM_JOB_TYP * pwm_job_p; // Pointer to structure containing data for one PWM test job (NB Large, so NOT on stack)
+	pthread_t gen_thread; // Generator thread
+	pthread_t chk_thread; // Checker thread
+
+
+	pwm_job_p = (PWM_JOB_TYP *)calloc( 1 ,sizeof(PWM_JOB_TYP) );
+
+	if (NULL == pwm_job_p)
+	{
+		host_check( job_p ,0 ,"Allocating job data" );
+		return;
+	} // if (NULL == pwm_job_p)
+
+	pwm_job_p->job_p = job_p;
+
+	if ((0 != init_host_queue( &(pwm_job_p->gen_q) ,sizeof(PWM_GEN_ITEM_TYP) ,HOST_QUEUE_DEPTH ))
+		|| (0 != init_host_queue( &(pwm_job_p->chk_q) ,sizeof(PWM_CHK_ITEM_TYP) ,HOST_QUEUE_DEPTH )))
+	{
+		host_check( job_p ,0 ,"Allocating queues" );
+		free( pwm_job_p );
+		return;
+	} // if ((0 != init_host_queue( &(pwm_job_p->gen_q) ,...
+
+	host_spawn( &gen_thread ,gen_pwm_tests ,pwm_job_p );
+	host_spawn( &chk_thread ,check_pwm_tests ,pwm_job_p );
+
+	serve_pwm_tests( pwm_job_p ); // NB Server runs on worker thread
+
+	pthread_join( gen_thread ,NULL );
+	pthread_join( chk_thread ,NULL );
+
+	free_host_queue( &(pwm_job_p->chk_q) );
+	free_host_queue( &(pwm_job_p->gen_q) );
+	free( pwm_job_p );
+} // run_pwm_job
+/*****************************************************************************/
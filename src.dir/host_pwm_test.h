@@ -0,0 +1,139 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_PWM_TEST_H_
+#define _HOST_PWM_TEST_H_
+
+#include "host_tests.h"
+#include "pwm_convert_width.h"
+#include "pwm_schedule.h"
+
+// NB Test values match app_test_pwm (see test_pwm_common.h and generate_pwm_tests.xc)
+#define PWM_MAX_TESTS 10 // No. of checked PWM periods for each width
+#define PWM_SKIP_TESTS 3 // No. of set-up PWM periods for each width
+#define PWM_COMP_BAND 32 // Current at which full dead-time correction is applied
+#define PWM_COMP_CURR (PWM_COMP_BAND << 1) // Magnitude of modelled phase current (outside compensation band)
+#define PWM_COMP_HALF (PWM_COMP_BAND >> 1) // Magnitude of modelled phase current (inside compensation band)
+#define PWM_DEAD_QUART (PWM_DEAD_TIME >> 2) // Quarter of dead-time (unit of expected compensation)
+#define PWM_HOST_MAX_BITS (1 << PWM_PERIOD_MAX_BITS) // Max. No. of port bits in one PWM period
+#define PWM_WRAP_LEAD (SECOND >> 10) // Virtual port timer starts this long before it wraps (so wrap-around is tested)
+
+/** Different PWM test options (see pwm_tests.txt) */
+typedef enum PWM_OPT_ETAG
+{
+  PWM_OPT_PHASE = 0,	// Select which PWM Phase to test
+  PWM_OPT_NARROW,			// Test Narrow PWM Widths
+  PWM_OPT_EQUAL,			// Test Equal PWM Widths
+  PWM_OPT_ADC,				// Test ADC Trigger
+  PWM_OPT_COMP,				// Test Dead-time compensation
+  NUM_PWM_OPTS				// Handy Value!-)
+} PWM_OPT_ENUM;
+
+/** Different components of PWM test vector */
+typedef enum PWM_COMP_ETAG
+{
+  PWM_CNTRL = 0,	// Control state (see PWM_CNTRL_ENUM)
+  PWM_WIDTH,			// Width-state (see PWM_WIDTH_ENUM)
+  PWM_PERIOD,			// Selected PWM period (see PWM_PERIOD_ENUM)
+  PWM_ADC,				// Flag set if ADC trigger tested
+  PWM_COMP,				// Dead-time compensation state (see PWM_CURR_ENUM)
+  NUM_PWM_COMPS		// Handy Value!-)
+} PWM_COMP_ENUM;
+
+/** Different PWM Control states */
+typedef enum PWM_CNTRL_ETAG
+{
+  PWM_SKIP = 0,	// Skip checks (test set-up)
+  PWM_VALID,		// Valid test
+  NUM_PWM_CNTRLS	// Handy Value!-)
+} PWM_CNTRL_ENUM;
+
+/** Different PWM Width states */
+typedef enum PWM_WIDTH_ETAG
+{
+  PWM_MINI = 0,	// Minimum PWM width (for Slowest Speed)
+  PWM_SMALL,		// Small PWM width (for Slow Speed)
+  PWM_EQUAL,		// Equal High and Low PWM (for Medium Speed)
+  PWM_LARGE,		// Large PWM width (for Fast Speed)
+  PWM_MAXI,			// Maximum PWM width (for Fastest Speed)
+  NUM_PWM_WIDTHS	// Handy Value!-)
+} PWM_WIDTH_ENUM;
+
+/** Different PWM Dead-time compensation states (modelled phase-current) */
+typedef enum PWM_CURR_ETAG
+{
+  PWM_NO_COMP = 0,	// Dead-Time compensation not tested
+  PWM_POSI_CURR,		// Large positive phase-current (flowing into motor)
+  PWM_POSI_BAND,		// Small positive phase-current (inside compensation band)
+  PWM_ZERO_CURR,		// Zero phase-current
+  PWM_NEGA_BAND,		// Small negative phase-current (inside compensation band)
+  PWM_NEGA_CURR,		// Large negative phase-current (flowing out of motor)
+  NUM_PWM_CURRS			// Handy Value!-)
+} PWM_CURR_ENUM;
+
+/** Structure containing one item sent from Generator to Server (NB replaces PWM Client channel and test-vector channel) */
+typedef struct PWM_GEN_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_PWM_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	unsigned widths[NUM_PWM_PHASES]; // Hi-leg widths sent to Server (NB After any dead-time compensation)
+	int demand; // Demanded width of phase under test (NB Before any dead-time compensation)
+} PWM_GEN_ITEM_TYP;
+
+/** Structure containing one item sent from Server to Checker (NB replaces PWM ports and ADC trigger channel) */
+typedef struct PWM_CHK_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_PWM_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	PWM_EVENT_TYP events[NUM_PWM_EVENTS]; // Events issued in one PWM period (timed port loads and ADC triggers)
+	int num_events; // No. of events issued
+	unsigned ref_time; // Reference time (centre) of PWM period
+	int demand; // Demanded width of phase under test (NB Before any dead-time compensation)
+} PWM_CHK_ITEM_TYP;
+
+/** Structure containing state of one modelled 1-bit buffered port (Checker) */
+typedef struct PWM_HOST_PORT_TAG
+{
+	unsigned char bits[PWM_HOST_MAX_BITS]; // Array of port values for current PWM period
+	unsigned hold; // Value held on port after last load (MS-bit of last pattern)
+	unsigned free_time; // Time when last load has been shifted out (NB Next load can NOT start earlier)
+	int load_err; // Flag set if a load overlapped the previous one, or fell outside the PWM period
+} PWM_HOST_PORT_TYP;
+
+/** Structure containing one pulse measured on a modelled port (Checker) */
+typedef struct PWM_HOST_PULSE_TAG
+{
+	int first; // Offset of first high bit from reference time
+	int last; // Offset of last high bit from reference time
+	int ones; // No. of high bits
+	int runs; // No. of separate pulses
+} PWM_HOST_PULSE_TYP;
+
+/** Structure containing all data for one PWM test job */
+typedef struct PWM_JOB_TAG
+{
+	HOST_JOB_TYP * job_p; // Pointer to test job
+	HOST_QUEUE_TYP gen_q; // Queue from Generator to Server
+	HOST_QUEUE_TYP chk_q; // Queue from Server to Checker
+	PWM_COMMS_TYP gen_comms; // PWM communication data (Generator, i.e. Client)
+	PWM_COMMS_TYP srv_comms; // PWM communication data (Server)
+	PWM_BUFFER_TYP buf; // Converted port data (Server)
+	PWM_SCHED_TYP sched; // Edge schedule (Server)
+	PWM_GEN_ITEM_TYP gen_item; // Current Generator item
+	int vect[NUM_PWM_COMPS]; // Current test vector (Generator)
+	int currs[NUM_PWM_PHASES]; // Modelled phase currents (Generator)
+	PWM_HOST_PORT_TYP ports[NUM_PWM_LEGS]; // Modelled Hi-leg and Lo-leg ports of phase under test (Checker)
+} PWM_JOB_TYP;
+
+#endif /* _HOST_PWM_TEST_H_ */
@@ -0,0 +1,382 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "host_qei_test.h"
+
+/* Host version of __app_test_qei (see generate_qei_tests.xc and check_qei_tests.xc)
+ * Generator: Fills 32-bit buffers with regular samples of the QEI sensor (Phases, Origin and Error bits),
+ * at a fixed speed for each speed-state. Occasional one-sample glitches are added to Phase_A.
+ * Server: QEI decoding of the QEI Server (module_foc_qei/src/qei_decode.c), with a Client request every QEI_REQ_LOOPS buffers.
+ * Checker: Checks error-status, total angle, origin correction, spin direction and speed of each set of QEI parameters.
+ */
+
+static void run_qei_job( HOST_JOB_TYP * job_p );
+
+const HOST_SUITE_TYP host_qei_suite = { "qei" ,"../__app_test_qei/qei_tests.txt" ,NUM_QEI_OPTS ,NUMBER_OF_MOTORS ,0 ,run_qei_job };
+
+/*****************************************************************************/
+static unsigned qei_speed_to_ticks( // Convert Velocity (in RPM) to ticks per QEI position
+	int speed // input speed
+) // Returns time in ticks
+{
+	return ((TICKS_PER_MIN_PER_QEI + (unsigned)(speed >> 1)) / (unsigned)speed);
+}	// qei_speed_to_ticks
+/*****************************************************************************/
+static void send_qei_vector( // Send new test vector (to Checker, via Server)
+	QEI_JOB_TYP * qei_job_p, // Pointer to structure containing data for one QEI test job
+	QEI_CNTRL_ENUM inp_cntrl // Control state of new vector
+)
+{
+	QEI_GEN_ITEM_TYP vect_item; // Generator item for test vector. NB Does NOT disturb buffer under construction
+
+
+	qei_job_p->vect[QEI_CNTRL] = inp_cntrl;
+
+	vect_item.type = HOST_ITEM_VECT;
+	memcpy( vect_item.vect ,qei_job_p->vect ,sizeof(vect_item.vect) );
+	put_host_queue( &(qei_job_p->gen_q) ,&vect_item );
+} // send_qei_vector
+/*****************************************************************************/
+static unsigned gen_qei_sample( // Generate one sample of QEI sensor
+	QEI_JOB_TYP * qei_job_p // Pointer to structure containing data for one QEI test job
+) // Returns 4-bit sample
+{
+	const unsigned phase_lut[QEI_PERIOD_LEN] = { 0b00 ,0b01 ,0b11 ,0b10 }; // [BA] Phase values in positive spin order
+	unsigned samp_val; // 4-bit sample value
+
+
+	samp_val = phase_lut[qei_job_p->ang & QEI_PHASE_MASK];
+
+	// Origin bit is set in one position per revolution
+	if (0 == (qei_job_p->ang & QEI_REV_MASK))
+	{
+		samp_val |= QEI_ORIG_MASK;
+	} // if (0 == (qei_job_p->ang & QEI_REV_MASK))
+
+	// NB Error-bit is active low
+	if (QEI_ERR_OFF == qei_job_p->vect[QEI_ERROR])
+	{
+		samp_val |= QEI_NERR_MASK;
+	} // if (QEI_ERR_OFF == qei_job_p->vect[QEI_ERROR])
+
+	// Add occasional glitch on Phase_A, if phases are steady (NB Should be removed by phase filter)
+	if ((QEI_GLITCH_GUARD <= qei_job_p->steady) && (0 == (qei_job_p->samp_cnt % QEI_GLITCH_SAMPS)))
+	{
+		samp_val ^= 0b01;
+	} // if ((QEI_GLITCH_GUARD <= qei_job_p->steady) && ...
+
+	return samp_val;
+} // gen_qei_sample
+/*****************************************************************************/
+static void send_qei_positions( // Move QEI sensor through positions, and send full buffers of samples (to Server)
+	QEI_JOB_TYP * qei_job_p, // Pointer to structure containing data for one QEI test job
+	int num_pos // No. of QEI positions to move through
+)
+{
+	QEI_GEN_ITEM_TYP * item_p = &(qei_job_p->gen_item); // Pointer to Generator item
+	int pos_cnt = 0; // QEI position counter
+	int buf_cnt = 0; // No. of samples in buffer
+
+
+	// NB Always finish with a full buffer
+	while ((pos_cnt < num_pos) || (0 != buf_cnt))
+	{
+		// Check if sensor has reached next position. NB int handles wrap-around
+		if (0 <= (int)(qei_job_p->samp_time - qei_job_p->next_change))
+		{
+			qei_job_p->ang += qei_job_p->vect[QEI_SPIN];
+			qei_job_p->next_change += qei_job_p->period;
+			qei_job_p->steady = 0;
+			pos_cnt++;
+		} // if (0 <= (int)(qei_job_p->samp_time - qei_job_p->next_change))
+
+		if (0 == buf_cnt)
+		{
+			item_p->buf_data = 0;
+			item_p->time = qei_job_p->samp_time;
+		} // if (0 == buf_cnt)
+
+		item_p->buf_data |= (gen_qei_sample( qei_job_p ) << (buf_cnt * QEI_SAMP_BITS)); // NB 1st sample in LS bits
+
+		qei_job_p->samp_time += TICKS_PER_SAMP; // NB unsigned wraps, like the target timer
+		qei_job_p->steady++;
+		qei_job_p->samp_cnt++;
+		buf_cnt++;
+
+		// Check for full buffer
+		if (SAMPS_PER_LOOP <= buf_cnt)
+		{
+			item_p->type = HOST_ITEM_DATA;
+			item_p->gen_ang = qei_job_p->ang;
+			put_host_queue( &(qei_job_p->gen_q) ,item_p );
+
+			buf_cnt = 0;
+		} // if (SAMPS_PER_LOOP <= buf_cnt)
+	} // while ((pos_cnt < num_pos) || (0 != buf_cnt))
+} // send_qei_positions
+/*****************************************************************************/
+static void send_qei_test( // Send one test: set-up positions (NOT checked), then checked positions
+	QEI_JOB_TYP * qei_job_p, // Pointer to structure containing data for one QEI test job
+	int skip_pos, // No. of set-up positions
+	int valid_pos // No. of checked positions
+)
+{
+	send_qei_vector( qei_job_p ,QEI_SKIP );
+	send_qei_positions( qei_job_p ,skip_pos );
+
+	send_qei_vector( qei_job_p ,QEI_VALID );
+	send_qei_positions( qei_job_p ,valid_pos );
+} // send_qei_test
+/*****************************************************************************/
+static void set_qei_speed( // Set new speed-state
+	QEI_JOB_TYP * qei_job_p, // Pointer to structure containing data for one QEI test job
+	QEI_SPEED_ENUM inp_speed // New speed-state
+)
+{
+	unsigned new_period = qei_speed_to_ticks( (QEI_FAST == inp_speed) ? QEI_HIGH_SPEED : QEI_LOW_SPEED ); // New period
+
+
+	qei_job_p->next_change += new_period - qei_job_p->period; // NB New period starts at current position
+	qei_job_p->period = new_period;
+	qei_job_p->vect[QEI_SPEED] = inp_speed;
+} // set_qei_speed
+/*****************************************************************************/
+static void * gen_qei_tests( // Generator thread: Generate QEI test data for one job
+	void * arg_p // Pointer to structure containing data for one QEI test job
+)
+{
+	QEI_JOB_TYP * qei_job_p = (QEI_JOB_TYP *)arg_p; // Pointer to structure containing data for one QEI test job
+	int * opts = qei_job_p->job_p->opts; // Array of test options
+
+
+	qei_job_p->vect[QEI_ERROR] = QEI_ERR_OFF;
+	qei_job_p->vect[QEI_SPIN] = 1;
+	qei_job_p->vect[QEI_SPEED] = QEI_FAST;
+	qei_job_p->period = qei_speed_to_ticks( QEI_HIGH_SPEED );
+	qei_job_p->ang = 0; // NB Start at origin, so total angle is consistent with origin corrections
+	qei_job_p->samp_time = 0u - QEI_WRAP_LEAD - (unsigned)(opts[QEI_OPT_MOTOR] * MILLI_SEC);
+	qei_job_p->next_change = qei_job_p->samp_time + qei_job_p->period;
+
+	// NB Speed is unknown until 1st M/T window complete
+	send_qei_test( qei_job_p ,(QEI_PER_REV >> 2) ,(QEI_PER_REV << 1) );
+
+	// Check if Error-status test activated
+	if (opts[QEI_OPT_ERROR])
+	{ // NB Server needs MAX_QEI_STATUS_ERR consecutive error samples (or non-error samples) to change error-status
+		qei_job_p->vect[QEI_ERROR] = QEI_ERR_ON;
+		send_qei_test( qei_job_p ,4 ,(QEI_PER_REV >> 4) );
+
+		qei_job_p->vect[QEI_ERROR] = QEI_ERR_OFF;
+		send_qei_test( qei_job_p ,4 ,(QEI_PER_REV >> 4) );
+	} // if (opts[QEI_OPT_ERROR])
+
+	// Check if Negative-spin test activated
+	if (opts[QEI_OPT_NEGA])
+	{ // NB M/T window must be clear of reversal
+		qei_job_p->vect[QEI_SPIN] = -1;
+		send_qei_test( qei_job_p ,(QEI_PER_REV >> 2) ,(QEI_PER_REV << 1) );
+	} // if (opts[QEI_OPT_NEGA])
+
+	// Slow speed test. NB Each edge completes an M/T window
+	set_qei_speed( qei_job_p ,QEI_SLOW );
+	send_qei_test( qei_job_p ,3 ,16 );
+
+	qei_job_p->gen_item.type = HOST_ITEM_STOP;
+	put_host_queue( &(qei_job_p->gen_q) ,&(qei_job_p->gen_item) );
+
+	return NULL;
+} // gen_qei_tests
+/*****************************************************************************/
+static void check_qei_speed( // Check mean speed of one valid test vector (NB As app, single values jitter by one sample)
+	HOST_JOB_TYP * job_p, // Pointer to test job
+	int vect[], // Test vector to check
+	int speed_sum, // Sum of velocities
+	int speed_num // No. of velocities in sum
+)
+{
+	int spin = vect[QEI_SPIN]; // Expected spin direction
+	int speed = ((QEI_FAST == vect[QEI_SPEED]) ? QEI_HIGH_SPEED : QEI_LOW_SPEED); // Expected speed magnitude
+	int mean; // Mean velocity
+
+
+	if (0 == speed_num) return;
+
+	mean = (speed_sum + (spin * (speed_num >> 1))) / speed_num; // NB Round away from zero
+
+	host_check( job_p ,((speed >> QEI_SPEED_ERR_BITS) >= abs( mean - (spin * speed) ))
+		,"Mean velocity=%d over %d requests, Expected %d" ,mean ,speed_num ,(spin * speed) );
+} // check_qei_speed
+/*****************************************************************************/
+static void check_qei_params( // Check one set of QEI parameters against test vector
+	HOST_JOB_TYP * job_p, // Pointer to test job
+	int vect[], // Current test vector
+	QEI_CHK_ITEM_TYP * chk_item_p // Pointer to Checker item
+)
+{
+	QEI_PARAM_TYP * params_p = &(chk_item_p->params); // Pointer to QEI parameters
+	unsigned req_time = chk_item_p->time; // Time of Client request
+	int spin = vect[QEI_SPIN]; // Expected spin direction
+
+
+	host_check( job_p ,(vect[QEI_ERROR] == params_p->err) ,"Time=%u Error-status=%d, Expected %d"
+		,req_time ,params_p->err ,vect[QEI_ERROR] );
+
+	host_check( job_p ,(QEI_ANG_ERR_LIM >= abs( params_p->tot_ang_this - chk_item_p->gen_ang ))
+		,"Time=%u Total-angle=%d, Expected %d" ,req_time ,params_p->tot_ang_this ,chk_item_p->gen_ang );
+
+	// Check for origin correction
+	if (params_p->orig_corr)
+	{
+		host_check( job_p ,(QEI_ANG_ERR_LIM >= abs( params_p->corr_ang ))
+			,"Time=%u Origin correction=%d" ,req_time ,params_p->corr_ang );
+	} // if (params_p->orig_corr)
+
+	host_check( job_p ,(0 < (spin * params_p->veloc)) ,"Time=%u Velocity=%d, NOT in spin direction %d"
+		,req_time ,params_p->veloc ,spin );
+} // check_qei_params
+/*****************************************************************************/
+static void * check_qei_tests( // Checker thread: Check QEI parameters for one job
+	void * arg_p // Pointer to structure containing data for one QEI test job
+)
+{
+	QEI_JOB_TYP * qei_job_p = (QEI_JOB_TYP *)arg_p; // Pointer to structure containing data for one QEI test job
+	QEI_CHK_ITEM_TYP chk_item; // Checker item
+	int vect[NUM_QEI_COMPS]; // Current test vector
+	int speed_sum = 0; // Sum of velocities for current test vector
+	int speed_num = 0; // No. of velocities in sum
+
+
+	memset( vect ,0 ,sizeof(vect) ); // NB Skip until 1st vector
+
+	for (;;)
+	{
+		get_host_queue( &(qei_job_p->chk_q) ,&chk_item );
+
+		if (HOST_ITEM_DATA != chk_item.type)
+		{ // End of test vector: Check mean speed
+			check_qei_speed( qei_job_p->job_p ,vect ,speed_sum ,speed_num );
+			speed_sum = 0;
+			speed_num = 0;
+
+			if (HOST_ITEM_STOP == chk_item.type) break;
+
+			memcpy( vect ,chk_item.vect ,sizeof(vect) );
+		} // if (HOST_ITEM_DATA != chk_item.type)
+		else
+		{
+			if (QEI_VALID == vect[QEI_CNTRL])
+			{
+				check_qei_params( qei_job_p->job_p ,vect ,&chk_item );
+
+				speed_sum += chk_item.params.veloc;
+				speed_num++;
+			} // if (QEI_VALID == vect[QEI_CNTRL])
+		} // else !(HOST_ITEM_DATA != chk_item.type)
+	} // for (;;)
+
+	return NULL;
+} // check_qei_tests
+/*****************************************************************************/
+static void serve_qei_tests( // Server: Decode buffers of QEI samples, and answer Client requests
+	QEI_JOB_TYP * qei_job_p // Pointer to structure containing data for one QEI test job
+)
+{
+	QEI_GEN_ITEM_TYP gen_item; // Generator item
+	QEI_CHK_ITEM_TYP chk_item; // Checker item
+	unsigned samp_time; // Time-stamp of current sample
+	int samp_cnt; // Sample counter
+	int loop_cnt = 0; // Buffer counter
+	int started = 0; // Flag set once QEI data initialised
+
+
+	for (;;)
+	{
+		get_host_queue( &(qei_job_p->gen_q) ,&gen_item );
+
+		if (HOST_ITEM_DATA != gen_item.type)
+		{ // Forward test vector, or end of test
+			chk_item.type = gen_item.type;
+			memcpy( chk_item.vect ,gen_item.vect ,sizeof(chk_item.vect) );
+			put_host_queue( &(qei_job_p->chk_q) ,&chk_item );
+
+			if (HOST_ITEM_STOP == gen_item.type) break;
+
+			continue;
+		} // if (HOST_ITEM_DATA != gen_item.type)
+
+		// NB Same as QEI Server: initialise with time-stamp of 1st buffer
+		if (0 == started)
+		{
+			init_qei_decode( &(qei_job_p->qei_data) ,qei_job_p->job_p->opts[QEI_OPT_MOTOR] ,gen_item.time );
+			started = 1;
+		} // if (0 == started)
+
+		samp_time = gen_item.time;
+
+		for (samp_cnt = 0; samp_cnt < SAMPS_PER_LOOP; samp_cnt++)
+		{
+			service_qei_input_pins( &(qei_job_p->qei_data) ,samp_time ,(gen_item.buf_data & QEI_SAMP_MASK) );
+
+			gen_item.buf_data >>= QEI_SAMP_BITS;
+			samp_time += TICKS_PER_SAMP;
+		} // for samp_cnt
+
+		loop_cnt++;
+
+		// Check for Client request
+		if (QEI_REQ_LOOPS <= loop_cnt)
+		{
+			get_qei_client_params( &(qei_job_p->qei_data) ,&(chk_item.params) ,qei_job_p->qei_data.ang_tot ,samp_time );
+
+			chk_item.type = HOST_ITEM_DATA;
+			chk_item.time = samp_time;
+			chk_item.gen_ang = gen_item.gen_ang;
+			put_host_queue( &(qei_job_p->chk_q) ,&chk_item );
+
+			loop_cnt = 0;
+		} // if (QEI_REQ_LOOPS <= loop_cnt)
+	} // for (;;)
+} // serve_qei_tests
+/*****************************************************************************/
+static void run_qei_job( // Run Generator, Server and Checker for one QEI test job
+	HOST_JOB_TYP * job_p // Pointer to test job
+)
+{
+	QEI_JOB_TYP qei_job_s; // Structure containing data for one QEI test job
+	pthread_t gen_thread; // Generator thread
+	pthread_t chk_thread; // Checker thread
+
+
+	memset( &qei_job_s ,0 ,sizeof(QEI_JOB_TYP) );
+	qei_job_s.job_p = job_p;
+
+	if ((0 != init_host_queue( &(qei_job_s.gen_q) ,sizeof(QEI_GEN_ITEM_TYP) ,HOST_QUEUE_DEPTH ))
+		|| (0 != init_host_queue( &(qei_job_s.chk_q) ,sizeof(QEI_CHK_ITEM_TYP) ,HOST_QUEUE_DEPTH )))
+	{
+		host_check( job_p ,0 ,"Allocating queues" );
+		return;
+	} // if ((0 != init_host_queue( &(qei_job_s.gen_q) ,...
+
+	host_spawn( &gen_thread ,gen_qei_tests ,&qei_job_s );
+	host_spawn( &chk_thread ,check_qei_tests ,&qei_job_s );
+
+	serve_qei_tests( &qei_job_s ); // NB Server runs on worker thread
+
+	pthread_join( gen_thread ,NULL );
+	pthread_join( chk_thread ,NULL );
+
+	free_host_queue( &(qei_job_s.chk_q) );
+	free_host_queue( &(qei_job_s.gen_q) );
+} // run_qei_job
+/*****************************************************************************/
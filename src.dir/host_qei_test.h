@@ -0,0 +1,103 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_QEI_TEST_H_
+#define _HOST_QEI_TEST_H_
+
+#include "host_tests.h"
+#include "qei_decode.h"
+
+// NB Test speeds match __app_test_qei (see test_qei_common.h)
+#define QEI_HIGH_SPEED 4000 // Fast speed (RPM)
+#define QEI_LOW_SPEED 50 // Slow speed (RPM)
+#define QEI_SPEED_ERR_BITS 6 // Mean speed error must be less than 1/64 of test speed (see check_qei_tests.h)
+#define QEI_ANG_ERR_LIM 2 // Max. difference between measured and generated angle (NB Allows for phase filter delay)
+#define QEI_REQ_LOOPS 8 // No. of port buffers between Client requests for QEI parameters
+#define QEI_GLITCH_SAMPS 61 // A one-sample glitch is added to Phase_A this often (NB Only when phases are steady)
+#define QEI_GLITCH_GUARD 8 // Phases must be steady for this many samples before a glitch
+#define QEI_WRAP_LEAD (SECOND >> 6) // Virtual timer starts this long before it wraps (so wrap-around is tested)
+
+/** Different QEI test options (see qei_tests.txt) */
+typedef enum QEI_OPT_ETAG
+{
+  QEI_OPT_MOTOR = 0,	// Select which motor to test
+  QEI_OPT_NEGA,				// Test Negative spin
+  QEI_OPT_ERROR,			// Test Error-Status
+  NUM_QEI_OPTS				// Handy Value!-)
+} QEI_OPT_ENUM;
+
+/** Different components of QEI test vector */
+typedef enum QEI_COMP_ETAG
+{
+  QEI_CNTRL = 0,	// Control state (see QEI_CNTRL_ENUM)
+  QEI_ERROR,			// Error-state (see ERROR_QEI_ENUM)
+  QEI_SPIN,				// Spin-state (1 = Positive, -1 = Negative)
+  QEI_SPEED,			// Speed-state (see QEI_SPEED_ENUM)
+  NUM_QEI_COMPS		// Handy Value!-)
+} QEI_COMP_ENUM;
+
+/** Different QEI Control states */
+typedef enum QEI_CNTRL_ETAG
+{
+  QEI_SKIP = 0,	// Skip checks (test set-up)
+  QEI_VALID,		// Valid test
+  NUM_QEI_CNTRLS	// Handy Value!-)
+} QEI_CNTRL_ENUM;
+
+/** Different QEI Speed states */
+typedef enum QEI_SPEED_ETAG
+{
+  QEI_FAST = 0,	// Constant Fast Speed
+  QEI_SLOW,			// Constant Slow Speed
+  NUM_QEI_SPEEDS	// Handy Value!-)
+} QEI_SPEED_ENUM;
+
+/** Structure containing one item sent from Generator to Server (NB replaces 32-bit buffered QEI port and test-vector channel) */
+typedef struct QEI_GEN_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_QEI_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	unsigned buf_data; // Buffer of SAMPS_PER_LOOP 4-bit samples (1st sample in LS bits)
+	unsigned time; // Time-stamp of 1st sample in buffer
+	int gen_ang; // Generated angle at last sample in buffer (NB Only used by Checker)
+} QEI_GEN_ITEM_TYP;
+
+/** Structure containing one item sent from Server to Checker (NB replaces QEI Client channel) */
+typedef struct QEI_CHK_ITEM_TAG
+{
+	HOST_ITEM_ENUM type; // Item type
+	int vect[NUM_QEI_COMPS]; // New test vector (if type is HOST_ITEM_VECT)
+	QEI_PARAM_TYP params; // QEI parameters returned to Client
+	unsigned time; // Time of Client request
+	int gen_ang; // Generated angle at time of Client request
+} QEI_CHK_ITEM_TYP;
+
+/** Structure containing all data for one QEI test job */
+typedef struct QEI_JOB_TAG
+{
+	HOST_JOB_TYP * job_p; // Pointer to test job
+	HOST_QUEUE_TYP gen_q; // Queue from Generator to Server
+	HOST_QUEUE_TYP chk_q; // Queue from Server to Checker
+	QEI_DATA_TYP qei_data; // QEI data for motor under test (Server)
+	QEI_GEN_ITEM_TYP gen_item; // Current Generator item
+	int vect[NUM_QEI_COMPS]; // Current test vector (Generator)
+	int ang; // Current angular position (Generator)
+	unsigned period; // Time between QEI positions (Generator)
+	unsigned samp_time; // Time of next sample (Generator)
+	unsigned next_change; // Time of next change of position (Generator)
+	int steady; // No. of samples since last change of position (Generator)
+	int samp_cnt; // Sample counter (Generator)
+} QEI_JOB_TYP;
+
+#endif /* _HOST_QEI_TEST_H_ */
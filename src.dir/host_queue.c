@@ -0,0 +1,100 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "host_queue.h"
+
+/*****************************************************************************/
+int init_host_queue( // Initialise empty queue. Returns 0 on success
+	HOST_QUEUE_TYP * queue_p, // Pointer to structure containing queue
+	int item_size, // Size of one item (in bytes)
+	int depth // Max. No. of items in queue
+)
+{
+	queue_p->items = (unsigned char *)malloc( (size_t)item_size * (size_t)depth );
+
+	if (NULL == queue_p->items)
+	{
+		return -1;
+	} // if (NULL == queue_p->items)
+
+	queue_p->item_size = item_size;
+	queue_p->depth = depth;
+	queue_p->wr_cnt = 0;
+	queue_p->rd_cnt = 0;
+
+	pthread_mutex_init( &(queue_p->lock) ,NULL );
+	pthread_cond_init( &(queue_p->not_empty) ,NULL );
+	pthread_cond_init( &(queue_p->not_full) ,NULL );
+
+	return 0;
+} // init_host_queue
+/*****************************************************************************/
+void free_host_queue( // Release storage of queue
+	HOST_QUEUE_TYP * queue_p // Pointer to structure containing queue
+)
+{
+	pthread_cond_destroy( &(queue_p->not_full) );
+	pthread_cond_destroy( &(queue_p->not_empty) );
+	pthread_mutex_destroy( &(queue_p->lock) );
+
+	free( queue_p->items );
+	queue_p->items = NULL;
+} // free_host_queue
+/*****************************************************************************/
+void put_host_queue( // Put one item at tail of queue (blocks while queue is full)
+	HOST_QUEUE_TYP * queue_p, // Pointer to structure containing queue
+	const void * item_p // Pointer to item
+)
+{
+	unsigned wr_off; // Offset of new item in storage
+
+
+	pthread_mutex_lock( &(queue_p->lock) );
+
+	while ((unsigned)queue_p->depth <= (queue_p->wr_cnt - queue_p->rd_cnt))
+	{
+		pthread_cond_wait( &(queue_p->not_full) ,&(queue_p->lock) );
+	} // while ((unsigned)queue_p->depth <= (queue_p->wr_cnt - queue_p->rd_cnt))
+
+	wr_off = queue_p->wr_cnt % (unsigned)queue_p->depth;
+	memcpy( &(queue_p->items[wr_off * (unsigned)queue_p->item_size]) ,item_p ,(size_t)queue_p->item_size );
+	queue_p->wr_cnt++;
+
+	pthread_cond_signal( &(queue_p->not_empty) );
+	pthread_mutex_unlock( &(queue_p->lock) );
+} // put_host_queue
+/*****************************************************************************/
+void get_host_queue( // Get one item from head of queue (blocks while queue is empty)
+	HOST_QUEUE_TYP * queue_p, // Pointer to structure containing queue
+	void * item_p // Pointer to item (output)
+)
+{
+	unsigned rd_off; // Offset of oldest item in storage
+
+
+	pthread_mutex_lock( &(queue_p->lock) );
+
+	while (queue_p->wr_cnt == queue_p->rd_cnt)
+	{
+		pthread_cond_wait( &(queue_p->not_empty) ,&(queue_p->lock) );
+	} // while (queue_p->wr_cnt == queue_p->rd_cnt)
+
+	rd_off = queue_p->rd_cnt % (unsigned)queue_p->depth;
+	memcpy( item_p ,&(queue_p->items[rd_off * (unsigned)queue_p->item_size]) ,(size_t)queue_p->item_size );
+	queue_p->rd_cnt++;
+
+	pthread_cond_signal( &(queue_p->not_full) );
+	pthread_mutex_unlock( &(queue_p->lock) );
+} // get_host_queue
+/*****************************************************************************/
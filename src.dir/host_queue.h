@@ -0,0 +1,61 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_QUEUE_H_
+#define _HOST_QUEUE_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* Bounded FIFO of fixed-size items, shared by 2 host threads.
+ * Replaces a channel or port of the target: put blocks while the queue is full, and get blocks while it is empty.
+ * So, like a streaming channel, a fast writer is held up by a slow reader.
+ */
+
+/** Structure containing one host queue */
+typedef struct HOST_QUEUE_TAG
+{
+	pthread_mutex_t lock; // Mutex protecting queue data
+	pthread_cond_t not_empty; // Signalled when an item is put
+	pthread_cond_t not_full; // Signalled when an item is got
+	unsigned char * items; // Storage for all items
+	int item_size; // Size of one item (in bytes)
+	int depth; // Max. No. of items in queue
+	unsigned wr_cnt; // No. of items put (NB Wraps)
+	unsigned rd_cnt; // No. of items got (NB Wraps)
+} HOST_QUEUE_TYP;
+
+/*****************************************************************************/
+int init_host_queue( // Initialise empty queue. Returns 0 on success
+	HOST_QUEUE_TYP * queue_p, // Pointer to structure containing queue
+	int item_size, // Size of one item (in bytes)
+	int depth // Max. No. of items in queue
+);
+/*****************************************************************************/
+void free_host_queue( // Release storage of queue
+	HOST_QUEUE_TYP * queue_p // Pointer to structure containing queue
+);
+/*****************************************************************************/
+void put_host_queue( // Put one item at tail of queue (blocks while queue is full)
+	HOST_QUEUE_TYP * queue_p, // Pointer to structure containing queue
+	const void * item_p // Pointer to item
+);
+/*****************************************************************************/
+void get_host_queue( // Get one item from head of queue (blocks while queue is empty)
+	HOST_QUEUE_TYP * queue_p, // Pointer to structure containing queue
+	void * item_p // Pointer to item (output)
+);
+/*****************************************************************************/
+#endif /* _HOST_QUEUE_H_ */
@@ -0,0 +1,460 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include <time.h>
+#include <unistd.h>
+
+#include "host_tests.h"
+
+/* Host-native, parallel run of the generate/check test suites of the xsim test applications
+ * (app_test_hall, __app_test_qei, app_test_adc and app_test_pwm).
+ *
+ * Each job runs 3 threads, like the cores of an xsim test application:-
+ *		Generator: Builds test vectors and test data. Test data is time-stamped with a virtual 32-bit timer
+ *		Server: Runs the real target code (e.g. hall_decode.c), and sends its parameters at each paced Client request
+ *		Checker: Checks the Server parameters against the current test vector
+ * The channels and ports between the threads are replaced by host queues (see host_queue.h).
+ * NB Test vectors are sent through the Server, in order with the test data, so each Server parameter set is checked
+ * against the vector in force when it was requested, whatever the thread scheduling.
+ *
+ * The jobs are run by a pool of worker threads (one per core by default), and a summary is printed for each suite.
+ *
+ * Usage: host_tests.x [-a] [-j num_threads] [suite ...]  (NB Run from src.dir, so that the *_tests.txt files are found)
+ *	Default: One job per suite, with the test options in the *_tests.txt file of its xsim test application
+ *	-a: Full regression. One job for every motor (or PWM phase), and every combination of the other test options
+ *	-j: No. of worker threads
+ *	suite: Only run named suites (hall qei adc pwm)
+ * Returns 1 if any check fails, or if a job does NO checks
+ */
+
+// Table of test suites
+static const HOST_SUITE_TYP * host_suites[] = { &host_hall_suite ,&host_qei_suite ,&host_adc_suite ,&host_pwm_suite };
+
+#define NUM_HOST_SUITES ((int)(sizeof(host_suites) / sizeof(HOST_SUITE_TYP *)))
+
+/** Structure containing data shared by all worker threads */
+typedef struct HOST_POOL_TAG
+{
+	HOST_JOB_TYP jobs[HOST_MAX_JOBS]; // Array of all jobs
+	int num_jobs; // No. of jobs
+	int next_job; // Index of next job to run
+	pthread_mutex_t lock; // Mutex protecting next_job
+} HOST_POOL_TYP;
+
+static pthread_mutex_t host_print_lock = PTHREAD_MUTEX_INITIALIZER; // Display Mutex (NB Like acquire_lock() on target)
+
+/*****************************************************************************/
+static double host_secs( void ) // Returns current time (in seconds)
+{
+	struct timespec time_s; // Current time
+
+
+	clock_gettime( CLOCK_MONOTONIC ,&time_s );
+
+	return ((double)time_s.tv_sec + 1.0e-9 * (double)time_s.tv_nsec);
+} // host_secs
+/*****************************************************************************/
+void host_check( // Count one check of a job, and report it if it failed
+	HOST_JOB_TYP * job_p, // Pointer to structure containing test job
+	int pass, // Flag set if check passed
+	const char * fmt, // Format of failure message (printf style)
+	...
+)
+{
+	va_list args; // Variable argument list
+
+
+	job_p->checks++;
+
+	if (pass)
+	{
+		return;
+	} // if (pass)
+
+	job_p->errs++;
+
+	if (HOST_PRINT_ERRS >= job_p->errs)
+	{
+		pthread_mutex_lock( &host_print_lock );
+
+		printf("  FAIL %s: " ,job_p->name );
+		va_start( args ,fmt );
+		vprintf( fmt ,args );
+		va_end( args );
+		printf("\n");
+
+		if (HOST_PRINT_ERRS == job_p->errs)
+		{
+			printf("  FAIL %s: Further failures NOT printed\n" ,job_p->name );
+		} // if (HOST_PRINT_ERRS == job_p->errs)
+
+		pthread_mutex_unlock( &host_print_lock );
+	} // if (HOST_PRINT_ERRS >= job_p->errs)
+} // host_check
+/*****************************************************************************/
+void host_spawn( // Start a thread for one part of a job (e.g. generator or checker)
+	pthread_t * thread_p, // Pointer to thread handle (output)
+	void * (*thread_fn)( void * ), // Thread function
+	void * arg_p // Argument passed to thread function
+)
+{
+	if (0 != pthread_create( thread_p ,NULL ,thread_fn ,arg_p ))
+	{
+		printf("ERROR: Creating thread\n");
+		exit( 1 );
+	} // if (0 != pthread_create( thread_p ,NULL ,thread_fn ,arg_p ))
+} // host_spawn
+/*****************************************************************************/
+static int parse_option_file( // Parse test options set-up file of one xsim test application
+	const HOST_SUITE_TYP * suite_p, // Pointer to test suite
+	int opts[] // Array of test option values (output)
+) // Returns 0 on success
+/* Same format as parse_control_file() in the xsim generators:
+ * In the left column, 1 selects a test, 0 skips it (or a letter selects a PWM phase). Text after a hash is a comment
+ */
+{
+	FILE * file_p; // Pointer to options file
+	char line[HOST_LINE_LEN]; // Current line
+	char * char_p; // Pointer to 1st non-blank character
+	int opt_cnt = 0; // No. of test options found
+
+
+	file_p = fopen( suite_p->opt_file ,"r" );
+	if (NULL == file_p)
+	{
+		printf("ERROR: Opening File %s\n" ,suite_p->opt_file );
+		return -1;
+	} // if (NULL == file_p)
+
+	while (NULL != fgets( line ,HOST_LINE_LEN ,file_p ))
+	{
+		char_p = line;
+
+		while ((' ' == *char_p) || ('\t' == *char_p))
+		{
+			char_p++;
+		} // while ((' ' == *char_p) || ('\t' == *char_p))
+
+		if (('0' <= *char_p) && ('9' >= *char_p))
+		{
+			opts[opt_cnt++] = *char_p - '0';
+		} // if (('0' <= *char_p) && ('9' >= *char_p))
+		else
+		{
+			if (('A' <= *char_p) && ('Z' >= *char_p))
+			{
+				opts[opt_cnt++] = *char_p - 'A';
+			} // if (('A' <= *char_p) && ('Z' >= *char_p))
+		} // else !(('0' <= *char_p) && ('9' >= *char_p))
+
+		if (suite_p->num_opts <= opt_cnt) break;
+	} // while (NULL != fgets( line ,HOST_LINE_LEN ,file_p ))
+
+	fclose( file_p );
+
+	if ((suite_p->num_opts != opt_cnt) || (0 > opts[0]) || (suite_p->num_ids <= opts[0]))
+	{
+		printf("ERROR: File %s needs %d valid test options\n" ,suite_p->opt_file ,suite_p->num_opts );
+		return -1;
+	} // if ((suite_p->num_opts != opt_cnt) || ...
+
+	return 0;
+} // parse_option_file
+/*****************************************************************************/
+static void add_job( // Add one job to pool
+	HOST_POOL_TYP * pool_p, // Pointer to structure containing worker pool data
+	int suite_id, // Index of test suite
+	int opts[] // Array of test option values
+)
+{
+	const HOST_SUITE_TYP * suite_p = host_suites[suite_id]; // Pointer to test suite
+	HOST_JOB_TYP * job_p = &(pool_p->jobs[pool_p->num_jobs]); // Pointer to new job
+	int name_len; // Length of job name
+	int opt_cnt; // test option counter
+
+
+	if (HOST_MAX_JOBS <= pool_p->num_jobs)
+	{
+		printf("ERROR: More than %d jobs\n" ,HOST_MAX_JOBS );
+		exit( 1 );
+	} // if (HOST_MAX_JOBS <= pool_p->num_jobs)
+
+	memset( job_p ,0 ,sizeof(HOST_JOB_TYP) );
+	job_p->suite_id = suite_id;
+
+	name_len = snprintf( job_p->name ,HOST_NAME_LEN ,"%s[%c" ,suite_p->name
+		,((suite_p->id_letter ? 'A' : '0') + opts[0]) );
+
+	for (opt_cnt = 0; opt_cnt < suite_p->num_opts; opt_cnt++)
+	{
+		job_p->opts[opt_cnt] = opts[opt_cnt];
+
+		if (0 < opt_cnt)
+		{
+			name_len += snprintf( &(job_p->name[name_len]) ,(size_t)(HOST_NAME_LEN - name_len) ,"%d" ,opts[opt_cnt] );
+		} // if (0 < opt_cnt)
+	} // for opt_cnt
+
+	snprintf( &(job_p->name[name_len]) ,(size_t)(HOST_NAME_LEN - name_len) ,"]" );
+
+	pool_p->num_jobs++;
+} // add_job
+/*****************************************************************************/
+static int build_suite_jobs( // Build list of jobs for one suite
+	HOST_POOL_TYP * pool_p, // Pointer to structure containing worker pool data
+	int suite_id, // Index of test suite
+	int full // Flag set for full regression
+) // Returns 0 on success
+{
+	const HOST_SUITE_TYP * suite_p = host_suites[suite_id]; // Pointer to test suite
+	int opts[HOST_MAX_OPTS]; // Array of test option values
+	int num_flags = suite_p->num_opts - 1; // No. of test option flags
+	int id_cnt; // identifier counter
+	int mask; // Bit-mask of selected test option flags
+	int opt_cnt; // test option counter
+
+
+	if (0 == full)
+	{
+		if (0 != parse_option_file( suite_p ,opts ))
+		{
+			return -1;
+		} // if (0 != parse_option_file( suite_p ,opts ))
+
+		add_job( pool_p ,suite_id ,opts );
+		return 0;
+	} // if (0 == full)
+
+	for (id_cnt = 0; id_cnt < suite_p->num_ids; id_cnt++)
+	{
+		for (mask = 0; mask < (1 << num_flags); mask++)
+		{
+			opts[0] = id_cnt;
+
+			for (opt_cnt = 0; opt_cnt < num_flags; opt_cnt++)
+			{
+				opts[opt_cnt + 1] = (mask >> opt_cnt) & 1;
+			} // for opt_cnt
+
+			add_job( pool_p ,suite_id ,opts );
+		} // for mask
+	} // for id_cnt
+
+	return 0;
+} // build_suite_jobs
+/*****************************************************************************/
+static void * run_worker( // Worker thread: Run jobs until none left
+	void * arg_p // Pointer to structure containing worker pool data
+)
+{
+	HOST_POOL_TYP * pool_p = (HOST_POOL_TYP *)arg_p; // Pointer to structure containing worker pool data
+	HOST_JOB_TYP * job_p; // Pointer to current job
+	double strt_secs; // Time at start of job
+	int job_id; // Index of current job
+
+
+	for (;;)
+	{
+		pthread_mutex_lock( &(pool_p->lock) );
+		job_id = pool_p->next_job++;
+		pthread_mutex_unlock( &(pool_p->lock) );
+
+		if (pool_p->num_jobs <= job_id) break;
+
+		job_p = &(pool_p->jobs[job_id]);
+
+		strt_secs = host_secs();
+		host_suites[job_p->suite_id]->run_job( job_p );
+		job_p->secs = host_secs() - strt_secs;
+
+		// A job that checks nothing has NOT tested anything
+		if (0 == job_p->checks)
+		{
+			host_check( job_p ,0 ,"NO checks done" );
+		} // if (0 == job_p->checks)
+	} // for (;;)
+
+	return NULL;
+} // run_worker
+/*****************************************************************************/
+static int print_summary( // Print summary of results for each suite
+	HOST_POOL_TYP * pool_p, // Pointer to structure containing worker pool data
+	int num_threads, // No. of worker threads
+	double wall_secs // Elapsed time of whole run
+) // Returns total No. of failed checks
+{
+	int num_jobs; // No. of jobs in suite
+	long checks; // No. of checks in suite
+	int errs; // No. of failed checks in suite
+	int fail_jobs; // No. of failed jobs in suite
+	double job_secs; // Sum of job times in suite
+	int tot_errs = 0; // Total No. of failed checks
+	int suite_cnt; // suite counter
+	int job_cnt; // job counter
+
+
+	printf("\n%-6s %6s %6s %12s %8s %9s\n" ,"Suite" ,"Jobs" ,"Failed" ,"Checks" ,"Errors" ,"Job_Secs" );
+
+	for (suite_cnt = 0; suite_cnt < NUM_HOST_SUITES; suite_cnt++)
+	{
+		num_jobs = 0;
+		checks = 0;
+		errs = 0;
+		fail_jobs = 0;
+		job_secs = 0.0;
+
+		for (job_cnt = 0; job_cnt < pool_p->num_jobs; job_cnt++)
+		{
+			if (suite_cnt == pool_p->jobs[job_cnt].suite_id)
+			{
+				num_jobs++;
+				checks += pool_p->jobs[job_cnt].checks;
+				errs += pool_p->jobs[job_cnt].errs;
+				job_secs += pool_p->jobs[job_cnt].secs;
+
+				if (pool_p->jobs[job_cnt].errs)
+				{
+					fail_jobs++;
+				} // if (pool_p->jobs[job_cnt].errs)
+			} // if (suite_cnt == pool_p->jobs[job_cnt].suite_id)
+		} // for job_cnt
+
+		if (num_jobs)
+		{
+			printf("%-6s %6d %6d %12ld %8d %9.2f\n" ,host_suites[suite_cnt]->name ,num_jobs ,fail_jobs ,checks ,errs ,job_secs );
+		} // if (num_jobs)
+
+		tot_errs += errs;
+	} // for suite_cnt
+
+	printf("%d jobs on %d threads in %.2f secs: %s\n" ,pool_p->num_jobs ,num_threads ,wall_secs
+		,(tot_errs ? "FAIL" : "PASS") );
+
+	return tot_errs;
+} // print_summary
+/*****************************************************************************/
+static int find_suite( // Returns index of named suite, or -1 if NOT found
+	const char * name // Suite name
+)
+{
+	int suite_cnt; // suite counter
+
+
+	for (suite_cnt = 0; suite_cnt < NUM_HOST_SUITES; suite_cnt++)
+	{
+		if (0 == strcmp( name ,host_suites[suite_cnt]->name ))
+		{
+			return suite_cnt;
+		} // if (0 == strcmp( name ,host_suites[suite_cnt]->name ))
+	} // for suite_cnt
+
+	return -1;
+} // find_suite
+/*****************************************************************************/
+int main( int argc ,char * argv[] )
+{
+	static HOST_POOL_TYP pool_s; // Structure containing worker pool data
+	pthread_t * workers; // Array of worker thread handles
+	int selected[NUM_HOST_SUITES]; // Array of flags, one for each suite. Set if suite selected
+	int num_sel = 0; // No. of suites named on command line
+	int num_threads = (int)sysconf( _SC_NPROCESSORS_ONLN ); // No. of worker threads. NB Default: one per core
+	int full = 0; // Flag set for full regression
+	double strt_secs; // Time at start of run
+	int suite_id; // Index of test suite
+	int arg_cnt; // argument counter
+	int thread_cnt; // thread counter
+
+
+	memset( selected ,0 ,sizeof(selected) );
+
+	for (arg_cnt = 1; arg_cnt < argc; arg_cnt++)
+	{
+		if (0 == strcmp( argv[arg_cnt] ,"-a" ))
+		{
+			full = 1;
+		} // if (0 == strcmp( argv[arg_cnt] ,"-a" ))
+		else
+		{
+			if ((0 == strcmp( argv[arg_cnt] ,"-j" )) && ((arg_cnt + 1) < argc))
+			{
+				num_threads = atoi( argv[++arg_cnt] );
+			} // if ((0 == strcmp( argv[arg_cnt] ,"-j" )) && ...
+			else
+			{
+				suite_id = find_suite( argv[arg_cnt] );
+
+				if (0 > suite_id)
+				{
+					printf("Usage: %s [-a] [-j num_threads] [hall] [qei] [adc] [pwm]\n" ,argv[0] );
+					return 1;
+				} // if (0 > suite_id)
+
+				selected[suite_id] = 1;
+				num_sel++;
+			} // else !((0 == strcmp( argv[arg_cnt] ,"-j" )) && ...
+		} // else !(0 == strcmp( argv[arg_cnt] ,"-a" ))
+	} // for arg_cnt
+
+	if (1 > num_threads)
+	{
+		num_threads = 1;
+	} // if (1 > num_threads)
+
+	for (suite_id = 0; suite_id < NUM_HOST_SUITES; suite_id++)
+	{
+		if ((0 == num_sel) || selected[suite_id])
+		{
+			if (0 != build_suite_jobs( &pool_s ,suite_id ,full ))
+			{
+				return 1;
+			} // if (0 != build_suite_jobs( &pool_s ,suite_id ,full ))
+		} // if ((0 == num_sel) || selected[suite_id])
+	} // for suite_id
+
+	if (num_threads > pool_s.num_jobs)
+	{
+		num_threads = pool_s.num_jobs;
+	} // if (num_threads > pool_s.num_jobs)
+
+	printf("Host test suites: %d jobs (%s) on %d threads\n" ,pool_s.num_jobs
+		,(full ? "Full regression" : "Options from *_tests.txt") ,num_threads );
+
+	pthread_mutex_init( &(pool_s.lock) ,NULL );
+	pool_s.next_job = 0;
+
+	workers = (pthread_t *)malloc( (size_t)num_threads * sizeof(pthread_t) );
+	if (NULL == workers)
+	{
+		printf("ERROR: Allocating %d worker threads\n" ,num_threads );
+		return 1;
+	} // if (NULL == workers)
+
+	strt_secs = host_secs();
+
+	for (thread_cnt = 0; thread_cnt < num_threads; thread_cnt++)
+	{
+		host_spawn( &workers[thread_cnt] ,run_worker ,&pool_s );
+	} // for thread_cnt
+
+	for (thread_cnt = 0; thread_cnt < num_threads; thread_cnt++)
+	{
+		pthread_join( workers[thread_cnt] ,NULL );
+	} // for thread_cnt
+
+	free( workers );
+	pthread_mutex_destroy( &(pool_s.lock) );
+
+	return (print_summary( &pool_s ,num_threads ,(host_secs() - strt_secs) ) ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,87 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _HOST_TESTS_H_
+#define _HOST_TESTS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "host_queue.h"
+
+/* NB This header is shared by all test suites, so must NOT include any app_global.h.
+ * Each suite is compiled against the app_global.h of its own xsim test application (see host_tests.mak)
+ */
+
+#define HOST_MAX_OPTS 8 // Max. No. of test options in one *_tests.txt file
+#define HOST_MAX_JOBS 256 // Max. No. of jobs in one run
+#define HOST_NAME_LEN 64 // Max. length of job name
+#define HOST_LINE_LEN 256 // Max. length of one line of *_tests.txt file
+#define HOST_PRINT_ERRS 4 // Max. No. of failures printed for each job
+#define HOST_QUEUE_DEPTH 64 // No. of items in each queue between threads of one job
+
+/** Different types of item sent between the threads of one job */
+typedef enum HOST_ITEM_ETAG
+{
+  HOST_ITEM_DATA = 0,	// Test data (e.g. port samples), or Server parameters
+  HOST_ITEM_VECT,			// New test vector
+  HOST_ITEM_STOP,			// End of test (NB Last item sent)
+  NUM_HOST_ITEMS			// Handy Value!-)
+} HOST_ITEM_ENUM;
+
+/** Structure containing one test job (one set of test options for one suite) */
+typedef struct HOST_JOB_TAG
+{
+	int suite_id; // Index of test suite
+	int opts[HOST_MAX_OPTS]; // Array of test option values (NB 1st option selects motor or phase)
+	char name[HOST_NAME_LEN]; // Job name (for reports)
+	int checks; // No. of checks done
+	int errs; // No. of failed checks
+	double secs; // Elapsed time
+} HOST_JOB_TYP;
+
+/** Structure describing one test suite (one xsim test application) */
+typedef struct HOST_SUITE_TAG
+{
+	const char * name; // Suite name
+	const char * opt_file; // Test options set-up file of xsim test application (relative to src.dir)
+	int num_opts; // No. of test options (NB 1st option is an identifier, the others are flags)
+	int num_ids; // No. of values of 1st option (e.g. NUMBER_OF_MOTORS)
+	int id_letter; // Flag set if 1st option is a letter (e.g. PWM phase), otherwise a digit
+	void (*run_job)( HOST_JOB_TYP * job_p ); // Run generator, Server and checker for one job
+} HOST_SUITE_TYP;
+
+extern const HOST_SUITE_TYP host_hall_suite; // Hall suite (see host_hall_test.c)
+extern const HOST_SUITE_TYP host_qei_suite; // QEI suite (see host_qei_test.c)
+extern const HOST_SUITE_TYP host_adc_suite; // ADC suite (see host_adc_test.c)
+extern const HOST_SUITE_TYP host_pwm_suite; // PWM suite (see host_pwm_test.c)
+
+/*****************************************************************************/
+void host_check( // Count one check of a job, and report it if it failed
+	HOST_JOB_TYP * job_p, // Pointer to structure containing test job
+	int pass, // Flag set if check passed
+	const char * fmt, // Format of failure message (printf style)
+	...
+);
+/*****************************************************************************/
+void host_spawn( // Start a thread for one part of a job (e.g. generator or checker)
+	pthread_t * thread_p, // Pointer to thread handle (output)
+	void * (*thread_fn)( void * ), // Thread function
+	void * arg_p // Argument passed to thread function
+);
+/*****************************************************************************/
+#endif /* _HOST_TESTS_H_ */
@@ -0,0 +1,46 @@
+# ansi C compile: Host-native parallel run of the Hall/QEI/ADC/PWM generate-check test suites
+
+MAIN =	host_tests
+
+# NB Each suite is compiled with the module under test, and the app_global.h of its xsim test application
+HALL_MODS = host_hall_test hall_decode
+QEI_MODS = host_qei_test qei_decode
+ADC_MODS = host_adc_test adc_pipeline adc_delay_calib
+PWM_MODS = host_pwm_test pwm_convert_width pwm_schedule
+
+CMODS =	$(MAIN) \
+	host_queue \
+	$(HALL_MODS) \
+	$(QEI_MODS) \
+	$(ADC_MODS) \
+	$(PWM_MODS) \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	host_queue.h \
+
+HALL_INC = host_inc ../module_foc_hall/src ../module_foc_util/src ../app_test_hall/src
+QEI_INC = host_inc ../module_foc_qei/src ../module_foc_util/src ../__app_test_qei/src
+ADC_INC = host_inc ../module_foc_adc/src ../module_foc_util/src ../app_test_adc/src
+PWM_INC = host_inc ../module_foc_pwm/src ../module_foc_util/src ../app_test_pwm/src
+
+# NB Only module directories, as each xsim test application has its own app_global.h
+SRC_DIR = host_inc ../module_foc_hall/src ../module_foc_qei/src ../module_foc_adc/src ../module_foc_pwm/src
+
+LIBS = pthread
+
+OPT = -O2
+
+# Full regression of all suites and all test options, spread over all host cores
+CHECK_ARGS = -a
+
+include host_model.mak
+
+# Select include directories of each suite
+INC_DIR = host_inc
+$(HALL_MODS:%=$(OBJ_DIR)/%.o) : INC_DIR = $(HALL_INC)
+$(QEI_MODS:%=$(OBJ_DIR)/%.o) : INC_DIR = $(QEI_INC)
+$(ADC_MODS:%=$(OBJ_DIR)/%.o) : INC_DIR = $(ADC_INC)
+$(PWM_MODS:%=$(OBJ_DIR)/%.o) : INC_DIR = $(PWM_INC)
+
+#
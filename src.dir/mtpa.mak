@@ -0,0 +1,21 @@
+# ansi C compile: Host check of MTPA table against closed form and brute-force search, and of feed-forward sign
+
+MAIN =	mtpa_model
+
+CMODS =	$(MAIN) \
+	field_weakening \
+	motor_model \
+	cordic \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	motor_model.h \
+	field_weakening.h \
+
+INC_DIR = host_inc ../module_foc_loop/src ../__app_foc_demo/src
+
+OPT = -O2
+
+include host_model.mak
+
+#
@@ -0,0 +1,277 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "mtpa_model.h"
+
+/* Host check of the MTPA table (see init_mtpa_table() in module_foc_loop/src/field_weakening.c)
+ * For each set of motor parameters, every table entry is checked against:-
+ *	The closed form |Id| = (sqrt(psi^2 + 4.dL^2.Iq^2) - psi) / (2.dL), where dL = L_q - L_d
+ *	A brute-force search along the constant-torque curve through the table point (torque ~ Iq.(psi + dL.|Id|)),
+ *	for the |Id| that minimises the total current magnitude. I.e. the table point must itself be the MTPA point for its torque.
+ *	NB This does NOT rely on the closed form
+ * The feed-forward voltages are then checked under field weakening, for both spin directions, with the radial current converted
+ * from the control-loop frame (as in inner_loop.xc). The demagnetising current must reduce the back-EMF, NOT increase it.
+ * Finally the Id/Iq loops (offset PIDs plus feed-forward) are closed round a modelled motor, while the speed is ramped above base speed.
+ *	The demand voltage must never reach the PWM clipping level, and once settled must stay within one Id step of the
+ *	field-weakening voltage limit, while the target Iq is delivered.
+ * Usage: mtpa_model.x
+ */
+
+// Test motors: L_d, L_q, psi, Closed-loop speed. NB 1st is surface-magnet motor of __app_foc_demo (NO saliency)
+static const MODEL_MOTOR_TYP test_motors[] = {
+	{ 2026 ,2026 ,242000 ,5000 } ,{ 2026 ,4000 ,242000 ,4200 } ,{ 2026 ,8000 ,242000 ,2950 } ,{ 1000 ,3000 ,100000 ,7800 } ,{ 2026 ,2500 ,20000 ,10000 }
+};
+
+#define NUM_TEST_MOTORS (sizeof(test_motors) / sizeof(MODEL_MOTOR_TYP))
+/*****************************************************************************/
+static double search_mtpa_Id( // Returns |Id| that minimises current magnitude, along constant-torque curve through one point
+	const MODEL_MOTOR_TYP * motor_p, // Pointer to motor parameters
+	double inp_Id, // Radial current magnitude of point (e.g. from MTPA table)
+	double inp_Iq // Tangential current of point
+)
+{
+	double diff_L = (double)(motor_p->L_q - motor_p->L_d); // Inductance difference (saliency)
+	double torque = inp_Iq * ((double)motor_p->psi + diff_L * inp_Id); // Torque to maintain (up to a constant)
+	double best_Id = 0.0; // Best radial current found
+	double best_mag = -1.0; // Current magnitude at best radial current (NB Negative until 1st point searched)
+	double srch_Id; // Radial current under test
+	double srch_Iq; // Tangential current giving same torque
+	double srch_mag; // Current magnitude
+
+
+	for (srch_Id = 0.0; srch_Id <= (inp_Iq + inp_Id); srch_Id += (1.0 / MODEL_SEARCH_STEPS))
+	{
+		srch_Iq = torque / ((double)motor_p->psi + diff_L * srch_Id);
+		srch_mag = sqrt( srch_Id * srch_Id + srch_Iq * srch_Iq );
+
+		if ((0.0 > best_mag) || (srch_mag < best_mag))
+		{
+			best_mag = srch_mag;
+			best_Id = srch_Id;
+		} // if ((0.0 > best_mag) || (srch_mag < best_mag))
+	} // for srch_Id
+
+	return best_Id;
+} // search_mtpa_Id
+/*****************************************************************************/
+static int check_ff_signs( // Check sign of feed-forward voltages under field weakening, for one spin direction
+	const MODEL_MOTOR_TYP * motor_p, // Pointer to motor parameters
+	int spin_dir // Spin direction (+1 or -1)
+) // Returns No. of errors
+{
+	MOTOR_PARAM_TYP params_s; // Motor parameters
+	FW_DATA_TYP fw_s; // Field-weakening data
+	int veloc = spin_dir * MODEL_FF_RPM; // Angular velocity (RPM)
+	int targ_Iq = spin_dir * MODEL_FF_IQ; // Target tangential current
+	int loop_Id = 0; // Radial current in control-loop frame
+	int model_Id; // Radial current in model frame
+	int emf_V; // Back-EMF voltage (with NO radial current)
+	int ff_Vd; // Radial feed-forward voltage (model frame)
+	int ff_Vq; // Tangential feed-forward voltage
+	int iter_cnt; // Iteration counter
+	int num_errs = 0; // No. of errors
+
+
+	init_motor_params( &params_s ,motor_p->L_d ,motor_p->L_q ,motor_p->psi );
+	// NB Id limit is half the current that would cancel the magnet flux
+	init_field_weakening( &fw_s ,&params_s ,MODEL_FF_VOLT ,MODEL_CURR_LIM ,(motor_p->psi / (motor_p->L_d << 1)) ,(1 << FW_RES_BITS) );
+
+	// Hold demand voltage above limit, so the voltage-feedback integrator demands demagnetising current
+	for (iter_cnt=0; iter_cnt<MODEL_FF_ITERS; iter_cnt++)
+	{
+		loop_Id = update_field_weakening( &fw_s ,&targ_Iq ,0 ,(MODEL_FF_VOLT << 1) );
+	} // for iter_cnt
+
+	if (0 > spin_dir) loop_Id = -loop_Id; // As inner_loop.xc: Loop-frame Id is -ve for -ve spin
+
+	model_Id = convert_loop_radial( loop_Id ,veloc );
+	calc_decoupling_voltages( &params_s ,&ff_Vd ,&emf_V ,veloc ,0 ,targ_Iq );
+	calc_decoupling_voltages( &params_s ,&ff_Vd ,&ff_Vq ,veloc ,model_Id ,targ_Iq );
+
+	// Demagnetising current must be negative in the model frame
+	if (0 <= model_Id) num_errs++;
+
+	// Demagnetising current must reduce the back-EMF magnitude, without reversing it
+	if ((abs(ff_Vq) >= abs(emf_V)) || (0 > (ff_Vq * spin_dir))) num_errs++;
+
+	// Conversion must be self-inverse
+	if (loop_Id != convert_loop_radial( model_Id ,veloc )) num_errs++;
+
+	if (num_errs)
+	{
+		printf("    ERROR: Spin=%2d Loop Id=%4d Model Id=%4d: ff_Vq=%6d, back-EMF=%6d\n"
+			,spin_dir ,loop_Id ,model_Id ,ff_Vq ,emf_V );
+	} // if (num_errs)
+
+	return num_errs;
+} // check_ff_signs
+/*****************************************************************************/
+static int check_closed_loop( // Close Id/Iq loops round modelled motor, and check demand voltage magnitude under field weakening
+	const MODEL_MOTOR_TYP * motor_p // Pointer to motor parameters
+) // Returns No. of errors
+{
+	MOTOR_PARAM_TYP params_s; // Motor parameters
+	FW_DATA_TYP fw_s; // Field-weakening data
+	double Xd; // Radial reactance at current speed
+	double Xq; // Tangential reactance at current speed
+	double emf; // Back-EMF at current speed
+	double det; // Determinant of steady-state coil equations
+	double ss_Id; // Steady-state radial current for applied voltage (model frame)
+	double ss_Iq; // Steady-state tangential current for applied voltage
+	double est_Id = 0.0; // Modelled radial current (model frame)
+	double est_Iq = 0.0; // Modelled tangential current
+	double sum_Vd = 0.0; // Radial PID integrator (loop frame)
+	double sum_Vq = 0.0; // Tangential PID integrator
+	double max_Iq_err = 0.0; // Max. settled tangential current error
+	int set_Vd = 0; // Radial demand voltage (loop frame)
+	int set_Vq = 0; // Tangential demand voltage
+	int targ_Id; // Target radial current (loop frame)
+	int targ_Iq; // Target tangential current
+	int ff_Vd; // Radial feed-forward voltage
+	int ff_Vq; // Tangential feed-forward voltage
+	int veloc; // Modelled speed (RPM)
+	int mag_V; // Demand voltage magnitude before limiting
+	int max_V = 0; // Max. demand voltage magnitude
+	int max_settled_V = 0; // Max. settled demand voltage magnitude
+	int tol_V = ((motor_p->loop_rpm * motor_p->L_d) >> MOTOR_PARAM_BITS) + 1; // Settled voltage tolerance: One quantisation step of Id
+	int iter_cnt; // Iteration counter
+	int num_errs = 0; // No. of errors
+
+
+	init_motor_params( &params_s ,motor_p->L_d ,motor_p->L_q ,motor_p->psi );
+	init_field_weakening( &fw_s ,&params_s ,MODEL_LOOP_VOLT ,MODEL_LOOP_CURR ,MODEL_LOOP_ID ,MODEL_LOOP_K_I );
+
+	for (iter_cnt=0; iter_cnt<(MODEL_RAMP_ITERS + MODEL_HOLD_ITERS); iter_cnt++)
+	{
+		veloc = motor_p->loop_rpm;
+		if (iter_cnt < MODEL_RAMP_ITERS) veloc = (int)(((long long)motor_p->loop_rpm * iter_cnt) / MODEL_RAMP_ITERS);
+
+		// Control loop (as update_foc_voltage() in inner_loop.xc, positive spin)
+		targ_Iq = MODEL_LOOP_IQ;
+		targ_Id = update_field_weakening( &fw_s ,&targ_Iq ,set_Vd ,set_Vq );
+
+		calc_decoupling_voltages( &params_s ,&ff_Vd ,&ff_Vq ,veloc ,convert_loop_radial( targ_Id ,veloc ) ,targ_Iq );
+		ff_Vd = convert_loop_radial( ff_Vd ,veloc );
+
+		sum_Vd += MODEL_PID_KI * (targ_Id - convert_loop_radial( (int)floor( est_Id + 0.5 ) ,veloc ));
+		sum_Vq += MODEL_PID_KI * (targ_Iq - est_Iq);
+
+		set_Vd = targ_Id + (int)floor( sum_Vd + 0.5 ) + ff_Vd;
+		set_Vq = targ_Iq + (int)floor( sum_Vq + 0.5 ) + ff_Vq;
+
+		// Limit demand voltage, as PWM conversion
+		mag_V = limit_vector_magnitude( &set_Vd ,&set_Vq ,MODEL_CLIP_LIM ,VECT_PRIOR_D );
+		if (max_V < mag_V) max_V = mag_V;
+
+		// Motor: Currents decay towards the steady-state solution of the coil equations (see motor_model.h)
+		Xd = (double)veloc * motor_p->L_d / (1 << MOTOR_PARAM_BITS);
+		Xq = (double)veloc * motor_p->L_q / (1 << MOTOR_PARAM_BITS);
+		emf = (double)veloc * motor_p->psi / (1 << MOTOR_PARAM_BITS);
+		det = MODEL_RES * MODEL_RES + Xd * Xq;
+
+		ss_Id = (MODEL_RES * convert_loop_radial( set_Vd ,veloc ) + Xq * (set_Vq - emf)) / det;
+		ss_Iq = (MODEL_RES * (set_Vq - emf) - Xd * convert_loop_radial( set_Vd ,veloc )) / det;
+
+		est_Id += MODEL_LAG * (ss_Id - est_Id);
+		est_Iq += MODEL_LAG * (ss_Iq - est_Iq);
+
+		// Check settled behaviour at test speed
+		if ((MODEL_RAMP_ITERS + MODEL_SETTLE_ITERS) <= iter_cnt)
+		{
+			if (max_settled_V < mag_V) max_settled_V = mag_V;
+			if (max_Iq_err < fabs( targ_Iq - est_Iq )) max_Iq_err = fabs( targ_Iq - est_Iq );
+		} // if ((MODEL_RAMP_ITERS + MODEL_SETTLE_ITERS) <= iter_cnt)
+	} // for iter_cnt
+
+	if (MODEL_CLIP_LIM <= max_V) num_errs++;
+	if ((MODEL_LOOP_VOLT + tol_V) < max_settled_V) num_errs++;
+	if (MODEL_CURR_TOL < max_Iq_err) num_errs++;
+
+	printf("    Closed loop at %5d RPM: Id=%3d, Max. |V|=%5d (clip %5d), Settled |V|=%5d (limit %5d+%d), Iq error %.2f\n"
+		,motor_p->loop_rpm ,targ_Id ,max_V ,MODEL_CLIP_LIM ,max_settled_V ,MODEL_LOOP_VOLT ,tol_V ,max_Iq_err );
+
+	return num_errs;
+} // check_closed_loop
+/*****************************************************************************/
+static int test_one_motor( // Check MTPA table for one set of motor parameters
+	const MODEL_MOTOR_TYP * motor_p // Pointer to motor parameters
+) // Returns 1 if all table entries pass
+{
+	MOTOR_PARAM_TYP params_s; // Motor parameters
+	FW_DATA_TYP fw_s; // Field-weakening data (contains MTPA table)
+	double diff_L = (double)(motor_p->L_q - motor_p->L_d); // Inductance difference (saliency)
+	double psi = (double)motor_p->psi; // Magnet flux linkage
+	double inp_Iq; // Tangential current of table entry
+	double form_Id; // Radial current from closed form
+	double srch_Id; // Radial current from brute-force search
+	int tab_cnt; // Table entry counter
+	int num_errs = 0; // No. of failed table entries
+
+
+	init_motor_params( &params_s ,motor_p->L_d ,motor_p->L_q ,motor_p->psi );
+	init_field_weakening( &fw_s ,&params_s ,MODEL_CURR_LIM ,MODEL_CURR_LIM ,MODEL_CURR_LIM ,0 );
+
+	for (tab_cnt = 0; tab_cnt <= MTPA_TAB_SIZ; tab_cnt++)
+	{
+		inp_Iq = (double)(tab_cnt << MTPA_STEP_BITS);
+		form_Id = 0.0;
+
+		if (0.0 < diff_L)
+		{
+			form_Id = (sqrt( psi * psi + 4.0 * diff_L * diff_L * inp_Iq * inp_Iq ) - psi) / (2.0 * diff_L);
+		} // if (0.0 < diff_L)
+
+		srch_Id = search_mtpa_Id( motor_p ,(double)fw_s.mtpa_Id[tab_cnt] ,inp_Iq );
+
+		if ((MODEL_ERR_LIM < fabs( fw_s.mtpa_Id[tab_cnt] - form_Id ))
+			|| (MODEL_ERR_LIM < fabs( fw_s.mtpa_Id[tab_cnt] - srch_Id )))
+		{
+			printf("    ERROR: Iq=%4d Table Id=%4d, Closed form %7.2f, Search %7.2f\n"
+				,(int)inp_Iq ,fw_s.mtpa_Id[tab_cnt] ,form_Id ,srch_Id );
+
+			num_errs++;
+		} // if ((MODEL_ERR_LIM < fabs( fw_s.mtpa_Id[tab_cnt] - form_Id )) || ...
+	} // for tab_cnt
+
+	num_errs += check_ff_signs( motor_p ,1 ) + check_ff_signs( motor_p ,-1 );
+	num_errs += check_closed_loop( motor_p );
+
+	printf("  L_d=%5d L_q=%5d psi=%6d: Id at Iq=%d is %d (closed form %.1f). %s\n"
+		,motor_p->L_d ,motor_p->L_q ,motor_p->psi ,MTPA_MAX_IQ ,fw_s.mtpa_Id[MTPA_TAB_SIZ] ,form_Id
+		,(num_errs ? "FAIL" : "PASS") );
+
+	return (0 == num_errs);
+} // test_one_motor
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("MTPA table tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_MOTORS; test_cnt++)
+	{
+		if (0 == test_one_motor( &test_motors[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_motor( &test_motors[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_MOTORS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
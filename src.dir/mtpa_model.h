@@ -0,0 +1,58 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _MTPA_MODEL_H_
+#define _MTPA_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "field_weakening.h"
+
+#define MODEL_CURR_LIM 4096 // Total current magnitude limit (NB Only used to initialise field-weakening engine)
+#define MODEL_SEARCH_STEPS 16 // No. of brute-force search steps per unit of radial current
+#define MODEL_ERR_LIM 1 // Max. error of one table entry (NB Allows for integer square-root and rounding)
+
+#define MODEL_FF_RPM 3000 // Speed magnitude used for feed-forward sign check
+#define MODEL_FF_IQ 60 // Tangential current magnitude used for feed-forward sign check
+#define MODEL_FF_VOLT 1000 // Demand voltage magnitude limit used for feed-forward sign check
+#define MODEL_FF_ITERS 64 // No. of over-voltage iterations used to build up the demagnetising current
+
+// Closed-loop check. NB Limits are copies of VECT_LIM_MAG, FW_VOLT_LIM, FW_CURR_LIM, FW_ID_LIM and FW_K_I in inner_loop.h
+#define MODEL_VOLT_MAX (1 << 14) // No. of different Voltage Magnitudes (VOLT_MAX_MAG)
+#define MODEL_CLIP_LIM ((MODEL_VOLT_MAX * 7) >> 3) // Demand voltage magnitude at which PWM is clipped
+#define MODEL_LOOP_VOLT ((MODEL_VOLT_MAX * 13) >> 4) // Field-weakening voltage limit
+#define MODEL_LOOP_CURR 120 // Total current magnitude limit
+#define MODEL_LOOP_ID 40 // Maximum demagnetising Id magnitude
+#define MODEL_LOOP_K_I 4 // Voltage-feedback integrator gain (at default PWM period)
+#define MODEL_LOOP_IQ 30 // Requested tangential current
+#define MODEL_RAMP_ITERS 16000 // No. of loop iterations to ramp up to test speed (~1 second)
+#define MODEL_HOLD_ITERS 16000 // No. of loop iterations at test speed
+#define MODEL_SETTLE_ITERS 4000 // No. of loop iterations allowed to settle at test speed
+#define MODEL_RES 1.0 // Coil resistance (Demand voltage per current unit). NB Matches offset PID, where voltage preset equals target current
+#define MODEL_LAG 0.05 // Fraction of current error removed per iteration (coil time-constant)
+#define MODEL_PID_KI 0.01 // Current PID integral gain (Voltage per current error, per iteration)
+#define MODEL_CURR_TOL 1.0 // Allowed settled tangential current error
+
+/** Structure containing one set of motor parameters under test */
+typedef struct MODEL_MOTOR_TAG
+{
+	int L_d; // Up-scaled radial inductance
+	int L_q; // Up-scaled tangential inductance
+	int psi; // Up-scaled magnet flux linkage
+	int loop_rpm; // Speed for closed-loop check (RPM). NB Above base speed where field weakening is required
+} MODEL_MOTOR_TYP;
+
+#endif /* _MTPA_MODEL_H_ */
@@ -0,0 +1,20 @@
+# ansi C compile: Host simulation of position loop through short moves, reversals, holding against a load, and starts from standstill
+
+MAIN =	position_model
+
+CMODS =	$(MAIN) \
+	position_loop \
+	trajectory \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	position_loop.h \
+	trajectory.h \
+
+INC_DIR = host_inc ../module_foc_loop/src ../module_foc_pwm/src ../module_foc_util/src ../__app_foc_demo/src
+
+OPT = -O2
+
+include host_model.mak
+
+#
@@ -0,0 +1,217 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "position_model.h"
+
+/* Host simulation of the position loop (see module_foc_loop/src/position_loop.c), cascaded on the trajectory generator and speed loop.
+ * The motor is modelled under speed control (PI on the speed error, plus acceleration feed-forward, with a current-limited acceleration),
+ * and its position is measured in (quantised) up-scaled QEI positions. One iteration is modelled per FOC iteration, in the same order as inner_loop.xc
+ * A profile of target positions is applied, either to a motor already in the FOC state (holding position zero), or to a stationary motor.
+ * A stationary motor is started with the modelled open-loop travel, then enters the FOC state. For each profile, the following are checked:-
+ *	The following error never exceeds its limit (I.e. the move is NEVER abandoned), including through reversals, and while holding against a load
+ *	A stationary motor is started, if and only if, the target is further away than the open-loop travel
+ *	The motor does NOT overshoot the final target by more than MODEL_MAX_OVER
+ *	The motor is settled within the target window (with near-zero speed) for the final MODEL_SETTLE_MS
+ * NB In the FOC state the motor is NEVER stopped and re-started, so short moves and reversals stay under closed-loop control
+ * Usage: position_model.x
+ */
+
+// Test configurations: Name, Stopped, Test length, Load on/off times, Load deceleration, Target profile
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "Short move" ,0 ,1500 ,0 ,0 ,0.0 ,1 ,{ { 0 ,64 } } }
+	,{ "Very short move" ,0 ,1000 ,0 ,0 ,0.0 ,1 ,{ { 0 ,-8 } } }
+	,{ "Short move and back" ,0 ,1500 ,0 ,0 ,0.0 ,2 ,{ { 0 ,64 } ,{ 50 ,-64 } } }
+	,{ "Long move" ,0 ,3000 ,0 ,0 ,0.0 ,1 ,{ { 0 ,(10 * QEI_PER_REV) } } }
+	,{ "Reverse mid-move" ,0 ,3000 ,0 ,0 ,0.0 ,2 ,{ { 0 ,(10 * QEI_PER_REV) } ,{ 300 ,(-2 * QEI_PER_REV) } } }
+	,{ "Reverse short moves" ,0 ,1500 ,0 ,0 ,0.0 ,4 ,{ { 0 ,200 } ,{ 20 ,-200 } ,{ 40 ,200 } ,{ 60 ,0 } } }
+	,{ "Hold against load" ,0 ,1500 ,100 ,600 ,2000.0 ,1 ,{ { 0 ,0 } } }
+	,{ "Move against load" ,0 ,2500 ,0 ,2500 ,2000.0 ,1 ,{ { 0 ,(-3 * QEI_PER_REV) } } }
+	,{ "Start: Far target" ,1 ,3000 ,0 ,0 ,0.0 ,1 ,{ { 0 ,(5 * QEI_PER_REV) } } }
+	,{ "Start: Far negative target" ,1 ,3000 ,0 ,0 ,0.0 ,1 ,{ { 0 ,(-4 * QEI_PER_REV) } } }
+	,{ "Start: Near target" ,1 ,500 ,0 ,0 ,0.0 ,1 ,{ { 0 ,(QEI_PER_REV >> 1) } } }
+	,{ "Start: Near negative target" ,1 ,500 ,0 ,0 ,0.0 ,1 ,{ { 0 ,-QEI_PER_REV } } }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+/*****************************************************************************/
+static int test_one_config( // Run one target profile through position loop
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+{
+	POSN_DATA_TYP posn_s; // Position loop data
+	TRAJ_DATA_TYP traj_s; // Trajectory data
+	MODEL_ERRS_TYP errs = { 0 ,0 ,0 ,0 ,0 ,0 ,0.0 }; // Error counts
+	double iters_per_sec = (double)SECOND / (double)MODEL_ITER_TICKS; // FOC iteration rate
+	double dt = 1.0 / iters_per_sec; // FOC iteration period (seconds)
+	double veloc = 0.0; // Modelled velocity (RPM)
+	double angle = 0.5; // Modelled total angle (QEI positions). NB Start half-way between QEI edges
+	double sum_err = 0.0; // Speed loop integrator (RPM.second)
+	double acc; // Modelled acceleration (RPM per second)
+	double cur_ms; // Current time (milli-seconds)
+	int end_iters = (int)((double)cfg_p->end_ms * iters_per_sec / 1000.0); // Length of test (FOC iterations)
+	int settle_iters = (int)((double)MODEL_SETTLE_MS * iters_per_sec / 1000.0); // Length of final settling check (FOC iterations)
+	int stopped = cfg_p->stopped; // Flag set while motor is stationary (PWM off)
+	int iter_cnt; // FOC iteration counter
+	int pnt_cnt = 0; // Target profile point counter
+	int final_targ; // Final target position (Up-scaled QEI positions)
+	int final_dir = 0; // Direction of final approach (+1/-1), or zero if none
+	int in_window = 0; // Flag set while motor settled on final target
+	int meas_posn; // Measured position (Up-scaled QEI positions)
+	int req_vel = 0; // Requested velocity
+	int targ_vel = 0; // Target velocity (output of trajectory generator)
+	int start_dir; // Start direction (+1/-1)
+	int over; // Overshoot past final target
+	int err_val; // Error value
+
+
+	init_trajectory( &traj_s ,MODEL_MAX_ACC ,MODEL_MAX_JERK );
+	init_position_loop( &posn_s ,MODEL_MAX_SPEED ,MODEL_WINDOW ,MODEL_FOLLOW_LIM ,MODEL_TICKS_PER_POSN );
+
+	final_targ = cfg_p->points[cfg_p->num_points - 1].targ << MODEL_UPSCALE_BITS;
+
+	for (iter_cnt=0; iter_cnt<end_iters; iter_cnt++)
+	{
+		cur_ms = 1000.0 * iter_cnt * dt;
+		meas_posn = ((int)floor( angle )) << MODEL_UPSCALE_BITS;
+
+		// Check for new target (NB As in process_position_command())
+		if ((pnt_cnt < cfg_p->num_points) && (cfg_p->points[pnt_cnt].time_ms <= cur_ms))
+		{
+			posn_s.targ = cfg_p->points[pnt_cnt].targ << MODEL_UPSCALE_BITS;
+			pnt_cnt++;
+
+			if (stopped)
+			{
+				req_vel = calc_position_start( &posn_s ,meas_posn ,MODEL_START_DIST ,MODEL_MIN_SPEED );
+
+				// Check start decision against open-loop travel
+				if ((0 != req_vel) != (MODEL_START_DIST < abs(posn_s.targ - meas_posn))) errs.start++;
+
+				// Check for start. NB Open-loop start modelled as an instantaneous move through the open-loop travel (then state is FOC)
+				if (0 != req_vel)
+				{
+					start_dir = ((0 > req_vel) ? -1 : 1);
+					angle += (double)(start_dir * (MODEL_TRANS_DIST + MODEL_ALIGN_DIST)) / (double)(1 << MODEL_UPSCALE_BITS);
+					veloc = (double)(start_dir * MODEL_START_SPEED);
+					meas_posn = ((int)floor( angle )) << MODEL_UPSCALE_BITS;
+
+					targ_vel = start_dir * MODEL_START_SPEED;
+					preset_trajectory( &traj_s ,targ_vel );
+					preset_position_loop( &posn_s ,meas_posn ); // NB As at end of TRANSIT state
+					sum_err = veloc / MODEL_SPEED_KI; // Preset speed integrator to hold start speed
+					stopped = 0;
+				} // if (0 != req_vel)
+			} // if (stopped)
+		} // if ((pnt_cnt < cfg_p->num_points) && ...
+
+		// A stationary motor stays stationary
+		if (stopped)
+		{
+			if ((end_iters - settle_iters) <= iter_cnt)
+			{
+				// Check a motor that was NOT started stays put
+				if ((0 != veloc) || (cfg_p->stopped && (0 != meas_posn))) errs.settle++;
+			} // if ((end_iters - settle_iters) <= iter_cnt)
+
+			continue;
+		} // if (stopped)
+
+		// FOC state: Update requested velocity from position loop (NB As in update_motor_state())
+		req_vel = calc_position_request( &posn_s );
+
+		// Update target velocity and position loop (NB As in calc_foc_pwm())
+		targ_vel = update_trajectory( &traj_s ,req_vel );
+
+		if (update_position_loop( &posn_s ,targ_vel ,MODEL_ITER_TICKS ,meas_posn ))
+		{
+			errs.follow++;
+		} // if (update_position_loop( &posn_s ,targ_vel ,MODEL_ITER_TICKS ,meas_posn ))
+
+		if (errs.max_follow < abs(posn_s.follow_err)) errs.max_follow = abs(posn_s.follow_err);
+
+		// Speed loop, with acceleration feed-forward (NB As in update_foc_voltage()). Measured velocity is rounded to RPM
+		sum_err += (double)(targ_vel + posn_s.veloc - (int)floor( veloc + 0.5 )) * dt;
+		acc = MODEL_SPEED_KP * (double)(targ_vel + posn_s.veloc - (int)floor( veloc + 0.5 )) + MODEL_SPEED_KI * sum_err;
+		acc += (double)traj_s.acc / (double)(1 << TRAJ_RES_BITS) * iters_per_sec;
+
+		// Clip to current limit
+		if (MODEL_MOTOR_ACC < acc) acc = MODEL_MOTOR_ACC;
+		if (-MODEL_MOTOR_ACC > acc) acc = -MODEL_MOTOR_ACC;
+
+		// Apply load
+		if ((cfg_p->load_on_ms <= cur_ms) && (cur_ms < cfg_p->load_off_ms))
+		{
+			acc -= cfg_p->load_acc;
+		} // if ((cfg_p->load_on_ms <= cur_ms) && (cur_ms < cfg_p->load_off_ms))
+
+		veloc += acc * dt;
+		angle += veloc * (double)QEI_PER_REV * dt / (double)SECS_PER_MIN;
+
+		// Once final target set, check for overshoot in direction of approach
+		if (pnt_cnt == cfg_p->num_points)
+		{
+			if (0 == final_dir)
+			{
+				final_dir = ((final_targ < meas_posn) ? -1 : 1);
+			} // if (0 == final_dir)
+
+			over = final_dir * (meas_posn - final_targ);
+			if (errs.max_over < over) errs.max_over = over;
+			if (MODEL_MAX_OVER < over) errs.over++;
+		} // if (pnt_cnt == cfg_p->num_points)
+
+		// Check if settled on final target
+		if ((MODEL_WINDOW >= abs(meas_posn - final_targ)) && (MODEL_SETTLE_RPM > fabs( veloc )))
+		{
+			if (0 == in_window) errs.settle_ms = cur_ms;
+			in_window = 1;
+		} // if ((MODEL_WINDOW >= abs(meas_posn - final_targ)) && (MODEL_SETTLE_RPM > fabs( veloc )))
+		else
+		{
+			in_window = 0;
+
+			if ((end_iters - settle_iters) <= iter_cnt) errs.settle++;
+		} // else !((MODEL_WINDOW >= abs(meas_posn - final_targ)) && (MODEL_SETTLE_RPM > fabs( veloc )))
+	} // for iter_cnt
+
+	err_val = errs.follow + errs.start + errs.over + errs.settle;
+
+	printf("  %-28s: Max. Follow=%5d, Max. Over=%3d, Settled at %6.1f ms. Errors: Follow=%d Start=%d Over=%d Settle=%d %s\n"
+		,cfg_p->name ,errs.max_follow ,errs.max_over ,(in_window ? errs.settle_ms : -1.0)
+		,errs.follow ,errs.start ,errs.over ,errs.settle ,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("Position loop tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,91 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _POSITION_MODEL_H_
+#define _POSITION_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "pwm_common.h"
+#include "trajectory.h"
+#include "position_loop.h"
+
+// Control-loop limits. NB Copies of definitions in module_foc_control/src/inner_loop.h
+#define MODEL_UPSCALE_BITS 2 // QEI_UPSCALE_BITS
+#define MODEL_UQ_PER_PAIR (QEI_PER_PAIR << MODEL_UPSCALE_BITS) // UQ_PER_PAIR
+#define MODEL_UQ_PER_REV (QEI_PER_REV << MODEL_UPSCALE_BITS) // UQ_PER_REV
+#define MODEL_MAX_ACC (1 << TRAJ_RES_BITS) // TRAJ_MAX_ACC
+#define MODEL_MAX_JERK (MODEL_MAX_ACC >> 6) // TRAJ_MAX_JERK
+#define MODEL_MAX_SPEED 4000 // SPEC_MAX_SPEED
+#define MODEL_MIN_SPEED 30 // MIN_SPEED
+#define MODEL_START_SPEED 100 // START_SPEED
+#define MODEL_WINDOW (4 << MODEL_UPSCALE_BITS) // POSN_WINDOW
+#define MODEL_FOLLOW_LIM (MODEL_UQ_PER_REV >> 1) // POSN_FOLLOW_LIM
+#define MODEL_TICKS_PER_POSN ((SECS_PER_MIN * ((SECOND + (QEI_PER_REV >> 1)) / QEI_PER_REV)) >> MODEL_UPSCALE_BITS) // POSN_TICKS_PER_POSN
+
+/* Open-loop start. The SEARCH and TRANSIT states end at trans_theta (one electrical cycle, plus 3 TRANSIT cycles for the default voltages),
+ * and alignment may add up to half an electrical cycle. See calc_start_distance() in inner_loop.xc
+ */
+#define MODEL_TRANS_DIST (4 * MODEL_UQ_PER_PAIR) // Distance travelled in SEARCH and TRANSIT states
+#define MODEL_START_DIST (MODEL_TRANS_DIST + (MODEL_UQ_PER_PAIR >> 1)) // Max. distance travelled under open-loop control
+
+// Modelled motor, under speed control. NB The speed PI output is an acceleration, and the trajectory acceleration is fed-forward
+#define MODEL_ITER_TICKS (1 << PWM_RES_BITS) // FOC iteration period (NB One FOC iteration per PWM period)
+#define MODEL_TICKS_PER_MS (SECOND / 1000) // No. of Reference Frequency Cycles per milli-second
+#define MODEL_SPEED_KP 200.0 // Speed loop proportional gain (RPM per second, per RPM of speed error)
+#define MODEL_SPEED_KI 5000.0 // Speed loop integral gain (RPM per second, per RPM.second of speed error)
+#define MODEL_MOTOR_ACC 60000.0 // Max. motor acceleration, from current limit (RPM per second). NB More than trajectory limit
+#define MODEL_ALIGN_DIST (MODEL_UQ_PER_PAIR >> 2) // Distance moved during alignment, in start direction
+
+// Checks
+#define MODEL_SETTLE_MS 100 // Motor must be settled on the final target for (at least) the final 100 ms of each test
+#define MODEL_SETTLE_RPM 2.0 // Max. speed of a settled motor (RPM)
+#define MODEL_MAX_OVER (2 * MODEL_WINDOW) // Max. overshoot past final target (Up-scaled QEI positions)
+#define MODEL_MAX_POINTS 4 // Max. No. of points in a target profile
+
+/** Structure containing one point of a target profile. NB Target is held until next point */
+typedef struct MODEL_POINT_TAG
+{
+	int time_ms; // Time of target change (milli-seconds)
+	int targ; // Target position (QEI positions)
+} MODEL_POINT_TYP;
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int stopped; // Flag set if motor starts stationary (PWM off), otherwise motor starts in FOC state, holding position zero
+	int end_ms; // Length of test (milli-seconds)
+	int load_on_ms; // Time load is applied (milli-seconds)
+	int load_off_ms; // Time load is removed (milli-seconds)
+	double load_acc; // Deceleration due to load (RPM per second)
+	int num_points; // No. of points in target profile
+	MODEL_POINT_TYP points[MODEL_MAX_POINTS]; // Target profile
+} MODEL_CONFIG_TYP;
+
+/** Structure containing error counts for one test */
+typedef struct MODEL_ERRS_TAG
+{
+	int follow; // No. of iterations where following error exceeded limit
+	int start; // No. of wrong start decisions (started with target too close, or NOT started with target far enough)
+	int over; // No. of iterations overshooting final target by more than MODEL_MAX_OVER
+	int settle; // No. of iterations NOT settled on final target, during final MODEL_SETTLE_MS
+	int max_follow; // Max. following error magnitude (Up-scaled QEI positions)
+	int max_over; // Max. overshoot past final target (Up-scaled QEI positions)
+	double settle_ms; // Time of last entry into final target window (milli-seconds)
+} MODEL_ERRS_TYP;
+
+#endif /* _POSITION_MODEL_H_ */
@@ -0,0 +1,21 @@
+# ansi C compile: Host model of the Multi-motor PWM Server merge loop, with two motors at the same and different PWM periods
+
+MAIN =	pwm_merge_model
+
+CMODS =	$(MAIN) \
+	pwm_convert_width \
+	pwm_schedule \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	../module_foc_pwm/src/pwm_schedule.h \
+
+INC_DIR = host_inc ../module_foc_pwm/src ../module_foc_util/src ../app_test_pwm/src
+
+OPT = -O2
+
+CONF = -DPWM_MULTI_SERVER=1 -DPWM_PHASE_SHIFT=1
+
+include host_model.mak
+
+#
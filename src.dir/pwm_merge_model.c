@@ -0,0 +1,337 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "pwm_merge_model.h"
+
+/* Host model of the Multi-motor PWM Server merge loop (see foc_pwm_do_triggered_multi() in module_foc_pwm/src/pwm_multi_server.xc)
+ * MODEL_MOTORS motors share one modelled Server, which calls the target merge code (next_pwm_event_motor() in pwm_schedule.c)
+ * to choose each event, and rebuilds each schedule with the target code (convert_all_pulse_widths() and build_pwm_schedule()).
+ * Each Client sends data every MODEL_CLIENT_CYCLES, i.e. many times per PWM period, and blocks until its data is accepted.
+ * The Server services a Client before an event only if the Client is ready first (worst case for the port deadlines).
+ * Port loads of one edge cluster are issued as one burst, as in do_multi_event().
+ * The port timer wraps during every test. For each pair of PWM periods, the following are checked:-
+ *	NO port deadline is missed, and NO rebuild finishes after the earliest edge of the next period
+ *	NO ADC trigger is more than MODEL_MAX_ADC_LATE cycles late
+ *	At most one Client data set is accepted per PWM period (see accept_data), and every period uses new data
+ * Usage: pwm_merge_model.x
+ */
+
+// Test configurations: Name, PWM period of each motor. NB Two motors at PWM_PERIOD_2048 are NOT supported (see pwm_multi_server.h)
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "Same 4096" ,{ PWM_PERIOD_4096 ,PWM_PERIOD_4096 } }
+	,{ "Same 8192" ,{ PWM_PERIOD_8192 ,PWM_PERIOD_8192 } }
+	,{ "Diff 4096/8192" ,{ PWM_PERIOD_4096 ,PWM_PERIOD_8192 } }
+	,{ "Diff 8192/4096" ,{ PWM_PERIOD_8192 ,PWM_PERIOD_4096 } }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+/*****************************************************************************/
+static void accept_client_data( // Receive one data set from Client (see service_multi_command())
+	MODEL_MOTOR_TYP * motor_p, // Pointer to modelled motor
+	PWM_SCHED_TYP * sched_p, // Pointer to edge schedule of this motor
+	int motor_id // Motor identifier
+)
+{
+	int phase_cnt; // phase counter
+
+
+	// Check for data still waiting for the next rebuild
+	if (motor_p->data_ready)
+	{
+		motor_p->extra++;
+	} // if (motor_p->data_ready)
+
+	// NB Widths sweep the full range, with a different sequence for each motor and phase
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		motor_p->comms.params.widths[phase_cnt] = (unsigned)((motor_p->accepts * 7919 + phase_cnt * 4099 + motor_id * 101)
+			% (motor_p->wid_lim + 1));
+	} // for phase_cnt
+
+	motor_p->accepts++;
+	motor_p->data_ready = 1;
+	sched_p->accept_data = 0; // NO more data until this data is used by the next rebuild
+} // accept_client_data
+/*****************************************************************************/
+static void model_next_period( // Build edge schedule for next PWM period of one motor (see next_multi_period())
+	MODEL_MOTOR_TYP * motor_p, // Pointer to modelled motor
+	PWM_SCHED_TYP * sched_p // Pointer to edge schedule of this motor
+)
+{
+	if (motor_p->data_ready)
+	{
+		convert_all_pulse_widths( &(motor_p->comms) ,&(motor_p->buf) );
+		motor_p->data_ready = 0;
+		motor_p->used++;
+	} // if (motor_p->data_ready)
+
+	motor_p->ref_time += motor_p->comms.timing.max_value;
+
+	build_pwm_schedule( sched_p ,&(motor_p->buf) ,motor_p->ref_time ,&(motor_p->comms.timing) ,LOCK_ADC_TO_PWM );
+	motor_p->builds++;
+} // model_next_period
+/*****************************************************************************/
+static unsigned issue_model_event( // Issue next event (or burst of port loads) of one motor (see do_multi_event())
+	MODEL_MOTOR_TYP * motor_p, // Pointer to modelled motor
+	PWM_SCHED_TYP * sched_p, // Pointer to edge schedule of this motor
+	unsigned cur_time // Current port time
+) // Returns port time after event
+{
+	PWM_EVENT_TYP event; // Copy of current event
+	unsigned free_time; // Port time when previous load on same port starts
+	signed short slack; // No. of cycles until event is due
+	int burst = 1; // Flag set while further port loads can be issued
+
+
+	while (burst)
+	{
+		event = sched_p->events[sched_p->next];
+		sched_p->next++;
+		burst = 0;
+
+		if (PWM_EVENT_BUILD == event.port_id)
+		{
+			model_next_period( motor_p ,sched_p );
+			cur_time += MODEL_BUILD_CYCLES;
+
+			// NB Rebuild deadline leaves PWM_BUILD_CYCLES before the earliest edge of the next period
+			if (0 < (int)(cur_time - (event.time + PWM_BUILD_CYCLES)))
+			{
+				motor_p->late_builds++;
+			} // if (0 < (int)(cur_time - (event.time + PWM_BUILD_CYCLES)))
+		} // if (PWM_EVENT_BUILD == event.port_id)
+		else
+		{
+			if (PWM_EVENT_ADC == event.port_id)
+			{
+				if (motor_p->adc_late < (int)(cur_time - event.time))
+				{
+					motor_p->adc_late = (int)(cur_time - event.time);
+				} // if (motor_p->adc_late < (int)(cur_time - event.time))
+
+				cur_time += MODEL_ADC_CYCLES;
+			} // if (PWM_EVENT_ADC == event.port_id)
+			else
+			{ // Timed port load. NB Load can NOT start until previous load on this port has started
+				free_time = event.ready + PWM_READY_LEAD;
+				if (0 < (int)(free_time - cur_time))
+				{
+					cur_time = free_time;
+				} // if (0 < (int)(free_time - cur_time))
+
+				slack = (signed short)(PORT_TIME_TYP)(event.time - cur_time);
+
+				if (PWM_EVENT_MARGIN > slack)
+				{ // Deadline missed: Drop rest of this period, and skip one period (see skip_multi_period())
+					motor_p->misses++;
+
+					init_pwm_schedule( sched_p ,(cur_time + PWM_PORT_WID) );
+					motor_p->ref_time += motor_p->comms.timing.max_value;
+					model_next_period( motor_p ,sched_p );
+				} // if (PWM_EVENT_MARGIN > slack)
+				else
+				{
+					cur_time += PWM_EVENT_MARGIN;
+
+					// Continue burst, if next event is a ready port load in the same edge cluster
+					if ((sched_p->next < sched_p->num_events) && (0 <= sched_p->events[sched_p->next].port_id))
+					{
+						burst = ((0 >= (int)(sched_p->events[sched_p->next].ready - cur_time))
+							&& (PWM_PORT_WID >= (int)(sched_p->events[sched_p->next].time - event.time)));
+					} // if ((sched_p->next < sched_p->num_events) && ...
+				} // else !(PWM_EVENT_MARGIN > slack)
+			} // else !(PWM_EVENT_ADC == event.port_id)
+		} // else !(PWM_EVENT_BUILD == event.port_id)
+	} // while (burst)
+
+	return cur_time;
+} // issue_model_event
+/*****************************************************************************/
+static int rebuild_ready( // Check if the rebuild of one motor is ready
+	PWM_SCHED_TYP * sched_p, // Pointer to edge schedule of this motor
+	unsigned cur_time // Current port time
+) // Returns 1 if rebuild ready
+{
+	int event_cnt; // event counter
+
+
+	for (event_cnt = sched_p->next; event_cnt < sched_p->num_events; event_cnt++)
+	{
+		if (PWM_EVENT_BUILD == sched_p->events[event_cnt].port_id)
+		{
+			return (0 >= (int)(sched_p->events[event_cnt].ready - cur_time));
+		} // if (PWM_EVENT_BUILD == sched_p->events[event_cnt].port_id)
+	} // for event_cnt
+
+	return 0;
+} // rebuild_ready
+/*****************************************************************************/
+static void start_model_motor( // Accept 1st data, and build 1st edge schedule of one motor (see start_multi_motor())
+	MODEL_MOTOR_TYP * motor_p, // Pointer to modelled motor
+	PWM_SCHED_TYP * sched_p, // Pointer to edge schedule of this motor
+	int motor_id, // Motor identifier
+	int period_sel, // Selected PWM period (see PWM_PERIOD_ENUM)
+	unsigned cur_time // Current port time
+)
+{
+	PWM_TIMING_TYP * timing_p = &(motor_p->comms.timing); // Pointer to timing values for selected PWM period
+
+
+	memset( motor_p ,0 ,sizeof(MODEL_MOTOR_TYP) );
+
+	init_pwm_timing( timing_p ,period_sel );
+	motor_p->wid_lim = (int)timing_p->max_value - PWM_DEAD_TIME - 1;
+
+	init_pwm_schedule( sched_p ,cur_time ); // All ports are free
+	accept_client_data( motor_p ,sched_p ,motor_id );
+	motor_p->send_time = cur_time + MODEL_CLIENT_CYCLES;
+
+	motor_p->ref_time = (cur_time + timing_p->max_value) & ~(timing_p->max_value - 1);
+	motor_p->ref_time += motor_id * (timing_p->half_max / MODEL_MOTORS);
+
+	model_next_period( motor_p ,sched_p );
+	sched_p->state = PWM_SCHED_RUN;
+} // start_model_motor
+/*****************************************************************************/
+static int test_one_config( // Run merge loop of modelled Server for one pair of PWM periods
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+{
+	MODEL_MOTOR_TYP motors[MODEL_MOTORS]; // Array of modelled motors
+	PWM_SCHED_TYP sched_arr[MODEL_MOTORS]; // Array of edge schedules (NB As passed to the target merge code)
+	MODEL_MOTOR_TYP * motor_p; // Pointer to modelled motor
+	unsigned cur_time = MODEL_START_TIME; // Modelled port time. NB Wraps during test
+	unsigned end_time; // Port time at end of test
+	unsigned wait_time; // Port time when next event is ready
+	unsigned max_period = 0; // Longest PWM period
+	int motor_id; // Motor with next event
+	int client_id; // Client ready first (-1 if none)
+	int motor_cnt; // motor counter
+	int err_val = 0; // Error value
+
+
+	for (motor_cnt = 0; motor_cnt < MODEL_MOTORS; motor_cnt++)
+	{
+		start_model_motor( &motors[motor_cnt] ,&sched_arr[motor_cnt] ,motor_cnt ,cfg_p->period_sel[motor_cnt] ,cur_time );
+
+		if (max_period < motors[motor_cnt].comms.timing.max_value)
+		{
+			max_period = motors[motor_cnt].comms.timing.max_value;
+		} // if (max_period < motors[motor_cnt].comms.timing.max_value)
+	} // for motor_cnt
+
+	end_time = cur_time + MODEL_PERIODS * max_period;
+
+	while (0 < (int)(end_time - cur_time))
+	{
+		motor_id = next_pwm_event_motor( sched_arr ,MODEL_MOTORS ,cur_time );
+		assert(0 <= motor_id); // ERROR: All motors are running
+		wait_time = sched_arr[motor_id].events[sched_arr[motor_id].next].ready;
+
+		// Count rebuilds that are ready, but deferred for another event
+		for (motor_cnt = 0; motor_cnt < MODEL_MOTORS; motor_cnt++)
+		{
+			if (((motor_cnt != motor_id) || (PWM_EVENT_BUILD != sched_arr[motor_id].events[sched_arr[motor_id].next].port_id))
+				&& rebuild_ready( &sched_arr[motor_cnt] ,cur_time ))
+			{
+				motors[motor_cnt].deferred++;
+			} // if (((motor_cnt != motor_id) || ...
+		} // for motor_cnt
+
+		// Find earliest Client whose data can be accepted (NB select case guard)
+		client_id = -1;
+		for (motor_cnt = 0; motor_cnt < MODEL_MOTORS; motor_cnt++)
+		{
+			if (sched_arr[motor_cnt].accept_data
+				&& ((0 > client_id) || (0 > (int)(motors[motor_cnt].send_time - motors[client_id].send_time))))
+			{
+				client_id = motor_cnt;
+			} // if (sched_arr[motor_cnt].accept_data && ...
+		} // for motor_cnt
+
+		// Check if Client is ready before the next event
+		if ((0 <= client_id) && (0 >= (int)(motors[client_id].send_time - wait_time)))
+		{
+			motor_p = &motors[client_id];
+
+			if (0 < (int)(motor_p->send_time - cur_time))
+			{
+				cur_time = motor_p->send_time;
+			} // if (0 < (int)(motor_p->send_time - cur_time))
+
+			accept_client_data( motor_p ,&sched_arr[client_id] ,client_id );
+			cur_time += MODEL_DATA_CYCLES;
+			motor_p->send_time = cur_time + MODEL_CLIENT_CYCLES; // NB Client was blocked until data accepted
+		} // if ((0 <= client_id) && (0 >= (int)(motors[client_id].send_time - wait_time)))
+		else
+		{
+			if (0 < (int)(wait_time - cur_time))
+			{
+				cur_time = wait_time;
+			} // if (0 < (int)(wait_time - cur_time))
+
+			cur_time = issue_model_event( &motors[motor_id] ,&sched_arr[motor_id] ,cur_time );
+		} // else !((0 <= client_id) && (0 >= (int)(motors[client_id].send_time - wait_time)))
+	} // while (0 < (int)(end_time - cur_time))
+
+	printf("  %-14s:" ,cfg_p->name );
+
+	for (motor_cnt = 0; motor_cnt < MODEL_MOTORS; motor_cnt++)
+	{
+		motor_p = &motors[motor_cnt];
+
+		printf(" M%d: %5d periods, %5d accepted, Deferred=%5d, ADC late=%3d, Errors: Miss=%d Late=%d Extra=%d Stale=%d."
+			,motor_cnt ,motor_p->builds ,motor_p->accepts ,motor_p->deferred ,motor_p->adc_late
+			,motor_p->misses ,motor_p->late_builds ,motor_p->extra ,(motor_p->builds - motor_p->used) );
+
+		err_val += motor_p->misses + motor_p->late_builds + motor_p->extra;
+
+		// NB Every rebuild must use new data, as the Client is always ready
+		if (motor_p->used < motor_p->builds)
+		{
+			err_val++;
+		} // if (motor_p->used < motor_p->builds)
+
+		if (MODEL_MAX_ADC_LATE < motor_p->adc_late)
+		{
+			err_val++;
+		} // if (MODEL_MAX_ADC_LATE < motor_p->adc_late)
+	} // for motor_cnt
+
+	printf(" %s\n" ,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("Multi-motor PWM merge tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,60 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _PWM_MERGE_MODEL_H_
+#define _PWM_MERGE_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pwm_convert_width.h"
+#include "pwm_schedule.h"
+
+#define MODEL_MOTORS 2 // No. of motors sharing the modelled Server
+#define MODEL_PERIODS 2000 // No. of PWM periods modelled for the motor with the longest period
+#define MODEL_START_TIME ((unsigned)(-(1 << 20))) // Initial port time (so timer wrap-around is tested)
+#define MODEL_BUILD_CYCLES 512 // Modelled time to convert new widths and rebuild one schedule (NB Allowance is PWM_BUILD_CYCLES)
+#define MODEL_ADC_CYCLES 4 // Modelled time to send one ADC trigger
+#define MODEL_DATA_CYCLES 32 // Modelled time to receive one data set from a Client
+#define MODEL_CLIENT_CYCLES 300 // Time between Client data sets (NB Much shorter than any PWM period)
+#define MODEL_MAX_ADC_LATE PWM_PORT_WID // Max. No. of cycles an ADC trigger may be late
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int period_sel[MODEL_MOTORS]; // Selected PWM period of each motor (see PWM_PERIOD_ENUM)
+} MODEL_CONFIG_TYP;
+
+/** Structure containing modelled state and error counts for one motor */
+typedef struct MODEL_MOTOR_TAG
+{
+	PWM_COMMS_TYP comms; // Structure containing PWM communication data
+	PWM_BUFFER_TYP buf; // Structure containing converted port data (pattern/time_offset)
+	unsigned ref_time; // Reference time (centre) of current PWM period
+	unsigned send_time; // Port time when Client is next ready to send data
+	int data_ready; // Flag set when new data is waiting for the next rebuild
+	int wid_lim; // Max. Hi-leg width (see convert_phase_pulse_widths())
+	int builds; // No. of rebuilds (one per PWM period)
+	int accepts; // No. of Client data sets accepted
+	int used; // No. of rebuilds that used new Client data
+	int extra; // No. of data sets accepted while previous data still waiting (I.e. more than one per PWM period)
+	int late_builds; // No. of rebuilds finishing after the earliest edge of the next period
+	int misses; // No. of missed port deadlines
+	int adc_late; // Max. No. of cycles an ADC trigger was late
+	int deferred; // No. of merge decisions where a ready rebuild was deferred for another event
+} MODEL_MOTOR_TYP;
+
+#endif /* _PWM_MERGE_MODEL_H_ */
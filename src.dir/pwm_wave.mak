@@ -0,0 +1,20 @@
+# ansi C compile: Host waveform model and exhaustive check of PWM port data
+
+MAIN =	pwm_wave_model
+
+CMODS =	$(MAIN) \
+	pwm_convert_width \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+
+INC_DIR = host_inc ../module_foc_pwm/src ../module_foc_util/src ../app_test_pwm/src
+
+OPT = -O2
+
+# NB Build with single-shunt triggers. The model sets the phase shift at run-time, so checks both modes
+CONF = -DPWM_MULTI_SERVER=1 -DPWM_PHASE_SHIFT=1 -DPWM_SINGLE_SHUNT=1
+
+include host_model.mak
+
+#
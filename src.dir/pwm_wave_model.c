@@ -0,0 +1,680 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "pwm_wave_model.h"
+
+/* Host waveform model of the PWM Server ports (see module_foc_pwm/src/pwm_server.xc)
+ * The port data (pattern/time_offset) is generated by the target code (convert_all_pulse_widths() in pwm_convert_width.c),
+ * then replayed bit-by-bit on a model of each 1-bit, 32-bit buffered port:
+ *	A timed load shifts out 32 bits (LS-bit first) from its port time, after which the port holds the MS-bit.
+ *	A load must NOT start before the previous load on the same port has been shifted out.
+ * Every PWM period is checked for pulse width, single pulse, centre alignment, and dead-time between the legs of each phase.
+ * With phase shift (see PWM_PHASE_SHIFT), each phase is checked in its own (shifted) PWM period,
+ * and each single-shunt trigger is checked to be in a settled window, where the DC-link carries the phase named by its token.
+ *
+ * Usage: pwm_wave_model.x
+ *	Checks every Hi-leg width from 0 to the PWM period, for every selectable PWM period (see PWM_PERIOD_ENUM),
+ *	without and with phase shift. With phase shift, equal widths are also checked (e.g. zero voltage).
+ *	Widths whose Lo-leg pulse (width + PWM_DEAD_TIME) would fill the period are rejected by the conversion, so are NOT checked.
+ *	Consecutive periods use different widths, so the value held between periods is also checked. Returns 1 if any check fails.
+ * Usage: pwm_wave_model.x wid_A wid_B wid_C [period_sel]
+ *	Writes WAVE_VCD_PERIODS periods with the given Hi-leg widths to WAVE_VCD_NAME (e.g. for GTKWave), with phase shift
+ *
+ * NB The ports start in the safe state used by the Server (Hi-legs off, Lo-legs high), so the 1st period is NOT checked.
+ * The model uses host stand-ins for the XMOS headers (see src.dir/host_inc)
+ */
+
+static const char * wave_err_names[NUM_WAVE_ERRS] = { "Load" ,"Width" ,"Pulse" ,"Centre" ,"Dead" ,"Shunt" };
+static const char wave_phase_names[NUM_PWM_PHASES] = { 'A' ,'B' ,'C' };
+
+/*****************************************************************************/
+static void init_wave_model( // Initialise waveform model for one PWM period selection
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	int period_sel, // Selected PWM period (see PWM_PERIOD_ENUM)
+	int shift // Phase shift (0 == Off)
+)
+{
+	int phase_cnt; // phase counter
+	int err_cnt; // error counter
+
+
+	memset( model_p ,0 ,sizeof(WAVE_MODEL_TYP) );
+
+	init_pwm_timing( &(model_p->comms.timing) ,period_sel );
+	model_p->comms.timing.shift = shift; // NB Overrides table value, so both modes are checked
+
+	model_p->period_sel = period_sel;
+	model_p->wid_lim = (int)model_p->comms.timing.max_value - PWM_DEAD_TIME - 1; // NB See convert_phase_pulse_widths()
+	model_p->start_time = 0;
+
+	// Ports start in safe state (see PWM_SAFE_HI_PATN and PWM_SAFE_LO_PATN)
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		model_p->ports[PWM_PORT_ID( PWM_HI_LEG ,phase_cnt )].hold = 0;
+		model_p->ports[PWM_PORT_ID( PWM_LO_LEG ,phase_cnt )].hold = 1;
+	} // for phase_cnt
+
+	for (err_cnt = 0; err_cnt < NUM_WAVE_ERRS; err_cnt++)
+	{
+		model_p->err_cnts[err_cnt] = 0;
+	} // for err_cnt
+} // init_wave_model
+/*****************************************************************************/
+static void load_port( // Model one timed load of a 32-bit buffered port
+	WAVE_PORT_TYP * port_p, // Pointer to structure containing state of one modelled port
+	int start_time, // Time at start of current PWM period
+	int num_bits, // No. of port bits in PWM period
+	int load_time, // Port time of load
+	unsigned pattern // Bit-pattern written to port
+)
+{
+	int off = load_time - start_time; // Offset of load into current PWM period
+	int bit_cnt; // bit counter
+
+
+	// Check load is inside this period, and does NOT overlap previous load
+	if ((0 > off) || (num_bits < (off + PWM_PORT_WID)) || (load_time < port_p->free_time))
+	{
+		port_p->load_err = 1;
+	} // if ((0 > off) || ...
+
+	// Shift out pattern, LS-bit first
+	for (bit_cnt = 0; bit_cnt < PWM_PORT_WID; bit_cnt++)
+	{
+		if ((0 <= (off + bit_cnt)) && (num_bits > (off + bit_cnt)))
+		{
+			port_p->bits[off + bit_cnt] = (unsigned char)((pattern >> bit_cnt) & 1);
+		} // if ((0 <= (off + bit_cnt)) && ...
+	} // for bit_cnt
+
+	// Port holds MS-bit until next load
+	port_p->hold = (pattern >> (PWM_PORT_WID - 1)) & 1;
+
+	for (bit_cnt = (off + PWM_PORT_WID); bit_cnt < num_bits; bit_cnt++)
+	{
+		if (0 <= bit_cnt)
+		{
+			port_p->bits[bit_cnt] = (unsigned char)port_p->hold;
+		} // if (0 <= bit_cnt)
+	} // for bit_cnt
+
+	port_p->free_time = load_time + PWM_PORT_WID;
+} // load_port
+/*****************************************************************************/
+static int phase_centre_off( // Returns time-offset of pulse centre for one phase (see PWM_PHASE_SHIFT)
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	int phase_cnt // Phase identifier
+)
+{
+	return ((phase_cnt - PWM_PHASE_B) * model_p->comms.timing.shift); // NB Same as convert_all_pulse_widths()
+} // phase_centre_off
+/*****************************************************************************/
+static void replay_port_period( // Replay port data for one PWM period of one port
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	WAVE_PORT_TYP * port_p, // Pointer to structure containing state of one modelled port
+	PWM_PORT_TYP * rise_data_p, // Pointer to port data for rising edge
+	PWM_PORT_TYP * fall_data_p, // Pointer to port data for falling edge
+	int centre_off // time-offset of pulse centre for this phase
+)
+{
+	int num_bits = (int)model_p->comms.timing.max_value; // No. of port bits in PWM period
+	int win_start = model_p->start_time + centre_off; // Time at start of PWM period for this phase
+	int ref_time = model_p->start_time + (int)model_p->comms.timing.half_max; // Reference time (centre) of PWM period
+
+
+	port_p->prev_end = port_p->hold;
+	memset( port_p->bits ,(int)port_p->hold ,num_bits ); // Port holds value from previous period
+	port_p->load_err = 0;
+
+	// NB Same order as Server: rising edge, then falling edge
+	load_port( port_p ,win_start ,num_bits ,(ref_time + rise_data_p->time_off) ,rise_data_p->pattern );
+	load_port( port_p ,win_start ,num_bits ,(ref_time + fall_data_p->time_off) ,fall_data_p->pattern );
+} // replay_port_period
+/*****************************************************************************/
+static unsigned port_value( // Returns value of one modelled port at one time
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	int port_id, // Port identifier (see PWM_PORT_ID)
+	int time_off // time-offset from reference time of current PWM period
+)
+/* NB Before the (shifted) PWM period of this port, the value held at the end of the previous period is returned,
+ * and after it, the value held at its end (NO load of the next period can start earlier)
+ */
+{
+	WAVE_PORT_TYP * port_p = &(model_p->ports[port_id]); // Pointer to modelled port
+	int num_bits = (int)model_p->comms.timing.max_value; // No. of port bits in PWM period
+	int bit_cnt = time_off + (int)model_p->comms.timing.half_max - phase_centre_off( model_p ,(port_id % NUM_PWM_PHASES) );
+
+
+	if (0 > bit_cnt)
+	{
+		return port_p->prev_end;
+	} // if (0 > bit_cnt)
+
+	if (num_bits <= bit_cnt)
+	{
+		return port_p->bits[num_bits - 1];
+	} // if (num_bits <= bit_cnt)
+
+	return port_p->bits[bit_cnt];
+} // port_value
+/*****************************************************************************/
+static void run_wave_period( // Convert widths with target code, and replay port data for one PWM period
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	unsigned widths[] // Array of Hi-leg widths, one for each phase
+)
+{
+	int phase_cnt; // phase counter
+
+
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		model_p->comms.params.widths[phase_cnt] = widths[phase_cnt];
+	} // for phase_cnt
+
+	convert_all_pulse_widths( &(model_p->comms) ,&(model_p->buf) );
+
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		replay_port_period( model_p ,&(model_p->ports[PWM_PORT_ID( PWM_HI_LEG ,phase_cnt )])
+			,&(model_p->buf.rise_edg.phase_data[phase_cnt].hi) ,&(model_p->buf.fall_edg.phase_data[phase_cnt].hi)
+			,phase_centre_off( model_p ,phase_cnt ) );
+
+		replay_port_period( model_p ,&(model_p->ports[PWM_PORT_ID( PWM_LO_LEG ,phase_cnt )])
+			,&(model_p->buf.rise_edg.phase_data[phase_cnt].lo) ,&(model_p->buf.fall_edg.phase_data[phase_cnt].lo)
+			,phase_centre_off( model_p ,phase_cnt ) );
+	} // for phase_cnt
+} // run_wave_period
+/*****************************************************************************/
+static void measure_pulse( // Measure pulse in one PWM period of one port
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	WAVE_PORT_TYP * port_p, // Pointer to structure containing state of one modelled port
+	WAVE_PULSE_TYP * pulse_p // Pointer to structure containing measured pulse
+)
+{
+	int num_bits = (int)model_p->comms.timing.max_value; // No. of port bits in PWM period
+	int half_max = (int)model_p->comms.timing.half_max; // Offset of reference time into PWM period
+	unsigned prev_bit = 0; // Previous port value
+	int bit_cnt; // bit counter
+
+
+	pulse_p->first = 0;
+	pulse_p->last = 0;
+	pulse_p->ones = 0;
+	pulse_p->runs = 0;
+
+	for (bit_cnt = 0; bit_cnt < num_bits; bit_cnt++)
+	{
+		if (port_p->bits[bit_cnt])
+		{
+			if (0 == pulse_p->ones)
+			{
+				pulse_p->first = bit_cnt - half_max;
+			} // if (0 == pulse_p->ones)
+
+			if (0 == prev_bit)
+			{
+				pulse_p->runs++; // Start of new pulse
+			} // if (0 == prev_bit)
+
+			pulse_p->last = bit_cnt - half_max;
+			pulse_p->ones++;
+		} // if (port_p->bits[bit_cnt])
+
+		prev_bit = port_p->bits[bit_cnt];
+	} // for bit_cnt
+} // measure_pulse
+/*****************************************************************************/
+static int check_wave_phase( // Check one PWM period of one phase
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	int phase_cnt, // Phase to check
+	int hi_wid // Requested Hi-leg width
+) // Returns No. of errors found
+{
+	WAVE_PORT_TYP * hi_port_p = &(model_p->ports[PWM_PORT_ID( PWM_HI_LEG ,phase_cnt )]); // Pointer to Hi-leg port
+	WAVE_PORT_TYP * lo_port_p = &(model_p->ports[PWM_PORT_ID( PWM_LO_LEG ,phase_cnt )]); // Pointer to Lo-leg port
+	WAVE_PULSE_TYP hi_pulse; // Measured Hi-leg pulse
+	WAVE_PULSE_TYP lo_pulse; // Measured Lo-leg pulse
+	int lo_wid = hi_wid + PWM_DEAD_TIME; // Expected Lo-leg width
+	int errs[NUM_WAVE_ERRS]; // Array of error flags, one for each error type
+	int err_cnt; // error counter
+	int num_errs = 0; // No. of errors found
+
+
+	measure_pulse( model_p ,hi_port_p ,&hi_pulse );
+	measure_pulse( model_p ,lo_port_p ,&lo_pulse );
+
+	errs[WAVE_ERR_LOAD] = (hi_port_p->load_err || lo_port_p->load_err);
+	errs[WAVE_ERR_WIDTH] = ((hi_wid != hi_pulse.ones) || (lo_wid != lo_pulse.ones));
+	errs[WAVE_ERR_PULSE] = ((((0 < hi_wid) ? 1 : 0) != hi_pulse.runs) || (1 != lo_pulse.runs));
+
+	// NB Centre may be half a bit early, when the width is odd
+	errs[WAVE_ERR_CENTRE] = (1 < abs( lo_pulse.first + lo_pulse.last + 1 ));
+	errs[WAVE_ERR_DEAD] = 0;
+
+	if (0 < hi_pulse.ones)
+	{
+		errs[WAVE_ERR_CENTRE] |= (1 < abs( hi_pulse.first + hi_pulse.last + 1 ));
+
+		errs[WAVE_ERR_DEAD] = (((hi_pulse.first - lo_pulse.first) < (PWM_DEAD_TIME >> 1))
+			|| ((lo_pulse.last - hi_pulse.last) < (PWM_DEAD_TIME >> 1)));
+	} // if (0 < hi_pulse.ones)
+
+	for (err_cnt = 0; err_cnt < NUM_WAVE_ERRS; err_cnt++)
+	{
+		if (errs[err_cnt])
+		{
+			if (WAVE_PRINT_ERRS > model_p->err_cnts[err_cnt])
+			{
+				printf("    ERROR %-6s: Phase_%c Width=%4d Hi=[%5d..%5d] %4d ones, Lo=[%5d..%5d] %4d ones\n"
+					,wave_err_names[err_cnt] ,wave_phase_names[phase_cnt] ,hi_wid
+					,hi_pulse.first ,hi_pulse.last ,hi_pulse.ones ,lo_pulse.first ,lo_pulse.last ,lo_pulse.ones );
+			} // if (WAVE_PRINT_ERRS > model_p->err_cnts[err_cnt])
+
+			model_p->err_cnts[err_cnt]++;
+			num_errs++;
+		} // if (errs[err_cnt])
+	} // for err_cnt
+
+	return num_errs;
+} // check_wave_phase
+/*****************************************************************************/
+static int check_shunt_triggers( // Check single-shunt triggers of one PWM period
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	unsigned widths[] // Array of Hi-leg widths, one for each phase
+) // Returns No. of errors found
+/* From WAVE_SHUNT_SETTLE before each trigger, until PWM_SHUNT_GUARD after it, every phase must be either
+ * connected to the DC-link (Hi-leg on, Lo-leg off), or NOT (Hi-leg off, Lo-leg on). NB Lo-leg port is inverted, so 1 is off.
+ * Sample 0 must have only the token phase connected, and sample 1 all phases except the token phase.
+ */
+{
+	PWM_SHUNT_TYP * shunt_p = &(model_p->buf.shunt); // Pointer to single-shunt trigger data
+	int meas_phases[PWM_SHUNT_TRIGS]; // Array of phases measured by each sample
+	int samp_cnt; // sample counter
+	int phase_cnt; // phase counter
+	int time_off; // time-offset from reference time
+	unsigned conn; // Expected value of both legs (1 == connected to DC-link)
+	int err = 0; // Flag set if error found
+
+
+	if (0 == shunt_p->valid)
+	{
+		return 0; // NO triggers sent
+	} // if (0 == shunt_p->valid)
+
+	model_p->shunt_cnt++;
+
+	for (samp_cnt = 0; samp_cnt < PWM_SHUNT_TRIGS; samp_cnt++)
+	{
+		meas_phases[samp_cnt] = (int)(shunt_p->tokens[samp_cnt] - PWM_SHUNT_CT_BASE) % NUM_PWM_PHASES;
+
+		// Check token identifies this sample
+		if (samp_cnt != ((int)(shunt_p->tokens[samp_cnt] - PWM_SHUNT_CT_BASE) / NUM_PWM_PHASES))
+		{
+			err = 1;
+		} // if (samp_cnt != ...
+
+		for (time_off = (shunt_p->trig_offs[samp_cnt] - WAVE_SHUNT_SETTLE);
+			time_off < (shunt_p->trig_offs[samp_cnt] + PWM_SHUNT_GUARD); time_off++)
+		{
+			for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+			{
+				conn = ((meas_phases[samp_cnt] == phase_cnt) ? 1 : 0) ^ (unsigned)samp_cnt;
+
+				if ((conn != port_value( model_p ,PWM_PORT_ID( PWM_HI_LEG ,phase_cnt ) ,time_off ))
+					|| (conn != port_value( model_p ,PWM_PORT_ID( PWM_LO_LEG ,phase_cnt ) ,time_off )))
+				{
+					err = 1;
+				} // if ((conn != port_value( model_p ,PWM_PORT_ID( PWM_HI_LEG ,phase_cnt ) ,time_off )) || ...
+			} // for phase_cnt
+		} // for time_off
+	} // for samp_cnt
+
+	if (meas_phases[0] == meas_phases[1])
+	{
+		err = 1;
+	} // if (meas_phases[0] == meas_phases[1])
+
+	if (err)
+	{
+		if (WAVE_PRINT_ERRS > model_p->err_cnts[WAVE_ERR_SHUNT])
+		{
+			printf("    ERROR %-6s: Widths=[%4u %4u %4u] Triggers=[%5d %5d] Phases=[%c %c]\n"
+				,wave_err_names[WAVE_ERR_SHUNT] ,widths[PWM_PHASE_A] ,widths[PWM_PHASE_B] ,widths[PWM_PHASE_C]
+				,shunt_p->trig_offs[0] ,shunt_p->trig_offs[1]
+				,wave_phase_names[meas_phases[0]] ,wave_phase_names[meas_phases[1]] );
+		} // if (WAVE_PRINT_ERRS > model_p->err_cnts[WAVE_ERR_SHUNT])
+
+		model_p->err_cnts[WAVE_ERR_SHUNT]++;
+	} // if (err)
+
+	return err;
+} // check_shunt_triggers
+/*****************************************************************************/
+static int check_wave_period( // Run and check one PWM period for all phases
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	unsigned widths[] // Array of Hi-leg widths, one for each phase
+) // Returns No. of errors found
+{
+	int phase_cnt; // phase counter
+	int num_errs = 0; // No. of errors found
+
+
+	run_wave_period( model_p ,widths );
+
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		num_errs += check_wave_phase( model_p ,phase_cnt ,(int)widths[phase_cnt] );
+	} // for phase_cnt
+
+	if (model_p->comms.timing.shift)
+	{
+		num_errs += check_shunt_triggers( model_p ,widths );
+	} // if (model_p->comms.timing.shift)
+
+	model_p->start_time += (int)model_p->comms.timing.max_value;
+
+	return num_errs;
+} // check_wave_period
+/*****************************************************************************/
+static int check_all_widths( // Check every Hi-leg width for one PWM period selection
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	int period_sel, // Selected PWM period (see PWM_PERIOD_ENUM)
+	int shift // Phase shift (0 == Off)
+) // Returns No. of errors found
+/* Phase_A steps through every width. Phase_B steps down, and Phase_C jumps, so consecutive periods are very different.
+ * With phase shift, all phases then step through every width together. Zero voltage (all widths at half the period)
+ * must give valid single-shunt triggers
+ */
+{
+	unsigned widths[NUM_PWM_PHASES] = { 0 ,0 ,0 }; // Array of Hi-leg widths, one for each phase
+	int wid_cnt; // width counter
+	int num_errs = 0; // No. of errors found
+	int num_skips = 0; // No. of widths too wide for dead-time
+	int err_cnt; // error counter
+
+
+	init_wave_model( model_p ,period_sel ,shift );
+
+	run_wave_period( model_p ,widths ); // Leave safe state. NB NOT checked
+	model_p->start_time += (int)model_p->comms.timing.max_value;
+
+	for (wid_cnt = 0; wid_cnt <= (int)model_p->comms.timing.max_value; wid_cnt++)
+	{
+		if (model_p->wid_lim < wid_cnt)
+		{ // Rejected by conversion (Lo-leg pulse would fill period)
+			num_skips++;
+		} // if (model_p->wid_lim < wid_cnt)
+		else
+		{
+			widths[PWM_PHASE_A] = (unsigned)wid_cnt;
+			widths[PWM_PHASE_B] = (unsigned)(model_p->wid_lim - wid_cnt);
+			widths[PWM_PHASE_C] = (unsigned)((wid_cnt * 5) % (model_p->wid_lim + 1));
+
+			num_errs += check_wave_period( model_p ,widths );
+		} // else !(model_p->wid_lim < wid_cnt)
+	} // for wid_cnt
+
+	if (shift)
+	{
+		for (wid_cnt = 0; wid_cnt <= model_p->wid_lim; wid_cnt++)
+		{
+			widths[PWM_PHASE_A] = widths[PWM_PHASE_B] = widths[PWM_PHASE_C] = (unsigned)wid_cnt;
+
+			num_errs += check_wave_period( model_p ,widths );
+
+			if ((wid_cnt == (int)model_p->comms.timing.half_max) && (0 == model_p->buf.shunt.valid))
+			{
+				printf("    ERROR %-6s: NO valid triggers at zero voltage\n" ,wave_err_names[WAVE_ERR_SHUNT] );
+				model_p->err_cnts[WAVE_ERR_SHUNT]++;
+				num_errs++;
+			} // if ((wid_cnt == (int)model_p->comms.timing.half_max) && ...
+		} // for wid_cnt
+	} // if (shift)
+
+	printf("  Period=%5d Shift=%3d: Widths [0..%4d] checked, %3d too wide for dead-time, %5d periods with shunt triggers. Errors:"
+		,model_p->comms.timing.max_value ,shift ,model_p->wid_lim ,num_skips ,model_p->shunt_cnt );
+
+	for (err_cnt = 0; err_cnt < NUM_WAVE_ERRS; err_cnt++)
+	{
+		printf(" %s=%d" ,wave_err_names[err_cnt] ,model_p->err_cnts[err_cnt] );
+	} // for err_cnt
+
+	printf(" %s\n" ,(num_errs ? "FAIL" : "PASS") );
+
+	return num_errs;
+} // check_all_widths
+/*****************************************************************************/
+static void write_vcd_header( // Write header of Value Change Dump file
+	FILE * vcd_p // Pointer to VCD file
+)
+{
+	int phase_cnt; // phase counter
+
+
+	fprintf( vcd_p ,"$version pwm_wave_model $end\n" );
+	fprintf( vcd_p ,"$timescale %d ns $end\n" ,(1000 / PLATFORM_REFERENCE_MHZ) ); // One port bit per Reference clock cycle
+	fprintf( vcd_p ,"$scope module pwm $end\n" );
+
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		fprintf( vcd_p ,"$var wire 1 %c hi_%c $end\n" ,('!' + PWM_PORT_ID( PWM_HI_LEG ,phase_cnt )) ,wave_phase_names[phase_cnt] );
+		fprintf( vcd_p ,"$var wire 1 %c lo_%c $end\n" ,('!' + PWM_PORT_ID( PWM_LO_LEG ,phase_cnt )) ,wave_phase_names[phase_cnt] );
+	} // for phase_cnt
+
+	fprintf( vcd_p ,"$var wire 1 %c adc_trig $end\n" ,('!' + WAVE_SIG_TRIG) );
+	fprintf( vcd_p ,"$var wire 1 %c adc_samp $end\n" ,('!' + WAVE_SIG_SAMP) );
+	fprintf( vcd_p ,"$upscope $end\n" );
+	fprintf( vcd_p ,"$enddefinitions $end\n" );
+} // write_vcd_header
+/*****************************************************************************/
+static unsigned adc_sample_point( // Returns 1 if an ADC sample point is at given time-offset
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	int time_off // time-offset from reference time
+)
+/* With phase shift, the single-shunt triggers are used (if valid), otherwise one sample at the reference time
+ */
+{
+	int samp_cnt; // sample counter
+
+
+	if (0 == LOCK_ADC_TO_PWM)
+	{
+		return 0;
+	} // if (0 == LOCK_ADC_TO_PWM)
+
+	if (0 == model_p->comms.timing.shift)
+	{
+		return (0 == time_off);
+	} // if (0 == model_p->comms.timing.shift)
+
+	if (model_p->buf.shunt.valid)
+	{
+		for (samp_cnt = 0; samp_cnt < PWM_SHUNT_TRIGS; samp_cnt++)
+		{
+			if (model_p->buf.shunt.trig_offs[samp_cnt] == time_off)
+			{
+				return 1;
+			} // if (model_p->buf.shunt.trig_offs[samp_cnt] == time_off)
+		} // for samp_cnt
+	} // if (model_p->buf.shunt.valid)
+
+	return 0;
+} // adc_sample_point
+/*****************************************************************************/
+static void write_vcd_period( // Write value changes for one PWM period
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	FILE * vcd_p, // Pointer to VCD file
+	unsigned prev_vals[] // Array of previous values, one for each signal
+)
+/* NB Each ADC trigger is sent 1/4 of a PWM period before its sample point (see build_pwm_schedule()).
+ * Both are shown as one-cycle pulses. The dump starts one phase shift early, so that it contains the whole Phase_A period.
+ * VCD times are offset by the same amount, so they start at zero
+ */
+{
+	int num_bits = (int)model_p->comms.timing.max_value; // No. of port bits in PWM period
+	int half_max = (int)model_p->comms.timing.half_max; // Offset of reference time into PWM period
+	int quart_max = (int)model_p->comms.timing.quart_max; // ADC trigger is sent this early
+	int shift = model_p->comms.timing.shift; // Phase shift
+	unsigned cur_val; // Current value of signal
+	int time_done; // Flag set when time-stamp written
+	int time_off; // time-offset from reference time
+	int bit_cnt; // bit counter
+	int sig_cnt; // signal counter
+
+
+	for (bit_cnt = 0; bit_cnt < num_bits; bit_cnt++)
+	{
+		time_done = 0;
+		time_off = bit_cnt - half_max - shift;
+
+		for (sig_cnt = 0; sig_cnt < NUM_WAVE_SIGS; sig_cnt++)
+		{
+			if (NUM_PWM_PORTS > sig_cnt)
+			{
+				cur_val = port_value( model_p ,sig_cnt ,time_off );
+			} // if (NUM_PWM_PORTS > sig_cnt)
+			else
+			{
+				cur_val = adc_sample_point( model_p ,((WAVE_SIG_TRIG == sig_cnt) ? (time_off + quart_max) : time_off) );
+			} // else !(NUM_PWM_PORTS > sig_cnt)
+
+			if ((cur_val != prev_vals[sig_cnt]) || (0 == (model_p->start_time + bit_cnt)))
+			{
+				if (0 == time_done)
+				{
+					fprintf( vcd_p ,"#%d\n" ,(model_p->start_time + bit_cnt) );
+					time_done = 1;
+				} // if (0 == time_done)
+
+				fprintf( vcd_p ,"%u%c\n" ,cur_val ,('!' + sig_cnt) );
+				prev_vals[sig_cnt] = cur_val;
+			} // if ((cur_val != prev_vals[sig_cnt]) || ...
+		} // for sig_cnt
+	} // for bit_cnt
+} // write_vcd_period
+/*****************************************************************************/
+static int write_vcd_file( // Replay given widths, and write waveforms to Value Change Dump file
+	WAVE_MODEL_TYP * model_p, // Pointer to structure containing data for waveform model
+	unsigned widths[], // Array of Hi-leg widths, one for each phase
+	int period_sel // Selected PWM period (see PWM_PERIOD_ENUM)
+) // Returns No. of errors found
+{
+	FILE * vcd_p; // Pointer to VCD file
+	unsigned prev_vals[NUM_WAVE_SIGS]; // Array of previous values, one for each signal
+	int period_cnt; // PWM period counter
+	int phase_cnt; // phase counter
+	int num_errs = 0; // No. of errors found
+
+
+	init_wave_model( model_p ,period_sel ,PWM_SHIFT_CYCLES );
+
+	for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+	{
+		if (model_p->wid_lim < (int)widths[phase_cnt])
+		{
+			printf("ERROR: Phase_%c width %u exceeds %d (Lo-leg pulse would fill period)\n"
+				,wave_phase_names[phase_cnt] ,widths[phase_cnt] ,model_p->wid_lim );
+			return 1;
+		} // if (model_p->wid_lim < (int)widths[phase_cnt])
+	} // for phase_cnt
+
+	vcd_p = fopen( WAVE_VCD_NAME ,"w" );
+	if (NULL == vcd_p)
+	{
+		printf("ERROR: Opening File %s\n" ,WAVE_VCD_NAME );
+		return 1;
+	} // if (NULL == vcd_p)
+
+	write_vcd_header( vcd_p );
+	memset( prev_vals ,0 ,sizeof(prev_vals) );
+
+	for (period_cnt = 0; period_cnt < WAVE_VCD_PERIODS; period_cnt++)
+	{
+		run_wave_period( model_p ,widths );
+		write_vcd_period( model_p ,vcd_p ,prev_vals );
+
+		// NB 1st period starts from safe state, so is NOT checked
+		if (0 < period_cnt)
+		{
+			for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+			{
+				num_errs += check_wave_phase( model_p ,phase_cnt ,(int)widths[phase_cnt] );
+			} // for phase_cnt
+
+			num_errs += check_shunt_triggers( model_p ,widths );
+		} // if (0 < period_cnt)
+
+		model_p->start_time += (int)model_p->comms.timing.max_value;
+	} // for period_cnt
+
+	fprintf( vcd_p ,"#%d\n" ,model_p->start_time );
+	fclose( vcd_p );
+
+	printf("%d periods of %d cycles (Shift=%d) written to %s, %d errors\n"
+		,WAVE_VCD_PERIODS ,model_p->comms.timing.max_value ,model_p->comms.timing.shift ,WAVE_VCD_NAME ,num_errs );
+
+	return num_errs;
+} // write_vcd_file
+/*****************************************************************************/
+int main( int argc ,char * argv[] )
+{
+	static WAVE_MODEL_TYP model_s; // Structure containing data for waveform model. NB static, as port arrays are large
+	unsigned widths[NUM_PWM_PHASES]; // Array of Hi-leg widths, one for each phase
+	int period_sel = PWM_PERIOD_DEF; // Selected PWM period
+	int phase_cnt; // phase counter
+	int num_errs = 0; // No. of errors found
+
+
+	if (1 == argc)
+	{
+		printf("PWM waveform checks (Dead-time=%d cycles)\n" ,PWM_DEAD_TIME );
+
+		for (period_sel = 0; period_sel < NUM_PWM_PERIODS; period_sel++)
+		{
+			num_errs += check_all_widths( &model_s ,period_sel ,0 );
+			num_errs += check_all_widths( &model_s ,period_sel ,PWM_SHIFT_CYCLES );
+		} // for period_sel
+
+		printf("%d errors found\n" ,num_errs );
+	} // if (1 == argc)
+	else
+	{
+		if ((NUM_PWM_PHASES + 1) > argc)
+		{
+			printf("Usage: %s [wid_A wid_B wid_C [period_sel]]\n" ,argv[0] );
+			return 1;
+		} // if ((NUM_PWM_PHASES + 1) > argc)
+
+		for (phase_cnt = 0; phase_cnt < NUM_PWM_PHASES; phase_cnt++)
+		{
+			widths[phase_cnt] = (unsigned)atoi( argv[phase_cnt + 1] );
+		} // for phase_cnt
+
+		if ((NUM_PWM_PHASES + 1) < argc)
+		{
+			period_sel = atoi( argv[NUM_PWM_PHASES + 1] );
+
+			if ((0 > period_sel) || (NUM_PWM_PERIODS <= period_sel))
+			{
+				printf("ERROR: period_sel must be in range [0..%d] (see PWM_PERIOD_ENUM)\n" ,(NUM_PWM_PERIODS - 1) );
+				return 1;
+			} // if ((0 > period_sel) || (NUM_PWM_PERIODS <= period_sel))
+		} // if ((NUM_PWM_PHASES + 1) < argc)
+
+		num_errs = write_vcd_file( &model_s ,widths ,period_sel );
+	} // else !(1 == argc)
+
+	return (num_errs ? 1 : 0);
+} // main
+/*****************************************************************************/
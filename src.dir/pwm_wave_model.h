@@ -0,0 +1,78 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _PWM_WAVE_MODEL_H_
+#define _PWM_WAVE_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pwm_convert_width.h"
+#include "pwm_schedule.h" // NB Only for port identifiers (see PWM_PORT_ID)
+
+#define WAVE_MAX_BITS (1 << PWM_PERIOD_MAX_BITS) // Max. No. of port bits in one PWM period
+#define WAVE_VCD_NAME "pwm_wave.vcd" // Name of Value Change Dump file
+#define WAVE_VCD_PERIODS 4 // No. of PWM periods written to VCD file
+#define WAVE_PRINT_ERRS 8 // Max. No. of errors printed for each PWM period selection
+#define WAVE_SIG_TRIG NUM_PWM_PORTS // VCD signal for ADC trigger (NB Follows port signals)
+#define WAVE_SIG_SAMP (NUM_PWM_PORTS + 1) // VCD signal for ADC sample point
+#define NUM_WAVE_SIGS (NUM_PWM_PORTS + 2) // No. of VCD signals
+#define WAVE_SHUNT_SETTLE (PWM_SHUNT_MIN_WIN - PWM_SHUNT_GUARD) // DC-link must be settled this long before single-shunt trigger
+
+/** Different errors found in one PWM period of one phase */
+typedef enum WAVE_ERR_ETAG
+{
+  WAVE_ERR_LOAD = 0,	// Port load overlaps previous load, or falls outside PWM period
+  WAVE_ERR_WIDTH,			// No. of one-bits differs from requested width
+  WAVE_ERR_PULSE,			// More than one pulse in PWM period
+  WAVE_ERR_CENTRE,		// Pulse NOT centred on reference time
+  WAVE_ERR_DEAD,			// Hi-leg pulse NOT inside Lo-leg pulse by half dead-time WARNING: Safety critical
+  WAVE_ERR_SHUNT,			// Single-shunt trigger NOT inside a settled window, where DC-link carries the token phase
+  NUM_WAVE_ERRS				// Handy Value!-)
+} WAVE_ERR_ENUM;
+
+/** Structure containing state of one modelled 1-bit buffered port */
+typedef struct WAVE_PORT_TAG
+{
+	unsigned char bits[WAVE_MAX_BITS]; // Array of port values for current PWM period
+	unsigned hold; // Value held on port after last load (MS-bit of last pattern)
+	unsigned prev_end; // Value held on port before current PWM period (i.e. at end of previous period)
+	int free_time; // Time when last load has been shifted out (NB Next load can NOT start earlier)
+	int load_err; // Flag set if a load overlapped the previous one, or fell outside the PWM period
+} WAVE_PORT_TYP;
+
+/** Structure containing measured pulse for one PWM period of one port */
+typedef struct WAVE_PULSE_TAG
+{
+	int first; // Time-offset of first one-bit (from reference time)
+	int last; // Time-offset of last one-bit (from reference time)
+	int ones; // No. of one-bits
+	int runs; // No. of separate pulses
+} WAVE_PULSE_TYP;
+
+/** Structure containing data for waveform model */
+typedef struct WAVE_MODEL_TAG
+{
+	WAVE_PORT_TYP ports[NUM_PWM_PORTS]; // Array of modelled ports (see PWM_PORT_ID)
+	PWM_COMMS_TYP comms; // Structure containing PWM communication data (Client side)
+	PWM_BUFFER_TYP buf; // Structure containing converted port data (pattern/time_offset)
+	int period_sel; // Selected PWM period (see PWM_PERIOD_ENUM)
+	int wid_lim; // Max. Hi-leg width (Lo-leg width must be less than PWM period)
+	int start_time; // Time at start of current PWM period (NB Phase_B. Other phases are shifted, see PWM_PHASE_SHIFT)
+	int shunt_cnt; // No. of PWM periods with valid single-shunt triggers
+	int err_cnts[NUM_WAVE_ERRS]; // Array of error counts, one for each error type
+} WAVE_MODEL_TYP;
+
+#endif /* _PWM_WAVE_MODEL_H_ */
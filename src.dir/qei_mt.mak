@@ -0,0 +1,19 @@
+# ansi C compile: Host check of QEI M/T velocity across the speed range, with timer wrap and stop
+
+MAIN =	qei_mt_model
+
+CMODS =	$(MAIN) \
+	qei_decode \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	qei_decode.h \
+	qei_common.h \
+
+INC_DIR = host_inc ../module_foc_qei/src ../module_foc_util/src ../__app_test_qei/src
+
+OPT = -O2
+
+include host_model.mak
+
+#
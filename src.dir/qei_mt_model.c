@@ -0,0 +1,199 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "qei_mt_model.h"
+
+/* Host check of the QEI M/T velocity estimate (see calc_mt_velocity() in module_foc_qei/src/qei_decode.c)
+ * A motor is modelled following a piecewise-linear speed profile. Its QEI signals (including the origin) are sampled every TICKS_PER_SAMP,
+ * and fed to the QEI decoder, which supplies the QEI parameters at every Client request. The timer wraps during every test.
+ * For each profile, the following are checked:-
+ *	Once the speed has settled, the velocity estimate is within MODEL_ERR_PPM of the modelled speed (across the full speed range).
+ *		NB The speed has settled once it has been constant for MODEL_SETTLE_WINS M/T windows (I.e. QEI_MT_WINDOW plus one QEI edge period)
+ *	The velocity estimate never has the wrong sign
+ *	Once the motor has stopped for QEI_MT_STOP_TICKS, the velocity estimate is zero
+ *	After a step restart (following a stop), the velocity estimate settles within MODEL_SETTLE_WINS M/T windows
+ * Usage: qei_mt_model.x
+ */
+
+// Test configurations: Name, Speed profile
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "10 RPM" ,2 ,{ { 0 ,10 } ,{ 3000 ,10 } } }
+	,{ "100 RPM" ,2 ,{ { 0 ,100 } ,{ 1000 ,100 } } }
+	,{ "1000 RPM" ,2 ,{ { 0 ,1000 } ,{ 1000 ,1000 } } }
+	,{ "4000 RPM" ,2 ,{ { 0 ,MAX_SPEC_RPM } ,{ 1000 ,MAX_SPEC_RPM } } }
+	,{ "-2000 RPM" ,2 ,{ { 0 ,-2000 } ,{ 1000 ,-2000 } } }
+	,{ "Stop/Restart" ,6 ,{ { 0 ,1000 } ,{ 200 ,1000 } ,{ 300 ,0 } ,{ 700 ,0 } ,{ 700 ,1000 } ,{ 1000 ,1000 } } }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+/*****************************************************************************/
+static double model_speed( // Returns modelled speed at one time, and whether the speed has settled
+	const MODEL_CONFIG_TYP * cfg_p, // Pointer to test configuration
+	int sim_ticks, // Time since start of profile (in Reference Frequency Cycles)
+	int * settled // Pointer to flag set if speed has been constant for at least MODEL_SETTLE_WINS M/T windows
+) // Returns speed (RPM)
+{
+	int settle_ticks = 0; // Time allowed for velocity estimate to settle
+	const MODEL_POINT_TYP * prev_p; // Pointer to point at start of profile segment
+	const MODEL_POINT_TYP * next_p; // Pointer to point at end of profile segment
+	double seg_ms = (double)sim_ticks / (double)MODEL_TICKS_PER_MS; // Time (milli-seconds)
+	int pnt_cnt; // Point counter
+
+
+	// Find profile segment
+	for (pnt_cnt=1; pnt_cnt<(cfg_p->num_points - 1); pnt_cnt++)
+	{
+		if (seg_ms < cfg_p->points[pnt_cnt].time_ms) break;
+	} // for pnt_cnt
+
+	prev_p = &cfg_p->points[pnt_cnt - 1];
+	next_p = &cfg_p->points[pnt_cnt];
+
+	// Check for constant non-zero speed. NB A stopped motor is checked against QEI_MT_STOP_TICKS instead
+	if (0 != prev_p->rpm)
+	{
+		settle_ticks = MODEL_SETTLE_WINS * (QEI_MT_WINDOW + TICKS_PER_MIN_PER_QEI / abs(prev_p->rpm)) + MODEL_REQ_TICKS;
+	} // if (0 != prev_p->rpm)
+
+	*settled = ((prev_p->rpm == next_p->rpm) && ((prev_p->time_ms * MODEL_TICKS_PER_MS + settle_ticks) <= sim_ticks));
+
+	return prev_p->rpm + (double)(next_p->rpm - prev_p->rpm) * (seg_ms - prev_p->time_ms) / (next_p->time_ms - prev_p->time_ms);
+} // model_speed
+/*****************************************************************************/
+static QEI_RAW_TYP model_qei_pins( // Returns modelled QEI input pins for one QEI count
+	int qei_cnt // Total QEI count
+)
+{
+	static const unsigned qei_phases[QEI_PERIOD_LEN] = { 0b00 ,0b01 ,0b11 ,0b10 }; // [BA] phases in positive spin order
+	QEI_RAW_TYP inp_pins = (qei_phases[qei_cnt & QEI_PHASE_MASK] | QEI_NERR_MASK); // NB No QEI error
+
+
+	// Check for origin
+	if (0 == (qei_cnt & QEI_REV_MASK))
+	{
+		inp_pins |= QEI_ORIG_MASK;
+	} // if (0 == (qei_cnt & QEI_REV_MASK))
+
+	return inp_pins;
+} // model_qei_pins
+/*****************************************************************************/
+static int test_one_config( // Run one speed profile through QEI decoder
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+{
+	QEI_DATA_TYP qei_s; // QEI decoder data (Server)
+	QEI_PARAM_TYP params_s; // QEI parameters (Client)
+	MODEL_ERRS_TYP errs = { 0 ,0 ,0 ,0 }; // Error counts
+	unsigned cur_time = MODEL_START_TIME; // Modelled timer value. NB Wraps during test
+	double mech_ang = 0.5; // Modelled total angle (in QEI counts). NB Start half-way between edges
+	double speed; // Modelled speed (RPM)
+	double err_ppm; // Velocity error (parts per million)
+	int end_ticks = cfg_p->points[cfg_p->num_points - 1].time_ms * MODEL_TICKS_PER_MS; // Length of profile
+	int req_ticks = 0; // Time of next Client request
+	int edge_ticks = 0; // Time of latest modelled QEI edge
+	int sim_ticks; // Time since start of profile
+	int settled; // Flag set if modelled speed has settled
+	int cur_cnt = 0; // Modelled QEI count
+	int new_cnt; // New modelled QEI count
+	int err_val; // Error value
+
+
+	init_qei_decode( &qei_s ,0 ,cur_time );
+	service_qei_input_pins( &qei_s ,cur_time ,model_qei_pins( cur_cnt ) );
+
+	for (sim_ticks=0; sim_ticks<end_ticks; sim_ticks += TICKS_PER_SAMP)
+	{
+		speed = model_speed( cfg_p ,sim_ticks ,&settled );
+		mech_ang += speed * QEI_PER_REV * TICKS_PER_SAMP / ((double)SECS_PER_MIN * (double)SECOND);
+		cur_time += TICKS_PER_SAMP;
+
+		new_cnt = (int)floor( mech_ang );
+
+		// Check for QEI edge
+		if (new_cnt != cur_cnt)
+		{
+			cur_cnt = new_cnt;
+			edge_ticks = sim_ticks;
+		} // if (new_cnt != cur_cnt)
+
+		service_qei_input_pins( &qei_s ,cur_time ,model_qei_pins( cur_cnt ) );
+
+		// Check for Client request
+		if (req_ticks <= sim_ticks)
+		{
+			req_ticks += MODEL_REQ_TICKS;
+
+			get_qei_client_params( &qei_s ,&params_s ,0 ,cur_time );
+
+			errs.checks++;
+
+			// Check velocity has correct sign
+			if ((MODEL_SIGN_RPM < fabs( speed )) && (0 > (params_s.veloc * speed)))
+			{
+				errs.veloc++;
+			} // if ((MODEL_SIGN_RPM < fabs( speed )) && (0 > (params_s.veloc * speed)))
+
+			if (settled)
+			{
+				if (0 == (int)speed)
+				{
+					// Check stopped motor has zero velocity
+					if (((QEI_MT_STOP_TICKS + MODEL_REQ_TICKS) < (sim_ticks - edge_ticks)) && (0 != params_s.veloc))
+					{
+						errs.stop++;
+					} // if (((QEI_MT_STOP_TICKS + MODEL_REQ_TICKS) < (sim_ticks - edge_ticks)) && (0 != params_s.veloc))
+				} // if (0 == (int)speed)
+				else
+				{
+					err_ppm = 1000000.0 * fabs( params_s.veloc - speed ) / fabs( speed );
+					if (errs.max_ppm < (int)err_ppm) errs.max_ppm = (int)err_ppm;
+
+					if ((fabs( speed ) * MODEL_ERR_PPM / 1000000.0 + MODEL_VELOC_ERR) < fabs( params_s.veloc - speed ))
+					{
+						errs.veloc++;
+					} // if ((fabs( speed ) * MODEL_ERR_PPM / 1000000.0 + MODEL_VELOC_ERR) < fabs( params_s.veloc - speed ))
+				} // else !(0 == (int)speed)
+			} // if (settled)
+		} // if (req_ticks <= sim_ticks)
+	} // for sim_ticks
+
+	err_val = errs.veloc + errs.stop;
+
+	printf("  %-12s: %5d requests checked, Max. settled error %5d ppm. Errors: Veloc=%d Stop=%d %s\n"
+		,cfg_p->name ,errs.checks ,errs.max_ppm ,errs.veloc ,errs.stop ,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("QEI M/T velocity tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,57 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _QEI_MT_MODEL_H_
+#define _QEI_MT_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "qei_decode.h"
+
+#define MODEL_REQ_TICKS 6250 // Time between Client requests (16 kHz, in Reference Frequency Cycles)
+#define MODEL_START_TIME ((unsigned)(-SECOND)) // Initial timer value (so timer wrap-around is tested)
+#define MODEL_TICKS_PER_MS (SECOND / 1000) // No. of Reference Frequency Cycles per milli-second
+#define MODEL_SETTLE_WINS 2 // No. of M/T windows allowed for velocity estimate to settle, after a change in speed
+#define MODEL_MAX_POINTS 8 // Max. No. of points in a speed profile
+#define MODEL_ERR_PPM 2000 // Max. error in settled velocity estimate (parts per million). NB See QEI_MT_WINDOW
+#define MODEL_VELOC_ERR 1 // Additional max. error in settled velocity estimate (RPM). NB Allows for rounding
+#define MODEL_SIGN_RPM 50 // Speed above which velocity estimate must NOT have the wrong sign
+
+/** Structure containing one point of a speed profile. NB Speed is linearly interpolated between points */
+typedef struct MODEL_POINT_TAG
+{
+	int time_ms; // Time of point (milli-seconds)
+	int rpm; // Mechanical speed at point (RPM)
+} MODEL_POINT_TYP;
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int num_points; // No. of points in speed profile
+	MODEL_POINT_TYP points[MODEL_MAX_POINTS]; // Speed profile
+} MODEL_CONFIG_TYP;
+
+/** Structure containing error counts for one test */
+typedef struct MODEL_ERRS_TAG
+{
+	int checks; // No. of checked Client requests
+	int veloc; // No. of velocity errors (settled error too large, or wrong sign)
+	int stop; // No. of requests where a stopped motor had a non-zero velocity estimate
+	int max_ppm; // Max. settled velocity error (parts per million)
+} MODEL_ERRS_TYP;
+
+#endif /* _QEI_MT_MODEL_H_ */
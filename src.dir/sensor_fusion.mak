@@ -0,0 +1,21 @@
+# ansi C compile: Host simulation of QEI/Hall sensor fusion observer, with QEI glitches and jittered Hall edges
+
+MAIN =	sensor_fusion_model
+
+CMODS =	$(MAIN) \
+	sensor_fusion \
+	hall_decode \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	sensor_fusion.h \
+	hall_decode.h \
+	hall_common.h \
+
+INC_DIR = host_inc ../module_foc_control/src ../module_foc_hall/src ../module_foc_util/src ../__app_foc_demo/src
+
+OPT = -O2
+
+include host_model.mak
+
+#
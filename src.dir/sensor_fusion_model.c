@@ -0,0 +1,179 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "sensor_fusion_model.h"
+
+/* Host simulation of the QEI/Hall sensor fusion observer (see module_foc_control/src/sensor_fusion.c)
+ * A motor is modelled at constant speed, with a quantised QEI angle, and uneven Hall sectors whose edges have jittered time-stamps.
+ * The Hall edges are fed to the Hall decoder (hall_decode.c), which supplies the Hall parameters at every fusion update.
+ * Once the observer has settled, the following are checked:-
+ *	The fused angle is within one QEI count of the modelled angle, and the fused velocity is close to the modelled speed
+ *	A QEI spike (one wrong sample) is ignored
+ *	A large persistent QEI step (count error) is absorbed into the QEI bias
+ *	A small persistent QEI step (below the outlier limit) is removed by the Hall anchors, within MODEL_RECOVER_MS
+ *	No Hall edge is rejected as a glitch
+ * Usage: sensor_fusion_model.x
+ */
+
+static const int sect_bounds[NUM_HALL_SECTS] = { 0 ,150 ,340 ,500 ,650 ,830 }; // Start of each sector (per mille of an electrical cycle)
+
+// Test configurations: Name, Speed, Glitch type, Glitch size, Expected QEI count errors
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "50 RPM" ,50 ,MODEL_NO_GLITCH ,0 ,0 }
+	,{ "500 RPM" ,500 ,MODEL_NO_GLITCH ,0 ,0 }
+	,{ "3000 RPM" ,3000 ,MODEL_NO_GLITCH ,0 ,0 }
+	,{ "-1000 RPM" ,-1000 ,MODEL_NO_GLITCH ,0 ,0 }
+	,{ "QEI spike" ,1000 ,MODEL_SPIKE ,10 ,0 }
+	,{ "QEI step" ,1000 ,MODEL_STEP ,10 ,1 }
+	,{ "Small QEI step" ,1000 ,MODEL_STEP ,3 ,0 }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+/*****************************************************************************/
+static int find_sector( // Returns modelled sector for one electrical angle
+	double elec_ang // Total electrical angle (in electrical cycles)
+)
+{
+	double frac_ang = elec_ang - floor( elec_ang ); // Angle within electrical cycle [0..1)
+	int sect_id = (NUM_HALL_SECTS - 1); // Preset to last sector
+
+
+	while ((frac_ang * 1000.0) < sect_bounds[sect_id])
+	{
+		sect_id--;
+	} // while ((frac_ang * 1000.0) < sect_bounds[sect_id])
+
+	return sect_id;
+} // find_sector
+/*****************************************************************************/
+static int test_one_config( // Run one test configuration through Hall decoder and sensor fusion observer
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+{
+	static const int hall_sects[(HALL_PHASE_MASK + 1)] = HALL_SECT_LUT; // Converts [CBA] Hall state to sector
+	HALL_DATA_TYP hall_s; // Hall decoder data (Server)
+	SENSOR_FUSION_TYP fuse_s; // Fused angle data (Client)
+	MODEL_ERRS_TYP errs = { 0 ,0 ,0 ,0 }; // Error counts
+	unsigned sect_vals[NUM_HALL_SECTS]; // Hall state for each sector
+	unsigned cur_time = MODEL_START_TIME; // Modelled timer value. NB Wraps during test
+	double elec_ang = 0.0; // Modelled total electrical angle (in electrical cycles)
+	double ang_inc; // Electrical angle increment per simulation time-step
+	double ang_err; // Fused angle error
+	int end_ticks = MODEL_RUN_MS * MODEL_TICKS_PER_MS; // Length of test
+	int glitch_ticks = MODEL_GLITCH_MS * MODEL_TICKS_PER_MS; // Time of injected glitch
+	int sim_ticks; // Time since start of test
+	int qei_cnt; // Modelled QEI count
+	int cur_sect; // Modelled sector
+	int new_sect; // New modelled sector
+	int sect_cnt; // Sector counter
+	int err_val; // Error value
+
+
+	for (sect_cnt=0; sect_cnt<=HALL_PHASE_MASK; sect_cnt++)
+	{
+		if (0 <= hall_sects[sect_cnt]) sect_vals[hall_sects[sect_cnt]] = sect_cnt;
+	} // for sect_cnt
+
+	srand( 1 ); // NB Same Hall jitter for every run
+
+	init_hall_decode( &hall_s ,0 );
+	init_sensor_fusion( &fuse_s ,MODEL_ANG_PER_PAIR );
+
+	ang_inc = (double)cfg_p->rpm * NUM_POLE_PAIRS * MODEL_SIM_TICKS / ((double)SECS_PER_MIN * (double)SECOND);
+
+	cur_sect = find_sector( elec_ang );
+	service_hall_input_pins( &hall_s ,(sect_vals[cur_sect] | HALL_NERR_MASK) ,cur_time );
+
+	for (sim_ticks=0; sim_ticks<end_ticks; sim_ticks += MODEL_SIM_TICKS)
+	{
+		elec_ang += ang_inc;
+		cur_time += MODEL_SIM_TICKS;
+
+		new_sect = find_sector( elec_ang );
+
+		// Check for Hall edge. NB Time-stamp lags edge by a random amount
+		if (new_sect != cur_sect)
+		{
+			service_hall_input_pins( &hall_s ,(sect_vals[new_sect] | HALL_NERR_MASK) ,(cur_time - (rand() % MODEL_HALL_JITTER)) );
+			cur_sect = new_sect;
+		} // if (new_sect != cur_sect)
+
+		// Check for fusion update
+		if (0 == (sim_ticks % MODEL_REQ_TICKS))
+		{
+			qei_cnt = (int)floor( elec_ang * QEI_PER_PAIR ); // Quantised QEI angle
+
+			// Check for injected glitch
+			if (((MODEL_SPIKE == cfg_p->glitch) && (glitch_ticks == sim_ticks))
+				|| ((MODEL_STEP == cfg_p->glitch) && (glitch_ticks <= sim_ticks)))
+			{
+				qei_cnt += cfg_p->glitch_cnts;
+			} // if (((MODEL_SPIKE == cfg_p->glitch) && ...
+
+			update_hall_client_params( &hall_s ,cur_time );
+			update_sensor_fusion( &fuse_s ,(qei_cnt << MODEL_UPSCALE_BITS) ,&hall_s.params ,cur_time );
+
+			// Check if observer has settled (NB Allow Hall anchors time to remove a small QEI count error)
+			if (((MODEL_SETTLE_MS * MODEL_TICKS_PER_MS) <= sim_ticks)
+				&& ((sim_ticks < glitch_ticks) || ((glitch_ticks + MODEL_RECOVER_MS * MODEL_TICKS_PER_MS) <= sim_ticks)
+					|| (cfg_p->qei_glitches) || (MODEL_STEP != cfg_p->glitch)))
+			{
+				errs.checks++;
+
+				ang_err = fabs( fuse_s.tot_ang - elec_ang * MODEL_ANG_PER_PAIR );
+				if (errs.max_ang < (int)ang_err) errs.max_ang = (int)ang_err;
+
+				if (MODEL_ANG_ERR < ang_err)
+				{
+					errs.angle++;
+				} // if (MODEL_ANG_ERR < ang_err)
+
+				if ((abs( cfg_p->rpm ) * MODEL_VELOC_PERCENT / 100.0 + MODEL_VELOC_ERR) < abs( fuse_s.veloc - cfg_p->rpm ))
+				{
+					errs.veloc++;
+				} // if ((abs( cfg_p->rpm ) * MODEL_VELOC_PERCENT / 100.0 + MODEL_VELOC_ERR) < abs( fuse_s.veloc - cfg_p->rpm ))
+			} // if (((MODEL_SETTLE_MS * MODEL_TICKS_PER_MS) <= sim_ticks) && ...
+		} // if (0 == (sim_ticks % MODEL_REQ_TICKS))
+	} // for sim_ticks
+
+	err_val = errs.angle + errs.veloc + (cfg_p->qei_glitches != fuse_s.qei_glitches) + fuse_s.hall_rejects;
+
+	printf("  %-14s: %5d updates checked, Max. angle error %d. Errors: Angle=%d Veloc=%d QEI_Glitches=%d Hall_Rejects=%d %s\n"
+		,cfg_p->name ,errs.checks ,errs.max_ang ,errs.angle ,errs.veloc ,fuse_s.qei_glitches ,fuse_s.hall_rejects
+		,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("Sensor fusion tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,68 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#ifndef _SENSOR_FUSION_MODEL_H_
+#define _SENSOR_FUSION_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "hall_decode.h"
+#include "sensor_fusion.h"
+
+#define MODEL_UPSCALE_BITS 2 // Same as QEI_UPSCALE_BITS (see module_foc_control/src/inner_loop.h)
+#define MODEL_ANG_PER_PAIR (QEI_PER_PAIR << MODEL_UPSCALE_BITS) // No. of angle units per electrical cycle (Same as UQ_PER_PAIR)
+#define MODEL_SIM_TICKS 50 // Simulation time-step (in Reference Frequency Cycles)
+#define MODEL_REQ_TICKS 6250 // Time between fusion updates (16 kHz, in Reference Frequency Cycles)
+#define MODEL_START_TIME ((unsigned)(-SECOND)) // Initial timer value (so timer wrap-around is tested)
+#define MODEL_TICKS_PER_MS (SECOND / 1000) // No. of Reference Frequency Cycles per milli-second
+#define MODEL_RUN_MS 2000 // Length of each test
+#define MODEL_SETTLE_MS 200 // Time allowed for observer to settle, after start
+#define MODEL_GLITCH_MS 1000 // Time of injected QEI glitch
+#define MODEL_RECOVER_MS 500 // Time allowed for Hall anchors to remove a small QEI count error
+#define MODEL_HALL_JITTER 2000 // Max. lag of Hall edge time-stamp (in Reference Frequency Cycles)
+#define MODEL_ANG_ERR 4 // Max. error of fused angle (angle units, i.e. one QEI count)
+#define MODEL_VELOC_PERCENT 2 // Max. error in velocity estimate (per cent)
+#define MODEL_VELOC_ERR 15 // Additional max. error in velocity estimate (RPM). NB Allows for QEI quantisation ripple at low speed
+
+/** Different injected QEI glitches */
+typedef enum MODEL_GLITCH_ETAG
+{
+  MODEL_NO_GLITCH = 0,	// No glitch
+  MODEL_SPIKE,					// QEI angle wrong for one update only
+  MODEL_STEP,						// QEI count error: QEI angle wrong from then on
+  NUM_MODEL_GLITCHES		// Handy Value!-)
+} MODEL_GLITCH_ENUM;
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int rpm; // Mechanical speed (RPM)
+	MODEL_GLITCH_ENUM glitch; // Type of injected QEI glitch
+	int glitch_cnts; // Size of injected QEI glitch (QEI counts)
+	int qei_glitches; // Expected No. of QEI count errors absorbed into QEI bias
+} MODEL_CONFIG_TYP;
+
+/** Structure containing error counts for one test */
+typedef struct MODEL_ERRS_TAG
+{
+	int checks; // No. of checked fusion updates
+	int angle; // No. of angle errors
+	int veloc; // No. of velocity errors
+	int max_ang; // Max. angle error (angle units)
+} MODEL_ERRS_TYP;
+
+#endif /* _SENSOR_FUSION_MODEL_H_ */
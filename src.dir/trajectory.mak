@@ -0,0 +1,18 @@
+# ansi C compile: Host check of S-curve trajectory generator limits, overshoot and mid-profile request changes
+
+MAIN =	trajectory_model
+
+CMODS =	$(MAIN) \
+	trajectory \
+
+# Common include files (NB triggers recompilation of all source)
+CINCS = $(MAIN).h \
+	trajectory.h \
+
+INC_DIR = host_inc ../module_foc_loop/src ../module_foc_pwm/src ../module_foc_util/src ../__app_foc_demo/src
+
+OPT = -O2
+
+include host_model.mak
+
+#
@@ -0,0 +1,204 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+#include "trajectory_model.h"
+
+/* Host check of the jerk-limited (S-curve) trajectory generator (see module_foc_loop/src/trajectory.c)
+ * A profile of requested velocities is fed to the trajectory generator, once per FOC iteration (i.e. once per PWM period).
+ * The acceleration and jerk limits are specified in RPM per second (and per second^2) at the default PWM period.
+ * For each profile, the following are checked:-
+ *	The acceleration and jerk never exceed the specified limits
+ *	The output velocity never overshoots a request that could be reached without overshoot
+ *		(I.e. any request from a steady velocity, or a change of request mid-profile while the deceleration distance is still available)
+ *	A request made from a steady velocity is reached within MODEL_TIME_PERCENT of the ideal S-curve time
+ *	The output velocity lands exactly on the final request
+ * The profiles are also run at the shortest and longest PWM periods, where the limits are re-scaled (as in PWM_SCALE_VALS).
+ * Usage: trajectory_model.x
+ */
+
+// Test configurations: Name, PWM resolution bits, Test length, Request profile
+static const MODEL_CONFIG_TYP test_configs[] = {
+	{ "Step 0 to 1000 RPM" ,MODEL_DEF_BITS ,100 ,1 ,{ { 0 ,1000 } } }
+	,{ "Small step 0 to 20 RPM" ,MODEL_DEF_BITS ,20 ,1 ,{ { 0 ,20 } } }
+	,{ "Small step 0 to -15 RPM" ,MODEL_DEF_BITS ,20 ,1 ,{ { 0 ,-15 } } }
+	,{ "Step 1000 to -1000 RPM" ,MODEL_DEF_BITS ,200 ,2 ,{ { 0 ,1000 } ,{ 50 ,-1000 } } }
+	,{ "Lower request mid-profile" ,MODEL_DEF_BITS ,150 ,2 ,{ { 0 ,2000 } ,{ 20 ,1000 } } }
+	,{ "Raise request mid-profile" ,MODEL_DEF_BITS ,150 ,2 ,{ { 0 ,500 } ,{ 10 ,2000 } } }
+	,{ "Reverse request mid-profile" ,MODEL_DEF_BITS ,200 ,2 ,{ { 0 ,2000 } ,{ 40 ,-500 } } }
+	,{ "Short PWM period: 0 to 1000" ,PWM_PERIOD_MIN_BITS ,100 ,1 ,{ { 0 ,1000 } } }
+	,{ "Short PWM period: Reverse" ,PWM_PERIOD_MIN_BITS ,200 ,2 ,{ { 0 ,2000 } ,{ 40 ,-500 } } }
+	,{ "Long PWM period: 0 to 1000" ,PWM_PERIOD_MAX_BITS ,100 ,1 ,{ { 0 ,1000 } } }
+	,{ "Long PWM period: Small step" ,PWM_PERIOD_MAX_BITS ,20 ,1 ,{ { 0 ,20 } } }
+};
+
+#define NUM_TEST_CONFIGS (sizeof(test_configs) / sizeof(MODEL_CONFIG_TYP))
+/*****************************************************************************/
+static void get_traj_limits( // Get trajectory limits used by the control loop for one PWM period (see PWM_SCALE_VALS in inner_loop.h)
+	int pwm_bits, // Resolution bits of PWM period
+	int * max_acc, // Pointer to returned up-scaled maximum acceleration, per FOC iteration
+	int * max_jerk // Pointer to returned up-scaled maximum jerk, per FOC iteration
+)
+{
+	*max_acc = TRAJ_PERIOD_ACC( MODEL_MAX_ACC ,(pwm_bits - MODEL_DEF_BITS) );
+	*max_jerk = TRAJ_PERIOD_JERK( MODEL_MAX_JERK ,(pwm_bits - MODEL_DEF_BITS) );
+} // get_traj_limits
+/*****************************************************************************/
+static double ideal_secs( // Returns ideal time for a jerk-limited velocity change, starting and ending with zero acceleration
+	double diff_vel, // Velocity change (RPM)
+	double lim_acc, // Acceleration limit (RPM per second)
+	double lim_jerk // Jerk limit (RPM per second^2)
+) // Returns time (seconds)
+{
+	double out_secs; // Ideal time
+
+
+	diff_vel = fabs( diff_vel );
+
+	// Check if maximum acceleration is reached
+	if ((lim_acc * lim_acc / lim_jerk) <= diff_vel)
+	{
+		out_secs = diff_vel / lim_acc + lim_acc / lim_jerk;
+	} // if ((lim_acc * lim_acc / lim_jerk) <= diff_vel)
+	else
+	{
+		out_secs = 2.0 * sqrt( diff_vel / lim_jerk );
+	} // else !((lim_acc * lim_acc / lim_jerk) <= diff_vel)
+
+	return out_secs;
+} // ideal_secs
+/*****************************************************************************/
+static int test_one_config( // Run one request profile through trajectory generator
+	const MODEL_CONFIG_TYP * cfg_p // Pointer to test configuration
+) // Returns 1 if all checks pass
+{
+	TRAJ_DATA_TYP traj_s; // Trajectory data
+	MODEL_ERRS_TYP errs = { 0 ,0 ,0 ,0 ,0.0 ,0.0 }; // Error counts
+	double iters_per_sec = (double)SECOND / (double)(1 << cfg_p->pwm_bits); // FOC iteration rate
+	double def_rate = (double)SECOND / (double)(1 << MODEL_DEF_BITS); // FOC iteration rate at default PWM period
+	double spec_acc = (MODEL_MAX_ACC / MODEL_UPSCALE) * def_rate; // Specified acceleration limit (RPM per second)
+	double spec_jerk = (MODEL_MAX_JERK / MODEL_UPSCALE) * def_rate * def_rate; // Specified jerk limit (RPM per second^2)
+	double phys_acc; // Acceleration (RPM per second)
+	double phys_jerk; // Jerk (RPM per second^2)
+	double lim_secs = 0.0; // Time allowed to reach current request (NB Zero if NOT checked)
+	S64_T stop_vel; // Velocity change incurred while ramping acceleration down to zero
+	S64_T err_vel; // Up-scaled velocity error when request changed
+	int down_acc; // Acceleration reduced towards request
+	int end_iters = (int)((double)cfg_p->end_ms * iters_per_sec / 1000.0); // Length of test (FOC iterations)
+	int max_acc; // Up-scaled maximum acceleration, per FOC iteration
+	int max_jerk; // Up-scaled maximum jerk, per FOC iteration
+	int iter_cnt; // FOC iteration counter
+	int pnt_cnt = 0; // Request profile point counter
+	int req_vel = 0; // Requested velocity
+	int req_iter = 0; // Iteration of latest request change
+	int req_sign = 0; // Sign of velocity error when request changed (NB Zero if overshoot NOT checked)
+	int reached = 1; // Flag set when current request has been reached
+	int prev_vel = 0; // Previous up-scaled velocity
+	int prev_acc = 0; // Previous up-scaled acceleration
+	int new_acc; // Up-scaled acceleration (velocity change in one iteration)
+	int out_vel = 0; // Output velocity
+	int err_val; // Error value
+
+
+	get_traj_limits( cfg_p->pwm_bits ,&max_acc ,&max_jerk );
+	init_trajectory( &traj_s ,max_acc ,max_jerk );
+
+	for (iter_cnt=0; iter_cnt<end_iters; iter_cnt++)
+	{
+		// Check for new request
+		if ((pnt_cnt < cfg_p->num_points)
+			&& ((double)cfg_p->points[pnt_cnt].time_ms * iters_per_sec / 1000.0 <= (double)iter_cnt))
+		{
+			req_vel = cfg_p->points[pnt_cnt].req_vel;
+			req_iter = iter_cnt;
+			reached = 0;
+			lim_secs = 0.0;
+			req_sign = 0;
+			pnt_cnt++;
+
+			// Check if request can be reached without overshoot: I.e. ramping acceleration down immediately does NOT pass it
+			err_vel = (S64_T)((req_vel << TRAJ_RES_BITS) - traj_s.vel);
+			down_acc = traj_s.acc - max_jerk;
+			if (0 > err_vel) down_acc = traj_s.acc + max_jerk;
+			stop_vel = ((S64_T)down_acc * (S64_T)(abs(down_acc) + max_jerk)) / (S64_T)(max_jerk << 1);
+
+			if ((0 <= err_vel) && (stop_vel <= err_vel)) req_sign = 1;
+			if ((0 > err_vel) && (stop_vel >= err_vel)) req_sign = -1;
+
+			// Check for request from a steady velocity
+			if (0 == traj_s.acc)
+			{
+				lim_secs = ideal_secs( (req_vel - out_vel) ,spec_acc ,spec_jerk ) * (100 + MODEL_TIME_PERCENT) / 100.0
+					+ MODEL_TIME_ITERS / iters_per_sec;
+			} // if (0 == traj_s.acc)
+		} // if ((pnt_cnt < cfg_p->num_points) && ...
+
+		out_vel = update_trajectory( &traj_s ,req_vel );
+
+		// Check acceleration and jerk against specified limits. NB Measured from the up-scaled velocity, NOT the generator's acceleration
+		new_acc = traj_s.vel - prev_vel;
+		phys_acc = fabs( (double)new_acc ) / MODEL_UPSCALE * iters_per_sec;
+		phys_jerk = fabs( (double)(new_acc - prev_acc) ) / MODEL_UPSCALE * iters_per_sec * iters_per_sec;
+		prev_vel = traj_s.vel;
+		prev_acc = new_acc;
+
+		if (errs.max_acc < phys_acc) errs.max_acc = phys_acc;
+		if (errs.max_jerk < phys_jerk) errs.max_jerk = phys_jerk;
+
+		if ((spec_acc * 1.000001) < phys_acc) errs.acc++;
+		if ((spec_jerk * 1.000001) < phys_jerk) errs.jerk++;
+
+		// Check for overshoot of up-scaled velocity
+		if (0 < (req_sign * (traj_s.vel - (req_vel << TRAJ_RES_BITS)))) errs.over++;
+
+		// Check if request reached
+		if ((0 == reached) && ((req_vel << TRAJ_RES_BITS) == traj_s.vel) && (0 == traj_s.acc))
+		{
+			reached = 1;
+
+			if ((0.0 < lim_secs) && (lim_secs < ((iter_cnt + 1 - req_iter) / iters_per_sec))) errs.time++;
+		} // if ((0 == reached) && ((req_vel << TRAJ_RES_BITS) == traj_s.vel) && (0 == traj_s.acc))
+	} // for iter_cnt
+
+	// Check final request was reached
+	if ((0 == reached) || (req_vel != out_vel)) errs.time++;
+
+	err_val = errs.acc + errs.jerk + errs.over + errs.time;
+
+	printf("  %-28s: Max. Acc=%6.0f RPM/s, Max. Jerk=%8.0f RPM/s^2. Errors: Acc=%d Jerk=%d Over=%d Time=%d %s\n"
+		,cfg_p->name ,errs.max_acc ,errs.max_jerk ,errs.acc ,errs.jerk ,errs.over ,errs.time ,(err_val ? "FAIL" : "PASS") );
+
+	return (0 == err_val);
+} // test_one_config
+/*****************************************************************************/
+int main( void )
+{
+	int test_cnt; // Test counter
+	int num_fails = 0; // No. of failed tests
+
+
+	printf("S-curve trajectory tests\n");
+
+	for (test_cnt=0; test_cnt<NUM_TEST_CONFIGS; test_cnt++)
+	{
+		if (0 == test_one_config( &test_configs[test_cnt] ))
+		{
+			num_fails++;
+		} // if (0 == test_one_config( &test_configs[test_cnt] ))
+	} // for test_cnt
+
+	printf("%d of %d tests failed\n" ,num_fails ,(int)NUM_TEST_CONFIGS );
+
+	return (num_fails ? 1 : 0);
+} // main
+/*****************************************************************************/
@@ -0,0 +1,65 @@
+/**
+ * The copyrights, all other intellectual and industrial
+ * property rights are retained by XMOS and/or its licensors.
+ * Terms and conditions covering the use of this code can
+ * be found in the Xmos End User License Agreement.
+ *
+ * Copyright XMOS Ltd 2013
+ *
+ * In the case where this code is a modification of existing code
+ * under a separate license, the separate license terms are shown
+ * below. The modifications to the code are still covered by the
+ * copyright notice above.
+ **/
+
+
+#ifndef _TRAJECTORY_MODEL_H_
+#define _TRAJECTORY_MODEL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "pwm_common.h"
+#include "trajectory.h"
+
+// Trajectory limits. NB Copies of TRAJ_MAX_ACC and TRAJ_MAX_JERK in module_foc_control/src/inner_loop.h
+#define MODEL_MAX_ACC (1 << TRAJ_RES_BITS) // Maximum acceleration, per FOC iteration at default PWM period
+#define MODEL_MAX_JERK (MODEL_MAX_ACC >> 6) // Maximum jerk, per FOC iteration at default PWM period
+
+#define MODEL_UPSCALE ((double)(1 << TRAJ_RES_BITS)) // Trajectory up-scaling factor
+#define MODEL_DEF_BITS PWM_RES_BITS // Resolution bits of default PWM period. NB One FOC iteration per PWM period
+#define MODEL_TICKS_PER_MS (SECOND / 1000) // No. of Reference Frequency Cycles per milli-second
+#define MODEL_MAX_POINTS 8 // Max. No. of points in a request profile
+#define MODEL_TIME_PERCENT 2 // Max. excess of time to reach requested velocity, over the ideal S-curve time (per cent)
+#define MODEL_TIME_ITERS 4 // Additional excess of time to reach requested velocity (FOC iterations). NB Allows for rounding
+
+/** Structure containing one point of a request profile. NB Request is held until next point */
+typedef struct MODEL_POINT_TAG
+{
+	int time_ms; // Time of request (milli-seconds)
+	int req_vel; // Requested velocity (RPM)
+} MODEL_POINT_TYP;
+
+/** Structure containing one test configuration */
+typedef struct MODEL_CONFIG_TAG
+{
+	const char * name; // Test name
+	int pwm_bits; // Resolution bits of PWM period (NB Sets FOC iteration period)
+	int end_ms; // Length of test (milli-seconds)
+	int num_points; // No. of points in request profile
+	MODEL_POINT_TYP points[MODEL_MAX_POINTS]; // Request profile
+} MODEL_CONFIG_TYP;
+
+/** Structure containing error counts for one test */
+typedef struct MODEL_ERRS_TAG
+{
+	int acc; // No. of iterations exceeding acceleration limit
+	int jerk; // No. of iterations exceeding jerk limit
+	int over; // No. of iterations where velocity overshot an unsettled request
+	int time; // No. of requests reached too late (or NOT at all)
+	double max_acc; // Max. acceleration magnitude (RPM per second)
+	double max_jerk; // Max. jerk magnitude (RPM per second^2)
+} MODEL_ERRS_TYP;
+
+#endif /* _TRAJECTORY_MODEL_H_ */